@@ -20,6 +20,7 @@ import copy
 import time
 import subprocess
 from maple.core import config
+from maple.core import logging
 from maple.core import util
 
 class TestResult:
@@ -280,3 +281,79 @@ class DeathTestCase(TestCase):
     def after_all_tests(self):
         pass
 
+class ParallelTestCase(TestCase):
+    """ The base class for test cases that run tests on multiple cpus
+    at the same time. Each worker runs the given pintool pinned to its
+    own cpu, with its outputs in its own run directory under the work
+    directory. The subclasses set the other knobs of the pintool and
+    create the workers.
+    """
+    def __init__(self, name, run_name, test, mode, threshold, pin, tool,
+                 num_workers, work_dir):
+        TestCase.__init__(self)
+        self.name = name
+        self.run_name = run_name
+        self.test = test
+        self.mode = mode
+        self.threshold = threshold
+        self.pin = pin
+        self.tool = tool
+        self.num_workers = num_workers
+        self.work_dir = work_dir
+        self.num_started = 0
+        self.test_history = []
+        self.result = None
+    def is_fatal(self):
+        assert self.result != None
+        if self.result == 'FATAL':
+            return True
+        else:
+            return False
+    def setup(self):
+        if self.num_workers <= 0:
+            self.num_workers = os.sysconf('SC_NPROCESSORS_ONLN')
+        if not os.path.exists(self.work_dir):
+            os.makedirs(self.work_dir)
+    def num_runs(self):
+        return len(self.test_history)
+    def threshold_check(self):
+        if self.mode == 'runout':
+            if self.num_runs() >= int(self.threshold):
+                return True
+        elif self.mode == 'timeout':
+            if self.elapsed_time() >= float(self.threshold):
+                return True
+        return False
+    def start_worker(self, slot, *args):
+        self.num_started += 1
+        run_dir = os.path.join(self.work_dir,
+                               '%s%d' % (self.run_name, self.num_started))
+        if not os.path.exists(run_dir):
+            os.makedirs(run_dir)
+        tool = copy.deepcopy(self.tool)
+        tool.knobs['stat_out'] = os.path.join(run_dir, 'stat.out')
+        tool.knobs['cpu'] = self.tool.knobs['cpu'] + slot
+        self.setup_worker_tool(tool, run_dir, *args)
+        prefix = []
+        prefix.append(self.pin.pin())
+        prefix.extend(self.pin.options())
+        prefix.extend(tool.options())
+        prefix.append('--')
+        test = copy.deepcopy(self.test)
+        test.set_prefix(prefix)
+        return self.create_worker(slot, run_dir, tool, test, *args)
+    def setup_worker_tool(self, tool, run_dir, *args):
+        pass
+    def create_worker(self, slot, run_dir, tool, test, *args):
+        raise NotImplementedError
+    def after_all_tests(self):
+        if self.is_fatal():
+            logging.msg('parallel %s fatal error detected\n' % self.name)
+        else:
+            logging.msg('parallel %s threshold reached\n' % self.name)
+    def log_stat(self):
+        runs = len(self.test_history)
+        used_time = self.used_time()
+        logging.msg('%-15s %d\n' % ('%s_runs' % self.name, runs))
+        logging.msg('%-15s %f\n' % ('%s_time' % self.name, used_time))
+        logging.msg('%-15s %d\n' % ('%s_workers' % self.name, self.num_workers))
@@ -490,6 +490,50 @@ def __command_active(argv):
                                             scheduler)
     testcase.run()
 
+def register_parallel_active_cmdline_options(parser, prefix=''):
+    register_active_cmdline_options(parser, prefix)
+    parser.add_option(
+            '--%snum_workers' % prefix,
+            action='store',
+            type='int',
+            dest='%snum_workers' % prefix,
+            default=0,
+            metavar='N',
+            help='the number of parallel workers (0 means the number of cpus)')
+    parser.add_option(
+            '--%swork_dir' % prefix,
+            action='store',
+            type='string',
+            dest='%swork_dir' % prefix,
+            default='parallel',
+            metavar='PATH',
+            help='the directory to store the outputs of each run')
+
+def __command_parallel_active(argv):
+    pin = pintool.Pin(config.pin_home())
+    scheduler = idiom_pintool.Scheduler()
+    # parse cmdline options
+    usage = 'usage: <script> parallel_active [options] --- program'
+    parser = optparse.OptionParser(usage)
+    register_parallel_active_cmdline_options(parser)
+    scheduler.register_cmdline_options(parser)
+    (opt_argv, prog_argv) = separate_opt_prog(argv)
+    if len(prog_argv) == 0:
+        parser.print_help()
+        sys.exit(0)
+    (options, args) = parser.parse_args(opt_argv)
+    scheduler.set_cmdline_options(options, args)
+    # run parallel active test
+    test = testing.InteractiveTest(prog_argv)
+    testcase = idiom_testing.ParallelActiveTestCase(test,
+                                                    options.mode,
+                                                    options.threshold,
+                                                    pin,
+                                                    scheduler,
+                                                    options.num_workers,
+                                                    options.work_dir)
+    testcase.run()
+
 def register_random_cmdline_options(parser, prefix=''):
     parser.add_option(
             '--%smode' % prefix,
@@ -855,6 +899,42 @@ def __command_active_script(argv):
                                             scheduler)
     testcase.run()
 
+def __command_parallel_active_script(argv):
+    pin = pintool.Pin(config.pin_home())
+    scheduler = idiom_pintool.Scheduler()
+    # parse cmdline options
+    usage = 'usage: <script> parallel_active_script [options] --- <bench name> <input index>\n\n'
+    usage += benchmark_usage()
+    parser = optparse.OptionParser(usage)
+    register_parallel_active_cmdline_options(parser)
+    scheduler.register_cmdline_options(parser)
+    (opt_argv, prog_argv) = separate_opt_prog(argv)
+    if len(prog_argv) == 1:
+        bench_name = prog_argv[0]
+        input_idx = 'default'
+    elif len(prog_argv) == 2:
+        bench_name = prog_argv[0]
+        input_idx = prog_argv[1]
+    else:
+        parser.print_help()
+        sys.exit(0)
+    if not valid_benchmark(bench_name):
+        logging.err('invalid benchmark name\n')
+    (options, args) = parser.parse_args(opt_argv)
+    scheduler.set_cmdline_options(options, args)
+    # run parallel active test
+    __import__('maple.benchmark.%s' % bench_name)
+    bench_mod = sys.modules['maple.benchmark.%s' % bench_name]
+    test = bench_mod.get_test(input_idx)
+    testcase = idiom_testing.ParallelActiveTestCase(test,
+                                                    options.mode,
+                                                    options.threshold,
+                                                    pin,
+                                                    scheduler,
+                                                    options.num_workers,
+                                                    options.work_dir)
+    testcase.run()
+
 def __command_native_script(argv):
     # parse cmdline options
     usage = 'usage: <script> native_script [options] --- <bench name> <input index>\n\n'
@@ -1175,6 +1255,15 @@ def __command_memo_tool(argv):
     memo_tool.set_cmdline_options(options, args)
     memo_tool.call()
 
+def __command_predict(argv):
+    usage = 'usage: <script> predict [options]'
+    parser = optparse.OptionParser(usage)
+    predictor = idiom_offline_tool.Predictor()
+    predictor.register_cmdline_options(parser)
+    (options, args) = parser.parse_args(argv)
+    predictor.set_cmdline_options(options, args)
+    predictor.call()
+
 def valid_command_set():
     result = set()
     for name in dir(sys.modules[__name__]):
@@ -44,6 +44,16 @@ class iRootInfo(object):
         self.proto.total_test_runs = n
     def set_async(self, a):
         self.proto.async = a
+    def unreached_test_runs(self):
+        return self.proto.unreached_test_runs
+    def has_event_time(self):
+        return self.proto.HasField('event_time')
+    def event_time(self):
+        return self.proto.event_time
+    def set_unreached_test_runs(self, n):
+        self.proto.unreached_test_runs = n
+    def set_event_time(self, t):
+        self.proto.event_time = t
     def __str__(self):
         content = []
         content.append(str(self.iroot()))
@@ -163,6 +173,10 @@ class Memo(object):
                     iroot_info.set_total_test_runs(other_iroot_info.total_test_runs())
                 if other_iroot_info.has_async() and other_iroot_info.async():
                     iroot_info.set_async(True)
+                if other_iroot_info.unreached_test_runs() > iroot_info.unreached_test_runs():
+                    iroot_info.set_unreached_test_runs(other_iroot_info.unreached_test_runs())
+                if other_iroot_info.has_event_time() and not iroot_info.has_event_time():
+                    iroot_info.set_event_time(other_iroot_info.event_time())
             else:
                 self.iroot_info_map[other_iroot_id] = other_iroot_info
         for other_iroot_info in other.exposed_set:
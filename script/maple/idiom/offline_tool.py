@@ -25,6 +25,7 @@ class MemoTool(offline_tool.OfflineTool):
         self.register_knob('debug_out', 'string', 'stdout', 'the output file for the debug messages')
         self.register_knob('sinfo_in', 'string', 'sinfo.db', 'the input static info database path', 'PATH')
         self.register_knob('sinfo_out', 'string', 'sinfo.db', 'the output static info database path', 'PATH')
+        self.register_knob('stat_out', 'string', 'stat.out', 'the statistics output file', 'PATH')
         self.register_knob('iroot_in', 'string', 'iroot.db', 'the input iroot database path', 'PATH')
         self.register_knob('iroot_out', 'string', 'iroot.db', 'the output iroot database path', 'PATH')
         self.register_knob('memo_in', 'string', 'memo.db', 'the input memoization database path', 'PATH')
@@ -33,6 +34,35 @@ class MemoTool(offline_tool.OfflineTool):
         self.register_knob('arg', 'string', 'null', 'the argument to the operation')
         self.register_knob('path', 'string', 'null', 'the path argument to the operation', 'PATH')
         self.register_knob('num', 'int', 0, 'the integer argument to the operation')
+        self.register_knob('merge_sinfo_in', 'string', 'null', 'the static info database path of the memo to merge', 'PATH')
+        self.register_knob('merge_iroot_in', 'string', 'null', 'the iroot database path of the memo to merge', 'PATH')
     def bin_path(self):
         return os.path.join(config.build_home(self.debug), 'idiom_memo_tool')
 
+class Predictor(offline_tool.OfflineTool):
+    def __init__(self):
+        offline_tool.OfflineTool.__init__(self, 'idiom_predict')
+        self.register_knob('debug_out', 'string', 'stdout', 'the output file for the debug messages')
+        self.register_knob('sinfo_in', 'string', 'sinfo.db', 'the input static info database path', 'PATH')
+        self.register_knob('sinfo_out', 'string', 'sinfo.db', 'the output static info database path', 'PATH')
+        self.register_knob('stat_out', 'string', 'stat.out', 'the statistics output file', 'PATH')
+        self.register_knob('trace_log_path', 'string', 'trace-log', 'the trace log path', 'PATH')
+        self.register_knob('memo_failed', 'bool', True, 'whether memoize fail-to-expose iroots')
+        self.register_knob('iroot_in', 'string', 'iroot.db', 'the input iroot database path', 'PATH')
+        self.register_knob('iroot_out', 'string', 'iroot.db', 'the output iroot database path', 'PATH')
+        self.register_knob('memo_in', 'string', 'memo.db', 'the input memoization database path', 'PATH')
+        self.register_knob('memo_out', 'string', 'memo.db', 'the output memoization database path', 'PATH')
+        self.register_knob('sinst_in', 'string', 'sinst.db', 'the input shared inst database path', 'PATH')
+        self.register_knob('num_workers', 'int', 0, 'the number of worker threads (0 means the number of cpus)')
+        self.register_knob('partition_size', 'int', 4096, 'the size of each address partition in bytes')
+        self.register_knob('enable_predictor_new', 'bool', True, 'whether enable the iroot predictor (NEW)')
+        self.register_knob('sync_only', 'bool', False, 'whether only monitor synchronization accesses')
+        self.register_knob('complex_idioms', 'bool', False, 'whether target complex idioms')
+        self.register_knob('single_var_idioms', 'bool', False, 'whether only target single variable idioms')
+        self.register_knob('racy_only', 'bool', False, 'whether only consider sync and racy memory dependencies')
+        self.register_knob('predict_deadlock', 'bool', False, 'whether predict and trigger deadlocks (experimental)')
+        self.register_knob('unit_size', 'int', 4, 'the monitoring granularity in bytes', 'SIZE')
+        self.register_knob('vw', 'int', 1000, 'the vulnerability window (# dynamic inst)', 'SIZE')
+    def bin_path(self):
+        return os.path.join(config.build_home(self.debug), 'idiom_predict')
+
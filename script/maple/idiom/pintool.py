@@ -58,6 +58,7 @@ class Predictor(analyzer.Analyzer):
         self.register_knob('predict_deadlock', 'bool', False, 'whether predict and trigger deadlocks (experimental)')
         self.register_knob('unit_size', 'int', 4, 'the monitoring granularity in bytes', 'SIZE')
         self.register_knob('vw', 'int', 1000, 'the vulnerability window (# dynamic inst)', 'SIZE')
+        self.register_knob('history_bytes', 'int', 0, 'the estimated memory budget in bytes of the access histories of all the locations, the least recently accessed locations are evicted first (0 means unlimited)', 'SIZE')
 
 class PredictorNew(analyzer.Analyzer):
     def __init__(self):
@@ -133,7 +134,9 @@ class ChessProfiler(Profiler):
         self.register_knob('race_out', 'string', 'race.db', 'the output race database path', 'PATH')
         self.schedulers = {}
         self.add_scheduler(scheduler.RandomScheduler())
+        self.add_scheduler(scheduler.PctScheduler())
         self.add_scheduler(scheduler.ChessScheduler())
+        self.add_scheduler(scheduler.ReplayScheduler())
     def so_path(self):
         return os.path.join(config.build_home(self.debug), 'idiom_chess_profiler.so')
     def add_scheduler(self, s):
@@ -155,6 +158,8 @@ class Scheduler(pintool.Pintool):
         self.register_knob('random_seed',  'int', 0, 'the random seed (0 means using current time)', 'SEED')
         self.register_knob('target_iroot', 'int', 0, 'the target iroot (0 means choosing any)', 'ID')
         self.register_knob('target_idiom', 'int', 0, 'the target idiom (0 means any idiom)', 'IDIOM')
+        self.register_knob('num_targets', 'int', 1, 'the max number of iroots to test in each run', 'NUM')
+        self.register_knob('memo_target', 'bool', False, 'whether update the memo for the iroot given by target_iroot')
         self.register_knob('memo_failed', 'bool', True, 'whether memoize fail-to-expose iroots')
         self.register_knob('yield_with_delay', 'bool', True, 'whether inject delays for async iroots')
         self.register_knob('test_history', 'string', 'test.histo', 'the test history file path', 'PATH')
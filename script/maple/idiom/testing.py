@@ -16,6 +16,9 @@ Authors - Jie Yu (jieyu@umich.edu)
 """
 
 import os
+import time
+import shutil
+import threading
 from maple.core import config
 from maple.core import logging
 from maple.core import static_info
@@ -38,6 +41,31 @@ def has_candidate(tool):
     else:
         return False
 
+def list_candidate(tool, num):
+    memo_tool = offline_tool.MemoTool()
+    memo_tool.knobs['operation'] = 'list_candidate'
+    memo_tool.knobs['arg'] = str(tool.knobs['target_idiom'])
+    memo_tool.knobs['num'] = num
+    memo_tool.knobs['sinfo_in'] = tool.knobs['sinfo_out']
+    memo_tool.knobs['iroot_in'] = tool.knobs['iroot_out']
+    memo_tool.knobs['memo_in'] = tool.knobs['memo_out']
+    stdout, stderr = memo_tool.run()
+    return [int(iroot_id) for iroot_id in stdout.split()]
+
+def merge_memo(tool, sinfo_path, iroot_path, memo_path):
+    memo_tool = offline_tool.MemoTool()
+    memo_tool.knobs['operation'] = 'merge'
+    memo_tool.knobs['sinfo_in'] = tool.knobs['sinfo_out']
+    memo_tool.knobs['sinfo_out'] = tool.knobs['sinfo_out']
+    memo_tool.knobs['iroot_in'] = tool.knobs['iroot_out']
+    memo_tool.knobs['iroot_out'] = tool.knobs['iroot_out']
+    memo_tool.knobs['memo_in'] = tool.knobs['memo_out']
+    memo_tool.knobs['memo_out'] = tool.knobs['memo_out']
+    memo_tool.knobs['merge_sinfo_in'] = sinfo_path
+    memo_tool.knobs['merge_iroot_in'] = iroot_path
+    memo_tool.knobs['path'] = memo_path
+    memo_tool.run()
+
 def predicted_size(tool):
     memo_tool = offline_tool.MemoTool()
     memo_tool.knobs['operation'] = 'total_predicted'
@@ -167,6 +195,119 @@ class ActiveTestCase(testing.DeathTestCase):
         logging.msg('%-15s %d\n' % ('active_runs', runs))
         logging.msg('%-15s %f\n' % ('active_time', used_time))
 
+class ActiveWorker(object):
+    """ An active test run by a worker of the parallel active test
+    case. The test runs in its own thread.
+    """
+    def __init__(self, cpu, iroot_id, run_dir, test):
+        self.cpu = cpu
+        self.iroot_id = iroot_id
+        self.run_dir = run_dir
+        self.test = test
+        self.thread = threading.Thread(target=test.run)
+    def path(self, name):
+        return os.path.join(self.run_dir, name)
+
+class ParallelActiveTestCase(testing.ParallelTestCase):
+    """ Run active tests on multiple cpus at the same time. Each
+    worker runs the scheduler pinned to its own cpu with its own target
+    iroot, reading a snapshot of the shared databases and writing all
+    its outputs to its own run directory. The coordinator (this test
+    case) is the only one that writes the shared databases: it hands
+    out the candidates from the shared memo and merges the memo of each
+    finished worker back (the iroots are matched by their instructions
+    as the workers may assign different ids to new iroots). The workers
+    update their memos for the target iroots, so the merged memo carries
+    the test runs and results of all the workers.
+    """
+    def __init__(self, test, mode, threshold, pin, scheduler, num_workers,
+                 work_dir):
+        testing.ParallelTestCase.__init__(self, 'active', 'run', test, mode,
+                                          threshold, pin, scheduler,
+                                          num_workers, work_dir)
+        self.scheduler = scheduler
+    def setup(self):
+        testing.ParallelTestCase.setup(self)
+        # the output databases are the shared ones
+        for name in ['sinfo', 'iroot', 'memo']:
+            db_in = self.scheduler.knobs['%s_in' % name]
+            db_out = self.scheduler.knobs['%s_out' % name]
+            if os.path.exists(db_in) and \
+               os.path.realpath(db_in) != os.path.realpath(db_out):
+                shutil.copyfile(db_in, db_out)
+    def body(self):
+        workers = {}
+        stop = False
+        while True:
+            # merge the results of the finished workers
+            for cpu in sorted(workers.keys()):
+                worker = workers[cpu]
+                if worker.thread.is_alive():
+                    continue
+                worker.thread.join()
+                del workers[cpu]
+                merge_memo(self.scheduler,
+                           worker.path('sinfo.db'),
+                           worker.path('iroot.db'),
+                           worker.path('memo.db'))
+                self.test_history.append(worker.test)
+                self.after_each_test(worker)
+                if worker.test.is_fatal():
+                    self.result = 'FATAL'
+                    stop = True
+            if not stop and self.threshold_check():
+                stop = True
+            # hand out candidates to the idle cpus, skipping the ones
+            # being tested (they are still candidates in the shared memo)
+            if not stop and len(workers) < self.num_workers:
+                testing_ids = set([w.iroot_id for w in workers.values()])
+                iroot_ids = list_candidate(self.scheduler, self.num_workers)
+                for iroot_id in iroot_ids:
+                    if len(workers) >= self.num_workers:
+                        break
+                    if iroot_id in testing_ids:
+                        continue
+                    for cpu in range(self.num_workers):
+                        if not cpu in workers:
+                            workers[cpu] = self.start_worker(cpu, iroot_id)
+                            break
+                    if self.threshold_check():
+                        stop = True
+                        break
+            # no candidate and no test in progress
+            if len(workers) == 0:
+                break
+            time.sleep(0.1)
+        if self.result == None:
+            self.result = 'NORMAL'
+        self.after_all_tests()
+    def num_runs(self):
+        # count the started runs so that no more runs are started than
+        # the threshold allows
+        return self.num_started
+    def setup_worker_tool(self, scheduler, run_dir, iroot_id):
+        # the worker reads a snapshot of the shared databases so that
+        # they can be merged while the worker is running
+        for name in ['sinfo', 'iroot', 'memo']:
+            db_path = os.path.join(run_dir, '%s.db' % name)
+            shutil.copyfile(self.scheduler.knobs['%s_out' % name], db_path)
+            scheduler.knobs['%s_in' % name] = db_path
+            scheduler.knobs['%s_out' % name] = db_path
+        scheduler.knobs['sinst_out'] = os.path.join(run_dir, 'sinst.db')
+        scheduler.knobs['test_history'] = os.path.join(run_dir, 'test.histo')
+        scheduler.knobs['target_iroot'] = iroot_id
+        scheduler.knobs['memo_target'] = True
+        scheduler.knobs['num_targets'] = 1
+    def create_worker(self, cpu, run_dir, scheduler, test, iroot_id):
+        worker = ActiveWorker(cpu, iroot_id, run_dir, test)
+        logging.msg('=== parallel active run %d started === (cpu %d) (iroot %d)\n' % (self.num_started, scheduler.knobs['cpu'], iroot_id))
+        worker.thread.start()
+        return worker
+    def after_each_test(self, worker):
+        used_time = worker.test.used_time()
+        logging.msg('=== parallel active run done === (%f) (%s)\n' % (used_time, worker.run_dir))
+        log_coverage(self.scheduler, used_time)
+
 class IdiomTestCase(testing.TestCase):
     """ Represent the default idiom test process, that is, profile
     first then active test.
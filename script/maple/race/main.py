@@ -25,6 +25,7 @@ from maple.core import pintool
 from maple.core import testing
 from maple.race import race
 from maple.race import pintool as race_pintool
+from maple.race import offline_tool as race_offline_tool
 from maple.race import testing as race_testing
 
 # global variables
@@ -202,6 +203,49 @@ def __command_djit(argv):
     testcase.run()
     testcase.log_stat()
 
+def __command_hybrid(argv):
+    pin = pintool.Pin(config.pin_home())
+    profiler = race_pintool.PctProfiler()
+    profiler.knob_defaults['enable_hybrid'] = True
+    # parse cmdline options
+    usage = 'usage: <script> hybrid [options] --- program'
+    parser = optparse.OptionParser(usage)
+    register_race_cmdline_options(parser)
+    profiler.register_cmdline_options(parser)
+    (opt_argv, prog_argv) = separate_opt_prog(argv)
+    if len(prog_argv) == 0:
+        parser.print_help()
+        sys.exit(0)
+    (options, args) = parser.parse_args(opt_argv)
+    profiler.set_cmdline_options(options, args)
+    # run hybrid race detector
+    test = testing.InteractiveTest(prog_argv)
+    test.set_prefix(get_prefix(pin, profiler))
+    testcase = race_testing.TestCase(test,
+                                     options.mode,
+                                     options.threshold,
+                                     profiler)
+    testcase.run()
+    testcase.log_stat()
+
+def __command_djit_offline(argv):
+    usage = 'usage: <script> djit_offline [options]'
+    parser = optparse.OptionParser(usage)
+    loader = race_offline_tool.Loader()
+    loader.register_cmdline_options(parser)
+    (options, args) = parser.parse_args(argv)
+    loader.set_cmdline_options(options, args)
+    loader.call()
+
+def __command_merge(argv):
+    usage = 'usage: <script> merge [options]'
+    parser = optparse.OptionParser(usage)
+    merge_tool = race_offline_tool.MergeTool()
+    merge_tool.register_cmdline_options(parser)
+    (options, args) = parser.parse_args(argv)
+    merge_tool.set_cmdline_options(options, args)
+    merge_tool.call()
+
 def valid_command_set():
     result = set()
     for name in dir(sys.modules[__name__]):
@@ -0,0 +1,53 @@
+"""Copyright 2011 The University of Michigan
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+Authors - Jie Yu (jieyu@umich.edu)
+"""
+
+import os
+from maple.core import config
+from maple.core import offline_tool
+
+class Loader(offline_tool.OfflineTool):
+    def __init__(self):
+        offline_tool.OfflineTool.__init__(self, 'race_loader')
+        self.register_knob('debug_out', 'string', 'stdout', 'the output file for the debug messages')
+        self.register_knob('sinfo_in', 'string', 'sinfo.db', 'the input static info database path', 'PATH')
+        self.register_knob('sinfo_out', 'string', 'sinfo.db', 'the output static info database path', 'PATH')
+        self.register_knob('stat_out', 'string', 'stat.out', 'the statistics output file', 'PATH')
+        self.register_knob('trace_log_path', 'string', 'trace-log', 'the trace log path', 'PATH')
+        self.register_knob('race_in', 'string', 'race.db', 'the input race database path', 'PATH')
+        self.register_knob('race_out', 'string', 'race.db', 'the output race database path', 'PATH')
+        self.register_knob('num_workers', 'int', 0, 'the number of worker threads (0 means the number of cpus)')
+        self.register_knob('partition_size', 'int', 4096, 'the size of each address partition in bytes')
+        self.register_knob('unit_size', 'int', 4, 'the monitoring granularity in bytes')
+        self.register_knob('enable_djit', 'bool', True, 'whether enable the djit data race detector')
+        self.register_knob('track_racy_inst', 'bool', False, 'whether track potential racy instructions')
+    def bin_path(self):
+        return os.path.join(config.build_home(self.debug), 'race_loader')
+
+class MergeTool(offline_tool.OfflineTool):
+    def __init__(self):
+        offline_tool.OfflineTool.__init__(self, 'race_merge')
+        self.register_knob('debug_out', 'string', 'stdout', 'the output file for the debug messages')
+        self.register_knob('sinfo_in', 'string', 'sinfo.db', 'the input static info database path', 'PATH')
+        self.register_knob('sinfo_out', 'string', 'sinfo.db', 'the output static info database path', 'PATH')
+        self.register_knob('stat_out', 'string', 'stat.out', 'the statistics output file', 'PATH')
+        self.register_knob('race_in', 'string', 'race.db', 'the input race database path', 'PATH')
+        self.register_knob('race_out', 'string', 'race.db', 'the output race database path', 'PATH')
+        self.register_knob('delta_path', 'string', 'race-delta', 'the directory that contains the race database deltas', 'PATH')
+        self.register_knob('num_workers', 'int', 0, 'the number of worker threads (0 means the number of cpus)')
+    def bin_path(self):
+        return os.path.join(config.build_home(self.debug), 'race_merge')
+
@@ -26,11 +26,16 @@ class Detector(analyzer.Analyzer):
         self.register_knob('unit_size', 'int', 4, 'the monitoring granularity in bytes', 'SIZE')
 
 class Djit(Detector):
-    def __init__(self):
-        Detector.__init__(self, 'race_djit')
+    def __init__(self, name='race_djit'):
+        Detector.__init__(self, name)
         self.register_knob('enable_djit', 'bool', False, 'whether enable the djit data race detector')
         self.register_knob('track_racy_inst', 'bool', False, 'whether track potential racy instructions')
 
+class Hybrid(Djit):
+    def __init__(self):
+        Djit.__init__(self, 'race_hybrid')
+        self.register_knob('enable_hybrid', 'bool', False, 'whether enable the hybrid (lock set and happens-before) data race detector')
+
 class Profiler(pintool.Pintool):
     def __init__(self, name='race_profiler'):
         pintool.Pintool.__init__(self, name)
@@ -41,7 +46,10 @@ class Profiler(pintool.Pintool):
         self.register_knob('sinfo_out', 'string', 'sinfo.db', 'the output static info database path', 'PATH')
         self.register_knob('race_in', 'string', 'race.db', 'the input race database path', 'PATH')
         self.register_knob('race_out', 'string', 'race.db', 'the output race database path', 'PATH')
+        self.register_knob('race_delta', 'bool', False, 'whether only save the races of this execution (to a new file under delta_path, to be merged by race_merge) without saving the static info and statistics')
+        self.register_knob('delta_path', 'string', 'race-delta', 'the directory that contains the race database deltas', 'PATH')
         self.add_analyzer(Djit())
+        self.add_analyzer(Hybrid())
     def so_path(self):
         return os.path.join(config.build_home(self.debug), 'race_profiler.so')
 
@@ -201,6 +201,7 @@ def __command_chess(argv):
     pin = pintool.Pin(config.pin_home())
     controller = systematic_pintool.Controller()
     controller.knob_defaults['enable_chess_scheduler'] = True
+    controller.knob_defaults['export_schedule'] = True
     # parse cmdline options
     usage = 'usage: <script> chess [options] --- program'
     parser = optparse.OptionParser(usage)
@@ -222,6 +223,60 @@ def __command_chess(argv):
     testcase.run()
     testcase.log_stat()
 
+def register_parallel_chess_cmdline_options(parser, prefix=''):
+    register_chess_cmdline_options(parser, prefix)
+    parser.add_option(
+            '--%snum_workers' % prefix,
+            action='store',
+            type='int',
+            dest='%snum_workers' % prefix,
+            default=0,
+            metavar='N',
+            help='the number of parallel workers (0 means the number of cpus)')
+    parser.add_option(
+            '--%swork_dir' % prefix,
+            action='store',
+            type='string',
+            dest='%swork_dir' % prefix,
+            default='parallel',
+            metavar='PATH',
+            help='the directory to store the outputs of each subtree')
+
+def __command_parallel_chess(argv):
+    pin = pintool.Pin(config.pin_home())
+    controller = systematic_pintool.Controller()
+    controller.knob_defaults['enable_chess_scheduler'] = True
+    controller.knob_defaults['export_schedule'] = True
+    # parse cmdline options
+    usage = 'usage: <script> parallel_chess [options] --- program'
+    parser = optparse.OptionParser(usage)
+    register_parallel_chess_cmdline_options(parser)
+    controller.register_cmdline_options(parser)
+    (opt_argv, prog_argv) = separate_opt_prog(argv)
+    if len(prog_argv) == 0:
+        parser.print_help()
+        sys.exit(0)
+    (options, args) = parser.parse_args(opt_argv)
+    controller.set_cmdline_options(options, args)
+    # the subtrees are split from the search stack between executions,
+    # which misses the backtrack entries that dpor adds above the split
+    # node later, and never happens while a fork server is running
+    if controller.knobs['dpor']:
+        logging.err('parallel_chess does not support dpor\n')
+    if controller.knobs['fork_server']:
+        logging.err('parallel_chess does not support fork_server\n')
+    # run parallel chess
+    test = testing.InteractiveTest(prog_argv)
+    testcase = systematic_testing.ParallelChessTestCase(test,
+                                                        options.mode,
+                                                        options.threshold,
+                                                        pin,
+                                                        controller,
+                                                        options.num_workers,
+                                                        options.work_dir)
+    testcase.run()
+    testcase.log_stat()
+
 def register_race_cmdline_options(parser, prefix=''):
     parser.add_option(
             '--%smode' % prefix,
@@ -250,6 +305,7 @@ def __command_chess_race(argv):
     controller = systematic_pintool.Controller()
     controller.knob_prefix = 'chess_'
     controller.knob_defaults['enable_chess_scheduler'] = True
+    controller.knob_defaults['export_schedule'] = True
     controller.knob_defaults['sched_race'] = True
     # parse cmdline options
     usage = 'usage: <script> chess_race [options] --- program'
@@ -286,6 +342,49 @@ def __command_chess_race(argv):
                                                     chess_testcase)
     testcase.run()
 
+def register_replay_cmdline_options(parser, prefix=''):
+    parser.add_option(
+            '--%smode' % prefix,
+            action='store',
+            type='string',
+            dest='%smode' % prefix,
+            default='runout',
+            metavar='MODE',
+            help='the replay mode: runout, timeout')
+    parser.add_option(
+            '--%sthreshold' % prefix,
+            action='store',
+            type='int',
+            dest='%sthreshold' % prefix,
+            default=1,
+            metavar='N',
+            help='the threshold (depends on mode)')
+
+def __command_replay(argv):
+    pin = pintool.Pin(config.pin_home())
+    controller = systematic_pintool.Controller()
+    controller.knob_defaults['enable_replay_scheduler'] = True
+    # parse cmdline options
+    usage = 'usage: <script> replay [options] --- program'
+    parser = optparse.OptionParser(usage)
+    register_replay_cmdline_options(parser)
+    controller.register_cmdline_options(parser)
+    (opt_argv, prog_argv) = separate_opt_prog(argv)
+    if len(prog_argv) == 0:
+        parser.print_help()
+        sys.exit(0)
+    (options, args) = parser.parse_args(opt_argv)
+    controller.set_cmdline_options(options, args)
+    # replay the exported schedule until the bug shows up
+    test = testing.InteractiveTest(prog_argv)
+    test.set_prefix(get_prefix(pin, controller))
+    testcase = testing.DeathTestCase(test, options.mode, options.threshold)
+    testcase.run()
+    if testcase.is_fatal():
+        logging.msg('replay fatal error detected\n')
+    else:
+        logging.msg('replay threshold reached\n')
+
 def valid_command_set():
     result = set()
     for name in dir(sys.modules[__name__]):
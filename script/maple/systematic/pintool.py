@@ -30,6 +30,8 @@ class Controller(pintool.Pintool):
         self.register_knob('sinfo_out', 'string', 'sinfo.db', 'the output static info database path', 'PATH')
         self.register_knob('sched_app', 'bool', True, 'whether only schedule operations from the application')
         self.register_knob('sched_race', 'bool', False, 'whether schedule racy memory operations (for racy programs)')
+        self.register_knob('sched_sinst', 'bool', False, 'whether schedule shared memory operations (using the shared inst database)')
+        self.register_knob('read_mostly_ratio', 'int', 10, 'coalesce the shared reads of the same address in a bbl if at most 1/ratio of the profiled reads follow a write (0 means never)', 'RATIO')
         self.register_knob('cpu', 'int', 0, 'which cpu to run on', 'CPU_ID')
         self.register_knob('unit_size', 'int', 4, 'the monitoring granularity in bytes', 'SIZE')
         self.register_knob('realtime_priority', 'int', 1, 'the realtime priority on which all the user thread should be run', 'PRIORITY')
@@ -37,8 +39,17 @@ class Controller(pintool.Pintool):
         self.register_knob('program_out', 'string', 'program.db', 'the output database for the modeled program', 'PATH')
         self.register_knob('race_in', 'string', 'race.db', 'the input race database path', 'PATH')
         self.register_knob('race_out', 'string', 'race.db', 'the output race database path', 'PATH')
+        self.register_knob('sinst_in', 'string', 'sinst.db', 'the input shared inst database path', 'PATH')
+        self.register_knob('fork_server', 'bool', False, 'whether fork each execution from the main function instead of restarting the program')
+        self.register_knob('fork_server_runs', 'int', 0, 'the maximum number of executions forked by the fork server (0 means until the search is done)', 'N')
+        self.register_knob('handoff_spin', 'int', 0, 'the number of spin iterations before a thread parks at a scheduling point', 'N')
+        self.register_knob('inline_schedule', 'bool', True, 'whether pick the next thread at a scheduling point directly instead of in the scheduler thread (random, pct and replay schedulers)')
+        self.register_knob('export_schedule', 'bool', False, 'whether export the schedule of each execution for replay')
+        self.register_knob('schedule_out', 'string', 'schedule.db', 'the output schedule file path', 'PATH')
         self.add_scheduler(scheduler.RandomScheduler())
+        self.add_scheduler(scheduler.PctScheduler())
         self.add_scheduler(scheduler.ChessScheduler())
+        self.add_scheduler(scheduler.ReplayScheduler())
     def so_path(self):
         return os.path.join(config.build_home(self.debug), 'systematic_controller.so')
     def add_scheduler(self, s):
@@ -26,6 +26,16 @@ class RandomScheduler(Scheduler):
     def __init__(self):
         Scheduler.__init__(self, 'random_scheduler')
         self.register_knob('enable_random_scheduler', 'bool', False, 'whether use the random scheduler')
+        self.register_knob('random_seed', 'int', 0, 'the random seed of the random scheduler (0 means use the current time)', 'SEED')
+
+class PctScheduler(Scheduler):
+    def __init__(self):
+        Scheduler.__init__(self, 'pct_scheduler')
+        self.register_knob('enable_pct_scheduler', 'bool', False, 'whether use the pct scheduler')
+        self.register_knob('pct_depth', 'int', 3, 'the target bug depth of the pct scheduler', 'DEPTH')
+        self.register_knob('pct_seed', 'int', 0, 'the random seed of the pct scheduler (0 means use the current time)', 'SEED')
+        self.register_knob('pct_steps', 'int', 0, 'the estimated number of schedule points in a run (0 means use the history)', 'N')
+        self.register_knob('pct_history', 'string', 'pct_sched.histo', 'the pct scheduler history file path', 'PATH')
 
 class ChessScheduler(Scheduler):
     def __init__(self):
@@ -34,9 +44,16 @@ class ChessScheduler(Scheduler):
         self.register_knob('fair', 'bool', True, 'whether enable the fair control module')
         self.register_knob('pb', 'bool', True, 'whether enable preemption bound search')
         self.register_knob('por', 'bool', True, 'whether enable parital order reduction')
+        self.register_knob('dpor', 'bool', False, 'whether enable dynamic partial order reduction')
+        self.register_knob('por_verify', 'bool', False, 'whether verify state hash hits by matching the past executions')
         self.register_knob('abort_diverge', 'bool', True, 'whether abort when divergence happens')
         self.register_knob('pb_limit', 'int', 2, 'the maximum number of preemption an execution can have', 'LIMIT')
         self.register_knob('search_in', 'string', 'search.db', 'the input file that contains the search information', 'PATH')
         self.register_knob('search_out', 'string', 'search.db', 'the output file that contains the search information', 'PATH')
         self.register_knob('por_info_path', 'string', 'por-info', 'the dir path that stores the partial order reduction information', 'PATH')
 
+class ReplayScheduler(Scheduler):
+    def __init__(self):
+        Scheduler.__init__(self, 'replay_scheduler')
+        self.register_knob('enable_replay_scheduler', 'bool', False, 'whether use the replay scheduler')
+        self.register_knob('schedule_in', 'string', 'schedule.db', 'the input schedule file path', 'PATH')
@@ -16,6 +16,7 @@ Authors - Jie Yu (jieyu@umich.edu)
 """
 
 import os
+import struct
 from maple.core import proto
 from maple.systematic import program
 
@@ -71,12 +72,16 @@ class SearchNode(object):
         return self.program.find_thread(self.proto.backtrack[idx])
     def done(self, idx):
         return self.program.find_thread(self.proto.done[idx])
+    def explored(self, idx):
+        return self.program.find_thread(self.proto.explored[idx])
     def enabled(self, idx):
         return self.enabled_vec[idx]
     def num_backtrack(self):
         return len(self.proto.backtrack)
     def num_done(self):
         return len(self.proto.done)
+    def num_explored(self):
+        return len(self.proto.explored)
     def num_enabled(self):
         return len(self.enabled_vec)
     def __str__(self):
@@ -90,6 +95,10 @@ class SearchNode(object):
         for idx in range(len(self.proto.done)):
             content.append('%d ' % self.done(idx).uid())
         content.append('\n')
+        content.append('explored: ')
+        for idx in range(len(self.proto.explored)):
+            content.append('%d ' % self.explored(idx).uid())
+        content.append('\n')
         content.append('enabled:\n')
         for idx in range(len(self.proto.enabled)):
             content.append('   %s\n' % str(self.enabled(idx)))
@@ -102,14 +111,104 @@ class SearchInfo(object):
         self.proto = search_pb2().SearchInfoProto()
         self.node_vec = []
     def load(self, db_name):
-        if not os.path.exists(db_name):
-            return
-        f = open(db_name, 'rb')
-        self.proto.ParseFromString(f.read())
-        f.close()
+        if os.path.exists(db_name):
+            f = open(db_name, 'rb')
+            self.proto.ParseFromString(f.read())
+            f.close()
+        self.load_log(db_name + '.log')
         for node_proto in self.proto.node:
             node = SearchNode(node_proto, self)
             self.node_vec.append(node)
+    def load_log(self, log_name):
+        """ Apply the deltas appended to the search log after the
+        snapshot. Each delta is prefixed with its size, and the log
+        ends at the first incomplete delta.
+        """
+        if not os.path.exists(log_name):
+            return
+        f = open(log_name, 'rb')
+        content = f.read()
+        f.close()
+        offset = 0
+        while offset + 4 <= len(content):
+            size = struct.unpack('=I', content[offset:offset+4])[0]
+            if offset + 4 + size > len(content):
+                break
+            delta = search_pb2().SearchDeltaProto()
+            try:
+                delta.ParseFromString(content[offset+4:offset+4+size])
+            except Exception:
+                break
+            offset += 4 + size
+            # skip the deltas that are already in the snapshot
+            if delta.num_runs <= self.proto.num_runs:
+                continue
+            if delta.base_size > len(self.proto.node):
+                break
+            del self.proto.node[delta.base_size:]
+            for idx, delta_node in zip(delta.node_idx, delta.node):
+                if idx == len(self.proto.node):
+                    self.proto.node.add().CopyFrom(delta_node)
+                    continue
+                # the enabled set of an existing node never changes
+                node_proto = self.proto.node[idx]
+                node_proto.sel = delta_node.sel
+                del node_proto.backtrack[:]
+                node_proto.backtrack.extend(delta_node.backtrack)
+                del node_proto.done[:]
+                node_proto.done.extend(delta_node.done)
+                del node_proto.explored[:]
+                node_proto.explored.extend(delta_node.explored)
+            self.proto.done = delta.done
+            self.proto.num_runs = delta.num_runs
+    def save(self, db_name):
+        # always save a full snapshot, thus the log is obsolete
+        f = open(db_name, 'wb')
+        f.write(self.proto.SerializeToString())
+        f.close()
+        if os.path.exists(db_name + '.log'):
+            os.remove(db_name + '.log')
+    def split(self):
+        """ Steal unexplored backtrack entries from the search stack so
+        that they can be explored independently. The shallowest node
+        that has unexplored entries is split (its subtrees are the
+        largest). Half of its entries are moved to a new search info
+        whose stack ends at that node, and they are marked as done in
+        this one. Return None if nothing can be stolen. The split is not
+        sound with dpor, which adds backtrack entries to the nodes above
+        the split node in later executions.
+        """
+        for idx in range(len(self.proto.node)):
+            node_proto = self.proto.node[idx]
+            undone = []
+            for uid in node_proto.backtrack:
+                if not uid in node_proto.done:
+                    undone.append(uid)
+            # the last node is the frontier of the next execution, thus
+            # it needs to keep at least one entry to explore
+            if idx == len(self.proto.node) - 1:
+                num_stolen = len(undone) / 2
+            else:
+                num_stolen = (len(undone) + 1) / 2
+            if num_stolen == 0:
+                continue
+            stolen = undone[len(undone)-num_stolen:]
+            result = SearchInfo(self.sinfo, self.program)
+            for prefix_idx in range(idx + 1):
+                prefix_proto = result.proto.node.add()
+                prefix_proto.CopyFrom(self.proto.node[prefix_idx])
+                # the nodes above the split node are explored by this
+                # search, and only the stolen entries are left in the
+                # split node
+                for uid in prefix_proto.backtrack:
+                    if prefix_idx == idx and uid in stolen:
+                        continue
+                    if not uid in prefix_proto.done:
+                        prefix_proto.done.append(uid)
+                result.node_vec.append(SearchNode(prefix_proto, result))
+            node_proto.done.extend(stolen)
+            return result
+        return None
     def done(self):
         return self.proto.done
     def num_runs(self):
@@ -16,6 +16,10 @@ Authors - Jie Yu (jieyu@umich.edu)
 """
 
 import os
+import copy
+import time
+import shutil
+import threading
 from maple.core import logging
 from maple.core import static_info
 from maple.core import testing
@@ -58,6 +62,132 @@ class ChessTestCase(testing.DeathTestCase):
         logging.msg('%-15s %d\n' % ('chess_runs', runs))
         logging.msg('%-15s %f\n' % ('chess_time', used_time))
 
+class ChessWorker(object):
+    """ A subtree of the parallel CHESS search explored by a worker.
+    The executions are run one by one in the worker's own thread.
+    """
+    def __init__(self, slot, run_dir, test, testcase):
+        self.slot = slot
+        self.run_dir = run_dir
+        self.test = test
+        self.testcase = testcase
+        self.thread = threading.Thread(target=self.loop)
+    def path(self, name):
+        return os.path.join(self.run_dir, name)
+    def search_done(self):
+        search_info = search.SearchInfo(None, None)
+        search_info.load(self.path('search.db'))
+        return search_info.done()
+    def loop(self):
+        while True:
+            test = copy.deepcopy(self.test)
+            test.run()
+            if not self.testcase.after_each_run(self, test):
+                break
+            if self.search_done():
+                break
+        self.testcase.after_each_subtree(self)
+
+class ParallelChessTestCase(testing.ParallelTestCase):
+    """ Run the CHESS search on multiple cpus at the same time. The
+    search tree is split into independent subtrees, each explored by a
+    worker with its own databases and search stack in its own run
+    directory. When a worker finishes its subtree, the cpu is given to a
+    subtree stolen from a running worker (see SearchInfo.split). The
+    stealing happens between two executions of the victim so that its
+    search stack is not being written. The thief gets a copy of the
+    static info and program databases of the victim because the search
+    stack refers to them.
+    """
+    def __init__(self, test, mode, threshold, pin, controller, num_workers,
+                 work_dir):
+        testing.ParallelTestCase.__init__(self, 'chess', 'subtree', test,
+                                          mode, threshold, pin, controller,
+                                          num_workers, work_dir)
+        self.controller = controller
+        self.workers = {}
+        self.lock = threading.Lock()
+        self.stop = False
+    def body(self):
+        # the first worker explores the whole search tree
+        self.lock.acquire()
+        worker = self.start_worker(0)
+        for name in ['sinfo', 'program', 'search']:
+            db_in = self.controller.knobs['%s_in' % name]
+            if os.path.exists(db_in):
+                shutil.copyfile(db_in, worker.path('%s.db' % name))
+        worker.thread.start()
+        self.lock.release()
+        # wait until all the subtrees are done
+        while True:
+            self.lock.acquire()
+            num_running = len(self.workers)
+            self.lock.release()
+            if num_running == 0:
+                break
+            time.sleep(0.1)
+        if self.result == None:
+            self.result = 'NORMAL'
+        self.after_all_tests()
+    def after_each_run(self, worker, test):
+        """ Called by a worker after each execution. Return whether the
+        worker should continue.
+        """
+        self.lock.acquire()
+        self.test_history.append(test)
+        iteration = len(self.test_history)
+        logging.msg('=== parallel chess iteration %d done === (%f) (%s)\n' % (iteration, test.used_time(), worker.run_dir))
+        if test.is_fatal():
+            self.result = 'FATAL'
+            self.stop = True
+        if not self.stop and self.threshold_check():
+            self.stop = True
+        # give the idle cpus the subtrees stolen from this worker
+        if not self.stop:
+            self.rebalance(worker)
+        stop = self.stop
+        self.lock.release()
+        return not stop
+    def after_each_subtree(self, worker):
+        self.lock.acquire()
+        del self.workers[worker.slot]
+        logging.msg('=== parallel chess subtree done === (%s)\n' % worker.run_dir)
+        self.lock.release()
+    def rebalance(self, victim):
+        while len(self.workers) < self.num_workers:
+            search_info = search.SearchInfo(None, None)
+            search_info.load(victim.path('search.db'))
+            if search_info.done():
+                break
+            stolen = search_info.split()
+            if stolen == None:
+                break
+            for slot in range(self.num_workers):
+                if not slot in self.workers:
+                    break
+            thief = self.start_worker(slot)
+            for name in ['sinfo', 'program']:
+                shutil.copyfile(victim.path('%s.db' % name),
+                                thief.path('%s.db' % name))
+            stolen.save(thief.path('search.db'))
+            search_info.save(victim.path('search.db'))
+            logging.msg('=== parallel chess subtree stolen === (%s -> %s)\n' % (victim.run_dir, thief.run_dir))
+            thief.thread.start()
+    def setup_worker_tool(self, controller, run_dir):
+        for name in ['sinfo', 'program', 'search']:
+            db_path = os.path.join(run_dir, '%s.db' % name)
+            controller.knobs['%s_in' % name] = db_path
+            controller.knobs['%s_out' % name] = db_path
+        controller.knobs['por_info_path'] = os.path.join(run_dir, 'por-info')
+        controller.knobs['schedule_out'] = os.path.join(run_dir, 'schedule.db')
+    def create_worker(self, slot, run_dir, controller, test):
+        worker = ChessWorker(slot, run_dir, test, self)
+        self.workers[slot] = worker
+        return worker
+    def log_stat(self):
+        testing.ParallelTestCase.log_stat(self)
+        logging.msg('%-15s %d\n' % ('chess_subtrees', self.num_started))
+
 class RaceTestCase(race_testing.TestCase):
     """ Run race detector to find all racy instructions.
     """
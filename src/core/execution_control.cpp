@@ -35,6 +35,7 @@ ExecutionControl::ExecutionControl()
       callstack_info_(NULL),
       debug_analyzer_(NULL),
       main_thread_started_(false),
+      read_only_(false),
       main_thd_id_(INVALID_THD_ID) {
   // Empty.
 }
@@ -428,11 +429,13 @@ void ExecutionControl::ProgramStart() {
 void ExecutionControl::ProgramExit(INT32 code, VOID *v) {
   HandleProgramExit();
 
-  // save static info
-  sinfo_->Save(knob_->ValueStr("sinfo_out"));
+  if (!read_only_) {
+    // save static info
+    sinfo_->Save(knob_->ValueStr("sinfo_out"));
 
-  // write statistics
-  stat_display(knob_->ValueStr("stat_out"));
+    // write statistics
+    stat_display(knob_->ValueStr("stat_out"));
+  }
 
   // close debug file if exists
   if (debug_file_)
@@ -487,6 +490,43 @@ void ExecutionControl::ThreadExit(THREADID tid, const CONTEXT *ctxt, INT32 code,
   os_tid_map_.erase(os_tid);
 }
 
+void ExecutionControl::AfterForkInChild(THREADID tid, const CONTEXT *ctxt,
+                                        VOID *v) {
+  // only the forking thread exists in the child, and it has a new os
+  // tid. rekey its entries in the os tid maps so that the threads it
+  // creates can find their parent, and drop the other threads.
+  thread_id_t curr_thd_id = PIN_ThreadUid();
+  OS_THREAD_ID os_tid = PIN_GetTid();
+  OS_THREAD_ID old_os_tid = INVALID_OS_THREAD_ID;
+
+  LockKernel();
+  for (std::map<OS_THREAD_ID, thread_id_t>::iterator it = os_tid_map_.begin();
+       it != os_tid_map_.end(); ++it) {
+    if (it->second == curr_thd_id) {
+      old_os_tid = it->first;
+      break;
+    }
+  }
+  Semaphore *sem = NULL;
+  for (std::map<OS_THREAD_ID, Semaphore *>::iterator it =
+           thd_create_sem_map_.begin();
+       it != thd_create_sem_map_.end(); ++it) {
+    if (it->first == old_os_tid)
+      sem = it->second;
+    else
+      delete it->second;
+  }
+  thd_create_sem_map_.clear();
+  os_tid_map_.clear();
+  child_thd_map_.clear();
+  thd_create_sem_map_[os_tid] = sem ? sem : CreateSemaphore(0);
+  os_tid_map_[os_tid] = curr_thd_id;
+  UnlockKernel();
+
+  // call handler
+  HandleAfterForkInChild();
+}
+
 void ExecutionControl::HandlePreSetup() {
   // empty (register knobs)
 }
@@ -594,6 +634,10 @@ void ExecutionControl::HandleThreadExit() {
   CALL_ANALYSIS_FUNC(ThreadExit, self, curr_thd_clk);
 }
 
+void ExecutionControl::HandleAfterForkInChild() {
+  // empty
+}
+
 void ExecutionControl::HandleMain(THREADID tid, CONTEXT *ctxt) {
   thread_id_t self = Self();
   timestamp_t curr_thd_clk = GetThdClk(tid);
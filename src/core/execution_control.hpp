@@ -135,6 +135,11 @@
                            VOID *v) {                                       \
     ctrl->ThreadExit(tid, ctxt, code, v);                                   \
   }                                                                         \
+  static VOID I_AfterForkInChild(THREADID tid,                              \
+                                 const CONTEXT *ctxt,                       \
+                                 VOID *v) {                                 \
+    ctrl->AfterForkInChild(tid, ctxt, v);                                   \
+  }                                                                         \
   int main(int argc, char *argv[]) {                                        \
     ctrl->Initialize();                                                     \
     ctrl->PreSetup();                                                       \
@@ -151,6 +156,7 @@
     PIN_AddFiniFunction(I_ProgramExit, NULL);                               \
     PIN_AddThreadStartFunction(I_ThreadStart, NULL);                        \
     PIN_AddThreadFiniFunction(I_ThreadExit, NULL);                          \
+    PIN_AddForkFunction(FPOINT_AFTER_IN_CHILD, I_AfterForkInChild, NULL);   \
     I_ProgramStart();                                                       \
     PIN_StartProgram();                                                     \
   }
@@ -177,6 +183,7 @@ class ExecutionControl {
   void ProgramExit(INT32 code, VOID *v);
   void ThreadStart(THREADID tid, CONTEXT *ctxt, INT32 flags, VOID *v);
   void ThreadExit(THREADID tid, const CONTEXT *ctxt, INT32 code, VOID *v);
+  void AfterForkInChild(THREADID tid, const CONTEXT *ctxt, VOID *v);
 
  protected:
   typedef std::list<Analyzer *> AnalyzerContainer;
@@ -205,6 +212,7 @@ class ExecutionControl {
                                     const CONTEXT *ctxt_from, CONTEXT *ctxt_to);
   virtual void HandleThreadStart();
   virtual void HandleThreadExit();
+  virtual void HandleAfterForkInChild();
   virtual void HandleMain(THREADID tid, CONTEXT *ctxt);
   virtual void HandleThreadMain(THREADID tid, CONTEXT *ctxt);
   virtual void HandleBeforeMemRead(THREADID tid, Inst *inst, address_t addr,
@@ -255,6 +263,7 @@ class ExecutionControl {
   AnalyzerContainer analyzers_;
   DebugAnalyzer *debug_analyzer_;
   volatile bool main_thread_started_;
+  bool read_only_; // whether not to save the static info and statistics
   timestamp_t tls_thd_clock_[PIN_MAX_THREADS];
   address_t tls_read_addr_[PIN_MAX_THREADS];
   size_t tls_read_size_[PIN_MAX_THREADS];
@@ -45,6 +45,10 @@ bool LockSet::Match(LockSet *ls) {
 }
 
 bool LockSet::Disjoint(LockSet *ls) {
+  // iterate the smaller set
+  if (set_.size() > ls->set_.size())
+    return ls->Disjoint(this);
+
   for (LockVersionMap::iterator it = set_.begin(); it != set_.end(); ++it) {
     LockVersionMap::iterator mit = ls->set_.find(it->first);
     if (mit != ls->set_.end())
@@ -66,6 +70,22 @@ bool LockSet::Disjoint(LockSet *rmt_ls1, LockSet *rmt_ls2) {
   return true;
 }
 
+void LockSet::Intersect(LockSet *ls) {
+  // remove the locks that are not in ls (the versions are kept), both
+  // sets are sorted by lock address, thus a single merge pass suffices
+  LockVersionMap::iterator it = set_.begin();
+  LockVersionMap::iterator mit = ls->set_.begin();
+  while (it != set_.end()) {
+    if (mit == ls->set_.end() || it->first < mit->first) {
+      set_.erase(it++);
+    } else {
+      if (it->first == mit->first)
+        ++it;
+      ++mit;
+    }
+  }
+}
+
 std::string LockSet::ToString() {
   std::stringstream ss;
   ss << "[";
@@ -41,6 +41,7 @@ class LockSet {
   bool Match(LockSet *ls);
   bool Disjoint(LockSet *ls);
   bool Disjoint(LockSet *rmt_ls1, LockSet *rmt_ls2);
+  void Intersect(LockSet *ls);
   std::string ToString();
   void IterBegin() { it_ = set_.begin(); }
   bool IterEnd() { return it_ == set_.end(); }
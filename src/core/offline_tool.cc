@@ -19,6 +19,10 @@
 
 #include "core/offline_tool.h"
 
+#include <unistd.h>
+
+#include "core/stat.h"
+
 OfflineTool *OfflineTool::tool_ = NULL;
 
 OfflineTool::OfflineTool()
@@ -36,6 +40,7 @@ OfflineTool::~OfflineTool() {
 
 void OfflineTool::Initialize() {
   logging_init(CreateMutex());
+  stat_init(CreateMutex());
   kernel_lock_ = CreateMutex();
   Knob::Initialize(new CmdlineKnob);
   knob_ = Knob::Get();
@@ -46,6 +51,7 @@ void OfflineTool::PreSetup() {
   knob_->RegisterStr("debug_out", "the output file for the debug messages", "stdout");
   knob_->RegisterStr("sinfo_in", "the input static info database path", "sinfo.db");
   knob_->RegisterStr("sinfo_out", "the output static info database path", "sinfo.db");
+  knob_->RegisterStr("stat_out", "the statistics output file", "stat.out");
 
   HandlePreSetup();
 }
@@ -88,6 +94,9 @@ void OfflineTool::Exit() {
     sinfo_->Save(knob_->ValueStr("sinfo_out"));
   }
 
+  // display statistics
+  stat_display(knob_->ValueStr("stat_out"));
+
   // close debug file if exists
   if (debug_file_)
     debug_file_->Close();
@@ -112,3 +121,21 @@ void OfflineTool::HandleExit() {
   // empty
 }
 
+int OfflineTool::NumWorkers(int num_workers) {
+  // non-positive means the number of cpus
+  if (num_workers <= 0)
+    num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+  if (num_workers <= 0)
+    num_workers = 1;
+  return num_workers;
+}
+
+address_t OfflineTool::PartitionSize(address_t size, address_t unit_size) {
+  // the partition size is a power of 2 no smaller than the unit size
+  // so that an address partition never splits a monitoring unit
+  address_t partition_size = unit_size;
+  while (partition_size < size)
+    partition_size <<= 1;
+  return partition_size;
+}
+
@@ -44,6 +44,10 @@ class OfflineTool {
   virtual void HandleStart();
   virtual void HandleExit();
 
+  // helpers for the tools that use worker threads
+  static int NumWorkers(int num_workers);
+  static address_t PartitionSize(address_t size, address_t unit_size);
+
   Mutex *kernel_lock_;
   Knob *knob_;
   LogFile *debug_file_;
@@ -0,0 +1,255 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: core/shadow_map.h - Define the shadow map which maps monitored
+// memory units to their meta data.
+
+#ifndef CORE_SHADOW_MAP_H_
+#define CORE_SHADOW_MAP_H_
+
+#include <cstring>
+#include <vector>
+#include <tr1/unordered_map>
+
+#include "core/basictypes.h"
+
+// the size of the address range covered by a shadow page. it matches
+// the os page size because the regions passed to free, memset and the
+// like are usually page sized or larger: freeing 1MB costs 256 page
+// lookups instead of 8K with 128-byte pages.
+#define SHADOW_PAGE_SIZE 4096
+
+// the size of the address range covered by a chunk of slots. a shadow
+// page only allocates the chunks that are touched, so a sparsely
+// touched page costs its chunk table (128 bytes on 64-bit hosts) plus
+// 512 bytes per touched chunk with 4-byte units, instead of 8KB.
+#define SHADOW_CHUNK_SIZE 256
+
+#ifndef MAX
+#define MAX(a, b) (((a)>(b)) ? (a) : (b))
+#endif
+
+// The shadow map groups the meta data of the units in the same address
+// range into a shadow page (a table of lazily allocated chunks of
+// slots). A lookup costs one hash operation, just like a flat hash
+// table. However, removing the meta data of a freed region only needs
+// one hash operation per shadow page instead of one per unit, and the
+// untouched pages and chunks are skipped.
+template <typename T>
+class ShadowMap {
+ public:
+  ShadowMap()
+      : unit_size_(0),
+        page_size_(0),
+        chunk_size_(0),
+        num_chunks_(0),
+        num_slots_(0),
+        size_(0),
+        chunk_count_(0) {}
+  ~ShadowMap() { Clear(); }
+
+  // the unit size must be a power of 2
+  void Setup(address_t unit_size) {
+    unit_size_ = unit_size;
+    page_size_ = MAX(unit_size, SHADOW_PAGE_SIZE);
+    chunk_size_ = MAX(unit_size, SHADOW_CHUNK_SIZE);
+    num_chunks_ = page_size_ / chunk_size_;
+    num_slots_ = chunk_size_ / unit_size;
+  }
+
+  size_t Size() { return size_; }
+
+  T *Find(address_t iaddr) {
+    typename PageTable::iterator it = page_table_.find(PageAddr(iaddr));
+    if (it == page_table_.end())
+      return NULL;
+    Chunk *chunk = it->second->chunks[ChunkIndex(iaddr)];
+    if (!chunk)
+      return NULL;
+    return chunk->slots[SlotIndex(iaddr)];
+  }
+
+  void Insert(address_t iaddr, T *value) {
+    Page *&page = page_table_[PageAddr(iaddr)];
+    if (!page)
+      page = NewPage();
+    Chunk *&chunk = page->chunks[ChunkIndex(iaddr)];
+    if (!chunk)
+      chunk = NewChunk();
+    T *&slot = chunk->slots[SlotIndex(iaddr)];
+    if (!slot) {
+      chunk->count++;
+      page->count++;
+      size_++;
+    }
+    slot = value;
+  }
+
+  // remove the meta data of the units in [start_addr, end_addr), the
+  // removed values are appended to the vector
+  void RemoveRange(address_t start_addr, address_t end_addr,
+                   std::vector<T *> *removed) {
+    if (!size_)
+      return;
+    for (address_t page_addr = PageAddr(start_addr); page_addr < end_addr;
+         page_addr += page_size_) {
+      typename PageTable::iterator it = page_table_.find(page_addr);
+      if (it == page_table_.end())
+        continue;
+      Page *page = it->second;
+      size_t start_chunk = 0;
+      size_t end_chunk = num_chunks_;
+      if (start_addr > page_addr)
+        start_chunk = ChunkIndex(start_addr);
+      if (end_addr < page_addr + page_size_)
+        end_chunk = ChunkIndex(end_addr - 1) + 1;
+      for (size_t cidx = start_chunk; cidx < end_chunk && page->count;
+           cidx++) {
+        Chunk *chunk = page->chunks[cidx];
+        if (!chunk)
+          continue;
+        address_t chunk_addr = page_addr + cidx * chunk_size_;
+        size_t start_idx = 0;
+        size_t end_idx = num_slots_;
+        if (start_addr > chunk_addr)
+          start_idx = SlotIndex(start_addr);
+        if (end_addr < chunk_addr + chunk_size_)
+          end_idx = SlotIndex(end_addr);
+        for (size_t idx = start_idx; idx < end_idx && chunk->count; idx++) {
+          if (chunk->slots[idx]) {
+            removed->push_back(chunk->slots[idx]);
+            chunk->slots[idx] = NULL;
+            chunk->count--;
+            page->count--;
+            size_--;
+          }
+        }
+        if (!chunk->count) {
+          DeleteChunk(chunk);
+          page->chunks[cidx] = NULL;
+        }
+      }
+      if (!page->count) {
+        DeletePage(page);
+        page_table_.erase(it);
+      }
+    }
+  }
+
+  // get all the values in the map
+  void GetValues(std::vector<T *> *values) {
+    for (typename PageTable::iterator it = page_table_.begin();
+         it != page_table_.end(); ++it) {
+      Page *page = it->second;
+      for (size_t cidx = 0; cidx < num_chunks_; cidx++) {
+        Chunk *chunk = page->chunks[cidx];
+        if (!chunk)
+          continue;
+        for (size_t idx = 0; idx < num_slots_; idx++) {
+          if (chunk->slots[idx])
+            values->push_back(chunk->slots[idx]);
+        }
+      }
+    }
+  }
+
+  // remove all the entries (the values are not deleted)
+  void Clear() {
+    for (typename PageTable::iterator it = page_table_.begin();
+         it != page_table_.end(); ++it) {
+      DeletePage(it->second);
+    }
+    page_table_.clear();
+    size_ = 0;
+  }
+
+  // the memory used by the map itself
+  size_t Bytes() {
+    return page_table_.size() * (sizeof(Page) + num_chunks_ * sizeof(Chunk *))
+        + chunk_count_ * (sizeof(Chunk) + num_slots_ * sizeof(T *));
+  }
+
+ private:
+  struct Chunk {
+    size_t count; // the number of non-empty slots
+    T **slots;
+  };
+
+  struct Page {
+    size_t count; // the number of non-empty slots
+    Chunk **chunks;
+  };
+
+  typedef std::tr1::unordered_map<address_t, Page *> PageTable;
+
+  address_t PageAddr(address_t addr) {
+    return UNIT_DOWN_ALIGN(addr, page_size_);
+  }
+
+  size_t ChunkIndex(address_t addr) {
+    return (addr - PageAddr(addr)) / chunk_size_;
+  }
+
+  size_t SlotIndex(address_t addr) {
+    return (addr - UNIT_DOWN_ALIGN(addr, chunk_size_)) / unit_size_;
+  }
+
+  Page *NewPage() {
+    Page *page = new Page;
+    page->count = 0;
+    page->chunks = new Chunk *[num_chunks_];
+    memset(page->chunks, 0, num_chunks_ * sizeof(Chunk *));
+    return page;
+  }
+
+  void DeletePage(Page *page) {
+    for (size_t cidx = 0; cidx < num_chunks_; cidx++) {
+      if (page->chunks[cidx])
+        DeleteChunk(page->chunks[cidx]);
+    }
+    delete [] page->chunks;
+    delete page;
+  }
+
+  Chunk *NewChunk() {
+    Chunk *chunk = new Chunk;
+    chunk->count = 0;
+    chunk->slots = new T *[num_slots_];
+    memset(chunk->slots, 0, num_slots_ * sizeof(T *));
+    chunk_count_++;
+    return chunk;
+  }
+
+  void DeleteChunk(Chunk *chunk) {
+    delete [] chunk->slots;
+    delete chunk;
+    chunk_count_--;
+  }
+
+  address_t unit_size_;
+  address_t page_size_;
+  address_t chunk_size_;
+  size_t num_chunks_;
+  size_t num_slots_; // the number of slots in a chunk
+  size_t size_;
+  size_t chunk_count_;
+  PageTable page_table_;
+
+  DISALLOW_COPY_CONSTRUCTORS(ShadowMap);
+};
+
+#endif
+
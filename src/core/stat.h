@@ -70,11 +70,11 @@ extern void stat_display(const std::string &fname);
 #define STAT_INC(var,i) do { g_stat->Inc(var, i, false); } while (0)
 #define STAT_INC_SAFE(var,i) do { g_stat->Inc(var, i, true); } while (0)
 #define STAT_MAX(var,i) do { g_stat->Max(var, i, false); } while (0)
-#define STAT_MAX_SAFE(var,i) do { g_stat->Inc(var, i, true); } while (0)
+#define STAT_MAX_SAFE(var,i) do { g_stat->Max(var, i, true); } while (0)
 #define STAT_MIN(var,i) do { g_stat->Min(var, i, false); } while (0)
 #define STAT_MIN_SAFE(var,i) do { g_stat->Min(var, i, true); } while (0)
 #define STAT_REC(var,i) do { g_stat->Rec(var, i, false); } while (0)
-#define STAT_REC_SAFE(var,i) do ( g_stat->Rec(var, i, true); } while (0)
+#define STAT_REC_SAFE(var,i) do { g_stat->Rec(var, i, true); } while (0)
 
 #ifdef _DEBUG
 #define DEBUG_STAT_INC(var,i) STAT_INC(var, i)
@@ -163,12 +163,19 @@ Inst *StaticInfo::FindInst(inst_id_type id) {
 }
 
 void StaticInfo::Load(const std::string &db_name) {
+  // images and instructions that are already known are kept so that
+  // the database can be loaded again to pick up the new entries saved
+  // by another process (e.g. a forked execution)
+  StaticInfoProto db_proto;
   std::fstream in(db_name.c_str(), std::ios::in | std::ios::binary);
-  proto_.ParseFromIstream(&in);
+  db_proto.ParseFromIstream(&in);
   in.close();
   // setup image map
-  for (int i = 0; i < proto_.image_size(); i++) {
-    ImageProto *image_proto = proto_.mutable_image(i);
+  for (int i = 0; i < db_proto.image_size(); i++) {
+    if (FindImage(db_proto.image(i).id()))
+      continue;
+    ImageProto *image_proto = proto_.add_image();
+    image_proto->CopyFrom(db_proto.image(i));
     Image *image = new Image(image_proto);
     image_id_type image_id = image->id();
     image_map_[image_id] = image;
@@ -176,8 +183,11 @@ void StaticInfo::Load(const std::string &db_name) {
       curr_image_id_ = image_id;
   }
   // setup inst map
-  for (int i = 0; i < proto_.inst_size(); i++) {
-    InstProto *inst_proto = proto_.mutable_inst(i);
+  for (int i = 0; i < db_proto.inst_size(); i++) {
+    if (FindInst(db_proto.inst(i).id()))
+      continue;
+    InstProto *inst_proto = proto_.add_inst();
+    inst_proto->CopyFrom(db_proto.inst(i));
     Image *image = FindImage(inst_proto->image_id());
     Inst *inst = new Inst(image, inst_proto);
     inst_id_type inst_id = inst->id();
@@ -19,9 +19,15 @@
 #ifndef CORE_SYNC_H_
 #define CORE_SYNC_H_
 
+#include <errno.h>
+#include <linux/futex.h>
+#include <pthread.h>
 #include <semaphore.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #include "core/basictypes.h"
+#include "core/atomic.h"
 
 // Define mutex interface.
 class Mutex {
@@ -98,6 +104,23 @@ class NullRWMutex : public RWMutex {
   DISALLOW_COPY_CONSTRUCTORS(NullRWMutex);
 };
 
+// Define the mutex implemented by the underlying os (used in offline
+// tools that analyze in multiple threads).
+class SysMutex : public Mutex {
+ public:
+  SysMutex() { pthread_mutex_init(&mutex_, NULL); }
+  ~SysMutex() { pthread_mutex_destroy(&mutex_); }
+
+  void Lock() { pthread_mutex_lock(&mutex_); }
+  void Unlock() { pthread_mutex_unlock(&mutex_); }
+  Mutex *Clone() { return new SysMutex; }
+
+ private:
+  pthread_mutex_t mutex_;
+
+  DISALLOW_COPY_CONSTRUCTORS(SysMutex);
+};
+
 // Define the semaphore implemented by the underlying os.
 class SysSemaphore : public Semaphore {
  public:
@@ -116,6 +139,70 @@ class SysSemaphore : public Semaphore {
   DISALLOW_COPY_CONSTRUCTORS(SysSemaphore);
 };
 
+// Define the semaphore implemented directly on the linux futex. A
+// waiter spins for a bounded number of iterations before it parks in
+// the kernel, so that a hand-off between two running threads does not
+// enter the kernel on either side.
+class FutexSemaphore : public Semaphore {
+ public:
+  FutexSemaphore() : value_(0), waiters_(0), spin_(0) {}
+  FutexSemaphore(unsigned int value, int spin)
+      : value_(0), waiters_(0), spin_(spin) { Init(value); }
+  ~FutexSemaphore() {}
+
+  int Init(unsigned int value) {
+    value_ = (int)value;
+    waiters_ = 0;
+    return 0;
+  }
+
+  int Wait() { return TimedWait(NULL); }
+
+  // the timeout is absolute, the same as sem_timedwait
+  int TimedWait(const struct timespec *to) {
+    for (int i = 0; i < spin_; i++) {
+      if (TryWait())
+        return 0;
+    }
+    ATOMIC_ADD_AND_FETCH(&waiters_, 1);
+    int res = 0;
+    while (!TryWait()) {
+      if (syscall(SYS_futex, &value_,
+                  FUTEX_WAIT_BITSET | FUTEX_CLOCK_REALTIME, 0, to,
+                  NULL, FUTEX_BITSET_MATCH_ANY) && errno == ETIMEDOUT) {
+        res = -1;
+        break;
+      }
+    }
+    ATOMIC_SUB_AND_FETCH(&waiters_, 1);
+    return res;
+  }
+
+  int Post() {
+    ATOMIC_ADD_AND_FETCH(&value_, 1);
+    if (waiters_ > 0)
+      syscall(SYS_futex, &value_, FUTEX_WAKE, 1, NULL, NULL, 0);
+    return 0;
+  }
+
+ private:
+  bool TryWait() {
+    while (true) {
+      int value = value_;
+      if (value <= 0)
+        return false;
+      if (ATOMIC_BOOL_COMPARE_AND_SWAP(&value_, value, value - 1))
+        return true;
+    }
+  }
+
+  int volatile value_;
+  int volatile waiters_;
+  int spin_;
+
+  DISALLOW_COPY_CONSTRUCTORS(FutexSemaphore);
+};
+
 // Define scoped lock.
 class ScopedLock {
  public:
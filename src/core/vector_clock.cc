@@ -100,6 +100,22 @@ void VectorClock::Join(VectorClock *vc) {
   }
 }
 
+void VectorClock::Meet(VectorClock *vc) {
+  // only the threads that appear in both vector clocks are kept
+  ThreadClockMap::iterator curr_it = map_.begin();
+  ThreadClockMap::iterator vc_it = vc->map_.begin();
+  while (curr_it != map_.end()) {
+    while (vc_it != vc->map_.end() && vc_it->first < curr_it->first)
+      ++vc_it;
+    if (vc_it == vc->map_.end() || vc_it->first != curr_it->first) {
+      map_.erase(curr_it++);
+    } else {
+      curr_it->second = MIN(curr_it->second, vc_it->second);
+      ++curr_it;
+    }
+  }
+}
+
 void VectorClock::Increment(thread_id_t thd_id) {
   ThreadClockMap::iterator it = map_.find(thd_id);
   if (it == map_.end()) {
@@ -136,6 +152,15 @@ bool VectorClock::Equal(VectorClock *vc) {
   return true;
 }
 
+size_t VectorClock::Hash() {
+  size_t hash_val = map_.size();
+  for (ThreadClockMap::iterator it = map_.begin(); it != map_.end(); ++it) {
+    hash_val = hash_val * 31 + (size_t)it->first;
+    hash_val = hash_val * 31 + (size_t)it->second;
+  }
+  return hash_val;
+}
+
 std::string VectorClock::ToString() {
   std::stringstream ss;
   ss << "[";
@@ -32,10 +32,12 @@ class VectorClock {
   bool HappensBefore(VectorClock *vc);
   bool HappensAfter(VectorClock *vc);
   void Join(VectorClock *vc);
+  void Meet(VectorClock *vc);
   void Increment(thread_id_t thd_id);
   timestamp_t GetClock(thread_id_t thd_id);
   void SetClock(thread_id_t thd_id, timestamp_t clk);
   bool Equal(VectorClock *vc);
+  size_t Hash();
   std::string ToString();
   void IterBegin() { it_ = map_.begin(); }
   bool IterEnd() { return it_ == map_.end(); }
@@ -23,16 +23,21 @@
 namespace idiom {
 
 void TestHistory::CreateEntry(iRoot *iroot) {
-  curr_proto_ = table_proto_.add_history();
-  curr_proto_->set_iroot_id(iroot->id());
+  HistoryProto *proto = table_proto_.add_history();
+  proto->set_iroot_id(iroot->id());
+  curr_protos_.push_back(proto);
 }
 
 void TestHistory::UpdateSeed(unsigned int seed) {
-  curr_proto_->set_seed(seed);
+  for (size_t i = 0; i < curr_protos_.size(); i++)
+    curr_protos_[i]->set_seed(seed);
 }
 
-void TestHistory::UpdateResult(bool success) {
-  curr_proto_->set_success(success);
+void TestHistory::UpdateResult(iRoot *iroot, bool success) {
+  for (size_t i = 0; i < curr_protos_.size(); i++) {
+    if (curr_protos_[i]->iroot_id() == iroot->id())
+      curr_protos_[i]->set_success(success);
+  }
 }
 
 int TestHistory::TotalTestRuns(iRoot *iroot) {
@@ -27,22 +27,23 @@
 
 namespace idiom {
 
-// Active testing history
+// Active testing history. Each run creates an entry for each of the
+// iroots it tests.
 class TestHistory {
  public:
-  TestHistory() : curr_proto_(NULL) {}
+  TestHistory() {}
   ~TestHistory() {}
 
   void CreateEntry(iRoot *iroot);
   void UpdateSeed(unsigned int seed);
-  void UpdateResult(bool success);
+  void UpdateResult(iRoot *iroot, bool success);
   int TotalTestRuns(iRoot *iroot);
   void Load(const std::string &file_name);
   void Save(const std::string &file_name);
 
  private:
   HistoryTableProto table_proto_;
-  HistoryProto *curr_proto_;
+  std::vector<HistoryProto *> curr_protos_; // entries of the current run
 
   DISALLOW_COPY_CONSTRUCTORS(TestHistory);
 };
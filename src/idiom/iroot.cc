@@ -22,6 +22,8 @@
 #include <cassert>
 #include <fstream>
 
+#include "core/logging.h"
+
 namespace idiom {
 
 bool iRoot::HasMem() {
@@ -76,16 +78,24 @@ iRootDB::iRootDB(Mutex *lock)
     : internal_lock_(lock),
       curr_event_id_(0),
       curr_iroot_id_(0) {
-  // empty
+  for (int i = 0; i < IROOT_DB_NUM_SHARDS; i++)
+    shards_[i].lock = lock->Clone();
+}
+
+iRootDB::~iRootDB() {
+  for (int i = 0; i < IROOT_DB_NUM_SHARDS; i++)
+    delete shards_[i].lock;
 }
 
 iRootEvent *iRootDB::GetiRootEvent(Inst *inst, iRootEventType type,
                                    bool locking) {
-  ScopedLock locker(internal_lock_, locking);
+  size_t hash_val = HashiRootEvent(inst, type);
+  Shard *shard = GetShard(hash_val);
+  ScopedLock locker(shard->lock, locking);
 
-  iRootEvent *event = FindiRootEvent(inst, type, false);
+  iRootEvent *event = FindiRootEvent(shard, hash_val, inst, type);
   if (!event)
-    event = CreateiRootEvent(inst, type, false);
+    event = CreateiRootEvent(shard, hash_val, inst, type, locking);
   return event;
 }
 
@@ -101,21 +111,22 @@ iRootEvent *iRootDB::FindiRootEvent(iroot_event_id_t event_id,
 }
 
 iRoot *iRootDB::GetiRoot(IdiomType idiom, bool locking, ...) {
-  ScopedLock locker(internal_lock_, locking);
-
-  int num_args = iRoot::GetNumEvents(idiom);
-  iRootEventVec events;
+  int num_events = iRoot::GetNumEvents(idiom);
+  iRootEvent *events[4]; // an iroot has at most 4 events
+  DEBUG_ASSERT(num_events <= 4);
   va_list vl;
   va_start(vl, locking);
-  for (int i = 0; i < num_args; i++) {
-    iRootEvent *event = va_arg(vl, iRootEvent *);
-    events.push_back(event);
-  }
+  for (int i = 0; i < num_events; i++)
+    events[i] = va_arg(vl, iRootEvent *);
   va_end(vl);
 
-  iRoot *iroot = FindiRoot(idiom, &events, false);
+  size_t hash_val = HashiRoot(idiom, events, num_events);
+  Shard *shard = GetShard(hash_val);
+  ScopedLock locker(shard->lock, locking);
+
+  iRoot *iroot = FindiRoot(shard, hash_val, idiom, events, num_events);
   if (!iroot)
-    iroot = CreateiRoot(idiom, &events, false);
+    iroot = CreateiRoot(shard, hash_val, idiom, events, num_events, locking);
   return iroot;
 }
 
@@ -129,87 +140,124 @@ iRoot *iRootDB::FindiRoot(iroot_id_t iroot_id, bool locking) {
     return it->second;
 }
 
-iRootEvent *iRootDB::FindiRootEvent(Inst *inst, iRootEventType type,
-                                    bool locking) {
-  ScopedLock locker(internal_lock_, locking);
+iRoot *iRootDB::Import(iRoot *iroot, StaticInfo *sinfo, bool locking) {
+  // the iroot comes from another iroot database (with its own static
+  // info), thus its events are matched by image names and offsets.
+  // new instructions are added to the given static info which is not
+  // locked here (used by offline tools only)
+  int num_events = iRoot::GetNumEvents(iroot->idiom());
+  iRootEvent *events[4];
+  DEBUG_ASSERT(num_events <= 4);
+  for (int i = 0; i < num_events; i++) {
+    iRootEvent *event = iroot->GetEvent(i);
+    Inst *inst = ImportInst(event->inst(), sinfo);
+    events[i] = GetiRootEvent(inst, event->type(), locking);
+  }
 
-  size_t hash_val = HashiRootEvent(inst, type);
-  iRootEventHashIndex::iterator it = event_index_.find(hash_val);
-  if (it == event_index_.end()) {
-    return NULL;
-  } else {
-    for (size_t i = 0; i < it->second.size(); i++) {
-      iRootEvent *event = it->second[i];
-      if (event->inst() == inst && event->type() == type)
-        return event;
-    }
-    return NULL;
+  size_t hash_val = HashiRoot(iroot->idiom(), events, num_events);
+  Shard *shard = GetShard(hash_val);
+  ScopedLock locker(shard->lock, locking);
+
+  iRoot *local = FindiRoot(shard, hash_val, iroot->idiom(), events,
+                           num_events);
+  if (!local)
+    local = CreateiRoot(shard, hash_val, iroot->idiom(), events, num_events,
+                        locking);
+  return local;
+}
+
+iRootEvent *iRootDB::FindiRootEvent(Shard *shard, size_t hash_val,
+                                    Inst *inst, iRootEventType type) {
+  std::pair<iRootEventHashIndex::iterator,
+            iRootEventHashIndex::iterator> range =
+      shard->event_index.equal_range(hash_val);
+  for (iRootEventHashIndex::iterator it = range.first;
+       it != range.second; ++it) {
+    iRootEvent *event = it->second;
+    if (event->inst() == inst && event->type() == type)
+      return event;
   }
+  return NULL;
 }
 
-iRootEvent *iRootDB::CreateiRootEvent(Inst *inst, iRootEventType type,
+iRootEvent *iRootDB::CreateiRootEvent(Shard *shard, size_t hash_val,
+                                      Inst *inst, iRootEventType type,
                                       bool locking) {
-  ScopedLock locker(internal_lock_, locking);
+  iRootEvent *event = NULL;
+  {
+    ScopedLock locker(internal_lock_, locking);
 
-  iRootEventProto *event_proto = proto_.add_event();
-  iroot_event_id_t event_id = GetNextiRootEventID();
-  event_proto->set_id(event_id);
-  event_proto->set_inst_id(inst->id());
-  event_proto->set_type(type);
-  iRootEvent *event = new iRootEvent(inst, event_proto);
-  event_map_[event_id] = event;
-  size_t hash_val = HashiRootEvent(inst, type);
-  event_index_[hash_val].push_back(event); // update index
+    iRootEventProto *event_proto = proto_.add_event();
+    iroot_event_id_t event_id = GetNextiRootEventID();
+    event_proto->set_id(event_id);
+    event_proto->set_inst_id(inst->id());
+    event_proto->set_type(type);
+    event = new iRootEvent(inst, event_proto);
+    event_map_[event_id] = event;
+  }
+  // update index (protected by the shard lock)
+  shard->event_index.insert(std::make_pair(hash_val, event));
   return event;
 }
 
-iRoot *iRootDB::FindiRoot(IdiomType idiom, iRootEventVec *events,
-                          bool locking) {
-  ScopedLock locker(internal_lock_, locking);
-
-  size_t hash_val = HashiRoot(idiom, events);
-  iRootHashIndex::iterator it = iroot_index_.find(hash_val);
-  if (it == iroot_index_.end()) {
-    return NULL;
-  } else {
-    for (size_t i = 0; i < it->second.size(); i++) {
-      iRoot *iroot = it->second[i];
-      if (iroot->idiom() == idiom) {
-        bool match = true;
-        for (size_t j = 0; j < events->size(); j++) {
-          if (iroot->events_[j] != (*events)[j]) {
-            match = false;
-            break;
-          }
+iRoot *iRootDB::FindiRoot(Shard *shard, size_t hash_val, IdiomType idiom,
+                          iRootEvent **events, int num_events) {
+  std::pair<iRootHashIndex::iterator, iRootHashIndex::iterator> range =
+      shard->iroot_index.equal_range(hash_val);
+  for (iRootHashIndex::iterator it = range.first; it != range.second; ++it) {
+    iRoot *iroot = it->second;
+    if (iroot->idiom() == idiom) {
+      bool match = true;
+      for (int j = 0; j < num_events; j++) {
+        if (iroot->events_[j] != events[j]) {
+          match = false;
+          break;
         }
-        if (match)
-          return iroot;
       }
+      if (match)
+        return iroot;
     }
-    return NULL;
   }
+  return NULL;
 }
 
-iRoot *iRootDB::CreateiRoot(IdiomType idiom, iRootEventVec *events,
+iRoot *iRootDB::CreateiRoot(Shard *shard, size_t hash_val, IdiomType idiom,
+                            iRootEvent **events, int num_events,
                             bool locking) {
-  ScopedLock locker(internal_lock_, locking);
+  iRoot *iroot = NULL;
+  {
+    ScopedLock locker(internal_lock_, locking);
 
-  iRootProto *iroot_proto = proto_.add_iroot();
-  iroot_id_t iroot_id = GetNextiRootID();
-  iroot_proto->set_id(iroot_id);
-  iroot_proto->set_idiom(idiom);
-  iRoot *iroot = new iRoot(iroot_proto);
-  for (size_t i = 0; i < events->size(); i++) {
-    iRootEvent *event = (*events)[i];
-    iroot_proto->add_event_id(event->id());
-    iroot->AddEvent(event);
+    iRootProto *iroot_proto = proto_.add_iroot();
+    iroot_id_t iroot_id = GetNextiRootID();
+    iroot_proto->set_id(iroot_id);
+    iroot_proto->set_idiom(idiom);
+    iroot = new iRoot(iroot_proto);
+    for (int i = 0; i < num_events; i++) {
+      iRootEvent *event = events[i];
+      iroot_proto->add_event_id(event->id());
+      iroot->AddEvent(event);
+    }
+    iroot_map_[iroot_id] = iroot;
   }
-  iroot_map_[iroot_id] = iroot;
-  size_t hash_val = HashiRoot(idiom, events);
-  iroot_index_[hash_val].push_back(iroot); // update index
+  // update index (protected by the shard lock)
+  shard->iroot_index.insert(std::make_pair(hash_val, iroot));
   return iroot;
 }
 
+Inst *iRootDB::ImportInst(Inst *inst, StaticInfo *sinfo) {
+  Image *image = sinfo->FindImage(inst->image()->name());
+  if (!image)
+    image = sinfo->CreateImage(inst->image()->name());
+  Inst *local = image->Find(inst->offset());
+  if (!local) {
+    local = sinfo->CreateInst(image, inst->offset());
+    if (inst->HasOpcode())
+      local->SetOpcode(inst->opcode());
+  }
+  return local;
+}
+
 void iRootDB::Load(const std::string &db_name, StaticInfo *sinfo) {
   std::fstream in;
   in.open(db_name.c_str(), std::ios::in | std::ios::binary);
@@ -223,7 +271,8 @@ void iRootDB::Load(const std::string &db_name, StaticInfo *sinfo) {
     iroot_event_id_t event_id = event->id();
     event_map_[event_id] = event;
     size_t hash_val = HashiRootEvent(event->inst(), event->type());
-    event_index_[hash_val].push_back(event); // update event index
+    // update event index
+    GetShard(hash_val)->event_index.insert(std::make_pair(hash_val, event));
     if (event_id > curr_event_id_)
       curr_event_id_ = event_id;
   }
@@ -238,8 +287,10 @@ void iRootDB::Load(const std::string &db_name, StaticInfo *sinfo) {
       iroot->AddEvent(event);
     }
     iroot_map_[iroot_id] = iroot;
-    size_t hash_val = HashiRoot(iroot->idiom(), &iroot->events_);
-    iroot_index_[hash_val].push_back(iroot); // update iroot index
+    size_t hash_val = HashiRoot(iroot->idiom(), &iroot->events_[0],
+                                (int)iroot->events_.size());
+    // update iroot index
+    GetShard(hash_val)->iroot_index.insert(std::make_pair(hash_val, iroot));
     if (iroot_id > curr_iroot_id_)
       curr_iroot_id_ = iroot_id;
   }
@@ -25,6 +25,7 @@
 #include "core/basictypes.h"
 #include "core/static_info.h"
 #include "core/atomic.h"
+#include "core/sync.h"
 #include "idiom/iroot.pb.h" // protobuf head file
 
 namespace idiom {
@@ -101,15 +102,25 @@ class iRoot {
   DISALLOW_COPY_CONSTRUCTORS(iRoot);
 };
 
+// the number of shards of the iroot database indices (must be a power
+// of 2)
+#define IROOT_DB_NUM_SHARDS 16
+
+// The iroot database. The hash indices are split into shards, each of
+// which is protected by its own lock, so that lookups of existing
+// iroot events and iroots from different threads rarely contend. The
+// global lock is only taken when new iroot events or iroots are
+// created.
 class iRootDB {
  public:
   explicit iRootDB(Mutex *lock);
-  ~iRootDB() {}
+  ~iRootDB();
 
   iRootEvent *GetiRootEvent(Inst *inst, iRootEventType type, bool locking);
   iRootEvent *FindiRootEvent(iroot_event_id_t event_id, bool locking);
   iRoot *GetiRoot(IdiomType idiom, bool locking, ...);
   iRoot *FindiRoot(iroot_id_t iroot_id, bool locking);
+  iRoot *Import(iRoot *iroot, StaticInfo *sinfo, bool locking);
   void Load(const std::string &db_name, StaticInfo *sinfo);
   void Save(const std::string &db_name, StaticInfo *sinfo);
 
@@ -118,13 +129,31 @@ class iRootDB {
   typedef std::vector<iRoot *> iRootVec;
   typedef std::tr1::unordered_map<iroot_event_id_t, iRootEvent *> iRootEventMap;
   typedef std::tr1::unordered_map<iroot_id_t, iRoot *> iRootMap;
-  typedef std::tr1::unordered_map<size_t, iRootEventVec> iRootEventHashIndex;
-  typedef std::tr1::unordered_map<size_t, iRootVec> iRootHashIndex;
-
-  iRootEvent *FindiRootEvent(Inst *inst, iRootEventType type, bool locking);
-  iRootEvent *CreateiRootEvent(Inst *inst, iRootEventType type, bool locking);
-  iRoot *FindiRoot(IdiomType idiom, iRootEventVec *events, bool locking);
-  iRoot *CreateiRoot(IdiomType idiom, iRootEventVec *events, bool locking);
+  typedef std::tr1::unordered_multimap<size_t, iRootEvent *> iRootEventHashIndex;
+  typedef std::tr1::unordered_multimap<size_t, iRoot *> iRootHashIndex;
+
+  // A shard of the hash indices.
+  typedef struct {
+    Mutex *lock;
+    iRootEventHashIndex event_index;
+    iRootHashIndex iroot_index;
+  } Shard;
+
+  iRootEvent *FindiRootEvent(Shard *shard, size_t hash_val, Inst *inst,
+                             iRootEventType type);
+  iRootEvent *CreateiRootEvent(Shard *shard, size_t hash_val, Inst *inst,
+                               iRootEventType type, bool locking);
+  iRoot *FindiRoot(Shard *shard, size_t hash_val, IdiomType idiom,
+                   iRootEvent **events, int num_events);
+  iRoot *CreateiRoot(Shard *shard, size_t hash_val, IdiomType idiom,
+                     iRootEvent **events, int num_events, bool locking);
+  Inst *ImportInst(Inst *inst, StaticInfo *sinfo);
+
+  Shard *GetShard(size_t hash_val) {
+    // use the high bits as the low bits are used to select buckets
+    return &shards_[(hash_val >> (sizeof(size_t) * 8 - 8)) &
+                    (IROOT_DB_NUM_SHARDS - 1)];
+  }
 
   iroot_event_id_t GetNextiRootEventID() {
     return ATOMIC_ADD_AND_FETCH(&curr_event_id_, 1);
@@ -134,16 +163,32 @@ class iRootDB {
     return ATOMIC_ADD_AND_FETCH(&curr_iroot_id_, 1);
   }
 
+  // mix the bits of a value (the finalizer of MurmurHash3)
+  static uint64 MixHash(uint64 val) {
+    val ^= val >> 33;
+    val *= 0xff51afd7ed558ccdULL;
+    val ^= val >> 33;
+    val *= 0xc4ceb9fe1a85ec53ULL;
+    val ^= val >> 33;
+    return val;
+  }
+
+  // combine the hash values in order
+  static uint64 CombineHash(uint64 seed, uint64 val) {
+    return MixHash(seed ^ (val + 0x9e3779b97f4a7c15ULL + (seed << 6) +
+                           (seed >> 2)));
+  }
+
   static size_t HashiRootEvent(Inst *inst, iRootEventType type) {
-    return (size_t)inst + (size_t)type;
+    return (size_t)CombineHash(MixHash((uint64)(size_t)inst), (uint64)type);
   }
 
-  static size_t HashiRoot(IdiomType idiom, iRootEventVec *events) {
-    size_t hash_val = (size_t)idiom;
-    for (size_t i = 0; i < events->size(); i++) {
-      hash_val += (size_t)(*events)[i];
-    }
-    return hash_val;
+  static size_t HashiRoot(IdiomType idiom, iRootEvent **events,
+                          int num_events) {
+    uint64 hash_val = MixHash((uint64)idiom);
+    for (int i = 0; i < num_events; i++)
+      hash_val = CombineHash(hash_val, (uint64)(size_t)events[i]);
+    return (size_t)hash_val;
   }
 
   Mutex *internal_lock_;
@@ -151,8 +196,7 @@ class iRootDB {
   iroot_id_t curr_iroot_id_;
   iRootEventMap event_map_;
   iRootMap iroot_map_;
-  iRootEventHashIndex event_index_;
-  iRootHashIndex iroot_index_;
+  Shard shards_[IROOT_DB_NUM_SHARDS];
   iRootDBProto proto_;
 
  private:
@@ -27,6 +27,11 @@ namespace idiom {
 #define DEFAULT_FAILED_LIMIT         2
 #define DEFAULT_TOTAL_FAILED_LIMIT   6
 
+// the fixed cost of each test run (in millisecond)
+#define TEST_RUN_OVERHEAD            1000
+// the exposing probability of async iroots relative to others
+#define ASYNC_EXPOSE_RATIO           0.5
+
 Memo::Memo(Mutex *lock, iRootDB *iroot_db)
     : internal_lock_(lock),
       iroot_db_(iroot_db),
@@ -57,55 +62,16 @@ iRoot *Memo::ChooseForTest() {
 }
 
 iRoot *Memo::ChooseForTest(IdiomType idiom) {
-  // choose an iroot to test for a given idiom
-  iRootInfo *candidate = NULL;
-
-  // step 1: find all iroots for the given idiom, and sort them
-  // according to their iroot id
-  std::map<iroot_id_t, iRootInfo *> candidates;
-  for (CandidateMap::iterator it = candidate_map_.begin();
-       it != candidate_map_.end(); ++it) {
-    iRootInfo *iroot_info = it->first;
-    iRoot *iroot = iroot_info->iroot();
-    if (iroot->idiom() == idiom) {
-      candidates[iroot->id()] = iroot_info;
-    }
-  }
-
-  // step 2: find iroots from the application (not from common libs)
-  // choose the first iroot that has the smallest number of test runs
-  for (std::map<iroot_id_t, iRootInfo *>::iterator it = candidates.begin();
-       it != candidates.end(); ++it) {
-    iRootInfo *iroot_info = it->second;
-    if (!iroot_info->iroot()->HasCommonLibEvent()) {
-      if (!candidate) {
-        candidate = iroot_info;
-      } else {
-        if (iroot_info->total_test_runs() < candidate->total_test_runs())
-          candidate = iroot_info;
-        }
-      }
-  }
-  if (candidate)
-    return candidate->iroot();
-
-  // step 3: find iroots from the rest
-  for (std::map<iroot_id_t, iRootInfo *>::iterator it = candidates.begin();
-       it != candidates.end(); ++it) {
-    iRootInfo *iroot_info = it->second;
-    if (!candidate) {
-      candidate = iroot_info;
-    } else {
-      if (iroot_info->total_test_runs() < candidate->total_test_runs()) {
-        candidate = iroot_info;
-      }
-    }
+  // choose an iroot to test for a given idiom. the candidate queue
+  // is ordered so that the iroots from the application (not from
+  // common libs) come first, and then the ones that are more likely
+  // to be exposed per unit of test time (see Score).
+  CandidateQueueMap::iterator it = candidate_queue_map_.find(idiom);
+  if (it == candidate_queue_map_.end() || it->second.empty()) {
+    // no iroot can be tested, return NULL
+    return NULL;
   }
-  if (candidate)
-    return candidate->iroot();
-
-  // no iroot can be tested, return NULL
-  return NULL;
+  return it->second.begin()->iroot_info->iroot();
 }
 
 iRoot *Memo::ChooseForTest(iroot_id_t iroot_id) {
@@ -114,6 +80,58 @@ iRoot *Memo::ChooseForTest(iroot_id_t iroot_id) {
   return iroot;
 }
 
+void Memo::ChooseForTest(size_t num, std::vector<iRoot *> *iroots) {
+  // choose at most num iroots to test in one run, following the same
+  // idiom priority as the single choice
+  IdiomType idiom_prio[5] =
+      {IDIOM_1, IDIOM_2, IDIOM_3, IDIOM_4, IDIOM_5};
+
+  for (int i = 0; i < 5; i++)
+    ChooseForTest(idiom_prio[i], num, iroots);
+}
+
+void Memo::ChooseForTest(IdiomType idiom, size_t num,
+                         std::vector<iRoot *> *iroots) {
+  // choose at most num iroots in total (including those already in
+  // iroots) in the candidate queue order. the chosen iroots do not
+  // share any instruction, so that each event can be dispatched to
+  // exactly one iroot.
+  CandidateQueueMap::iterator it = candidate_queue_map_.find(idiom);
+  if (it == candidate_queue_map_.end())
+    return;
+  CandidateQueue &queue = it->second;
+  for (CandidateQueue::iterator qit = queue.begin();
+       qit != queue.end() && iroots->size() < num; ++qit) {
+    iRoot *iroot = qit->iroot_info->iroot();
+    if (!ShareInst(iroot, iroots))
+      iroots->push_back(iroot);
+  }
+}
+
+void Memo::ListCandidate(size_t num, std::vector<iRoot *> *iroots) {
+  // list at most num candidates in the order they would be chosen by
+  // consecutive single choices
+  IdiomType idiom_prio[5] =
+      {IDIOM_1, IDIOM_2, IDIOM_3, IDIOM_4, IDIOM_5};
+
+  for (int i = 0; i < 5; i++)
+    ListCandidate(idiom_prio[i], num, iroots);
+}
+
+void Memo::ListCandidate(IdiomType idiom, size_t num,
+                         std::vector<iRoot *> *iroots) {
+  // unlike ChooseForTest, the listed candidates may share instructions
+  // as they are meant to be tested in separate runs
+  CandidateQueueMap::iterator it = candidate_queue_map_.find(idiom);
+  if (it == candidate_queue_map_.end())
+    return;
+  CandidateQueue &queue = it->second;
+  for (CandidateQueue::iterator qit = queue.begin();
+       qit != queue.end() && iroots->size() < num; ++qit) {
+    iroots->push_back(qit->iroot_info->iroot());
+  }
+}
+
 void Memo::TestSuccess(iRoot *iroot, bool locking) {
   ScopedLock locker(internal_lock_, locking);
 
@@ -124,6 +142,7 @@ void Memo::TestSuccess(iRoot *iroot, bool locking) {
   // increment count
   cit->second++;
   iroot_info->set_total_test_runs(iroot_info->total_test_runs() + 1);
+  UpdateCandidate(iroot_info);
   // added to exposed set
   exposed_set_.insert(iroot_info);
 }
@@ -138,6 +157,7 @@ void Memo::TestFail(iRoot *iroot, bool locking) {
   // increment count
   cit->second++;
   iroot_info->set_total_test_runs(iroot_info->total_test_runs() + 1);
+  UpdateCandidate(iroot_info);
   // added to failed set if needed
   if (iroot_info->total_test_runs() >= total_failed_limit_) {
     failed_set_.insert(iroot_info);
@@ -153,7 +173,7 @@ void Memo::Predicted(iRoot *iroot, bool locking) {
     // add to candidate set if it is newly predicted
     predicted_set_.insert(iroot_info);
     DEBUG_ASSERT(candidate_map_.find(iroot_info) == candidate_map_.end());
-    candidate_map_[iroot_info] = 0;
+    AddCandidate(iroot_info, 0);
   }
 }
 
@@ -189,6 +209,28 @@ void Memo::SetAsync(iRoot *iroot, bool locking) {
   iRootInfo *iroot_info = GetiRootInfo(iroot, false);
   DEBUG_ASSERT(iroot_info);
   iroot_info->set_async(true);
+  UpdateCandidate(iroot_info);
+}
+
+void Memo::EventReached(iRoot *iroot, timestamp_t time, bool locking) {
+  ScopedLock locker(internal_lock_, locking);
+
+  iRootInfo *iroot_info = GetiRootInfo(iroot, false);
+  DEBUG_ASSERT(iroot_info);
+  // keep a moving average of the time to reach the first event
+  if (iroot_info->has_event_time())
+    time = (iroot_info->event_time() + time) / 2;
+  iroot_info->set_event_time(time);
+  UpdateCandidate(iroot_info);
+}
+
+void Memo::EventUnreached(iRoot *iroot, bool locking) {
+  ScopedLock locker(internal_lock_, locking);
+
+  iRootInfo *iroot_info = GetiRootInfo(iroot, false);
+  DEBUG_ASSERT(iroot_info);
+  iroot_info->set_unreached_test_runs(iroot_info->unreached_test_runs() + 1);
+  UpdateCandidate(iroot_info);
 }
 
 size_t Memo::TotalCandidate(bool locking) {
@@ -227,10 +269,14 @@ size_t Memo::TotalPredicted(bool locking) {
 }
 
 void Memo::Merge(Memo *other) {
+  Merge(other, NULL);
+}
+
+void Memo::Merge(Memo *other, StaticInfo *sinfo) {
   // Merge iroot_info_map_.
   for (iRootInfoMap::iterator it = other->iroot_info_map_.begin();
        it != other->iroot_info_map_.end(); ++it) {
-    iRoot *other_iroot = it->first;
+    iRoot *other_iroot = MergediRoot(other, it->first, sinfo);
     iRootInfo *other_iroot_info = it->second;
     iRootInfoMap::iterator fit = iroot_info_map_.find(other_iroot);
     if (fit == iroot_info_map_.end()) {
@@ -239,6 +285,11 @@ void Memo::Merge(Memo *other) {
       if (other_iroot_info->has_async()) {
         iroot_info->set_async(other_iroot_info->async());
       }
+      iroot_info->set_unreached_test_runs(
+          other_iroot_info->unreached_test_runs());
+      if (other_iroot_info->has_event_time()) {
+        iroot_info->set_event_time(other_iroot_info->event_time());
+      }
       iroot_info_map_[other_iroot] = iroot_info;
     } else {
       iRootInfo *iroot_info = fit->second;
@@ -248,6 +299,15 @@ void Memo::Merge(Memo *other) {
       if (other_iroot_info->has_async() && other_iroot_info->async()) {
         iroot_info->set_async(true);
       }
+      if (other_iroot_info->unreached_test_runs() >
+          iroot_info->unreached_test_runs()) {
+        iroot_info->set_unreached_test_runs(
+            other_iroot_info->unreached_test_runs());
+      }
+      if (other_iroot_info->has_event_time() &&
+          !iroot_info->has_event_time()) {
+        iroot_info->set_event_time(other_iroot_info->event_time());
+      }
     }
   }
 
@@ -255,7 +315,8 @@ void Memo::Merge(Memo *other) {
   for (iRootInfoSet::iterator it = other->exposed_set_.begin();
        it != other->exposed_set_.end(); ++it) {
     iRootInfo *other_iroot_info = *it;
-    iRoot *other_iroot = other_iroot_info->iroot();
+    iRoot *other_iroot = MergediRoot(other, other_iroot_info->iroot(),
+                                     sinfo);
     iRootInfoMap::iterator fit = iroot_info_map_.find(other_iroot);
     assert(fit != iroot_info_map_.end());
     exposed_set_.insert(fit->second);
@@ -265,7 +326,8 @@ void Memo::Merge(Memo *other) {
   for (iRootInfoSet::iterator it = other->failed_set_.begin();
        it != other->failed_set_.end(); ++it) {
     iRootInfo *other_iroot_info = *it;
-    iRoot *other_iroot = other_iroot_info->iroot();
+    iRoot *other_iroot = MergediRoot(other, other_iroot_info->iroot(),
+                                     sinfo);
     iRootInfoMap::iterator fit = iroot_info_map_.find(other_iroot);
     assert(fit != iroot_info_map_.end());
     failed_set_.insert(fit->second);
@@ -275,7 +337,8 @@ void Memo::Merge(Memo *other) {
   for (iRootInfoSet::iterator it = other->predicted_set_.begin();
        it != other->predicted_set_.end(); ++it) {
     iRootInfo *other_iroot_info = *it;
-    iRoot *other_iroot = other_iroot_info->iroot();
+    iRoot *other_iroot = MergediRoot(other, other_iroot_info->iroot(),
+                                     sinfo);
     iRootInfoMap::iterator fit = iroot_info_map_.find(other_iroot);
     assert(fit != iroot_info_map_.end());
     predicted_set_.insert(fit->second);
@@ -285,7 +348,8 @@ void Memo::Merge(Memo *other) {
   for (iRootInfoSet::iterator it = other->shadow_exposed_set_.begin();
        it != other->shadow_exposed_set_.end(); ++it) {
     iRootInfo *other_iroot_info = *it;
-    iRoot *other_iroot = other_iroot_info->iroot();
+    iRoot *other_iroot = MergediRoot(other, other_iroot_info->iroot(),
+                                     sinfo);
     iRootInfoMap::iterator fit = iroot_info_map_.find(other_iroot);
     assert(fit != iroot_info_map_.end());
     shadow_exposed_set_.insert(fit->second);
@@ -295,20 +359,27 @@ void Memo::Merge(Memo *other) {
   for (CandidateMap::iterator it = other->candidate_map_.begin();
        it != other->candidate_map_.end(); ++it) {
     iRootInfo *other_iroot_info = it->first;
-    iRoot *other_iroot = other_iroot_info->iroot();
+    iRoot *other_iroot = MergediRoot(other, other_iroot_info->iroot(),
+                                     sinfo);
     int other_test_runs = it->second;
     iRootInfoMap::iterator fit = iroot_info_map_.find(other_iroot);
     assert(fit != iroot_info_map_.end());
     iRootInfo *iroot_info = fit->second;
     CandidateMap::iterator cit = candidate_map_.find(iroot_info);
     if (cit == candidate_map_.end()) {
-      candidate_map_[iroot_info] = other_test_runs;
+      AddCandidate(iroot_info, other_test_runs);
     } else {
       if (other_test_runs > cit->second) {
         cit->second = other_test_runs;
       }
     }
   }
+
+  // Re-score the candidates as their iroot info might have changed.
+  for (CandidateMap::iterator it = candidate_map_.begin();
+       it != candidate_map_.end(); ++it) {
+    UpdateCandidate(it->first);
+  }
 }
 
 void Memo::RefineCandidate(bool memo_failed) {
@@ -323,20 +394,20 @@ void Memo::RefineCandidate(bool memo_failed) {
   }
   for (iRootInfoSet::iterator it = to_remove.begin();
        it != to_remove.end(); ++it) {
-    candidate_map_.erase(*it);
+    RemoveCandidate(*it);
   }
 
   // remove those candidates that are exposed
   for (iRootInfoSet::iterator it = exposed_set_.begin();
        it != exposed_set_.end(); ++it) {
-    candidate_map_.erase(*it);
+    RemoveCandidate(*it);
   }
 
   // remove failed from candidates if needed
   if (memo_failed) {
     for (iRootInfoSet::iterator it = failed_set_.begin();
          it != failed_set_.end(); ++it) {
-      candidate_map_.erase(*it);
+      RemoveCandidate(*it);
     }
   }
 }
@@ -359,7 +430,7 @@ void Memo::SampleCandidate(IdiomType idiom, size_t num) {
   if (num < iroot_info_vec.size()) {
     size_t remove_size = iroot_info_vec.size() - num;
     for (size_t i = 0; i < remove_size; i++) {
-      candidate_map_.erase(iroot_info_vec[i]);
+      RemoveCandidate(iroot_info_vec[i]);
     }
   }
 }
@@ -423,7 +494,7 @@ void Memo::Load(const std::string &db_name, StaticInfo *sinfo) {
     DEBUG_ASSERT(iroot);
     iRootInfo *iroot_info = FindiRootInfo(iroot, false);
     DEBUG_ASSERT(iroot_info);
-    candidate_map_[iroot_info] = test_runs;
+    AddCandidate(iroot_info, test_runs);
   }
 }
 
@@ -497,5 +568,83 @@ iRootInfo *Memo::CreateiRootInfo(iRoot *iroot, bool locking) {
   return iroot_info;
 }
 
+double Memo::Score(iRootInfo *iroot_info) {
+  // estimate the probability of exposing the iroot in the next test
+  // run using the rule of succession (a candidate has never been
+  // exposed). a test run that does not even reach any event of the
+  // iroot counts twice.
+  int runs = iroot_info->total_test_runs() +
+             iroot_info->unreached_test_runs();
+  double prob = 1.0 / (runs + 2);
+  // the cost of a test run is dominated by the time to reach the
+  // first event of the iroot, before which the scheduler can do
+  // nothing. iroots that have not been timed are assumed to be
+  // cheap so that they get tested early. the async penalty is only
+  // applied to timed iroots so that, without timing data, the order
+  // is the same as ordering by test runs.
+  double cost = TEST_RUN_OVERHEAD;
+  if (iroot_info->has_event_time()) {
+    cost += iroot_info->event_time();
+    if (iroot_info->async())
+      prob *= ASYNC_EXPOSE_RATIO;
+  }
+  // the expected number of exposed iroots per second
+  return prob * 1000.0 / cost;
+}
+
+void Memo::AddCandidate(iRootInfo *iroot_info, int test_runs) {
+  candidate_map_[iroot_info] = test_runs;
+  UpdateCandidate(iroot_info);
+}
+
+void Memo::RemoveCandidate(iRootInfo *iroot_info) {
+  CandidateKeyMap::iterator it = candidate_key_map_.find(iroot_info);
+  if (it != candidate_key_map_.end()) {
+    IdiomType idiom = iroot_info->iroot()->idiom();
+    candidate_queue_map_[idiom].erase(it->second);
+    candidate_key_map_.erase(it);
+  }
+  candidate_map_.erase(iroot_info);
+}
+
+void Memo::UpdateCandidate(iRootInfo *iroot_info) {
+  if (candidate_map_.find(iroot_info) == candidate_map_.end())
+    return;
+  IdiomType idiom = iroot_info->iroot()->idiom();
+  CandidateQueue &queue = candidate_queue_map_[idiom];
+  CandidateKeyMap::iterator it = candidate_key_map_.find(iroot_info);
+  if (it != candidate_key_map_.end()) {
+    queue.erase(it->second);
+  } else {
+    it = candidate_key_map_.insert(
+        CandidateKeyMap::value_type(iroot_info, CandidateKey())).first;
+    it->second.common_lib = iroot_info->iroot()->HasCommonLibEvent();
+    it->second.iroot_info = iroot_info;
+  }
+  it->second.score = Score(iroot_info);
+  queue.insert(it->second);
+}
+
+bool Memo::ShareInst(iRoot *iroot, std::vector<iRoot *> *iroots) {
+  int size = iRoot::GetNumEvents(iroot->idiom());
+  for (size_t i = 0; i < iroots->size(); i++) {
+    iRoot *other = (*iroots)[i];
+    int other_size = iRoot::GetNumEvents(other->idiom());
+    for (int j = 0; j < size; j++) {
+      for (int k = 0; k < other_size; k++) {
+        if (iroot->GetEvent(j)->inst() == other->GetEvent(k)->inst())
+          return true;
+      }
+    }
+  }
+  return false;
+}
+
+iRoot *Memo::MergediRoot(Memo *other, iRoot *iroot, StaticInfo *sinfo) {
+  if (!sinfo || other->iroot_db_ == iroot_db_)
+    return iroot;
+  return iroot_db_->Import(iroot, sinfo, false);
+}
+
 } // namespace idiom
 
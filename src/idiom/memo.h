@@ -19,6 +19,9 @@
 #ifndef IDIOM_MEMO_H_
 #define IDIOM_MEMO_H_
 
+#include <map>
+#include <set>
+#include <vector>
 #include <tr1/unordered_map>
 #include <tr1/unordered_set>
 
@@ -38,8 +41,13 @@ class iRootInfo {
   int total_test_runs() { return proto_->total_test_runs(); }
   bool async() { return (proto_->has_async() ? proto_->async() : false); }
   bool has_async() { return proto_->has_async(); }
+  int unreached_test_runs() { return proto_->unreached_test_runs(); }
+  timestamp_t event_time() { return proto_->event_time(); }
+  bool has_event_time() { return proto_->has_event_time(); }
   void set_total_test_runs(int n) { proto_->set_total_test_runs(n); }
   void set_async(bool async) { proto_->set_async(async); }
+  void set_unreached_test_runs(int n) { proto_->set_unreached_test_runs(n); }
+  void set_event_time(timestamp_t t) { proto_->set_event_time(t); }
 
  protected:
   iRootInfo(iRoot *iroot, iRootInfoProto *proto)
@@ -69,6 +77,12 @@ class Memo {
   iRoot *ChooseForTest();
   iRoot *ChooseForTest(IdiomType idiom);
   iRoot *ChooseForTest(iroot_id_t iroot_id);
+  void ChooseForTest(size_t num, std::vector<iRoot *> *iroots);
+  void ChooseForTest(IdiomType idiom, size_t num,
+                     std::vector<iRoot *> *iroots);
+  void ListCandidate(size_t num, std::vector<iRoot *> *iroots);
+  void ListCandidate(IdiomType idiom, size_t num,
+                     std::vector<iRoot *> *iroots);
   void TestSuccess(iRoot *iroot, bool locking);
   void TestFail(iRoot *iroot, bool locking);
   void Predicted(iRoot *iroot, bool locking);
@@ -76,10 +90,16 @@ class Memo {
   int TotalTestRuns(iRoot *iroot, bool locking);
   bool Async(iRoot *iroot, bool locking);
   void SetAsync(iRoot *iroot, bool locking);
+  void EventReached(iRoot *iroot, timestamp_t time, bool locking);
+  void EventUnreached(iRoot *iroot, bool locking);
   size_t TotalCandidate(bool locking);
   size_t TotalExposed(IdiomType idiom, bool shadow, bool locking);
   size_t TotalPredicted(bool locking);
   void Merge(Memo *other);
+  // merge a memo whose iroots belong to another iroot database, the
+  // iroots are imported to the iroot database of this memo (and new
+  // instructions to the given static info)
+  void Merge(Memo *other, StaticInfo *sinfo);
   void RefineCandidate(bool memo_failed);
   void SampleCandidate(IdiomType idiom, size_t num);
   void Load(const std::string &db_name, StaticInfo *sinfo);
@@ -90,9 +110,39 @@ class Memo {
   typedef std::tr1::unordered_set<iRootInfo *> iRootInfoSet;
   typedef std::tr1::unordered_map<iRootInfo *, int> CandidateMap;
 
+  // the key to order the candidates of an idiom. candidates from the
+  // application come first, and then those with higher scores.
+  class CandidateKey {
+   public:
+    CandidateKey() : common_lib(false), score(0.0), iroot_info(NULL) {}
+    ~CandidateKey() {}
+
+    bool operator<(const CandidateKey &other) const {
+      if (common_lib != other.common_lib)
+        return !common_lib;
+      if (score != other.score)
+        return score > other.score;
+      return iroot_info->iroot()->id() < other.iroot_info->iroot()->id();
+    }
+
+    bool common_lib;
+    double score;
+    iRootInfo *iroot_info;
+  };
+
+  typedef std::set<CandidateKey> CandidateQueue;
+  typedef std::map<IdiomType, CandidateQueue> CandidateQueueMap;
+  typedef std::tr1::unordered_map<iRootInfo *, CandidateKey> CandidateKeyMap;
+
   iRootInfo *GetiRootInfo(iRoot *iroot, bool locking);
   iRootInfo *FindiRootInfo(iRoot *iroot, bool locking);
   iRootInfo *CreateiRootInfo(iRoot *iroot, bool locking);
+  double Score(iRootInfo *iroot_info);
+  void AddCandidate(iRootInfo *iroot_info, int test_runs);
+  void RemoveCandidate(iRootInfo *iroot_info);
+  void UpdateCandidate(iRootInfo *iroot_info);
+  iRoot *MergediRoot(Memo *other, iRoot *iroot, StaticInfo *sinfo);
+  static bool ShareInst(iRoot *iroot, std::vector<iRoot *> *iroots);
 
   Mutex *internal_lock_;
   iRootDB *iroot_db_;
@@ -102,6 +152,8 @@ class Memo {
   iRootInfoSet predicted_set_;
   iRootInfoSet shadow_exposed_set_; // optional
   CandidateMap candidate_map_;
+  CandidateQueueMap candidate_queue_map_; // candidates ordered by scores
+  CandidateKeyMap candidate_key_map_;
   MemoProto proto_;
   int failed_limit_;
   int total_failed_limit_;
@@ -39,6 +39,8 @@ void MemoTool::HandlePreSetup() {
   knob_->RegisterStr("arg", "the argument to the operation", "null");
   knob_->RegisterStr("path", "the path argument to the operation", "null");
   knob_->RegisterInt("num", "the integer argument to the operation", "0");
+  knob_->RegisterStr("merge_sinfo_in", "the static info database path of the memo to merge", "null");
+  knob_->RegisterStr("merge_iroot_in", "the iroot database path of the memo to merge", "null");
 }
 
 void MemoTool::HandlePostSetup() {
@@ -54,11 +56,13 @@ void MemoTool::HandlePostSetup() {
   // Register operations.
   Register("list", std::tr1::bind(&MemoTool::list, this));
   Register("has_candidate", std::tr1::bind(&MemoTool::has_candidate, this));
+  Register("list_candidate", std::tr1::bind(&MemoTool::list_candidate, this));
   Register("sample_candidate", std::tr1::bind(&MemoTool::sample_candidate, this));
   Register("total_candidate", std::tr1::bind(&MemoTool::total_candidate, this));
   Register("total_exposed", std::tr1::bind(&MemoTool::total_exposed, this));
   Register("total_predicted", std::tr1::bind(&MemoTool::total_predicted, this));
   Register("apply", std::tr1::bind(&MemoTool::apply, this));
+  Register("merge", std::tr1::bind(&MemoTool::merge, this));
 }
 
 void MemoTool::HandleStart() {
@@ -133,6 +137,33 @@ void MemoTool::has_candidate() {
   }
 }
 
+void MemoTool::list_candidate() {
+  read_only_ = true;
+
+  // print the ids of (at most num) candidates in the order they would
+  // be chosen for test
+  std::vector<iRoot *> iroots;
+  size_t num = (size_t)knob_->ValueInt("num");
+  std::string arg = knob_->ValueStr("arg");
+  if (arg == "0" || arg == "null") {
+    memo_->ListCandidate(num, &iroots);
+  } else if (arg == "1") {
+    memo_->ListCandidate(IDIOM_1, num, &iroots);
+  } else if (arg == "2") {
+    memo_->ListCandidate(IDIOM_2, num, &iroots);
+  } else if (arg == "3") {
+    memo_->ListCandidate(IDIOM_3, num, &iroots);
+  } else if (arg == "4") {
+    memo_->ListCandidate(IDIOM_4, num, &iroots);
+  } else if (arg == "5") {
+    memo_->ListCandidate(IDIOM_5, num, &iroots);
+  }
+
+  for (size_t i = 0; i < iroots.size(); i++) {
+    printf("%u\n", iroots[i]->id());
+  }
+}
+
 void MemoTool::sample_candidate() {
   std::string arg = knob_->ValueStr("arg");
   int num = knob_->ValueInt("num");
@@ -186,5 +217,19 @@ void MemoTool::apply() {
   memo_->RefineCandidate(true);
 }
 
+void MemoTool::merge() {
+  // The memo to merge comes with its own static info and iroot
+  // database (e.g. the output of a parallel test worker), thus its
+  // iroots are imported into the databases of this tool.
+  StaticInfo *sinfo_other = new StaticInfo(CreateMutex());
+  sinfo_other->Load(knob_->ValueStr("merge_sinfo_in"));
+  iRootDB *iroot_db_other = new iRootDB(CreateMutex());
+  iroot_db_other->Load(knob_->ValueStr("merge_iroot_in"), sinfo_other);
+  Memo *memo_other = new Memo(CreateMutex(), iroot_db_other);
+  memo_other->Load(knob_->ValueStr("path"), sinfo_other);
+  memo_->Merge(memo_other, sinfo_);
+  memo_->RefineCandidate(true);
+}
+
 } // namespace idiom {
 
@@ -56,11 +56,13 @@ class MemoTool : public OfflineTool {
   // Belows are operation handling functions.
   void list();
   void has_candidate();
+  void list_candidate();
   void sample_candidate();
   void total_candidate();
   void total_exposed();
   void total_predicted();
   void apply();
+  void merge();
 
   iRootDB *iroot_db_;
   Memo *memo_;
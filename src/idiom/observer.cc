@@ -441,75 +441,63 @@ void Observer::UpdateLocalInfo(ObserverAccess *curr_access, address_t addr,
   ObserverLocalInfo &curr_li = local_info_map_[curr_thd_id];
 
   // iterator recent accesses, calculate distance, discover complex iroots
-  std::tr1::unordered_set<address_t> touched_addr_set;
-  std::vector<ObserverAccess> local_prev_vec;
-  for (ObserverLocalInfo::EntryMap::reverse_iterator mit =
-          curr_li.entries_.rbegin(); mit != curr_li.entries_.rend(); ++mit) {
-    timestamp_t time = mit->first;
-
-    if (TIME_DISTANCE(time, curr_time) < vw_) {
-      bool need_break = false;
-      for (ObserverLocalInfo::EntryVec::reverse_iterator vit =
-              mit->second.rbegin(); vit != mit->second.rend(); ++vit) {
-        ObserverLocalInfo::EntryType &entry = *vit;
-        if (touched_addr_set.find(entry.addr) != touched_addr_set.end())
-          continue;
-        // add to the touched address set
-        touched_addr_set.insert(entry.addr);
-        if (time != curr_time) {
-          local_prev_vec.push_back(entry.access);
-          UpdateComplexiRoots(curr_access, preds, &entry.access, &entry.succs,
-                              (entry.addr == addr));
-        }
-        if (entry.addr == addr) {
-          need_break = true;
-          break;
-        }
-      } // end of for
-      if (need_break)
-        break;
-    } else {
+  touched_addr_set_.Clear();
+  local_prev_vec_.clear();
+  for (size_t idx = curr_li.Size(); idx > 0; idx--) {
+    ObserverLocalInfo::EntryType &entry = curr_li.At(idx - 1);
+    timestamp_t time = entry.access.clk_;
+    if (TIME_DISTANCE(time, curr_time) >= vw_)
       break;
+    // add to the touched address set
+    if (!touched_addr_set_.Insert(entry.addr))
+      continue;
+    if (time != curr_time) {
+      local_prev_vec_.push_back(entry.access);
+      UpdateComplexiRoots(curr_access, preds, &entry.access, &entry.succs,
+                          (entry.addr == addr));
     }
+    if (entry.addr == addr)
+      break;
   }
 
   // add curr_access to the succ of all the pred entries
+  ObserverLocalInfo::PrevVecPtr prev_vec;
   for (std::vector<ObserverAccess>::iterator it = preds->begin();
        it != preds->end(); ++it) {
     ObserverAccess &access = *it;
     timestamp_t time = access.clk_;
     ObserverLocalInfo &li = local_info_map_[access.thd_id_];
-    ObserverLocalInfo::EntryMap::iterator mit = li.entries_.find(time);
-    if (mit != li.entries_.end()) {
-      for (ObserverLocalInfo::EntryVec::iterator vit = mit->second.begin();
-           vit != mit->second.end(); ++vit) {
-        if (addr == vit->addr &&
-            access.type_ == vit->access.type_ &&
-            access.inst_ == vit->access.inst_) {
-          ObserverLocalInfo::SuccEntry succ_entry;
-          succ_entry.succ = *curr_access;
-          succ_entry.local_prev_vec = local_prev_vec;
-          vit->succs.push_back(succ_entry);
-        }
+    for (size_t idx = li.LowerBound(time); idx < li.Size(); idx++) {
+      ObserverLocalInfo::EntryType &entry = li.At(idx);
+      if (entry.access.clk_ != time)
+        break;
+      if (addr == entry.addr &&
+          access.type_ == entry.access.type_ &&
+          access.inst_ == entry.access.inst_) {
+        // the local prev accesses are copied only once
+        if (!prev_vec)
+          prev_vec.reset(new ObserverLocalInfo::PrevVec(local_prev_vec_));
+        ObserverLocalInfo::SuccEntry succ_entry;
+        succ_entry.succ = *curr_access;
+        succ_entry.local_prev_vec = prev_vec;
+        entry.succs.push_back(succ_entry);
       }
     }
   }
 
-  // remove stale entries if local info is so large
-  while (!curr_li.entries_.empty()) {
-    ObserverLocalInfo::EntryMap::iterator it = curr_li.entries_.begin();
-    if (TIME_DISTANCE(it->first, curr_time) >= vw_) {
-      curr_li.entries_.erase(it);
+  // remove stale entries
+  while (curr_li.Size() > 0) {
+    if (TIME_DISTANCE(curr_li.At(0).access.clk_, curr_time) >= vw_) {
+      curr_li.PopFront();
     } else {
       break;
     }
   }
 
   // add entry
-  ObserverLocalInfo::EntryType new_entry;
-  new_entry.addr = addr;
-  new_entry.access = *curr_access;
-  curr_li.entries_[curr_time].push_back(new_entry);
+  ObserverLocalInfo::EntryType *new_entry = curr_li.PushBack();
+  new_entry->addr = addr;
+  new_entry->access = *curr_access;
 }
 
 void Observer::UpdateiRoots(ObserverAccess *curr_access,
@@ -519,11 +507,11 @@ void Observer::UpdateiRoots(ObserverAccess *curr_access,
        it != preds->end(); ++it) {
     iRootEvent *pred = iroot_db_->GetiRootEvent(it->inst_,
                                                 it->type_,
-                                                false);
+                                                true);
     iRootEvent *curr = iroot_db_->GetiRootEvent(curr_access->inst_,
                                                 curr_access->type_,
-                                                false);
-    iRoot *iroot = iroot_db_->GetiRoot(IDIOM_1, false, pred, curr);
+                                                true);
+    iRoot *iroot = iroot_db_->GetiRoot(IDIOM_1, true, pred, curr);
     memo_->Observed(iroot, shadow_, false);
   }
 }
@@ -549,13 +537,13 @@ void Observer::UpdateComplexiRoots(ObserverAccess *curr_access,
         if (sa.thd_id_ == pa.thd_id_ && sa.clk_ < pa.clk_) {
           iRootEvent *e0 = iroot_db_->GetiRootEvent(prev_access->inst_,
                                                     prev_access->type_,
-                                                    false);
-          iRootEvent *e1 = iroot_db_->GetiRootEvent(sa.inst_, sa.type_, false);
-          iRootEvent *e2 = iroot_db_->GetiRootEvent(pa.inst_, pa.type_, false);
+                                                    true);
+          iRootEvent *e1 = iroot_db_->GetiRootEvent(sa.inst_, sa.type_, true);
+          iRootEvent *e2 = iroot_db_->GetiRootEvent(pa.inst_, pa.type_, true);
           iRootEvent *e3 = iroot_db_->GetiRootEvent(curr_access->inst_,
                                                     curr_access->type_,
-                                                    false);
-          iRoot *iroot = iroot_db_->GetiRoot(IDIOM_3, false, e0, e1, e2, e3);
+                                                    true);
+          iRoot *iroot = iroot_db_->GetiRoot(IDIOM_3, true, e0, e1, e2, e3);
           memo_->Observed(iroot, shadow_, false);
         }
 
@@ -571,12 +559,12 @@ void Observer::UpdateComplexiRoots(ObserverAccess *curr_access,
       if (idiom2_exists) {
         iRootEvent *e0 = iroot_db_->GetiRootEvent(prev_access->inst_,
                                                   prev_access->type_,
-                                                  false);
-        iRootEvent *e1 = iroot_db_->GetiRootEvent(pa.inst_, pa.type_, false);
+                                                  true);
+        iRootEvent *e1 = iroot_db_->GetiRootEvent(pa.inst_, pa.type_, true);
         iRootEvent *e2 = iroot_db_->GetiRootEvent(curr_access->inst_,
                                                   curr_access->type_,
-                                                  false);
-        iRoot *iroot = iroot_db_->GetiRoot(IDIOM_2, false, e0, e1, e2);
+                                                  true);
+        iRoot *iroot = iroot_db_->GetiRoot(IDIOM_2, true, e0, e1, e2);
         memo_->Observed(iroot, shadow_, false);
       }
     }
@@ -594,17 +582,17 @@ void Observer::UpdateComplexiRoots(ObserverAccess *curr_access,
           if (sa.clk_ < pa.clk_) {
             iRootEvent *e0 = iroot_db_->GetiRootEvent(prev_access->inst_,
                                                       prev_access->type_,
-                                                      false);
+                                                      true);
             iRootEvent *e1 = iroot_db_->GetiRootEvent(sa.inst_,
                                                       sa.type_,
-                                                      false);
+                                                      true);
             iRootEvent *e2 = iroot_db_->GetiRootEvent(pa.inst_,
                                                       pa.type_,
-                                                      false);
+                                                      true);
             iRootEvent *e3 = iroot_db_->GetiRootEvent(curr_access->inst_,
                                                       curr_access->type_,
-                                                      false);
-            iRoot *iroot = iroot_db_->GetiRoot(IDIOM_4, false, e0, e1, e2, e3);
+                                                      true);
+            iRoot *iroot = iroot_db_->GetiRoot(IDIOM_4, true, e0, e1, e2, e3);
             memo_->Observed(iroot, shadow_, false);
           } else if (sa.clk_ > pa.clk_) {
             if (TIME_DISTANCE(pa.clk_, sa.clk_) < vw_) {
@@ -612,26 +600,26 @@ void Observer::UpdateComplexiRoots(ObserverAccess *curr_access,
               // and pa that accesses the same location as sa or pa
               // check whether pa is in local_prev_vec
               for (std::vector<ObserverAccess>::iterator it =
-                      (*sit).local_prev_vec.begin();
-                      it != (*sit).local_prev_vec.end(); ++it) {
+                      (*sit).local_prev_vec->begin();
+                      it != (*sit).local_prev_vec->end(); ++it) {
                 if ((*it).clk_ == pa.clk_ &&
                     (*it).type_ == pa.type_ &&
                     (*it).inst_ == pa.inst_) {
                   iRootEvent *e0 = iroot_db_->GetiRootEvent(prev_access->inst_,
                                                             prev_access->type_,
-                                                            false);
+                                                            true);
                   iRootEvent *e1 = iroot_db_->GetiRootEvent(sa.inst_,
                                                             sa.type_,
-                                                            false);
+                                                            true);
                   iRootEvent *e2 = iroot_db_->GetiRootEvent(pa.inst_,
                                                             pa.type_,
-                                                            false);
+                                                            true);
                   iRootEvent *e3 = iroot_db_->GetiRootEvent(curr_access->inst_,
                                                             curr_access->type_,
-                                                            false);
-                  iRoot *iroot = iroot_db_->GetiRoot(IDIOM_5, false,
+                                                            true);
+                  iRoot *iroot = iroot_db_->GetiRoot(IDIOM_5, true,
                                                      e0, e1, e2, e3);
-                  iRoot *irootx = iroot_db_->GetiRoot(IDIOM_5, false,
+                  iRoot *irootx = iroot_db_->GetiRoot(IDIOM_5, true,
                                                       e2, e3, e0, e1);
                   memo_->Observed(iroot, shadow_, false);
                   memo_->Observed(irootx, shadow_, false);
@@ -646,5 +634,96 @@ void Observer::UpdateComplexiRoots(ObserverAccess *curr_access,
   }
 }
 
+void ObserverLocalInfo::Clear() {
+  while (size_ > 0)
+    PopFront();
+  head_ = 0;
+}
+
+ObserverLocalInfo::EntryType *ObserverLocalInfo::PushBack() {
+  if (size_ == ring_.size())
+    Grow();
+  EntryType *entry = &At(size_);
+  size_++;
+  return entry;
+}
+
+void ObserverLocalInfo::PopFront() {
+  DEBUG_ASSERT(size_ > 0);
+  // keep the capacity of the succ vector for reuse
+  At(0).succs.clear();
+  head_ = (head_ + 1) & (ring_.size() - 1);
+  size_--;
+}
+
+size_t ObserverLocalInfo::LowerBound(timestamp_t time) {
+  size_t low = 0;
+  size_t high = size_;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (At(mid).access.clk_ < time)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+void ObserverLocalInfo::Grow() {
+  EntryVec ring(ring_.empty() ? 16 : ring_.size() * 2);
+  for (size_t idx = 0; idx < size_; idx++) {
+    EntryType &entry = At(idx);
+    ring[idx].addr = entry.addr;
+    ring[idx].access = entry.access;
+    ring[idx].succs.swap(entry.succs);
+  }
+  ring_.swap(ring);
+  head_ = 0;
+}
+
+void ObserverAddrSet::Clear() {
+  size_ = 0;
+  epoch_++;
+  if (epoch_ == 0) {
+    // the epoch wraps around, reset all the slots
+    for (size_t idx = 0; idx < slots_.size(); idx++)
+      slots_[idx].epoch = 0;
+    epoch_ = 1;
+  }
+}
+
+bool ObserverAddrSet::Insert(address_t addr) {
+  // keep the load factor no larger than 1/2
+  if ((size_ + 1) * 2 > slots_.size())
+    Grow();
+  size_t mask = slots_.size() - 1;
+  size_t idx = Hash(addr) & mask;
+  while (slots_[idx].epoch == epoch_) {
+    if (slots_[idx].addr == addr)
+      return false;
+    idx = (idx + 1) & mask;
+  }
+  slots_[idx].addr = addr;
+  slots_[idx].epoch = epoch_;
+  size_++;
+  return true;
+}
+
+void ObserverAddrSet::Grow() {
+  std::vector<SlotType> slots;
+  slots.swap(slots_);
+  SlotType empty_slot = { 0, 0 };
+  slots_.resize(slots.empty() ? 64 : slots.size() * 2, empty_slot);
+  size_t mask = slots_.size() - 1;
+  for (size_t i = 0; i < slots.size(); i++) {
+    if (slots[i].epoch != epoch_)
+      continue;
+    size_t idx = Hash(slots[i].addr) & mask;
+    while (slots_[idx].epoch == epoch_)
+      idx = (idx + 1) & mask;
+    slots_[idx] = slots[i];
+  }
+}
+
 } // namespace idiom
 
@@ -24,6 +24,7 @@
 #include <map>
 #include <set>
 #include <tr1/unordered_map>
+#include <tr1/memory>
 
 #include "core/basictypes.h"
 #include "core/sync.h"
@@ -78,6 +79,7 @@ class ObserverAccess {
   Inst *inst_;
 
   friend class Observer;
+  friend class ObserverLocalInfo;
 
   // using default copy constructor and assignment operator
 };
@@ -126,18 +128,25 @@ class ObserverMutexMeta : public ObserverMeta {
   DISALLOW_COPY_CONSTRUCTORS(ObserverMutexMeta);
 };
 
-// Local information.
+// Local information. The recent accesses of a thread are stored in a
+// ring buffer ordered by their timestamps. The ring buffer only grows
+// when the accesses in the vulnerability window do not fit, thus no
+// allocation is needed once it covers the window.
 class ObserverLocalInfo {
  public:
-  ObserverLocalInfo() {}
+  ObserverLocalInfo() : head_(0), size_(0) {}
   ~ObserverLocalInfo() {}
 
-  void Clear() { entries_.clear(); }
+  void Clear();
 
  private:
+  // the local accesses that precede a succ in the vulnerability window,
+  // shared by all the succ entries created by the same access
+  typedef std::vector<ObserverAccess> PrevVec;
+  typedef std::tr1::shared_ptr<PrevVec> PrevVecPtr;
   typedef struct {
     ObserverAccess succ;
-    std::vector<ObserverAccess> local_prev_vec; // for idiom-5
+    PrevVecPtr local_prev_vec; // for idiom-5
   } SuccEntry;
   typedef std::vector<SuccEntry> SuccVec;
   typedef struct {
@@ -146,15 +155,58 @@ class ObserverLocalInfo {
     SuccVec succs;
   } EntryType;
   typedef std::vector<EntryType> EntryVec;
-  typedef std::map<timestamp_t, EntryVec> EntryMap;
 
-  EntryMap entries_;
+  size_t Size() { return size_; }
+  // the entry at idx (0 is the oldest)
+  EntryType &At(size_t idx) {
+    return ring_[(head_ + idx) & (ring_.size() - 1)];
+  }
+  EntryType *PushBack();
+  void PopFront();
+  // the index of the first entry whose timestamp is not less than time
+  size_t LowerBound(timestamp_t time);
+  void Grow();
+
+  EntryVec ring_; // the size is always a power of 2
+  size_t head_;
+  size_t size_;
 
   friend class Observer;
 
   // using default copy constructor and assignment operator
 };
 
+// A small open addressing hash set of addresses. Each slot is tagged
+// with the epoch in which it is filled, thus clearing the set is done
+// by simply starting a new epoch.
+class ObserverAddrSet {
+ public:
+  ObserverAddrSet() : epoch_(1), size_(0) {}
+  ~ObserverAddrSet() {}
+
+  void Clear();
+  // return false if the address is already in the set
+  bool Insert(address_t addr);
+
+ private:
+  typedef struct {
+    address_t addr;
+    uint32 epoch;
+  } SlotType;
+
+  size_t Hash(address_t addr) {
+    uint64 h = (uint64)addr * 0x9e3779b97f4a7c15ULL;
+    return (size_t)(h ^ (h >> 32));
+  }
+  void Grow();
+
+  uint32 epoch_;
+  size_t size_;
+  std::vector<SlotType> slots_; // the size is always a power of 2
+
+  DISALLOW_COPY_CONSTRUCTORS(ObserverAddrSet);
+};
+
 // iRoot observer which analyzes which iRoots are tested.
 class Observer : public Analyzer {
  public:
@@ -247,6 +299,8 @@ class Observer : public Analyzer {
   timestamp_t vw_; // vulnerability window
   RegionFilter *filter_;
   std::map<thread_id_t, ObserverLocalInfo> local_info_map_;
+  ObserverAddrSet touched_addr_set_; // used in UpdateLocalInfo
+  ObserverLocalInfo::PrevVec local_prev_vec_; // used in UpdateLocalInfo
   MetaMap meta_map_;
 
   DISALLOW_COPY_CONSTRUCTORS(Observer);
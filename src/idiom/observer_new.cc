@@ -416,11 +416,11 @@ void ObserverNew::UpdateiRoot(Acc *curr_acc, Acc::Vec *preds) {
   for (Acc::Vec::iterator it = preds->begin(); it != preds->end(); ++it) {
     iRootEvent *pred = iroot_db_->GetiRootEvent((*it).inst,
                                                 (*it).type,
-                                                false);
+                                                true);
     iRootEvent *curr = iroot_db_->GetiRootEvent(curr_acc->inst,
                                                 curr_acc->type,
-                                                false);
-    iRoot *iroot = iroot_db_->GetiRoot(IDIOM_1, false, pred, curr);
+                                                true);
+    iRoot *iroot = iroot_db_->GetiRoot(IDIOM_1, true, pred, curr);
     memo_->Observed(iroot, shadow_, false);
     DEBUG_STAT_INC("ob_dynamic_deps", 1);
   }
@@ -453,21 +453,21 @@ void ObserverNew::UpdateComplexiRoot(Acc *curr_acc,
           // for idiom3/idiom4
           iRootEvent *e0 = iroot_db_->GetiRootEvent(prev_acc.inst,
                                                     prev_acc.type,
-                                                    false);
+                                                    true);
           iRootEvent *e1 = iroot_db_->GetiRootEvent(succ.inst,
                                                     succ.type,
-                                                    false);
+                                                    true);
           iRootEvent *e2 = iroot_db_->GetiRootEvent(pred.inst,
                                                     pred.type,
-                                                    false);
+                                                    true);
           iRootEvent *e3 = iroot_db_->GetiRootEvent(curr_acc->inst,
                                                     curr_acc->type,
-                                                    false);
+                                                    true);
           iRoot *iroot = NULL;
           if (prev_meta == curr_meta) {
-            iroot = iroot_db_->GetiRoot(IDIOM_3, false, e0, e1, e2, e3);
+            iroot = iroot_db_->GetiRoot(IDIOM_3, true, e0, e1, e2, e3);
           } else {
-            iroot = iroot_db_->GetiRoot(IDIOM_4, false, e0, e1, e2, e3);
+            iroot = iroot_db_->GetiRoot(IDIOM_4, true, e0, e1, e2, e3);
           }
           memo_->Observed(iroot, shadow_, false);
         } else if (succ.thd_clk > pred.thd_clk) {
@@ -483,19 +483,19 @@ void ObserverNew::UpdateComplexiRoot(Acc *curr_acc,
                 if ((*it).uid == pred.uid) {
                   iRootEvent *e0 = iroot_db_->GetiRootEvent(prev_acc.inst,
                                                             prev_acc.type,
-                                                            false);
+                                                            true);
                   iRootEvent *e1 = iroot_db_->GetiRootEvent(succ.inst,
                                                             succ.type,
-                                                            false);
+                                                            true);
                   iRootEvent *e2 = iroot_db_->GetiRootEvent(pred.inst,
                                                             pred.type,
-                                                            false);
+                                                            true);
                   iRootEvent *e3 = iroot_db_->GetiRootEvent(curr_acc->inst,
                                                             curr_acc->type,
-                                                            false);
-                  iRoot *iroot = iroot_db_->GetiRoot(IDIOM_5, false,
+                                                            true);
+                  iRoot *iroot = iroot_db_->GetiRoot(IDIOM_5, true,
                                                      e0, e1, e2, e3);
-                  iRoot *irootx = iroot_db_->GetiRoot(IDIOM_5, false,
+                  iRoot *irootx = iroot_db_->GetiRoot(IDIOM_5, true,
                                                       e2, e3, e0, e1);
                   memo_->Observed(iroot, shadow_, false);
                   memo_->Observed(irootx, shadow_, false);
@@ -516,14 +516,14 @@ void ObserverNew::UpdateComplexiRoot(Acc *curr_acc,
     if (same_acc_exist) {
       iRootEvent *e0 = iroot_db_->GetiRootEvent(prev_acc.inst,
                                                 prev_acc.type,
-                                                false);
+                                                true);
       iRootEvent *e1 = iroot_db_->GetiRootEvent(succ.inst,
                                                 succ.type,
-                                                false);
+                                                true);
       iRootEvent *e2 = iroot_db_->GetiRootEvent(curr_acc->inst,
                                                 curr_acc->type,
-                                                false);
-      iRoot *iroot = iroot_db_->GetiRoot(IDIOM_2, false, e0, e1, e2);
+                                                true);
+      iRoot *iroot = iroot_db_->GetiRoot(IDIOM_2, true, e0, e1, e2);
       memo_->Observed(iroot, shadow_, false);
     }
   } // end of for each succ
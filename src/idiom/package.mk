@@ -20,6 +20,8 @@ srcs += \
   idiom/observer_new.cc \
   idiom/pct_profiler.cpp \
   idiom/pct_profiler_main.cpp \
+  idiom/predict_tool.cc \
+  idiom/predict_tool_main.cc \
   idiom/predictor.cc \
   idiom/predictor_new.cc \
   idiom/profiler.cpp \
@@ -38,7 +40,8 @@ pintools += \
   idiom_scheduler.so
 
 cmdtools += \
-  idiom_memo_tool
+  idiom_memo_tool \
+  idiom_predict
 
 iroot_objs += \
   idiom/history.o \
@@ -129,3 +132,14 @@ idiom_memo_tool_objs := \
   idiom/memo_tool_main.o \
   $(core_cmd_objs)
 
+idiom_predict_objs := \
+  idiom/iroot.o \
+  idiom/iroot.pb.o \
+  idiom/memo.o \
+  idiom/memo.pb.o \
+  idiom/predict_tool.o \
+  idiom/predict_tool_main.o \
+  idiom/predictor_new.o \
+  $(sinst_cmd_objs) \
+  $(tracer_cmd_objs) \
+  $(core_cmd_objs)
@@ -0,0 +1,288 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+
+// File: idiom/predict_tool.cc - Implementation of the offline iroot
+// predictor which replays recorded trace logs.
+
+#include "idiom/predict_tool.h"
+
+#include <pthread.h>
+#include <cstdio>
+#include <cstdlib>
+
+#include "core/logging.h"
+
+namespace idiom {
+
+PredictTool::PredictTool()
+    : iroot_db_(NULL),
+      memo_(NULL),
+      predictor_(NULL),
+      partition_size_(0) {
+  // empty
+}
+
+void PredictTool::HandlePreSetup() {
+  tracer::Loader::HandlePreSetup();
+
+  knob_->RegisterBool("memo_failed", "whether memoize fail-to-expose iroots", "1");
+  knob_->RegisterStr("iroot_in", "the input iroot database path", "iroot.db");
+  knob_->RegisterStr("iroot_out", "the output iroot database path", "iroot.db");
+  knob_->RegisterStr("memo_in", "the input memoization database path", "memo.db");
+  knob_->RegisterStr("memo_out", "the output memoization database path", "memo.db");
+  knob_->RegisterStr("sinst_in", "the input shared inst database path", "sinst.db");
+  knob_->RegisterInt("num_workers", "the number of worker threads (0 means the number of cpus)", "0");
+  knob_->RegisterInt("partition_size", "the size of each address partition in bytes", "4096");
+
+  predictor_ = new PredictorNew;
+  predictor_->Register();
+}
+
+void PredictTool::HandlePostSetup() {
+  tracer::Loader::HandlePostSetup();
+
+  if (!predictor_->Enabled()) {
+    printf("Please enable the iroot predictor\n");
+    exit(1);
+  }
+
+  // load iroot db and memo db
+  iroot_db_ = new iRootDB(CreateMutex());
+  iroot_db_->Load(knob_->ValueStr("iroot_in"), sinfo_);
+  memo_ = new Memo(CreateMutex(), iroot_db_);
+  memo_->Load(knob_->ValueStr("memo_in"), sinfo_);
+
+  partition_size_ = PartitionSize(knob_->ValueInt("partition_size"),
+                                  knob_->ValueInt("unit_size"));
+
+  // complex idioms relate the accesses to different addresses in the
+  // same thread, thus cannot be predicted from a single partition
+  int num_workers = NumWorkers(knob_->ValueInt("num_workers"));
+  if (knob_->ValueBool("complex_idioms"))
+    num_workers = 1;
+
+  // create workers, each of which has its own shared inst database
+  // so that the shared instructions found in one partition do not
+  // depend on the progress of other workers
+  for (int i = 0; i < num_workers; i++) {
+    Worker *worker = new Worker;
+    worker->id = i;
+    worker->tool = this;
+    worker->sinst_db = new sinst::SharedInstDB(CreateMutex());
+    worker->sinst_db->Load(knob_->ValueStr("sinst_in"), sinfo_);
+    worker->predictor = i == 0 ? predictor_ : new PredictorNew;
+    worker->predictor->Setup(CreateMutex(), sinfo_, iroot_db_, memo_,
+                             worker->sinst_db);
+    worker->predictor->SetPartition(partition_size_, num_workers, i);
+    workers_.push_back(worker);
+  }
+}
+
+void PredictTool::HandleStart() {
+  std::vector<pthread_t> tid_vec(workers_.size());
+  for (size_t i = 0; i < workers_.size(); i++)
+    pthread_create(&tid_vec[i], NULL, WorkerMain, workers_[i]);
+  for (size_t i = 0; i < workers_.size(); i++)
+    pthread_join(tid_vec[i], NULL);
+}
+
+void PredictTool::HandleExit() {
+  memo_->RefineCandidate(knob_->ValueBool("memo_failed"));
+
+  // save iroot db
+  iroot_db_->Save(knob_->ValueStr("iroot_out"), sinfo_);
+  // save memoization db
+  memo_->Save(knob_->ValueStr("memo_out"), sinfo_);
+}
+
+void PredictTool::WorkerLoop(Worker *worker) {
+  // each worker reads the trace log on its own
+  tracer::TraceLog trace_log(knob_->ValueStr("trace_log_path"));
+  trace_log.OpenForRead();
+  while (trace_log.HasNextEntry()) {
+    tracer::LogEntry entry = trace_log.NextEntry();
+    WorkerHandleEvent(worker, &entry);
+  }
+  trace_log.CloseForRead();
+  // predict iroots for the owned partitions
+  worker->predictor->ProgramExit();
+}
+
+void PredictTool::WorkerHandleEvent(Worker *worker, tracer::LogEntry *e) {
+  PredictorNew *predictor = worker->predictor;
+  thread_id_t self = e->thd_id();
+  timestamp_t curr_thd_clk = e->thd_clk();
+  switch (e->type()) {
+    case tracer::LOG_ENTRY_IMAGE_LOAD:
+    case tracer::LOG_ENTRY_IMAGE_UNLOAD:
+      {
+        Image *image = sinfo_->FindImage((image_id_type)e->arg(0));
+        DEBUG_ASSERT(image);
+        if (e->type() == tracer::LOG_ENTRY_IMAGE_LOAD)
+          predictor->ImageLoad(image, e->arg(1), e->arg(2), e->arg(3),
+                               e->arg(4), e->arg(5), e->arg(6));
+        else
+          predictor->ImageUnload(image, e->arg(1), e->arg(2), e->arg(3),
+                                 e->arg(4), e->arg(5), e->arg(6));
+      }
+      break;
+    case tracer::LOG_ENTRY_SYSCALL_ENTRY:
+      predictor->SyscallEntry(self, curr_thd_clk, e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_SIGNAL_RECEIVED:
+      predictor->SignalReceived(self, curr_thd_clk, e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_THREAD_START:
+      predictor->ThreadStart(self, e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_THREAD_EXIT:
+      predictor->ThreadExit(self, curr_thd_clk);
+      break;
+    case tracer::LOG_ENTRY_BEFORE_MEM_READ:
+      if (predictor->desc()->HookBeforeMem() &&
+          WorkerOwnedMem(worker, e->arg(0), e->arg(1)))
+        predictor->BeforeMemRead(self, curr_thd_clk,
+                                 sinfo_->FindInst(e->inst_id()),
+                                 e->arg(0), e->arg(1));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_MEM_WRITE:
+      if (predictor->desc()->HookBeforeMem() &&
+          WorkerOwnedMem(worker, e->arg(0), e->arg(1)))
+        predictor->BeforeMemWrite(self, curr_thd_clk,
+                                  sinfo_->FindInst(e->inst_id()),
+                                  e->arg(0), e->arg(1));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_ATOMIC_INST:
+      predictor->BeforeAtomicInst(self, curr_thd_clk,
+                                  sinfo_->FindInst(e->inst_id()),
+                                  e->str_arg(0), e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_AFTER_ATOMIC_INST:
+      predictor->AfterAtomicInst(self, curr_thd_clk,
+                                 sinfo_->FindInst(e->inst_id()),
+                                 e->str_arg(0), e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_AFTER_PTHREAD_JOIN:
+      predictor->AfterPthreadJoin(self, curr_thd_clk,
+                                  sinfo_->FindInst(e->inst_id()),
+                                  e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_AFTER_PTHREAD_MUTEX_LOCK:
+      predictor->AfterPthreadMutexLock(self, curr_thd_clk,
+                                       sinfo_->FindInst(e->inst_id()),
+                                       e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_PTHREAD_MUTEX_UNLOCK:
+      predictor->BeforePthreadMutexUnlock(self, curr_thd_clk,
+                                          sinfo_->FindInst(e->inst_id()),
+                                          e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_PTHREAD_COND_SIGNAL:
+      predictor->BeforePthreadCondSignal(self, curr_thd_clk,
+                                         sinfo_->FindInst(e->inst_id()),
+                                         e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_PTHREAD_COND_BROADCAST:
+      predictor->BeforePthreadCondBroadcast(self, curr_thd_clk,
+                                            sinfo_->FindInst(e->inst_id()),
+                                            e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_PTHREAD_COND_WAIT:
+      predictor->BeforePthreadCondWait(self, curr_thd_clk,
+                                       sinfo_->FindInst(e->inst_id()),
+                                       e->arg(0), e->arg(1));
+      break;
+    case tracer::LOG_ENTRY_AFTER_PTHREAD_COND_WAIT:
+      predictor->AfterPthreadCondWait(self, curr_thd_clk,
+                                      sinfo_->FindInst(e->inst_id()),
+                                      e->arg(0), e->arg(1));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_PTHREAD_COND_TIMEDWAIT:
+      predictor->BeforePthreadCondTimedwait(self, curr_thd_clk,
+                                            sinfo_->FindInst(e->inst_id()),
+                                            e->arg(0), e->arg(1));
+      break;
+    case tracer::LOG_ENTRY_AFTER_PTHREAD_COND_TIMEDWAIT:
+      predictor->AfterPthreadCondTimedwait(self, curr_thd_clk,
+                                           sinfo_->FindInst(e->inst_id()),
+                                           e->arg(0), e->arg(1));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_PTHREAD_BARRIER_WAIT:
+      predictor->BeforePthreadBarrierWait(self, curr_thd_clk,
+                                          sinfo_->FindInst(e->inst_id()),
+                                          e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_AFTER_PTHREAD_BARRIER_WAIT:
+      predictor->AfterPthreadBarrierWait(self, curr_thd_clk,
+                                         sinfo_->FindInst(e->inst_id()),
+                                         e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_AFTER_MALLOC:
+      predictor->AfterMalloc(self, curr_thd_clk,
+                             sinfo_->FindInst(e->inst_id()),
+                             e->arg(0), e->arg(1));
+      break;
+    case tracer::LOG_ENTRY_AFTER_CALLOC:
+      predictor->AfterCalloc(self, curr_thd_clk,
+                             sinfo_->FindInst(e->inst_id()),
+                             e->arg(0), e->arg(1), e->arg(2));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_REALLOC:
+      predictor->BeforeRealloc(self, curr_thd_clk,
+                               sinfo_->FindInst(e->inst_id()),
+                               e->arg(0), e->arg(1));
+      break;
+    case tracer::LOG_ENTRY_AFTER_REALLOC:
+      predictor->AfterRealloc(self, curr_thd_clk,
+                              sinfo_->FindInst(e->inst_id()),
+                              e->arg(0), e->arg(1), e->arg(2));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_FREE:
+      predictor->BeforeFree(self, curr_thd_clk,
+                            sinfo_->FindInst(e->inst_id()), e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_AFTER_VALLOC:
+      predictor->AfterValloc(self, curr_thd_clk,
+                             sinfo_->FindInst(e->inst_id()),
+                             e->arg(0), e->arg(1));
+      break;
+    default:
+      // the predictor is not interested in other events, and the
+      // program exit is handled after the whole trace is replayed
+      break;
+  }
+}
+
+bool PredictTool::WorkerOwnedMem(Worker *worker, address_t addr,
+                                 size_t size) {
+  // check whether any part of the access falls in an owned partition
+  address_t end_addr = addr + size;
+  for (address_t iaddr = UNIT_DOWN_ALIGN(addr, partition_size_);
+       iaddr < end_addr; iaddr += partition_size_) {
+    if (worker->predictor->Owned(iaddr))
+      return true;
+  }
+  return false;
+}
+
+void *PredictTool::WorkerMain(void *arg) {
+  Worker *worker = (Worker *)arg;
+  worker->tool->WorkerLoop(worker);
+  return NULL;
+}
+
+} // namespace idiom
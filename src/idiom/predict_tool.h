@@ -0,0 +1,83 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+
+// File: idiom/predict_tool.h - Define the offline iroot predictor which
+// replays recorded trace logs.
+
+#ifndef IDIOM_PREDICT_TOOL_H_
+#define IDIOM_PREDICT_TOOL_H_
+
+#include <vector>
+
+#include "core/basictypes.h"
+#include "core/sync.h"
+#include "tracer/log.h"
+#include "tracer/loader.h"
+#include "idiom/iroot.h"
+#include "idiom/memo.h"
+#include "idiom/predictor_new.h"
+#include "sinst/sinst.h"
+
+namespace idiom {
+
+// The offline iroot predictor. The address space is partitioned across
+// worker threads. Each worker reads the whole trace log and replays all
+// the synchronization events (which are relatively rare) to track the
+// vector clocks and the locksets of the threads, but only builds the
+// access histories (thus the iroot events) for the addresses it owns.
+// The workers share the iroot database and the memoization database.
+class PredictTool : public tracer::Loader {
+ public:
+  PredictTool();
+  ~PredictTool() {}
+
+ protected:
+  // The state of a worker thread.
+  struct Worker {
+    Worker() : id(0), tool(NULL), predictor(NULL), sinst_db(NULL) {}
+
+    int id;
+    PredictTool *tool;
+    PredictorNew *predictor;
+    sinst::SharedInstDB *sinst_db;
+  };
+
+  Mutex *CreateMutex() { return new SysMutex; }
+  void HandlePreSetup();
+  void HandlePostSetup();
+  void HandleStart();
+  void HandleExit();
+
+  void WorkerLoop(Worker *worker);
+  void WorkerHandleEvent(Worker *worker, tracer::LogEntry *e);
+  bool WorkerOwnedMem(Worker *worker, address_t addr, size_t size);
+
+  static void *WorkerMain(void *arg);
+
+  iRootDB *iroot_db_;
+  Memo *memo_;
+  PredictorNew *predictor_; // owns the predictor knobs
+  address_t partition_size_;
+  std::vector<Worker *> workers_;
+
+ private:
+  DISALLOW_COPY_CONSTRUCTORS(PredictTool);
+};
+
+} // namespace idiom
+
+#endif
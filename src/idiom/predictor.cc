@@ -22,6 +22,7 @@
 #include <sys/syscall.h>
 #include "core/logging.h"
 #include "core/knob.h"
+#include "core/stat.h"
 
 namespace idiom {
 
@@ -37,6 +38,11 @@ Predictor::Predictor()
       vw_(1000),
       racy_only_(false),
       predict_deadlock_(false),
+      history_bytes_(0),
+      num_history_accesses_(0),
+      max_history_accesses_(0),
+      num_history_segments_(0),
+      num_history_dropped_(0),
       filter_(NULL) {
   // empty
 }
@@ -53,6 +59,7 @@ void Predictor::Register() {
   knob_->RegisterBool("predict_deadlock", "whether predict and trigger deadlocks (experimental)", "0");
   knob_->RegisterInt("unit_size", "the monitoring granularity in bytes", "4");
   knob_->RegisterInt("vw", "the vulnerability window (# dynamic inst)", "1000");
+  knob_->RegisterInt("history_bytes", "the estimated memory budget in bytes of the access histories of all the locations, the least recently accessed locations are evicted first (0 means unlimited)", "0");
 }
 
 bool Predictor::Enabled() {
@@ -69,10 +76,12 @@ void Predictor::Setup(Mutex *lock, StaticInfo *sinfo, iRootDB *iroot_db,
 
   sync_only_ = knob_->ValueBool("sync_only");
   unit_size_ = knob_->ValueInt("unit_size");
+  meta_map_.Setup(unit_size_);
   complex_idioms_ = knob_->ValueBool("complex_idioms");
   vw_ = knob_->ValueInt("vw");
   racy_only_ = knob_->ValueBool("racy_only");
   predict_deadlock_ = knob_->ValueBool("predict_deadlock");
+  history_bytes_ = knob_->ValueInt("history_bytes");
   filter_ = new RegionFilter(internal_lock_->Clone());
 
   if (!sync_only_) {
@@ -90,6 +99,12 @@ void Predictor::ProgramExit() {
   if (complex_idioms_) {
     UpdateComplexiRoots();
   }
+
+  // the offline predict tool reports from multiple workers
+  STAT_INC_SAFE("predictor_history_accesses", num_history_accesses_);
+  STAT_MAX_SAFE("predictor_history_max_accesses", max_history_accesses_);
+  STAT_INC_SAFE("predictor_history_vcs", vc_pool_.Size());
+  STAT_INC_SAFE("predictor_history_dropped", num_history_dropped_);
 }
 
 void Predictor::ImageLoad(Image *image, address_t low_addr,
@@ -475,74 +490,74 @@ void Predictor::AfterValloc(thread_id_t curr_thd_id, timestamp_t curr_thd_clk,
 }
 
 PredictorMemMeta *Predictor::GetMemMeta(address_t iaddr) {
-  MetaMap::iterator it = meta_map_.find(iaddr);
-  if (it == meta_map_.end()) {
+  PredictorMeta *exist_meta = meta_map_.Find(iaddr);
+  if (!exist_meta) {
     PredictorMemMeta *meta = new PredictorMemMeta(iaddr);
-    meta_map_[iaddr] = meta;
+    meta_map_.Insert(iaddr, meta);
     return meta;
   } else {
     // check the type of the existing meta for this address
-    PredictorMemMeta *meta = dynamic_cast<PredictorMemMeta *>(it->second);
+    PredictorMemMeta *meta = dynamic_cast<PredictorMemMeta *>(exist_meta);
     return meta; // could be NULL
   }
 }
 
 PredictorMutexMeta *Predictor::GetMutexMeta(address_t iaddr) {
-  MetaMap::iterator it = meta_map_.find(iaddr);
-  if (it == meta_map_.end()) {
+  PredictorMeta *exist_meta = meta_map_.Find(iaddr);
+  if (!exist_meta) {
     PredictorMutexMeta *meta = new PredictorMutexMeta(iaddr);
-    meta_map_[iaddr] = meta;
+    meta_map_.Insert(iaddr, meta);
     return meta;
   } else {
     // check the type of the existing meta for this address
-    PredictorMutexMeta *meta = dynamic_cast<PredictorMutexMeta *>(it->second);
+    PredictorMutexMeta *meta = dynamic_cast<PredictorMutexMeta *>(exist_meta);
     if (meta) {
       return meta;
     } else {
-      delete it->second;
+      DeleteMeta(exist_meta);
       meta = new PredictorMutexMeta(iaddr);
-      it->second = meta;
+      meta_map_.Insert(iaddr, meta);
       return meta;
     }
   }
 }
 
 PredictorCondMeta *Predictor::GetCondMeta(address_t iaddr) {
-  MetaMap::iterator it = meta_map_.find(iaddr);
-  if (it == meta_map_.end()) {
+  PredictorMeta *exist_meta = meta_map_.Find(iaddr);
+  if (!exist_meta) {
     PredictorCondMeta *meta = new PredictorCondMeta(iaddr);
-    meta_map_[iaddr] = meta;
+    meta_map_.Insert(iaddr, meta);
     return meta;
   } else {
     // check the type of the existing meta for this address
-    PredictorCondMeta *meta = dynamic_cast<PredictorCondMeta *>(it->second);
+    PredictorCondMeta *meta = dynamic_cast<PredictorCondMeta *>(exist_meta);
     if (meta) {
       return meta;
     } else {
-      delete it->second;
+      DeleteMeta(exist_meta);
       meta = new PredictorCondMeta(iaddr);
-      it->second = meta;
+      meta_map_.Insert(iaddr, meta);
       return meta;
     }
   }
 }
 
 PredictorBarrierMeta *Predictor::GetBarrierMeta(address_t iaddr) {
-  MetaMap::iterator it = meta_map_.find(iaddr);
-  if (it == meta_map_.end()) {
+  PredictorMeta *exist_meta = meta_map_.Find(iaddr);
+  if (!exist_meta) {
     PredictorBarrierMeta *meta = new PredictorBarrierMeta(iaddr);
-    meta_map_[iaddr] = meta;
+    meta_map_.Insert(iaddr, meta);
     return meta;
   } else {
     // check the type of the existing meta for this address
     PredictorBarrierMeta *meta =
-        dynamic_cast<PredictorBarrierMeta *>(it->second);
+        dynamic_cast<PredictorBarrierMeta *>(exist_meta);
     if (meta) {
       return meta;
     } else {
-      delete it->second;
+      DeleteMeta(exist_meta);
       meta = new PredictorBarrierMeta(iaddr);
-      it->second = meta;
+      meta_map_.Insert(iaddr, meta);
       return meta;
     }
   }
@@ -561,13 +576,12 @@ void Predictor::FreeAddrRegion(address_t addr) {
   size_t size = filter_->RemoveRegion(addr, false);
   address_t start_addr = UNIT_DOWN_ALIGN(addr, unit_size_);
   address_t end_addr = UNIT_UP_ALIGN(addr + size, unit_size_);
-  for (address_t iaddr = start_addr; iaddr < end_addr; iaddr += unit_size_) {
-    MetaMap::iterator it = meta_map_.find(iaddr);
-    if (it != meta_map_.end()) {
-      UpdateOnFree(it->second);
-      delete it->second;
-      meta_map_.erase(it);
-    }
+  std::vector<PredictorMeta *> meta_vec;
+  meta_map_.RemoveRange(start_addr, end_addr, &meta_vec);
+  for (std::vector<PredictorMeta *>::iterator it = meta_vec.begin();
+       it != meta_vec.end(); ++it) {
+    UpdateOnFree(*it);
+    DeleteMeta(*it);
   }
 }
 
@@ -691,15 +705,18 @@ bool Predictor::ValidPair(iRootEventType prev_type, iRootEventType curr_type) {
 }
 
 void Predictor::UpdateOnThreadExit(thread_id_t thd_id) {
-  for (MetaMap::iterator it = meta_map_.begin(); it != meta_map_.end(); ++it) {
+  std::vector<PredictorMeta *> meta_vec;
+  meta_map_.GetValues(&meta_vec);
+  for (std::vector<PredictorMeta *>::iterator it = meta_vec.begin();
+       it != meta_vec.end(); ++it) {
     PredictorMemMeta *mem_meta
-        = dynamic_cast<PredictorMemMeta *>(it->second);
+        = dynamic_cast<PredictorMemMeta *>(*it);
     if (mem_meta) {
       UpdateOnThreadExit(thd_id, mem_meta);
     }
 
     PredictorMutexMeta *mutex_meta
-        = dynamic_cast<PredictorMutexMeta *>(it->second);
+        = dynamic_cast<PredictorMutexMeta *>(*it);
     if (mutex_meta) {
       UpdateOnThreadExit(thd_id, mutex_meta);
     }
@@ -718,13 +735,21 @@ void Predictor::UpdateOnFree(PredictorMeta *meta) {
   }
 }
 
+void Predictor::DeleteMeta(PredictorMeta *meta) {
+  PredictorMemMeta *mem_meta = dynamic_cast<PredictorMemMeta *>(meta);
+  if (mem_meta) {
+    ClearMemHistory(mem_meta);
+  }
+  delete meta;
+}
+
 bool Predictor::CheckShared(thread_id_t curr_thd_id, Inst *inst,
                             PredictorMemMeta *meta) {
   if (meta->shared_)
     return true;
 
   if (sinst_db_->Shared(inst)) {
-    meta->history_ = new PredictorMemMeta::AccessHistory;
+    NewMemHistory(meta);
     meta->shared_ = true;
     return true;
   }
@@ -737,7 +762,7 @@ bool Predictor::CheckShared(thread_id_t curr_thd_id, Inst *inst,
   if (meta->last_access_thd_id_ == curr_thd_id)
     return false;
 
-  meta->history_ = new PredictorMemMeta::AccessHistory;
+  NewMemHistory(meta);
   meta->shared_ = true;
   return true;
 }
@@ -796,7 +821,7 @@ void Predictor::UpdateForRead(thread_id_t curr_thd_id,
       // iterate each vector clock value
       for (PredictorMemMeta::PerThreadAccesses::reverse_iterator lit =
               accesses.rbegin(); lit != accesses.rend(); ++lit) {
-        VectorClock &vc = lit->first;
+        VectorClock &vc = *lit->first;
         PredictorMemMeta::AccessVec &access_vec = lit->second;
 
         if (vc.HappensAfter(curr_vc)) {
@@ -966,7 +991,7 @@ void Predictor::UpdateForWrite(thread_id_t curr_thd_id,
       // iterate each vector clock value
       for (PredictorMemMeta::PerThreadAccesses::reverse_iterator lit =
               accesses.rbegin(); lit != accesses.rend(); ++lit) {
-        VectorClock &vc = lit->first;
+        VectorClock &vc = *lit->first;
         PredictorMemMeta::AccessVec &access_vec = lit->second;
 
         if (vc.HappensAfter(curr_vc)) {
@@ -1154,7 +1179,7 @@ void Predictor::FindSuccForRead(thread_id_t curr_thd_id,
     // iterate all the accesses in this thread
     for (PredictorMemMeta::PerThreadAccesses::iterator lit =
             accesses.begin(); lit != accesses.end(); ++lit) {
-      VectorClock &vc = lit->first;
+      VectorClock &vc = *lit->first;
       PredictorMemMeta::AccessVec &access_vec = lit->second;
 
       if (vc.HappensBefore(curr_reader_vc)) {
@@ -1292,7 +1317,7 @@ void Predictor::FindSuccForWrite(thread_id_t curr_thd_id,
     // iterate all the accesses in this thread
     for (PredictorMemMeta::PerThreadAccesses::iterator lit = accesses.begin();
          lit != accesses.end(); ++lit) {
-      VectorClock &vc = lit->first;
+      VectorClock &vc = *lit->first;
       PredictorMemMeta::AccessVec &access_vec = lit->second;
 
       if (vc.HappensBefore(curr_writer_vc)) {
@@ -1400,34 +1425,27 @@ void Predictor::UpdateMemAccess(thread_id_t thd_id, VectorClock *vc,
   PredictorMemMeta::AccessMap &access_map = meta->history_->access_map;
   PredictorMemMeta::PerThreadAccesses &per_thd_accesses = access_map[thd_id];
 
-  if (per_thd_accesses.empty()) {
-    PredictorMemMeta::AccessVec access_vec;
-    access_vec.push_back(*access);
-    per_thd_accesses.push_back(
-        PredictorMemMeta::TimedAccessVec(*vc, access_vec));
-    meta->history_->last_gc_vec_size[thd_id] = 0;
+  if (!per_thd_accesses.empty() &&
+      per_thd_accesses.back().first->Equal(vc)) {
+    // no need to create a new vector clock value
+    AddMemAccess(&per_thd_accesses.back().second, access);
   } else {
-    // obtain the last vector clock and the associated access vector
-    VectorClock &last_vc = per_thd_accesses.back().first;
-    PredictorMemMeta::AccessVec &last_access_vec
-        = per_thd_accesses.back().second;
-    if (last_vc.Equal(vc)) {
-      // no need to create a new vector clock value
-      last_access_vec.push_back(*access);
-      // selectively compress the last_access_vec depending on gc status
-      CheckCompress(thd_id, &last_access_vec, meta);
-    } else {
-      DEBUG_ASSERT(last_vc.HappensBefore(vc));
-      // compress last_access_vec
-      Compress(&last_access_vec, meta);
-      // create a new access_vec
-      PredictorMemMeta::AccessVec access_vec;
-      access_vec.push_back(*access);
-      per_thd_accesses.push_back(
-          PredictorMemMeta::TimedAccessVec(*vc, access_vec));
-      meta->history_->last_gc_vec_size[thd_id] = 0;
-      CheckGC(meta);
-    }
+    DEBUG_ASSERT(per_thd_accesses.empty() ||
+                 per_thd_accesses.back().first->HappensBefore(vc));
+    // create a new access_vec
+    per_thd_accesses.push_back(
+        PredictorMemMeta::TimedAccessVec(vc_pool_.Get(vc),
+                                         PredictorMemMeta::AccessVec()));
+    num_history_segments_++;
+    AddMemAccess(&per_thd_accesses.back().second, access);
+    CheckGC(meta);
+  }
+
+  // enforce the memory budget
+  if (history_bytes_) {
+    TouchMemHistory(meta);
+    if (HistoryBytes() > history_bytes_)
+      EvictMemHistory(meta);
   }
 }
 
@@ -1439,7 +1457,7 @@ VectorClock *Predictor::FindLastVC(thread_id_t thd_id, PredictorMemMeta *meta) {
   if (accesses.empty()) {
     return NULL;
   } else {
-    return &accesses.back().first;
+    return accesses.back().first;
   }
 }
 
@@ -1457,30 +1475,58 @@ PredictorMemAccess *Predictor::FindLastAccess(thread_id_t thd_id,
   }
 }
 
-bool Predictor::CheckGC(PredictorMemMeta *meta) {
-  DEBUG_ASSERT(meta->history_);
+void Predictor::AddMemAccess(PredictorMemMeta::AccessVec *access_vec,
+                             PredictorMemAccess *access) {
+  // only the last one of the accesses with the same type, inst and lock
+  // set is kept, thus the access vector never needs to be compressed
+  for (PredictorMemMeta::AccessVec::iterator vit = access_vec->begin();
+       vit != access_vec->end(); ++vit) {
+    if (vit->type_ == access->type_ &&
+        vit->inst_ == access->inst_ &&
+        vit->ls_.Match(&access->ls_)) {
+      access_vec->erase(vit);
+      num_history_accesses_--;
+      break;
+    }
+  }
+  access_vec->push_back(*access);
+  num_history_accesses_++;
+  max_history_accesses_ = MAX(max_history_accesses_, num_history_accesses_);
+}
+
+void Predictor::EraseMemAccesses(
+    PredictorMemMeta::PerThreadAccesses *accesses,
+    PredictorMemMeta::PerThreadAccesses::iterator first,
+    PredictorMemMeta::PerThreadAccesses::iterator last) {
+  for (PredictorMemMeta::PerThreadAccesses::iterator it = first;
+       it != last; ++it) {
+    num_history_accesses_ -= it->second.size();
+    num_history_segments_--;
+    vc_pool_.Put(it->first);
+  }
+  accesses->erase(first, last);
+}
 
-  GC(meta);
+void Predictor::ClearMemHistory(PredictorMemMeta *meta) {
+  if (!meta->history_)
+    return;
 
-  return true;
+  PredictorMemMeta::AccessMap &access_map = meta->history_->access_map;
+  for (PredictorMemMeta::AccessMap::iterator mit = access_map.begin();
+       mit != access_map.end(); ++mit) {
+    EraseMemAccesses(&mit->second, mit->second.begin(), mit->second.end());
+  }
+  if (meta->history_->in_lru)
+    history_lru_.erase(meta->history_->lru_it);
+  delete meta->history_;
+  meta->history_ = NULL;
 }
 
-bool Predictor::CheckCompress(thread_id_t thd_id,
-                              PredictorMemMeta::AccessVec *access_vec,
-                              PredictorMemMeta *meta) {
+bool Predictor::CheckGC(PredictorMemMeta *meta) {
   DEBUG_ASSERT(meta->history_);
 
-  size_t last_gc_size = meta->history_->last_gc_vec_size[thd_id];
-  size_t curr_size = access_vec->size();
-
-  if (curr_size < last_gc_size)
-    return false;
-
-  if (curr_size - last_gc_size < 70)
-    return false;
+  GC(meta);
 
-  Compress(access_vec, meta);
-  meta->history_->last_gc_vec_size[thd_id] = access_vec->size();
   return true;
 }
 
@@ -1491,106 +1537,104 @@ void Predictor::GC(PredictorMemMeta *meta) {
 
   PredictorMemMeta::AccessMap &access_map = meta->history_->access_map;
 
-  std::map<thread_id_t, VectorClock *> last_access_vc_table;
-  for (PredictorMemMeta::AccessMap::iterator mit = access_map.begin();
-       mit != access_map.end(); ++mit) {
-    thread_id_t thd_id = mit->first;
-
-    VectorClock *last_vc = FindLastVC(thd_id, meta);
-    if (last_vc) {
-      last_access_vc_table[thd_id] = last_vc;
+  // an access can be collected if its vector clock happens before the
+  // current vector clocks of all the live threads and the vector clocks
+  // of their last accesses to this location, that is, if it happens
+  // before the minimum of these vector clocks
+  VectorClock min_vc;
+  bool has_live_thd = false;
+  for (std::map<thread_id_t, VectorClock *>::iterator vcit =
+          curr_vc_map_.begin(); vcit != curr_vc_map_.end(); ++vcit) {
+    if (!has_live_thd) {
+      min_vc = *vcit->second;
+      has_live_thd = true;
+    } else {
+      min_vc.Meet(vcit->second);
     }
+
+    PredictorMemMeta::AccessMap::iterator mit = access_map.find(vcit->first);
+    if (mit != access_map.end() && !mit->second.empty())
+      min_vc.Meet(mit->second.back().first);
   }
 
   // iterate each thread access history
   for (PredictorMemMeta::AccessMap::iterator mit = access_map.begin();
        mit != access_map.end(); ++mit) {
-    thread_id_t thd_id = mit->first;
     PredictorMemMeta::PerThreadAccesses &accesses = mit->second;
 
-    // reverse iterate each vector clock value
+    // reverse iterate each vector clock value, find the last one that can
+    // be collected (the accesses before it are not needed any more)
     PredictorMemMeta::PerThreadAccesses::iterator lit;
     for (lit = accesses.end(); lit != accesses.begin(); ) {
       --lit;
 
-      VectorClock &vc = lit->first;
-
-      // check whether vc is earlier than all curr_vc && last_access_vc
-      // if yes, clear the remaining access vectors
-      bool collect = true;
-      for (std::map<thread_id_t, VectorClock *>::iterator vcit =
-              curr_vc_map_.begin(); vcit != curr_vc_map_.end(); ++vcit) {
-        // skip the same thread
-        if (vcit->first == thd_id)
-          continue;
-
-        if (!vc.HappensBefore(vcit->second)) {
-          collect = false;
-          break;
-        }
-
-        std::map<thread_id_t, VectorClock *>::iterator luit =
-            last_access_vc_table.find(vcit->first);
-        if (luit != last_access_vc_table.end()) {
-          if (!vc.HappensBefore(luit->second)) {
-            collect = false;
-            break;
-          }
-        }
-      }
-
-      if (collect) {
+      if (!has_live_thd || lit->first->HappensBefore(&min_vc))
         break;
-      }
     }
 
     // delete [begin(), lit)
-    for (PredictorMemMeta::PerThreadAccesses::iterator it = lit;
-         it != accesses.begin(); ) {
-      --it;
-      //DEBUG_FMT_PRINT_SAFE("<GC> %lu mem accesses in T%lx are collected\n",
-      //                     (*it).second.size(), thd_id);
-    }
-
-    accesses.erase(accesses.begin(), lit);
+    EraseMemAccesses(&accesses, accesses.begin(), lit);
   } // end for each thread
 }
 
-void Predictor::Compress(PredictorMemMeta::AccessVec *access_vec,
-                         PredictorMemMeta *meta) {
-  DEBUG_ASSERT(meta->history_);
+size_t Predictor::HistoryBytes() {
+  // an estimation, the lock sets of the accesses are not counted
+  return num_history_accesses_ * sizeof(PredictorMemAccess) +
+         num_history_segments_ * (sizeof(PredictorMemMeta::TimedAccessVec) +
+                                  2 * sizeof(void *)) +
+         vc_pool_.Bytes();
+}
 
-  // resultant list
-  std::list<PredictorMemAccess> results;
-
-  // reverse iterate access_vec
-  for (PredictorMemMeta::AccessVec::reverse_iterator vit =
-          access_vec->rbegin(); vit != access_vec->rend(); ++vit) {
-    PredictorMemAccess &access = *vit;
-
-    // iterate the results to find duplicates
-    bool duplicate = false;
-    for (std::list<PredictorMemAccess>::iterator it = results.begin();
-         it != results.end(); ++it) {
-      if (it->type_ == access.type_ &&
-          it->inst_ == access.inst_ &&
-          it->ls_.Match(&access.ls_)) {
-        // duplicate
-        duplicate = true;
-        break;
-      }
-    }
+void Predictor::NewMemHistory(PredictorMemMeta *meta) {
+  meta->history_ = new PredictorMemMeta::AccessHistory;
+  meta->history_->in_lru = false;
+}
 
-    if (!duplicate) {
-      results.push_front(access);
+void Predictor::TouchMemHistory(PredictorMemMeta *meta) {
+  PredictorMemMeta::AccessHistory *history = meta->history_;
+  if (history->in_lru) {
+    history_lru_.splice(history_lru_.begin(), history_lru_, history->lru_it);
+  } else {
+    history_lru_.push_front(meta);
+    history->lru_it = history_lru_.begin();
+    history->in_lru = true;
+  }
+}
+
+void Predictor::EvictMemHistory(PredictorMemMeta *meta) {
+  // the budget covers the access histories of all the locations. first,
+  // evict the oldest vector clock values of the growing location. the
+  // last one of each thread is kept because it is needed to order new
+  // accesses. then, evict the whole histories of the least recently
+  // accessed locations. thus the budget is only exceeded by the last
+  // accesses of the growing location. the evicted accesses may still be
+  // needed by live threads, thus some predictions can be lost (counted
+  // in predictor_history_dropped)
+  PredictorMemMeta::AccessMap &access_map = meta->history_->access_map;
+  for (PredictorMemMeta::AccessMap::iterator mit = access_map.begin();
+       mit != access_map.end(); ++mit) {
+    PredictorMemMeta::PerThreadAccesses &accesses = mit->second;
+    while (accesses.size() > 1 && HistoryBytes() > history_bytes_) {
+      num_history_dropped_ += accesses.front().second.size();
+      EraseMemAccesses(&accesses, accesses.begin(), ++accesses.begin());
     }
   }
 
-  // recreate access_vec
-  access_vec->clear();
-  for (std::list<PredictorMemAccess>::iterator it = results.begin();
-       it != results.end(); ++it) {
-    access_vec->push_back(*it);
+  while (HistoryBytes() > history_bytes_ && history_lru_.back() != meta) {
+    PredictorMemMeta *victim = history_lru_.back();
+    PredictorMemMeta::AccessMap &victim_map = victim->history_->access_map;
+    for (PredictorMemMeta::AccessMap::iterator mit = victim_map.begin();
+         mit != victim_map.end(); ++mit) {
+      PredictorMemMeta::PerThreadAccesses &accesses = mit->second;
+      for (PredictorMemMeta::PerThreadAccesses::iterator it =
+              accesses.begin(); it != accesses.end(); ++it) {
+        num_history_dropped_ += it->second.size();
+      }
+      EraseMemAccesses(&accesses, accesses.begin(), accesses.end());
+    }
+    victim_map.clear();
+    victim->history_->in_lru = false;
+    history_lru_.pop_back();
   }
 }
 
@@ -2099,11 +2143,11 @@ void Predictor::UpdateMemo(thread_id_t src_thd_id, PredictorAccess &src_access,
                            thread_id_t dst_thd_id, PredictorAccess &dst_access){
   iRootEvent *e0 = iroot_db_->GetiRootEvent(src_access.inst_,
                                             src_access.type_,
-                                            false);
+                                            true);
   iRootEvent *e1 = iroot_db_->GetiRootEvent(dst_access.inst_,
                                             dst_access.type_,
-                                            false);
-  iRoot *iroot = iroot_db_->GetiRoot(IDIOM_1, false, e0, e1);
+                                            true);
+  iRoot *iroot = iroot_db_->GetiRoot(IDIOM_1, true, e0, e1);
   memo_->Predicted(iroot, false);
   if (CheckAsync(src_thd_id, src_access.clk_) ||
       CheckAsync(dst_thd_id, dst_access.clk_)) {
@@ -2283,17 +2327,17 @@ void Predictor::UpdateComplexiRoots() {
             if (sr.start <= pr.end) {
               iRootEvent *e0 = iroot_db_->GetiRootEvent(prev_event.inst,
                                                         prev_event.type,
-                                                        false);
+                                                        true);
               iRootEvent *e1 = iroot_db_->GetiRootEvent(se.inst,
                                                         se.type,
-                                                        false);
+                                                        true);
               iRootEvent *e2 = iroot_db_->GetiRootEvent(pe.inst,
                                                         pe.type,
-                                                        false);
+                                                        true);
               iRootEvent *e3 = iroot_db_->GetiRootEvent(curr_event.inst,
                                                         curr_event.type,
-                                                        false);
-              iRoot *iroot = iroot_db_->GetiRoot(IDIOM_3,false, e0, e1, e2, e3);
+                                                        true);
+              iRoot *iroot = iroot_db_->GetiRoot(IDIOM_3,true, e0, e1, e2, e3);
               memo_->Predicted(iroot, false);
               if (curr_async ||
                   CheckAsync(se.thd_id, sr.end) ||
@@ -2317,14 +2361,14 @@ void Predictor::UpdateComplexiRoots() {
         if (idiom2_exists) {
           iRootEvent *e0 = iroot_db_->GetiRootEvent(prev_event.inst,
                                                     prev_event.type,
-                                                    false);
+                                                    true);
           iRootEvent *e1 = iroot_db_->GetiRootEvent(se.inst,
                                                     se.type,
-                                                    false);
+                                                    true);
           iRootEvent *e2 = iroot_db_->GetiRootEvent(curr_event.inst,
                                                     curr_event.type,
-                                                    false);
-          iRoot *iroot = iroot_db_->GetiRoot(IDIOM_2, false, e0, e1, e2);
+                                                    true);
+          iRoot *iroot = iroot_db_->GetiRoot(IDIOM_2, true, e0, e1, e2);
           memo_->Predicted(iroot, false);
           if (curr_async || CheckAsync(se.thd_id, sr.end)) {
             memo_->SetAsync(iroot, false);
@@ -2348,17 +2392,17 @@ void Predictor::UpdateComplexiRoots() {
             if (sr.start <= pr.end) {
               iRootEvent *e0 = iroot_db_->GetiRootEvent(prev_event.inst,
                                                         prev_event.type,
-                                                        false);
+                                                        true);
               iRootEvent *e1 = iroot_db_->GetiRootEvent(se.inst,
                                                         se.type,
-                                                        false);
+                                                        true);
               iRootEvent *e2 = iroot_db_->GetiRootEvent(pe.inst,
                                                         pe.type,
-                                                        false);
+                                                        true);
               iRootEvent *e3 = iroot_db_->GetiRootEvent(curr_event.inst,
                                                         curr_event.type,
-                                                        false);
-              iRoot *iroot = iroot_db_->GetiRoot(IDIOM_4,false, e0, e1, e2, e3);
+                                                        true);
+              iRoot *iroot = iroot_db_->GetiRoot(IDIOM_4,true, e0, e1, e2, e3);
               memo_->Predicted(iroot, false);
               if (curr_async ||
                   CheckAsync(se.thd_id, sr.end) ||
@@ -2381,17 +2425,17 @@ void Predictor::UpdateComplexiRoots() {
                   local_info_.pair_db_.end()) {
                 iRootEvent *e0 = iroot_db_->GetiRootEvent(prev_event.inst,
                                                           prev_event.type,
-                                                          false);
+                                                          true);
                 iRootEvent *e1 = iroot_db_->GetiRootEvent(se.inst,
                                                           se.type,
-                                                          false);
+                                                          true);
                 iRootEvent *e2 = iroot_db_->GetiRootEvent(pe.inst,
                                                           pe.type,
-                                                          false);
+                                                          true);
                 iRootEvent *e3 = iroot_db_->GetiRootEvent(curr_event.inst,
                                                           curr_event.type,
-                                                          false);
-                iRoot *iroot = iroot_db_->GetiRoot(IDIOM_5, false, e0,e1,e2,e3);
+                                                          true);
+                iRoot *iroot = iroot_db_->GetiRoot(IDIOM_5, true, e0,e1,e2,e3);
                 memo_->Predicted(iroot, false);
                 if (curr_async ||
                     CheckAsync(se.thd_id, sr.end) ||
@@ -2434,17 +2478,17 @@ void Predictor::UpdateComplexiRoots() {
             outer_prev_addr == inner_curr_addr) {
           iRootEvent *e0 = iroot_db_->GetiRootEvent(outer_prev_inst,
                                                     outer_prev_type,
-                                                    false);
+                                                    true);
           iRootEvent *e1 = iroot_db_->GetiRootEvent(inner_curr_inst,
                                                     inner_curr_type,
-                                                    false);
+                                                    true);
           iRootEvent *e2 = iroot_db_->GetiRootEvent(inner_prev_inst,
                                                     inner_prev_type,
-                                                    false);
+                                                    true);
           iRootEvent *e3 = iroot_db_->GetiRootEvent(outer_curr_inst,
                                                     outer_curr_type,
-                                                    false);
-          iRoot *iroot = iroot_db_->GetiRoot(IDIOM_5, false, e0, e1, e2, e3);
+                                                    true);
+          iRoot *iroot = iroot_db_->GetiRoot(IDIOM_5, true, e0, e1, e2, e3);
           memo_->Predicted(iroot, false);
         }
       }
@@ -2452,5 +2496,49 @@ void Predictor::UpdateComplexiRoots() {
   }
 }
 
-} // namespace idiom
+VectorClock *PredictorVectorClockPool::Get(VectorClock *vc) {
+  size_t hash_val = vc->Hash();
+  std::pair<HashIndex::iterator, HashIndex::iterator> range =
+      index_.equal_range(hash_val);
+  for (HashIndex::iterator it = range.first; it != range.second; ++it) {
+    if (it->second->Equal(vc)) {
+      ref_count_map_[it->second]++;
+      return it->second;
+    }
+  }
+  VectorClock *shared_vc = new VectorClock(*vc);
+  index_.insert(std::make_pair(hash_val, shared_vc));
+  ref_count_map_[shared_vc] = 1;
+  bytes_ += VectorClockBytes(shared_vc);
+  return shared_vc;
+}
+
+void PredictorVectorClockPool::Put(VectorClock *vc) {
+  RefCountMap::iterator rit = ref_count_map_.find(vc);
+  DEBUG_ASSERT(rit != ref_count_map_.end());
+  if (--rit->second)
+    return;
+  ref_count_map_.erase(rit);
+  std::pair<HashIndex::iterator, HashIndex::iterator> range =
+      index_.equal_range(vc->Hash());
+  for (HashIndex::iterator it = range.first; it != range.second; ++it) {
+    if (it->second == vc) {
+      index_.erase(it);
+      break;
+    }
+  }
+  bytes_ -= VectorClockBytes(vc);
+  delete vc;
+}
 
+size_t PredictorVectorClockPool::VectorClockBytes(VectorClock *vc) {
+  // each clock is a node in a std::map (about 4 pointers of overhead)
+  size_t num_clocks = 0;
+  for (vc->IterBegin(); !vc->IterEnd(); vc->IterNext())
+    num_clocks++;
+  return sizeof(VectorClock) +
+         num_clocks * (sizeof(thread_id_t) + sizeof(timestamp_t) +
+                       4 * sizeof(void *));
+}
+
+} // namespace idiom
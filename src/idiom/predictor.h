@@ -33,6 +33,7 @@
 #include "core/vector_clock.h"
 #include "core/lock_set.h"
 #include "core/filter.h"
+#include "core/shadow_map.h"
 #include "idiom/iroot.h"
 #include "idiom/memo.h"
 #include "sinst/sinst.h"
@@ -134,12 +135,14 @@ class PredictorMemMeta : public PredictorMeta {
 
  private:
   typedef std::vector<PredictorMemAccess> AccessVec;
-  typedef std::pair<VectorClock, AccessVec> TimedAccessVec;
+  // the vector clock is shared through the vector clock pool
+  typedef std::pair<VectorClock *, AccessVec> TimedAccessVec;
   typedef std::list<TimedAccessVec> PerThreadAccesses;
   typedef std::map<thread_id_t, PerThreadAccesses> AccessMap;
   typedef struct {
     AccessMap access_map;
-    std::map<thread_id_t, size_t> last_gc_vec_size;
+    bool in_lru; // whether in the lru list of the predictor
+    std::list<PredictorMemMeta *>::iterator lru_it;
   } AccessHistory;
 
   bool shared_;
@@ -214,6 +217,34 @@ class PredictorBarrierMeta : public PredictorMeta {
   DISALLOW_COPY_CONSTRUCTORS(PredictorBarrierMeta);
 };
 
+// Pool of vector clocks. The access histories of all the locations
+// share equal vector clocks (hash consing) instead of copying them.
+class PredictorVectorClockPool {
+ public:
+  PredictorVectorClockPool() : bytes_(0) {}
+  ~PredictorVectorClockPool() {}
+
+  // return the shared copy of vc and increment its reference count
+  VectorClock *Get(VectorClock *vc);
+  // decrement the reference count of a shared vector clock
+  void Put(VectorClock *vc);
+  size_t Size() { return ref_count_map_.size(); }
+  // the estimated memory used by the shared vector clocks
+  size_t Bytes() { return bytes_; }
+
+ private:
+  typedef std::tr1::unordered_multimap<size_t, VectorClock *> HashIndex;
+  typedef std::tr1::unordered_map<VectorClock *, size_t> RefCountMap;
+
+  static size_t VectorClockBytes(VectorClock *vc);
+
+  HashIndex index_;
+  RefCountMap ref_count_map_;
+  size_t bytes_;
+
+  DISALLOW_COPY_CONSTRUCTORS(PredictorVectorClockPool);
+};
+
 // Local information.
 class PredictorLocalInfo {
  public:
@@ -431,7 +462,7 @@ class Predictor : public Analyzer {
                    Inst *inst, size_t size, address_t addr);
 
  private:
-  typedef std::tr1::unordered_map<address_t, PredictorMeta *> MetaMap;
+  typedef ShadowMap<PredictorMeta> MetaMap;
 
   PredictorMemMeta *GetMemMeta(address_t iaddr);
   PredictorMutexMeta *GetMutexMeta(address_t iaddr);
@@ -451,6 +482,7 @@ class Predictor : public Analyzer {
   bool ValidPair(iRootEventType prev_type, iRootEventType curr_type);
   void UpdateOnThreadExit(thread_id_t thd_id);
   void UpdateOnFree(PredictorMeta *meta);
+  void DeleteMeta(PredictorMeta *meta);
 
   // for memory access meta
   bool CheckShared(thread_id_t curr_thd_id, Inst *inst, PredictorMemMeta *meta);
@@ -474,13 +506,18 @@ class Predictor : public Analyzer {
                        PredictorMemAccess *access, PredictorMemMeta *meta);
   VectorClock *FindLastVC(thread_id_t thd_id, PredictorMemMeta *meta);
   PredictorMemAccess *FindLastAccess(thread_id_t thd_id,PredictorMemMeta *meta);
+  void AddMemAccess(PredictorMemMeta::AccessVec *access_vec,
+                    PredictorMemAccess *access);
+  void EraseMemAccesses(PredictorMemMeta::PerThreadAccesses *accesses,
+                        PredictorMemMeta::PerThreadAccesses::iterator first,
+                        PredictorMemMeta::PerThreadAccesses::iterator last);
+  void ClearMemHistory(PredictorMemMeta *meta);
   bool CheckGC(PredictorMemMeta *meta);
-  bool CheckCompress(thread_id_t thd_id,
-                     PredictorMemMeta::AccessVec *access_vec,
-                     PredictorMemMeta *meta);
   void GC(PredictorMemMeta *meta);
-  void Compress(PredictorMemMeta::AccessVec *access_vec,
-                PredictorMemMeta *meta);
+  size_t HistoryBytes();
+  void NewMemHistory(PredictorMemMeta *meta);
+  void TouchMemHistory(PredictorMemMeta *meta);
+  void EvictMemHistory(PredictorMemMeta *meta);
 
   // for mutex meta
   void UpdateForLock(thread_id_t curr_thd_id, timestamp_t curr_thd_clk,
@@ -531,6 +568,13 @@ class Predictor : public Analyzer {
   timestamp_t vw_; // vulnerability window
   bool racy_only_; // whether ignore non racy mem and mutex dependencies
   bool predict_deadlock_; // whether predict deadlock
+  size_t history_bytes_; // the memory budget of the access histories
+  size_t num_history_accesses_; // the number of accesses in the histories
+  size_t max_history_accesses_;
+  size_t num_history_segments_; // the number of vector clock values
+  size_t num_history_dropped_; // the accesses evicted for the budget
+  // the locations with access histories, most recently accessed first
+  std::list<PredictorMemMeta *> history_lru_;
   RegionFilter *filter_;
   std::map<thread_id_t, VectorClock *> curr_vc_map_;
   std::map<thread_id_t, LockSet *> curr_ls_map_;
@@ -540,6 +584,7 @@ class Predictor : public Analyzer {
   std::map<thread_id_t, timestamp_t> async_start_time_map_;
   std::map<address_t, size_t> addr_region_map_;
   MetaMap meta_map_;
+  PredictorVectorClockPool vc_pool_;
   PredictorLocalInfo local_info_;
   PredictorDeadlockInfo deadlock_info_;
 
@@ -46,6 +46,9 @@ PredictorNew::PredictorNew()
       predict_deadlock_(false),
       unit_size_(4),
       vw_(1000),
+      partition_size_(0),
+      num_partitions_(1),
+      partition_id_(0),
       filter_(NULL) {
   // empty
 }
@@ -106,6 +109,19 @@ void PredictorNew::Setup(Mutex *lock,
   desc_.SetTrackInstCount();
 }
 
+void PredictorNew::SetPartition(address_t partition_size,
+                                int num_partitions,
+                                int partition_id) {
+  // the partition size should be a power of 2 no smaller than the
+  // unit size so that a partition never splits a monitoring unit
+  DEBUG_ASSERT(partition_size >= unit_size_);
+  DEBUG_ASSERT(UNIT_DOWN_ALIGN(partition_size, unit_size_) == partition_size);
+  DEBUG_ASSERT(partition_id >= 0 && partition_id < num_partitions);
+  partition_size_ = partition_size;
+  num_partitions_ = num_partitions;
+  partition_id_ = partition_id;
+}
+
 void PredictorNew::ProgramExit() {
   // process free for all the remaining meta (user forgot to call free)
   for (Meta::Table::iterator it = meta_table_.begin();
@@ -226,6 +242,9 @@ void PredictorNew::BeforeMemRead(thread_id_t curr_thd_id,
   address_t start_addr = UNIT_DOWN_ALIGN(addr, unit_size_);
   address_t end_addr = UNIT_UP_ALIGN(addr + size, unit_size_);
   for (address_t iaddr = start_addr; iaddr < end_addr; iaddr += unit_size_) {
+    // skip the addresses owned by other predictors
+    if (!Owned(iaddr))
+      continue;
     // whether this access to iaddr is a shared access
     bool shared_access = false;
     // check shared for iaddr
@@ -292,6 +311,9 @@ void PredictorNew::BeforeMemWrite(thread_id_t curr_thd_id,
   address_t start_addr = UNIT_DOWN_ALIGN(addr, unit_size_);
   address_t end_addr = UNIT_UP_ALIGN(addr + size, unit_size_);
   for (address_t iaddr = start_addr; iaddr < end_addr; iaddr += unit_size_) {
+    // skip the addresses owned by other predictors
+    if (!Owned(iaddr))
+      continue;
     // whether this access to iaddr is a shared access
     bool shared_access = false;
     // check shared for iaddr
@@ -391,10 +413,12 @@ void PredictorNew::AfterPthreadMutexLock(thread_id_t curr_thd_id,
                                          address_t addr) {
   ScopedLock locker(internal_lock_);
   DEBUG_ASSERT(UNIT_DOWN_ALIGN(addr, unit_size_) == addr);
-  Meta *meta = GetMutexMeta(addr);
-  DEBUG_ASSERT(meta);
-  ProcessiRootEvent(curr_thd_id, curr_thd_clk,
-                    IROOT_EVENT_MUTEX_LOCK, inst, meta);
+  if (Owned(addr)) {
+    Meta *meta = GetMutexMeta(addr);
+    DEBUG_ASSERT(meta);
+    ProcessiRootEvent(curr_thd_id, curr_thd_clk,
+                      IROOT_EVENT_MUTEX_LOCK, inst, meta);
+  }
   LockSet *curr_ls = curr_ls_map_[curr_thd_id];
   DEBUG_ASSERT(curr_ls);
   curr_ls->Add(addr);
@@ -406,13 +430,15 @@ void PredictorNew::BeforePthreadMutexUnlock(thread_id_t curr_thd_id,
                                             address_t addr) {
   ScopedLock locker(internal_lock_);
   DEBUG_ASSERT(UNIT_DOWN_ALIGN(addr, unit_size_) == addr);
-  Meta *meta = GetMutexMeta(addr);
-  DEBUG_ASSERT(meta);
   LockSet *curr_ls = curr_ls_map_[curr_thd_id];
   DEBUG_ASSERT(curr_ls);
   curr_ls->Remove(addr);
-  ProcessiRootEvent(curr_thd_id, curr_thd_clk,
-                    IROOT_EVENT_MUTEX_UNLOCK, inst, meta);
+  if (Owned(addr)) {
+    Meta *meta = GetMutexMeta(addr);
+    DEBUG_ASSERT(meta);
+    ProcessiRootEvent(curr_thd_id, curr_thd_clk,
+                      IROOT_EVENT_MUTEX_UNLOCK, inst, meta);
+  }
 }
 
 void PredictorNew::BeforePthreadCondSignal(thread_id_t curr_thd_id,
@@ -732,7 +758,7 @@ void PredictorNew::AddAccSumPair(AccSum *src, AccSum *dst) {
   // add src->dst (precondition: no duplication)
   acc_sum_succ_index_[src].push_back(dst);
   acc_sum_pred_index_[dst].push_back(src);
-  DEBUG_STAT_INC("pd_acc_sum_deps", 1);
+  DEBUG_STAT_INC_SAFE("pd_acc_sum_deps", 1);
 }
 
 PredictorNew::AccSum *PredictorNew::MatchAccSum(DynAcc *dyn_acc) {
@@ -946,12 +972,12 @@ void PredictorNew::PredictiRoot() {
          vit != iit->second.end(); ++vit) {
       AccSum *dst = *vit;
       // predict iroot according to src->dst
-      iRootEvent *e0 = iroot_db_->GetiRootEvent(src->inst, src->type, false);
-      iRootEvent *e1 = iroot_db_->GetiRootEvent(dst->inst, dst->type, false);
-      iRoot *iroot = iroot_db_->GetiRoot(IDIOM_1, false, e0, e1);
-      memo_->Predicted(iroot, false);
+      iRootEvent *e0 = iroot_db_->GetiRootEvent(src->inst, src->type, true);
+      iRootEvent *e1 = iroot_db_->GetiRootEvent(dst->inst, dst->type, true);
+      iRoot *iroot = iroot_db_->GetiRoot(IDIOM_1, true, e0, e1);
+      memo_->Predicted(iroot, true);
       if (CheckAsync(src) || CheckAsync(dst)) {
-        memo_->SetAsync(iroot, false);
+        memo_->SetAsync(iroot, true);
       }
     }
   }
@@ -974,14 +1000,14 @@ PredictorNew::AccSum *PredictorNew::ProcessAccSumUpdate(DynAcc *dyn_acc) {
       // no need to do a full search
       AddThdClk(&tinfo_entry.second, dyn_acc->thd_clk);
       skip_search = true;
-      DEBUG_STAT_INC("pd_acc_sum_hit", 1);
+      DEBUG_STAT_INC_SAFE("pd_acc_sum_hit", 1);
     } else {
       // add a new tinfo entry
       ThdClkInfo thd_clk_info(dyn_acc->thd_clk);
       curr_acc_sum->tinfo.push_back(
           AccSum::TimeInfoEntry(dyn_acc->vc, thd_clk_info));
-      DEBUG_STAT_INC("pd_new_vc", 1);
-      DEBUG_STAT_MAX("pd_max_vc", curr_acc_sum->tinfo.size());
+      DEBUG_STAT_INC_SAFE("pd_new_vc", 1);
+      DEBUG_STAT_MAX_SAFE("pd_max_vc", curr_acc_sum->tinfo.size());
     }
   } else {
     // create a new access summary and update hash index
@@ -996,9 +1022,9 @@ PredictorNew::AccSum *PredictorNew::ProcessAccSumUpdate(DynAcc *dyn_acc) {
         AccSum::TimeInfoEntry(dyn_acc->vc, thd_clk_info));
     acc_histo->acc_sum_table[dyn_acc->thd_id].push_back(curr_acc_sum);
     acc_sum_hash_index_[Hash(curr_acc_sum)].push_back(curr_acc_sum);
-    DEBUG_STAT_INC("pd_acc_sum_new", 1);
-    DEBUG_STAT_MAX("pd_max_acc_sum",
-                   acc_histo->acc_sum_table[dyn_acc->thd_id].size());
+    DEBUG_STAT_INC_SAFE("pd_acc_sum_new", 1);
+    DEBUG_STAT_MAX_SAFE("pd_max_acc_sum",
+                        acc_histo->acc_sum_table[dyn_acc->thd_id].size());
   } // end of else (curr_acc_sum)
 
   // do a full search against all access summaries in other threads
@@ -1072,7 +1098,7 @@ void PredictorNew::ProcessAccSumPairUpdate(Meta *meta) {
   // before I4 (non-concurrent). However, we need to avoid predicting
   // I1->I4. Also, we need to avoid predicting I2->I5.
 
-  DEBUG_STAT_INC("pd_non_concur_upd", 1);
+  DEBUG_STAT_INC_SAFE("pd_non_concur_upd", 1);
   typedef std::pair<VectorClock *, AccSum::Pair> TimedEntry;
   typedef std::vector<TimedEntry> TimedEntryVec;
   typedef std::map<thread_id_t, TimedEntryVec> TimedEntryTable;
@@ -1444,7 +1470,7 @@ iRoot *PredictorNew::Predict(IdiomType idiom, ...) {
   va_start(vl, idiom);
   for (int i = 0; i < num_args; i++) {
     AccSum *a = va_arg(vl, AccSum *);
-    iRootEvent *e = iroot_db_->GetiRootEvent(a->inst, a->type, false);
+    iRootEvent *e = iroot_db_->GetiRootEvent(a->inst, a->type, true);
     av.push_back(a);
     ev.push_back(e);
   }
@@ -1454,29 +1480,29 @@ iRoot *PredictorNew::Predict(IdiomType idiom, ...) {
   iRoot *iroot = NULL;
   switch (idiom) {
     case IDIOM_1:
-      iroot = iroot_db_->GetiRoot(idiom, false, ev[0], ev[1]);
-      memo_->Predicted(iroot, false);
+      iroot = iroot_db_->GetiRoot(idiom, true, ev[0], ev[1]);
+      memo_->Predicted(iroot, true);
       if (CheckAsync(av[0]) || CheckAsync(av[1]))
-        memo_->SetAsync(iroot, false);
+        memo_->SetAsync(iroot, true);
       break;
     case IDIOM_2:
-      iroot = iroot_db_->GetiRoot(idiom, false, ev[0], ev[1], ev[2]);
-      memo_->Predicted(iroot, false);
+      iroot = iroot_db_->GetiRoot(idiom, true, ev[0], ev[1], ev[2]);
+      memo_->Predicted(iroot, true);
       if (CheckAsync(av[2]) || CheckAsync(av[1]))
-        memo_->SetAsync(iroot, false);
+        memo_->SetAsync(iroot, true);
       break;
     case IDIOM_3:
     case IDIOM_4:
-      iroot = iroot_db_->GetiRoot(idiom, false, ev[0], ev[1], ev[2], ev[3]);
-      memo_->Predicted(iroot, false);
+      iroot = iroot_db_->GetiRoot(idiom, true, ev[0], ev[1], ev[2], ev[3]);
+      memo_->Predicted(iroot, true);
       if (CheckAsync(av[3]) || CheckAsync(av[2]))
-        memo_->SetAsync(iroot, false);
+        memo_->SetAsync(iroot, true);
       break;
     case IDIOM_5:
-      iroot = iroot_db_->GetiRoot(idiom, false, ev[0], ev[1], ev[2], ev[3]);
-      memo_->Predicted(iroot, false);
+      iroot = iroot_db_->GetiRoot(idiom, true, ev[0], ev[1], ev[2], ev[3]);
+      memo_->Predicted(iroot, true);
       if (CheckAsync(av[3]) || CheckAsync(av[1]))
-        memo_->SetAsync(iroot, false);
+        memo_->SetAsync(iroot, true);
       break;
     default:
       assert(0);
@@ -1730,7 +1756,7 @@ void PredictorNew::ProcessiRootEvent(thread_id_t curr_thd_id,
                                      iRootEventType type,
                                      Inst *inst,
                                      Meta *meta) {
-  DEBUG_STAT_INC("pd_iroot_event", 1);
+  DEBUG_STAT_INC_SAFE("pd_iroot_event", 1);
   // obtain the access history of this meta
   AccHisto *acc_histo = meta->acc_histo;
   DEBUG_ASSERT(meta->acc_histo);
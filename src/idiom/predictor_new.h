@@ -43,6 +43,12 @@ class PredictorNew : public Analyzer {
   bool Enabled();
   void Setup(Mutex *lock, StaticInfo *sinfo, iRootDB *iroot_db, Memo *memo,
              sinst::SharedInstDB *sinst_db);
+  void SetPartition(address_t partition_size, int num_partitions,
+                    int partition_id);
+  bool Owned(address_t iaddr) {
+    return num_partitions_ <= 1 ||
+           (int)((iaddr / partition_size_) % num_partitions_) == partition_id_;
+  }
   void ProgramExit();
   void ImageLoad(Image *image, address_t low_addr, address_t high_addr,
                  address_t data_start, size_t data_size, address_t bss_start,
@@ -414,6 +420,12 @@ class PredictorNew : public Analyzer {
   address_t unit_size_;
   timestamp_t vw_;
 
+  // address partition (only the meta data for the owned
+  // partitions are tracked by this predictor)
+  address_t partition_size_;
+  int num_partitions_;
+  int partition_id_;
+
   // meta data
   CondMeta::Table cond_meta_table_;
   BarrierMeta::Table barrier_meta_table_;
@@ -44,6 +44,8 @@ void Scheduler::HandlePreSetup() {
   knob_->RegisterStr("sinst_in", "the input shared inst database path", "sinst.db");
   knob_->RegisterStr("sinst_out", "the output shared inst database path", "sinst.db");
   knob_->RegisterInt("target_idiom", "the target idiom (0 means any idiom)", "0");
+  knob_->RegisterInt("num_targets", "the max number of iroots to test in each run", "1");
+  knob_->RegisterBool("memo_target", "whether update the memo for the iroot given by target_iroot", "0");
 
   sinst_analyzer_ = new sinst::SharedInstAnalyzer;
   sinst_analyzer_->Register();
@@ -121,6 +123,19 @@ bool Scheduler::HandleIgnoreMemAccess(IMG img) {
 void Scheduler::HandleProgramExit() {
   SchedulerCommon::HandleProgramExit();
 
+  // record the time to reach the first event of each iroot, which
+  // is used to estimate the cost of testing the iroot
+  if (UpdateMemo()) {
+    for (size_t i = 0; i < targets_.size(); i++) {
+      SchedTarget *target = targets_[i];
+      if (target->first_event_time() != INVALID_TIMESTAMP)
+        memo_->EventReached(target->iroot(), target->first_event_time(),
+                            true);
+      else
+        memo_->EventUnreached(target->iroot(), true);
+    }
+  }
+
   // save memoization
   memo_->RefineCandidate(knob_->ValueBool("memo_failed"));
   memo_->Save(knob_->ValueStr("memo_out"), sinfo_);
@@ -129,50 +144,68 @@ void Scheduler::HandleProgramExit() {
 }
 
 void Scheduler::Choose() {
-  // set current iroot to test
+  // set the iroots to test
   int target_iroot_id = knob_->ValueInt("target_iroot");
   int target_idiom_int = knob_->ValueInt("target_idiom");
+  int num_targets = knob_->ValueInt("num_targets");
+  if (num_targets < 1)
+    num_targets = 1;
+  std::vector<iRoot *> iroots;
   if (target_iroot_id) {
-    curr_iroot_ = memo_->ChooseForTest((iroot_id_t)target_iroot_id);
+    iroots.push_back(memo_->ChooseForTest((iroot_id_t)target_iroot_id));
   } else {
     if (target_idiom_int) {
-      curr_iroot_ = memo_->ChooseForTest((IdiomType)target_idiom_int);
+      memo_->ChooseForTest((IdiomType)target_idiom_int, num_targets, &iroots);
     } else {
-      curr_iroot_ = memo_->ChooseForTest();
+      memo_->ChooseForTest(num_targets, &iroots);
     }
   }
 
-  if (!curr_iroot_) {
+  if (iroots.empty()) {
     printf("No iRoot to test, exit...\n");
     exit(0);
   }
+
+  for (size_t i = 0; i < iroots.size(); i++)
+    AddTarget(iroots[i]);
 }
 
-void Scheduler::TestSuccess() {
-  SchedulerCommon::TestSuccess();
-  if (!knob_->ValueInt("target_iroot")) {
-    memo_->TestSuccess(curr_iroot_, true);
+void Scheduler::TestSuccess(iRoot *iroot) {
+  SchedulerCommon::TestSuccess(iroot);
+  if (UpdateMemo()) {
+    memo_->TestSuccess(iroot, true);
   }
 }
 
-void Scheduler::TestFail() {
-  SchedulerCommon::TestFail();
-  if (!knob_->ValueInt("target_iroot")) {
-    memo_->TestFail(curr_iroot_, false);
+void Scheduler::TestFail(iRoot *iroot) {
+  SchedulerCommon::TestFail(iroot);
+  if (UpdateMemo()) {
+    memo_->TestFail(iroot, false);
   }
 }
 
 bool Scheduler::UseDecreasingPriorities() {
-  if (knob_->ValueInt("target_iroot")) {
-    return history_->TotalTestRuns(curr_iroot_) % 2 == 0;
+  // the priorities are decided by the first target
+  iRoot *iroot = targets_[0]->iroot();
+  if (UpdateMemo()) {
+    return memo_->TotalTestRuns(iroot, true) % 2 == 0;
   } else {
-    return memo_->TotalTestRuns(curr_iroot_, true) % 2 == 0;
+    return history_->TotalTestRuns(iroot) % 2 == 0;
   }
 }
 
+bool Scheduler::UpdateMemo() {
+  // a given target iroot is tested without touching the memo unless
+  // asked to (the workers of the parallel active test, whose memos are
+  // merged into the shared one and thus carry the shared test runs)
+  if (knob_->ValueInt("target_iroot"))
+    return knob_->ValueBool("memo_target");
+  return true;
+}
+
 bool Scheduler::YieldWithDelay() {
   if (knob_->ValueBool("yield_with_delay")) {
-    if (memo_->Async(curr_iroot_, true)) {
+    if (memo_->Async(CurrTarget()->iroot(), true)) {
       return true;
     }
   }
@@ -47,11 +47,13 @@ class Scheduler : public SchedulerCommon {
 
   // functions to override
   void Choose();
-  void TestSuccess();
-  void TestFail();
+  void TestSuccess(iRoot *iroot);
+  void TestFail(iRoot *iroot);
   bool UseDecreasingPriorities();
   bool YieldWithDelay();
 
+  bool UpdateMemo();
+
   Memo *memo_;
   sinst::SharedInstDB *sinst_db_;
   sinst::SharedInstAnalyzer *sinst_analyzer_;
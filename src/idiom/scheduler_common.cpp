@@ -22,6 +22,7 @@
 #include <errno.h>
 #include <sys/syscall.h>
 #include <sys/resource.h>
+#include <sys/time.h>
 #include <cstdlib>
 
 #include "core/pin_util.hpp"
@@ -56,82 +57,138 @@ static void seed_random_number(unsigned long seed) {
 }
 #endif
 
-Idiom1SchedStatus::Idiom1SchedStatus() {
-  state_ = IDIOM1_STATE_INIT;
-  thd_id_[0] = INVALID_THD_ID;
-  thd_id_[1] = INVALID_THD_ID;
-  addr_[0] = 0;
-  addr_[1] = 0;
-  size_[0] = 0;
-  size_[1] = 0;
-}
-
-Idiom2SchedStatus::Idiom2SchedStatus() {
-  state_ = IDIOM2_STATE_INIT;
-  thd_id_[0] = INVALID_THD_ID;
-  thd_id_[1] = INVALID_THD_ID;
-  thd_id_[2] = INVALID_THD_ID;
-  addr_[0] = 0;
-  addr_[1] = 0;
-  addr_[2] = 0;
-  size_[0] = 0;
-  size_[1] = 0;
-  size_[2] = 0;
-  window_ = 0;
-}
-
-Idiom3SchedStatus::Idiom3SchedStatus() {
-  state_ = IDIOM3_STATE_INIT;
-  thd_id_[0] = INVALID_THD_ID;
-  thd_id_[1] = INVALID_THD_ID;
-  thd_id_[2] = INVALID_THD_ID;
-  thd_id_[3] = INVALID_THD_ID;
-  addr_[0] = 0;
-  addr_[1] = 0;
-  addr_[2] = 0;
-  addr_[3] = 0;
-  size_[0] = 0;
-  size_[1] = 0;
-  size_[2] = 0;
-  size_[3] = 0;
-  window_ = 0;
-}
-
-Idiom4SchedStatus::Idiom4SchedStatus() {
-  state_ = IDIOM4_STATE_INIT;
-  thd_id_[0] = INVALID_THD_ID;
-  thd_id_[1] = INVALID_THD_ID;
-  thd_id_[2] = INVALID_THD_ID;
-  thd_id_[3] = INVALID_THD_ID;
-  addr_[0] = 0;
-  addr_[1] = 0;
-  addr_[2] = 0;
-  addr_[3] = 0;
-  size_[0] = 0;
-  size_[1] = 0;
-  size_[2] = 0;
-  size_[3] = 0;
-  window_ = 0;
+const char *const IdiomSchedDesc<IDIOM_1>::kStateNames[] = {
+  "INVALID",
+  "INIT",
+  "E0",
+  "E1",
+  "E0_E1",
+  "E0_WATCH",
+  "E0_WATCH_X",
+  "DONE"
+};
+
+const char *const IdiomSchedDesc<IDIOM_2>::kStateNames[] = {
+  "INVALID",
+  "INIT",
+  "E0",
+  "E1",
+  "E0_E1",
+  "E0_E1_WATCH",
+  "E0_E1_WATCH_X",
+  "E0_WATCH",
+  "E0_WATCH_X",
+  "E1_WATCH",
+  "E1_WATCH_X",
+  "E0_E1_E2",
+  "DONE"
+};
+
+const char *const IdiomSchedDesc<IDIOM_3>::kStateNames[] = {
+  "INVALID",
+  "INIT",
+  "E0",
+  "E1",
+  "E0_WATCH",
+  "E0_WATCH_X",
+  "E0_E1",
+  "E0_E1_WATCH",
+  "E1_WATCH",
+  "E1_WATCH_X",
+  "E0_WATCH_E3",
+  "E1_WATCH_E3",
+  "E1_WATCH_E3_X",
+  "E1_WATCH_E2",
+  "E1_WATCH_E2_WATCH",
+  "E1_WATCH_E2_WATCH_X",
+  "E0_E1_E2_E3",
+  "DONE"
+};
+
+const char *const IdiomSchedDesc<IDIOM_4>::kStateNames[] = {
+  "INVALID",
+  "INIT",
+  "E0",
+  "E1",
+  "E0_WATCH",
+  "E0_WATCH_X",
+  "E0_E1",
+  "E0_E1_WATCH",
+  "E1_WATCH",
+  "E1_WATCH_X",
+  "E0_WATCH_E3",
+  "E1_WATCH_E3",
+  "E1_WATCH_E3_X",
+  "E1_WATCH_E2",
+  "E1_WATCH_E2_WATCH",
+  "E1_WATCH_E2_WATCH_X",
+  "E0_E1_E2_E3",
+  "DONE"
+};
+
+const char *const IdiomSchedDesc<IDIOM_5>::kStateNames[] = {
+  "INVALID",
+  "INIT",
+  "E0",
+  "E2",
+  "E0_WATCH",
+  "E0_WATCH_X",
+  "E2_WATCH",
+  "E2_WATCH_X",
+  "E0_E2",
+  "E0_E2_WATCH",
+  "E0_E2_WATCH_X",
+  "E0_WATCH_E3",
+  "E2_WATCH_E1",
+  "E0_E2_WATCH_E3",
+  "E0_E2_WATCH_E3_X",
+  "E0_E2_WATCH_E1",
+  "E0_E2_WATCH_E1_X",
+  "E0_E2_WATCH_E3_WATCH",
+  "E0_E2_WATCH_E3_WATCH_X",
+  "E0_E2_WATCH_E1_WATCH",
+  "E0_E2_WATCH_E1_WATCH_X",
+  "E0_E1_E2_E3",
+  "DONE"
+};
+
+Idiom2SchedStatus::Idiom2SchedStatus()
+    : window_(0) {
+  // empty
+}
+
+Idiom3SchedStatus::Idiom3SchedStatus()
+    : window_(0) {
+  // empty
+}
+
+Idiom4SchedStatus::Idiom4SchedStatus()
+    : window_(0) {
+  // empty
 }
 
 Idiom5SchedStatus::Idiom5SchedStatus() {
-  state_ = IDIOM5_STATE_INIT;
-  thd_id_[0] = INVALID_THD_ID;
-  thd_id_[1] = INVALID_THD_ID;
-  thd_id_[2] = INVALID_THD_ID;
-  thd_id_[3] = INVALID_THD_ID;
-  addr_[0] = 0;
-  addr_[1] = 0;
-  addr_[2] = 0;
-  addr_[3] = 0;
-  size_[0] = 0;
-  size_[1] = 0;
-  size_[2] = 0;
-  size_[3] = 0;
   window_[0] = 0;
   window_[1] = 0;
 }
 
+SchedTarget::SchedTarget(iRoot *iroot)
+    : iroot_(iroot),
+      idiom1_sched_status_(NULL),
+      idiom2_sched_status_(NULL),
+      idiom3_sched_status_(NULL),
+      idiom4_sched_status_(NULL),
+      idiom5_sched_status_(NULL),
+      ops_(NULL),
+      success_(false),
+      first_event_time_(INVALID_TIMESTAMP) {
+  // empty
+}
+
+bool SchedTarget::Involved(thread_id_t thd_id) {
+  return ops_->involved(this, thd_id);
+}
+
 SchedulerCommon::SchedulerCommon()
     : iroot_db_(NULL),
       history_(NULL),
@@ -143,17 +200,14 @@ SchedulerCommon::SchedulerCommon()
       new_thread_priorities_cursor_(0),
       unit_size_(0),
       vw_(0),
-      curr_iroot_(NULL),
-      idiom1_sched_status_(NULL),
-      idiom2_sched_status_(NULL),
-      idiom3_sched_status_(NULL),
-      idiom4_sched_status_(NULL),
-      idiom5_sched_status_(NULL),
+      watch_mem_(false),
+      watch_inst_count_(false),
       sched_status_lock_(NULL),
       misc_lock_(NULL),
-      start_schedule_(false),
-      test_success_(false) {
-  // empty
+      start_time_(0),
+      start_schedule_(false) {
+  memset(tls_target_, 0, sizeof(tls_target_));
+  memset(tls_handoff_sem_, 0, sizeof(tls_handoff_sem_));
 }
 
 void SchedulerCommon::HandlePreSetup() {
@@ -172,7 +226,7 @@ void SchedulerCommon::HandlePreSetup() {
   knob_->RegisterStr("test_history", "the test history file path", "test.histo");
   knob_->RegisterInt("target_iroot", "the target iroot (0 means choosing any)", "0");
   knob_->RegisterBool("yield_with_delay", "whether inject delays for async iroots", "1");
-  knob_->RegisterInt("yield_delay_unit", "the unit time of each delay (in millisecond)", "100");
+  knob_->RegisterInt("yield_delay_unit", "the max time of each delay, cut short by a state change (in millisecond)", "100");
   knob_->RegisterInt("yield_delay_min_each", "the minimal delay each event is guaranteed (in millisecond)", "1000");
   knob_->RegisterInt("yield_delay_max_total", "the maximum delay for all events (in millisecond)", "5000");
   knob_->RegisterBool("ordered_new_thread_prio", "whether assign ordered priority to each new thread", "1");
@@ -228,7 +282,7 @@ void SchedulerCommon::HandlePreInstrumentTrace(TRACE trace) {
   ExecutionControl::HandlePreInstrumentTrace(trace);
 
   // no need to instrument if no memory iroot event exists
-  if (curr_iroot_->HasMem()) {
+  if (TargetHasMem()) {
     InstrumentMemiRootEvent(trace);
     InstrumentWatchInstCount(trace);
     InstrumentWatchMem(trace);
@@ -240,7 +294,7 @@ void SchedulerCommon::HandlePreInstrumentTrace(TRACE trace) {
 void SchedulerCommon::HandleImageLoad(IMG img, Image *image) {
   if (!desc_.HookPthreadFunc()) {
     // no need to wrap mutex functions if no sync iroot event exists
-    if (curr_iroot_->HasSync()) {
+    if (TargetHasSync()) {
       ReplacePthreadMutexWrappers(img);
     }
   }
@@ -263,42 +317,27 @@ void SchedulerCommon::HandleSyscallEntry(THREADID tid, CONTEXT *ctxt,
 }
 
 void SchedulerCommon::HandleProgramStart() {
-  // set current iroot to test
+  // the test time is measured from here
+  start_time_ = CurrentTime();
+
+  // set the target iroots to test
   Choose();
-  DEBUG_ASSERT(curr_iroot_);
-  history_->CreateEntry(curr_iroot_);
+  DEBUG_ASSERT(!targets_.empty());
+  for (size_t i = 0; i < targets_.size(); i++)
+    history_->CreateEntry(targets_[i]->iroot_);
   history_->UpdateSeed(random_seed_);
   history_->Save(knob_->ValueStr("test_history"));
-
-  // set sched status
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      idiom1_sched_status_ = new Idiom1SchedStatus;
-      break;
-    case IDIOM_2:
-      idiom2_sched_status_ = new Idiom2SchedStatus;
-      break;
-    case IDIOM_3:
-      idiom3_sched_status_ = new Idiom3SchedStatus;
-      break;
-    case IDIOM_4:
-      idiom4_sched_status_ = new Idiom4SchedStatus;
-      break;
-    case IDIOM_5:
-      idiom5_sched_status_ = new Idiom5SchedStatus;
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
-  }
 }
 
 void SchedulerCommon::HandleProgramExit() {
   ExecutionControl::HandleProgramExit();
 
-  if (!test_success_) {
-    TestFail();
-    history_->UpdateResult(false);
+  for (size_t i = 0; i < targets_.size(); i++) {
+    SchedTarget *target = targets_[i];
+    if (!target->success_) {
+      TestFail(target->iroot_);
+      history_->UpdateResult(target->iroot_, false);
+    }
   }
 
   // save test history
@@ -326,6 +365,10 @@ void SchedulerCommon::HandleThreadStart() {
     SetPriority(curr_thd_id, priority);
   }
 
+  // create the hand-off semaphore (thread ids might be reused)
+  if (!tls_handoff_sem_[PIN_ThreadId()])
+    tls_handoff_sem_[PIN_ThreadId()] = CreateSemaphore(0);
+
   ExecutionControl::HandleThreadStart();
 }
 
@@ -335,9 +378,27 @@ void SchedulerCommon::HandleThreadExit() {
   LockMisc();
   thd_id_os_tid_map_.erase(curr_thd_id);
   UnlockMisc();
+  // an exiting thread will never reach the events it is involved in,
+  // thus no need to keep the other threads waiting for it
+  LockSchedStatus();
+  for (size_t i = 0; i < targets_.size(); i++) {
+    if (targets_[i]->Involved(curr_thd_id))
+      HandoffNotify(targets_[i]);
+  }
+  UnlockSchedStatus();
   DEBUG_FMT_PRINT_SAFE("[T%lx] Thread exit\n", PIN_ThreadUid());
 }
 
+void SchedulerCommon::HandleAfterForkInChild() {
+  // the priorities are set through os tids, and only the forking
+  // thread exists in the child
+  thread_id_t curr_thd_id = PIN_ThreadUid();
+  LockMisc();
+  thd_id_os_tid_map_.clear();
+  thd_id_os_tid_map_[curr_thd_id] = PIN_GetTid();
+  UnlockMisc();
+}
+
 void SchedulerCommon::HandleMain(THREADID tid, CONTEXT *ctxt) {
   ExecutionControl::HandleMain(tid, ctxt);
   // start scheduling
@@ -361,16 +422,18 @@ void SchedulerCommon::HandleThreadMain(THREADID tid, CONTEXT *ctxt) {
 }
 
 void SchedulerCommon::Choose() {
-  // this function should setup the curr_iroot_ field
+  // this function should add the target iroots
   int target_iroot_id = knob_->ValueInt("target_iroot");
-  curr_iroot_ = iroot_db_->FindiRoot((iroot_id_t)target_iroot_id, false);
-  if (!curr_iroot_) {
+  iRoot *iroot = iroot_db_->FindiRoot((iroot_id_t)target_iroot_id, false);
+  if (!iroot) {
     Abort("target iroot invalid\n");
   }
+  AddTarget(iroot);
 }
 
 bool SchedulerCommon::UseDecreasingPriorities() {
-  return history_->TotalTestRuns(curr_iroot_) % 2 == 0;
+  // the priorities are decided by the first target
+  return history_->TotalTestRuns(targets_[0]->iroot_) % 2 == 0;
 }
 
 bool SchedulerCommon::YieldWithDelay() {
@@ -380,18 +443,139 @@ bool SchedulerCommon::YieldWithDelay() {
     return false;
 }
 
+void SchedulerCommon::AddTarget(iRoot *iroot) {
+  SchedTarget *target = new SchedTarget(iroot);
+  // set sched status and resolve the idiom entry points once, so that
+  // the analysis routines do not switch on the idiom
+  switch (iroot->idiom()) {
+    case IDIOM_1:
+      target->idiom1_sched_status_ = new Idiom1SchedStatus;
+      target->ops_ = GetIdiomOps<IDIOM_1>();
+      break;
+    case IDIOM_2:
+      target->idiom2_sched_status_ = new Idiom2SchedStatus;
+      target->ops_ = GetIdiomOps<IDIOM_2>();
+      break;
+    case IDIOM_3:
+      target->idiom3_sched_status_ = new Idiom3SchedStatus;
+      target->ops_ = GetIdiomOps<IDIOM_3>();
+      break;
+    case IDIOM_4:
+      target->idiom4_sched_status_ = new Idiom4SchedStatus;
+      target->ops_ = GetIdiomOps<IDIOM_4>();
+      break;
+    case IDIOM_5:
+      target->idiom5_sched_status_ = new Idiom5SchedStatus;
+      target->ops_ = GetIdiomOps<IDIOM_5>();
+      break;
+    default:
+      Abort("invalid idiom\n");
+      break;
+  }
+  targets_.push_back(target);
+  AddCandidates(iroot);
+}
+
+bool SchedulerCommon::EnterTarget(SchedTarget *target) {
+  // the current thread cannot enter the target if it is involved in
+  // the state machine of another target. only the current thread can
+  // get itself involved, thus the result holds until it returns.
+  if (targets_.size() > 1) {
+    thread_id_t curr_thd_id = PIN_ThreadUid();
+    bool involved = false;
+    LockSchedStatus();
+    for (size_t i = 0; i < targets_.size(); i++) {
+      if (targets_[i] != target && targets_[i]->Involved(curr_thd_id)) {
+        involved = true;
+        break;
+      }
+    }
+    UnlockSchedStatus();
+    if (involved) {
+      DEBUG_STAT_INC("target_conflict", 1);
+      return false;
+    }
+  }
+  tls_target_[PIN_ThreadId()] = target;
+  return true;
+}
+
+bool SchedulerCommon::TargetHasMem() {
+  for (size_t i = 0; i < targets_.size(); i++) {
+    if (targets_[i]->iroot_->HasMem())
+      return true;
+  }
+  return false;
+}
+
+bool SchedulerCommon::TargetHasSync() {
+  for (size_t i = 0; i < targets_.size(); i++) {
+    if (targets_[i]->iroot_->HasSync())
+      return true;
+  }
+  return false;
+}
+
+int SchedulerCommon::HandoffWait(int timeout) {
+  // block the current thread (with the sched status unlocked) until
+  // the state of its target changes or the timeout (in millisecond)
+  // expires. return the time waited (in millisecond, at least 1).
+  SchedTarget *target = CurrTarget();
+  THREADID tid = PIN_ThreadId();
+  Semaphore *sem = tls_handoff_sem_[tid];
+  DEBUG_ASSERT(sem);
+  struct timeval start, end;
+  gettimeofday(&start, NULL);
+  struct timespec to;
+  to.tv_sec = start.tv_sec + timeout / 1000;
+  to.tv_nsec = (start.tv_usec + (timeout % 1000) * 1000) * 1000;
+  if (to.tv_nsec >= 1000000000) {
+    to.tv_sec++;
+    to.tv_nsec -= 1000000000;
+  }
+  target->handoff_set_.insert(tid);
+  UnlockSchedStatus();
+  int ret = 0;
+  do {
+    ret = sem->TimedWait(&to);
+  } while (ret && errno == EINTR);
+  LockSchedStatus();
+  if (ret && !target->handoff_set_.erase(tid)) {
+    // notified right after the timeout, consume the post
+    sem->Wait();
+  }
+  gettimeofday(&end, NULL);
+  int waited = (end.tv_sec - start.tv_sec) * 1000 +
+               (end.tv_usec - start.tv_usec) / 1000;
+  return waited > 0 ? waited : 1;
+}
+
+void SchedulerCommon::HandoffNotify(SchedTarget *target) {
+  // wake up the threads waiting for a state change of the target
+  for (std::set<THREADID>::iterator it = target->handoff_set_.begin();
+       it != target->handoff_set_.end(); ++it) {
+    tls_handoff_sem_[*it]->Post();
+  }
+  target->handoff_set_.clear();
+}
+
 void SchedulerCommon::InstrumentMemiRootEvent(TRACE trace) {
-  int size = iRoot::GetNumEvents(curr_iroot_->idiom());
-  for (int i = 0; i < size; i++) {
-    int idx = size - 1 - i;
-    iRootEvent *e = curr_iroot_->GetEvent(idx);
-    if (e->IsMem())
-      InstrumentMemiRootEvent(trace, idx);
+  for (size_t t = 0; t < targets_.size(); t++) {
+    SchedTarget *target = targets_[t];
+    int size = iRoot::GetNumEvents(target->iroot_->idiom());
+    for (int i = 0; i < size; i++) {
+      int idx = size - 1 - i;
+      iRootEvent *e = target->iroot_->GetEvent(idx);
+      if (e->IsMem())
+        InstrumentMemiRootEvent(trace, target, idx);
+    }
   }
 }
 
-void SchedulerCommon::InstrumentMemiRootEvent(TRACE trace, UINT32 idx) {
-  iRootEvent *e = curr_iroot_->GetEvent(idx);
+void SchedulerCommon::InstrumentMemiRootEvent(TRACE trace,
+                                              SchedTarget *target,
+                                              UINT32 idx) {
+  iRootEvent *e = target->iroot_->GetEvent(idx);
 
   DEBUG_ASSERT(e->IsMem());
 
@@ -420,6 +604,7 @@ void SchedulerCommon::InstrumentMemiRootEvent(TRACE trace, UINT32 idx) {
           INS_InsertCall(ins, IPOINT_BEFORE,
                          (AFUNPTR)__BeforeiRootMemRead,
                          CALL_ORDER_BEFORE
+                         IARG_PTR, target,
                          IARG_UINT32, idx,
                          IARG_MEMORYREAD_EA,
                          IARG_MEMORYREAD_SIZE,
@@ -430,6 +615,7 @@ void SchedulerCommon::InstrumentMemiRootEvent(TRACE trace, UINT32 idx) {
           INS_InsertCall(ins, IPOINT_BEFORE,
                          (AFUNPTR)__BeforeiRootMemWrite,
                          CALL_ORDER_BEFORE
+                         IARG_PTR, target,
                          IARG_UINT32, idx,
                          IARG_MEMORYWRITE_EA,
                          IARG_MEMORYWRITE_SIZE,
@@ -440,6 +626,7 @@ void SchedulerCommon::InstrumentMemiRootEvent(TRACE trace, UINT32 idx) {
           INS_InsertCall(ins, IPOINT_BEFORE,
                          (AFUNPTR)__BeforeiRootMemRead,
                          CALL_ORDER_BEFORE
+                         IARG_PTR, target,
                          IARG_UINT32, idx,
                          IARG_MEMORYREAD2_EA,
                          IARG_MEMORYREAD_SIZE,
@@ -450,6 +637,7 @@ void SchedulerCommon::InstrumentMemiRootEvent(TRACE trace, UINT32 idx) {
           INS_InsertCall(ins, IPOINT_AFTER,
                          (AFUNPTR)__AfteriRootMem,
                          CALL_ORDER_AFTER
+                         IARG_PTR, target,
                          IARG_UINT32, idx,
                          IARG_END);
         }
@@ -458,6 +646,7 @@ void SchedulerCommon::InstrumentMemiRootEvent(TRACE trace, UINT32 idx) {
           INS_InsertCall(ins, IPOINT_TAKEN_BRANCH,
                          (AFUNPTR)__AfteriRootMem,
                          CALL_ORDER_AFTER
+                         IARG_PTR, target,
                          IARG_UINT32, idx,
                          IARG_END);
         }
@@ -473,297 +662,112 @@ void SchedulerCommon::ReplacePthreadMutexWrappers(IMG img) {
 }
 
 void SchedulerCommon::CheckiRootBeforeMutexLock(Inst *inst, address_t addr) {
-  bool is_candidate = false;
-  int size = iRoot::GetNumEvents(curr_iroot_->idiom());
-  for (int i = 0; i < size; i++) {
-    int idx = size - 1 - i;
-    iRootEvent *e = curr_iroot_->GetEvent(idx);
-    if (e->type() == IROOT_EVENT_MUTEX_LOCK && e->inst() == inst) {
-      HandleBeforeiRootMutexLock(idx, addr);
-      is_candidate = true;
+  for (size_t t = 0; t < targets_.size(); t++) {
+    SchedTarget *target = targets_[t];
+    bool is_candidate = false;
+    int size = iRoot::GetNumEvents(target->iroot_->idiom());
+    for (int i = 0; i < size; i++) {
+      int idx = size - 1 - i;
+      iRootEvent *e = target->iroot_->GetEvent(idx);
+      if (e->type() == IROOT_EVENT_MUTEX_LOCK && e->inst() == inst) {
+        HandleBeforeiRootMutexLock(target, idx, addr);
+        is_candidate = true;
+      }
     }
+    if (!is_candidate)
+      HandleWatchMutexLock(target, addr);
   }
-  if (!is_candidate)
-    HandleWatchMutexLock(addr);
 }
 
 void SchedulerCommon::CheckiRootAfterMutexLock(Inst *inst, address_t addr) {
-  int size = iRoot::GetNumEvents(curr_iroot_->idiom());
-  for (int i = 0; i < size; i++) {
-    int idx = size - 1 - i;
-    iRootEvent *e = curr_iroot_->GetEvent(idx);
-    if (e->type() == IROOT_EVENT_MUTEX_LOCK && e->inst() == inst) {
-      HandleAfteriRootMutexLock(idx, addr);
+  for (size_t t = 0; t < targets_.size(); t++) {
+    SchedTarget *target = targets_[t];
+    int size = iRoot::GetNumEvents(target->iroot_->idiom());
+    for (int i = 0; i < size; i++) {
+      int idx = size - 1 - i;
+      iRootEvent *e = target->iroot_->GetEvent(idx);
+      if (e->type() == IROOT_EVENT_MUTEX_LOCK && e->inst() == inst) {
+        HandleAfteriRootMutexLock(target, idx, addr);
+      }
     }
   }
 }
 
 void SchedulerCommon::CheckiRootBeforeMutexUnlock(Inst *inst, address_t addr) {
-  bool is_candidate = false;
-  int size = iRoot::GetNumEvents(curr_iroot_->idiom());
-  for (int i = 0; i < size; i++) {
-    int idx = size - 1 - i;
-    iRootEvent *e = curr_iroot_->GetEvent(idx);
-    if (e->type() == IROOT_EVENT_MUTEX_UNLOCK && e->inst() == inst) {
-      HandleBeforeiRootMutexUnlock(idx, addr);
-      is_candidate = true;
+  for (size_t t = 0; t < targets_.size(); t++) {
+    SchedTarget *target = targets_[t];
+    bool is_candidate = false;
+    int size = iRoot::GetNumEvents(target->iroot_->idiom());
+    for (int i = 0; i < size; i++) {
+      int idx = size - 1 - i;
+      iRootEvent *e = target->iroot_->GetEvent(idx);
+      if (e->type() == IROOT_EVENT_MUTEX_UNLOCK && e->inst() == inst) {
+        HandleBeforeiRootMutexUnlock(target, idx, addr);
+        is_candidate = true;
+      }
     }
+    if (!is_candidate)
+      HandleWatchMutexUnlock(target, addr);
   }
-  if (!is_candidate)
-    HandleWatchMutexUnlock(addr);
 }
 
 void SchedulerCommon::CheckiRootAfterMutexUnlock(Inst *inst, address_t addr) {
-  int size = iRoot::GetNumEvents(curr_iroot_->idiom());
-  for (int i = 0; i < size; i++) {
-    int idx = size - 1 - i;
-    iRootEvent *e = curr_iroot_->GetEvent(idx);
-    if (e->type() == IROOT_EVENT_MUTEX_UNLOCK && e->inst() == inst) {
-      HandleAfteriRootMutexUnlock(idx, addr);
+  for (size_t t = 0; t < targets_.size(); t++) {
+    SchedTarget *target = targets_[t];
+    int size = iRoot::GetNumEvents(target->iroot_->idiom());
+    for (int i = 0; i < size; i++) {
+      int idx = size - 1 - i;
+      iRootEvent *e = target->iroot_->GetEvent(idx);
+      if (e->type() == IROOT_EVENT_MUTEX_UNLOCK && e->inst() == inst) {
+        HandleAfteriRootMutexUnlock(target, idx, addr);
+      }
     }
   }
 }
 
 void SchedulerCommon::InstrumentWatchMem(TRACE trace) {
-  switch (curr_iroot_->idiom()) {
-      case IDIOM_1:
-        Idiom1InstrumentWatchMem(trace);
-        break;
-      case IDIOM_2:
-        Idiom2InstrumentWatchMem(trace);
-        break;
-      case IDIOM_3:
-        Idiom3InstrumentWatchMem(trace);
-        break;
-      case IDIOM_4:
-        Idiom4InstrumentWatchMem(trace);
-        break;
-      case IDIOM_5:
-        Idiom5InstrumentWatchMem(trace);
-        break;
-      default:
-        break;
-  }
-}
-
-void SchedulerCommon::InstrumentWatchInstCount(TRACE trace) {
-  switch (curr_iroot_->idiom()) {
-      case IDIOM_1:
-        // no need to instrumet
-        break;
-      case IDIOM_2:
-        Idiom2InstrumentWatchInstCount(trace);
-        break;
-      case IDIOM_3:
-        Idiom3InstrumentWatchInstCount(trace);
-        break;
-      case IDIOM_4:
-        Idiom4InstrumentWatchInstCount(trace);
-        break;
-      case IDIOM_5:
-        Idiom5InstrumentWatchInstCount(trace);
-        break;
-      default:
-        break;
-  }
-}
-
-void SchedulerCommon::Idiom1InstrumentWatchMem(TRACE trace) {
-  Idiom1SchedStatus *s = idiom1_sched_status_;
-
-  if (ContainCandidates(trace)) {
-    __InstrumentWatchMem(trace, true);
-    return;
-  }
-
-  switch (s->state_) {
-    case IDIOM1_STATE_E0_WATCH:
-      __InstrumentWatchMem(trace, false);
-      break;
-    default:
-      break;
-  }
-}
-
-void SchedulerCommon::Idiom1InstrumentWatchInstCount(TRACE trace) {
-  Idiom1SchedStatus *s = idiom1_sched_status_;
-
-  switch (s->state_) {
-    case IDIOM1_STATE_E0_WATCH:
-      __InstrumentWatchInstCount(trace);
-      break;
-    default:
-      break;
-  }
-}
-
-void SchedulerCommon::Idiom2InstrumentWatchMem(TRACE trace) {
-  Idiom2SchedStatus *s = idiom2_sched_status_;
-
-  if (ContainCandidates(trace)) {
-    __InstrumentWatchMem(trace, true);
-    return;
-  }
-
-  switch (s->state_) {
-    case IDIOM2_STATE_E0_WATCH:
-    case IDIOM2_STATE_E0_E1_WATCH:
-    case IDIOM2_STATE_E1_WATCH:
-      __InstrumentWatchMem(trace, false);
-      break;
-    default:
-      break;
-  }
-}
-
-void SchedulerCommon::Idiom2InstrumentWatchInstCount(TRACE trace) {
-  Idiom2SchedStatus *s = idiom2_sched_status_;
-
-  switch (s->state_) {
-    case IDIOM2_STATE_E0_WATCH:
-    case IDIOM2_STATE_E0_E1_WATCH:
-    case IDIOM2_STATE_E1_WATCH:
-      __InstrumentWatchInstCount(trace);
-      break;
-    default:
-      break;
-  }
-}
-
-void SchedulerCommon::Idiom3InstrumentWatchMem(TRACE trace) {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
-
   if (ContainCandidates(trace)) {
     __InstrumentWatchMem(trace, true);
     return;
   }
 
-  switch (s->state_) {
-    case IDIOM3_STATE_E0_WATCH:
-    case IDIOM3_STATE_E0_E1_WATCH:
-    case IDIOM3_STATE_E1_WATCH:
-    case IDIOM3_STATE_E0_WATCH_E3:
-    case IDIOM3_STATE_E1_WATCH_E3:
-    case IDIOM3_STATE_E1_WATCH_E2:
-    case IDIOM3_STATE_E1_WATCH_E2_WATCH:
-      __InstrumentWatchMem(trace, false);
-      break;
-    default:
-      break;
-  }
+  // the watch instrumentation is always inserted, but guarded by a
+  // flag so that changing the watch set does not need retranslation
+  __InstrumentWatchMem(trace, false);
 }
 
-void SchedulerCommon::Idiom3InstrumentWatchInstCount(TRACE trace) {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
-
-  switch (s->state_) {
-    case IDIOM3_STATE_E0_WATCH:
-    case IDIOM3_STATE_E0_E1_WATCH:
-    case IDIOM3_STATE_E1_WATCH:
-    case IDIOM3_STATE_E0_WATCH_E3:
-    case IDIOM3_STATE_E1_WATCH_E3:
-    case IDIOM3_STATE_E1_WATCH_E2:
-    case IDIOM3_STATE_E1_WATCH_E2_WATCH:
-      __InstrumentWatchInstCount(trace);
-      break;
-    default:
-      break;
-  }
-}
-
-void SchedulerCommon::Idiom4InstrumentWatchMem(TRACE trace) {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
-
-  if (ContainCandidates(trace)) {
-    __InstrumentWatchMem(trace, true);
-    return;
-  }
-
-  switch (s->state_) {
-    case IDIOM4_STATE_E0_WATCH:
-    case IDIOM4_STATE_E0_E1_WATCH:
-    case IDIOM4_STATE_E1_WATCH:
-    case IDIOM4_STATE_E0_WATCH_E3:
-    case IDIOM4_STATE_E1_WATCH_E3:
-    case IDIOM4_STATE_E1_WATCH_E2:
-    case IDIOM4_STATE_E1_WATCH_E2_WATCH:
-      __InstrumentWatchMem(trace, false);
-      break;
-    default:
-      break;
-  }
-}
-
-void SchedulerCommon::Idiom4InstrumentWatchInstCount(TRACE trace) {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
-
-  switch (s->state_) {
-    case IDIOM4_STATE_E0_WATCH:
-    case IDIOM4_STATE_E0_E1_WATCH:
-    case IDIOM4_STATE_E1_WATCH:
-    case IDIOM4_STATE_E0_WATCH_E3:
-    case IDIOM4_STATE_E1_WATCH_E3:
-    case IDIOM4_STATE_E1_WATCH_E2:
-    case IDIOM4_STATE_E1_WATCH_E2_WATCH:
+void SchedulerCommon::InstrumentWatchInstCount(TRACE trace) {
+  for (size_t i = 0; i < targets_.size(); i++) {
+    if (targets_[i]->ops_->watch_inst_count) {
       __InstrumentWatchInstCount(trace);
-      break;
-    default:
-      break;
-  }
-}
-
-void SchedulerCommon::Idiom5InstrumentWatchMem(TRACE trace) {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
-
-  if (ContainCandidates(trace)) {
-    __InstrumentWatchMem(trace, true);
-    return;
-  }
-
-  switch (s->state_) {
-    case IDIOM5_STATE_E0_WATCH:
-    case IDIOM5_STATE_E2_WATCH:
-    case IDIOM5_STATE_E0_E2_WATCH:
-    case IDIOM5_STATE_E0_WATCH_E3:
-    case IDIOM5_STATE_E2_WATCH_E1:
-    case IDIOM5_STATE_E0_E2_WATCH_E3:
-    case IDIOM5_STATE_E0_E2_WATCH_E1:
-    case IDIOM5_STATE_E0_E2_WATCH_E3_WATCH:
-    case IDIOM5_STATE_E0_E2_WATCH_E1_WATCH:
-      __InstrumentWatchMem(trace, false);
-      break;
-    default:
-      break;
+      return;
+    }
   }
 }
 
-void SchedulerCommon::Idiom5InstrumentWatchInstCount(TRACE trace) {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
-
-  switch (s->state_) {
-    case IDIOM5_STATE_E0_WATCH:
-    case IDIOM5_STATE_E2_WATCH:
-    case IDIOM5_STATE_E0_E2_WATCH:
-    case IDIOM5_STATE_E0_WATCH_E3:
-    case IDIOM5_STATE_E2_WATCH_E1:
-    case IDIOM5_STATE_E0_E2_WATCH_E3:
-    case IDIOM5_STATE_E0_E2_WATCH_E1:
-    case IDIOM5_STATE_E0_E2_WATCH_E3_WATCH:
-    case IDIOM5_STATE_E0_E2_WATCH_E1_WATCH:
-      __InstrumentWatchInstCount(trace);
-      break;
-    default:
-      break;
+bool SchedulerCommon::Watching(bool inst_count) {
+  // return true if any target needs to watch memory accesses (or
+  // instruction counts if inst_count is true)
+  for (size_t i = 0; i < targets_.size(); i++) {
+    SchedTarget *target = targets_[i];
+    if ((this->*target->ops_->watching)(target, inst_count))
+      return true;
   }
+  return false;
 }
 
 void SchedulerCommon::__InstrumentWatchInstCount(TRACE trace) {
   for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
-    BBL_InsertCall(bbl, IPOINT_BEFORE,
-                   (AFUNPTR)__WatchInstCount,
-                   CALL_ORDER_BEFORE
-                   IARG_UINT32, BBL_NumIns(bbl),
-                   IARG_END);
+    BBL_InsertIfCall(bbl, IPOINT_BEFORE,
+                     (AFUNPTR)__WatchGuard,
+                     CALL_ORDER_BEFORE
+                     IARG_PTR, &watch_inst_count_,
+                     IARG_END);
+    BBL_InsertThenCall(bbl, IPOINT_BEFORE,
+                       (AFUNPTR)__WatchInstCount,
+                       CALL_ORDER_BEFORE
+                       IARG_UINT32, BBL_NumIns(bbl),
+                       IARG_END);
   }
 }
 
@@ -773,134 +777,161 @@ void SchedulerCommon::__InstrumentWatchMem(TRACE trace, bool cand) {
   if (IMG_Valid(img) && IMG_Name(img).find("libpthread") != std::string::npos)
     return;
 
+  ADDRINT img_low_addr = 0;
+  CandidateOffsetMap *cands = FindCandidates(trace, &img_low_addr);
   for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
     for (INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins)) {
       // ignore stack accesses
       if (INS_IsStackRead(ins) || INS_IsStackWrite(ins))
         continue;
 
-      if (IsCandidate(trace, ins))
+      if (IsCandidate(cands, img_low_addr, ins))
         continue;
 
       if (INS_IsMemoryRead(ins)) {
         Inst *inst = FindInst(INS_Address(ins));
-        INS_InsertCall(ins, IPOINT_BEFORE,
-                       (AFUNPTR)__WatchMemRead,
-                       CALL_ORDER_BEFORE
-                       IARG_PTR, inst,
-                       IARG_MEMORYREAD_EA,
-                       IARG_MEMORYREAD_SIZE,
-                       IARG_BOOL, cand,
-                       IARG_END);
+        __InstrumentWatchAccess(ins, (AFUNPTR)__WatchMemRead, inst,
+                                IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE,
+                                cand);
       }
 
       if (INS_IsMemoryWrite(ins)) {
         Inst *inst = FindInst(INS_Address(ins));
-        INS_InsertCall(ins, IPOINT_BEFORE,
-                       (AFUNPTR)__WatchMemWrite,
-                       CALL_ORDER_BEFORE
-                       IARG_PTR, inst,
-                       IARG_MEMORYWRITE_EA,
-                       IARG_MEMORYWRITE_SIZE,
-                       IARG_BOOL, cand,
-                       IARG_END);
+        __InstrumentWatchAccess(ins, (AFUNPTR)__WatchMemWrite, inst,
+                                IARG_MEMORYWRITE_EA, IARG_MEMORYWRITE_SIZE,
+                                cand);
       }
 
       if (INS_HasMemoryRead2(ins)) {
         Inst *inst = FindInst(INS_Address(ins));
-        INS_InsertCall(ins, IPOINT_BEFORE,
-                       (AFUNPTR)__WatchMemRead,
-                       CALL_ORDER_BEFORE
-                       IARG_PTR, inst,
-                       IARG_MEMORYREAD2_EA,
-                       IARG_MEMORYREAD_SIZE,
-                       IARG_BOOL, cand,
-                       IARG_END);
+        __InstrumentWatchAccess(ins, (AFUNPTR)__WatchMemRead, inst,
+                                IARG_MEMORYREAD2_EA, IARG_MEMORYREAD_SIZE,
+                                cand);
       }
     } // end of for ins
   } // end of for bbl
 }
 
-bool SchedulerCommon::ContainCandidates(TRACE trace) {
-  int size = iRoot::GetNumEvents(curr_iroot_->idiom());
-  for (int i = 0; i < size; i++) {
-    iRootEvent *e = curr_iroot_->GetEvent(i);
-    if (e->IsMem()) {
-      Inst *inst = e->inst();
-      DEBUG_ASSERT(inst);
-      Image *image = inst->image();
-      DEBUG_ASSERT(image);
-      IMG img = GetImgByTrace(trace);
-
-      // no need to proceed if image does not match
-      if (IMG_Valid(img)) {
-        if (image->name().compare(IMG_Name(img)) != 0)
-          continue;
-      } else {
-        if (image->name().compare(PSEUDO_IMAGE_NAME) != 0)
-          continue;
-      }
-
-      ADDRINT img_low_addr = IMG_Valid(img) ? IMG_LowAddress(img) : 0;
-      for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
-        for (INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins)) {
-          ADDRINT offset = INS_Address(ins) - img_low_addr;
-          if (offset == inst->offset()) {
-            return true;
-          }
-        }
-      }
-    }
+void SchedulerCommon::__InstrumentWatchAccess(INS ins, AFUNPTR func,
+                                              Inst *inst, IARG_TYPE ea,
+                                              IARG_TYPE size, bool cand) {
+  // accesses in the traces containing candidates are always watched
+  if (cand) {
+    INS_InsertCall(ins, IPOINT_BEFORE, func,
+                   CALL_ORDER_BEFORE
+                   IARG_PTR, inst,
+                   ea,
+                   size,
+                   IARG_BOOL, cand,
+                   IARG_END);
+    return;
   }
 
-  return false;
+  INS_InsertIfCall(ins, IPOINT_BEFORE,
+                   (AFUNPTR)__WatchGuard,
+                   CALL_ORDER_BEFORE
+                   IARG_PTR, &watch_mem_,
+                   IARG_END);
+  INS_InsertThenCall(ins, IPOINT_BEFORE, func,
+                     CALL_ORDER_BEFORE
+                     IARG_PTR, inst,
+                     ea,
+                     size,
+                     IARG_BOOL, cand,
+                     IARG_END);
 }
 
-bool SchedulerCommon::IsCandidate(TRACE trace, INS ins) {
-  int size = iRoot::GetNumEvents(curr_iroot_->idiom());
+void SchedulerCommon::AddCandidates(iRoot *iroot) {
+  int size = iRoot::GetNumEvents(iroot->idiom());
   for (int i = 0; i < size; i++) {
-    iRootEvent *e = curr_iroot_->GetEvent(i);
+    iRootEvent *e = iroot->GetEvent(i);
     Inst *inst = e->inst();
     DEBUG_ASSERT(inst);
     Image *image = inst->image();
     DEBUG_ASSERT(image);
-    IMG img = GetImgByTrace(trace);
+    bool &mem = cand_map_[image->name()][inst->offset()];
+    mem = mem || e->IsMem();
+  }
+}
 
-    // no need to proceed if image does not match
-    if (IMG_Valid(img)) {
-      if (image->name().compare(IMG_Name(img)) != 0)
-        continue;
-    } else {
-      if (image->name().compare(PSEUDO_IMAGE_NAME) != 0)
-        continue;
-    }
+SchedulerCommon::CandidateOffsetMap *SchedulerCommon::FindCandidates(
+    TRACE trace, ADDRINT *img_low_addr) {
+  IMG img = GetImgByTrace(trace);
+  CandidateMap::iterator it;
+  if (IMG_Valid(img)) {
+    it = cand_map_.find(IMG_Name(img));
+    *img_low_addr = IMG_LowAddress(img);
+  } else {
+    it = cand_map_.find(PSEUDO_IMAGE_NAME);
+    *img_low_addr = 0;
+  }
+  return it == cand_map_.end() ? NULL : &it->second;
+}
 
-    ADDRINT img_low_addr = IMG_Valid(img) ? IMG_LowAddress(img) : 0;
-    ADDRINT offset = INS_Address(ins) - img_low_addr;
-    if (offset == inst->offset())
-      return true;
+bool SchedulerCommon::ContainCandidates(TRACE trace) {
+  ADDRINT img_low_addr = 0;
+  CandidateOffsetMap *cands = FindCandidates(trace, &img_low_addr);
+  if (!cands)
+    return false;
+
+  for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
+    for (INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins)) {
+      CandidateOffsetMap::iterator it
+          = cands->find(INS_Address(ins) - img_low_addr);
+      // only memory iroot events are considered
+      if (it != cands->end() && it->second)
+        return true;
+    }
   }
   return false;
 }
 
+bool SchedulerCommon::IsCandidate(CandidateOffsetMap *cands,
+                                  ADDRINT img_low_addr, INS ins) {
+  if (!cands)
+    return false;
+  return cands->find(INS_Address(ins) - img_low_addr) != cands->end();
+}
+
 void SchedulerCommon::FlushWatch() {
-  DEBUG_ASSERT(curr_iroot_);
-  if (curr_iroot_->HasMem()) {
-    DEBUG_FMT_PRINT_SAFE("flush code cache\n");
-    CODECACHE_FlushCache();
-    //PIN_RemoveInstrumentation();
-  }
+  // the watch instrumentation is guarded by the watch flags, thus
+  // only the flags need to be updated (no code cache flush)
+  DEBUG_ASSERT(!targets_.empty());
+  LockSchedStatus();
+  watch_mem_ = TargetHasMem() && Watching(false);
+  watch_inst_count_ = Watching(true);
+  UnlockSchedStatus();
+  DEBUG_FMT_PRINT_SAFE("flush watch mem=%d inst_count=%d\n",
+                       (int)watch_mem_, (int)watch_inst_count_);
 }
 
 void SchedulerCommon::ActivelyExposed() {
-  DEBUG_ASSERT(curr_iroot_);
-  if (!test_success_) {
-    TestSuccess();
-    history_->UpdateResult(true);
-    test_success_ = true;
+  SchedTarget *target = CurrTarget();
+  DEBUG_ASSERT(target);
+  if (!target->success_) {
+    TestSuccess(target->iroot_);
+    history_->UpdateResult(target->iroot_, true);
+    target->success_ = true;
   }
 }
 
+void SchedulerCommon::RecordFirstEvent() {
+  // only called for the events of the target iroots, thus taking the
+  // lock for both the check and the update is cheap
+  SchedTarget *target = CurrTarget();
+  LockMisc();
+  if (target->first_event_time_ == INVALID_TIMESTAMP)
+    target->first_event_time_ = CurrentTime() - start_time_;
+  UnlockMisc();
+}
+
+timestamp_t SchedulerCommon::CurrentTime() {
+  // return the current time in millisecond
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (timestamp_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
 Inst *SchedulerCommon::FindInst(ADDRINT pc) {
   Image *image = NULL;
   ADDRINT offset = 0;
@@ -1128,434 +1159,574 @@ void SchedulerCommon::SetAffinity() {
   }
 }
 
-void SchedulerCommon::HandleBeforeiRootMemRead(UINT32 idx, address_t addr,
-                                         size_t size) {
+void SchedulerCommon::HandleBeforeiRootMemRead(SchedTarget *target, UINT32 idx,
+                                               address_t addr, size_t size) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1BeforeiRootMemRead(idx, addr, size);
-      break;
-    case IDIOM_2:
-      Idiom2BeforeiRootMemRead(idx, addr, size);
-      break;
-    case IDIOM_3:
-      Idiom3BeforeiRootMemRead(idx, addr, size);
-      break;
-    case IDIOM_4:
-      Idiom4BeforeiRootMemRead(idx, addr, size);
-      break;
-    case IDIOM_5:
-      Idiom5BeforeiRootMemRead(idx, addr, size);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
+  // the access is a normal access for the other targets
+  Inst *inst = target->iroot_->GetEvent(idx)->inst();
+  for (size_t i = 0; i < targets_.size(); i++) {
+    if (targets_[i] != target)
+      HandleWatchMemRead(targets_[i], inst, addr, size, true);
   }
+
+  if (!EnterTarget(target))
+    return;
+
+  RecordFirstEvent();
+
+  (this->*target->ops_->before_mem_read)(idx, addr, size);
 }
 
-void SchedulerCommon::HandleBeforeiRootMemWrite(UINT32 idx, address_t addr,
-                                          size_t size) {
+void SchedulerCommon::HandleBeforeiRootMemWrite(SchedTarget *target, UINT32 idx,
+                                                address_t addr, size_t size) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1BeforeiRootMemWrite(idx, addr, size);
-      break;
-    case IDIOM_2:
-      Idiom2BeforeiRootMemWrite(idx, addr, size);
-      break;
-    case IDIOM_3:
-      Idiom3BeforeiRootMemWrite(idx, addr, size);
-      break;
-    case IDIOM_4:
-      Idiom4BeforeiRootMemWrite(idx, addr, size);
-      break;
-    case IDIOM_5:
-      Idiom5BeforeiRootMemWrite(idx, addr, size);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
+  // the access is a normal access for the other targets
+  Inst *inst = target->iroot_->GetEvent(idx)->inst();
+  for (size_t i = 0; i < targets_.size(); i++) {
+    if (targets_[i] != target)
+      HandleWatchMemWrite(targets_[i], inst, addr, size, true);
   }
+
+  if (!EnterTarget(target))
+    return;
+
+  RecordFirstEvent();
+
+  (this->*target->ops_->before_mem_write)(idx, addr, size);
 }
 
-void SchedulerCommon::HandleAfteriRootMem(UINT32 idx) {
+void SchedulerCommon::HandleAfteriRootMem(SchedTarget *target, UINT32 idx) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1AfteriRootMem(idx);
-      break;
-    case IDIOM_2:
-      Idiom2AfteriRootMem(idx);
-      break;
-    case IDIOM_3:
-      Idiom3AfteriRootMem(idx);
-      break;
-    case IDIOM_4:
-      Idiom4AfteriRootMem(idx);
-      break;
-    case IDIOM_5:
-      Idiom5AfteriRootMem(idx);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
-  }
+  if (!EnterTarget(target))
+    return;
+
+  (this->*target->ops_->after_mem)(idx);
 }
 
-void SchedulerCommon::HandleBeforeiRootMutexLock(UINT32 idx, address_t addr) {
+void SchedulerCommon::HandleBeforeiRootMutexLock(SchedTarget *target,
+                                                 UINT32 idx, address_t addr) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1BeforeiRootMutexLock(idx, addr);
-      break;
-    case IDIOM_2:
-      Idiom2BeforeiRootMutexLock(idx, addr);
-      break;
-    case IDIOM_3:
-      Idiom3BeforeiRootMutexLock(idx, addr);
-      break;
-    case IDIOM_4:
-      Idiom4BeforeiRootMutexLock(idx, addr);
-      break;
-    case IDIOM_5:
-      Idiom5BeforeiRootMutexLock(idx, addr);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
-  }
+  if (!EnterTarget(target))
+    return;
+
+  RecordFirstEvent();
+
+  (this->*target->ops_->before_mutex_lock)(idx, addr);
 }
 
-void SchedulerCommon::HandleAfteriRootMutexLock(UINT32 idx, address_t addr) {
+void SchedulerCommon::HandleAfteriRootMutexLock(SchedTarget *target,
+                                                UINT32 idx, address_t addr) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1AfteriRootMutexLock(idx, addr);
-      break;
-    case IDIOM_2:
-      Idiom2AfteriRootMutexLock(idx, addr);
-      break;
-    case IDIOM_3:
-      Idiom3AfteriRootMutexLock(idx, addr);
-      break;
-    case IDIOM_4:
-      Idiom4AfteriRootMutexLock(idx, addr);
-      break;
-    case IDIOM_5:
-      Idiom5AfteriRootMutexLock(idx, addr);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
-  }
+  if (!EnterTarget(target))
+    return;
+
+  (this->*target->ops_->after_mutex_lock)(idx, addr);
 }
 
-void SchedulerCommon::HandleBeforeiRootMutexUnlock(UINT32 idx, address_t addr) {
+void SchedulerCommon::HandleBeforeiRootMutexUnlock(SchedTarget *target,
+                                                   UINT32 idx, address_t addr) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1BeforeiRootMutexUnlock(idx, addr);
-      break;
-    case IDIOM_2:
-      Idiom2BeforeiRootMutexUnlock(idx, addr);
-      break;
-    case IDIOM_3:
-      Idiom3BeforeiRootMutexUnlock(idx, addr);
-      break;
-    case IDIOM_4:
-      Idiom4BeforeiRootMutexUnlock(idx, addr);
-      break;
-    case IDIOM_5:
-      Idiom5BeforeiRootMutexUnlock(idx, addr);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
-  }
+  if (!EnterTarget(target))
+    return;
+
+  RecordFirstEvent();
+
+  (this->*target->ops_->before_mutex_unlock)(idx, addr);
 }
 
-void SchedulerCommon::HandleAfteriRootMutexUnlock(UINT32 idx, address_t addr) {
+void SchedulerCommon::HandleAfteriRootMutexUnlock(SchedTarget *target,
+                                                  UINT32 idx, address_t addr) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1AfteriRootMutexUnlock(idx, addr);
-      break;
-    case IDIOM_2:
-      Idiom2AfteriRootMutexUnlock(idx, addr);
-      break;
-    case IDIOM_3:
-      Idiom3AfteriRootMutexUnlock(idx, addr);
-      break;
-    case IDIOM_4:
-      Idiom4AfteriRootMutexUnlock(idx, addr);
-      break;
-    case IDIOM_5:
-      Idiom5AfteriRootMutexUnlock(idx, addr);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
-  }
+  if (!EnterTarget(target))
+    return;
+
+  (this->*target->ops_->after_mutex_unlock)(idx, addr);
 }
 
-void SchedulerCommon::HandleWatchMutexLock(address_t addr) {
+void SchedulerCommon::HandleWatchMutexLock(SchedTarget *target,
+                                           address_t addr) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1WatchMutexLock(addr);
-      break;
-    case IDIOM_2:
-      Idiom2WatchMutexLock(addr);
-      break;
-    case IDIOM_3:
-      Idiom3WatchMutexLock(addr);
-      break;
-    case IDIOM_4:
-      Idiom4WatchMutexLock(addr);
-      break;
-    case IDIOM_5:
-      Idiom5WatchMutexLock(addr);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
-  }
+  if (!EnterTarget(target))
+    return;
+
+  (this->*target->ops_->watch_mutex_lock)(addr);
+}
+
+void SchedulerCommon::HandleWatchMutexUnlock(SchedTarget *target,
+                                             address_t addr) {
+  if (!start_schedule_)
+    return;
+
+  if (!EnterTarget(target))
+    return;
+
+  (this->*target->ops_->watch_mutex_unlock)(addr);
+}
+
+void SchedulerCommon::HandleWatchMemRead(Inst *inst, address_t addr, size_t size,
+                                         bool cand) {
+  if (!start_schedule_)
+    return;
+
+  for (size_t i = 0; i < targets_.size(); i++)
+    HandleWatchMemRead(targets_[i], inst, addr, size, cand);
 }
 
-void SchedulerCommon::HandleWatchMutexUnlock(address_t addr) {
+void SchedulerCommon::HandleWatchMemWrite(Inst *inst, address_t addr, size_t size,
+                                          bool cand) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1WatchMutexUnlock(addr);
-      break;
-    case IDIOM_2:
-      Idiom2WatchMutexUnlock(addr);
-      break;
-    case IDIOM_3:
-      Idiom3WatchMutexUnlock(addr);
-      break;
-    case IDIOM_4:
-      Idiom4WatchMutexUnlock(addr);
-      break;
-    case IDIOM_5:
-      Idiom5WatchMutexUnlock(addr);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
-  }
+  for (size_t i = 0; i < targets_.size(); i++)
+    HandleWatchMemWrite(targets_[i], inst, addr, size, cand);
 }
 
-void SchedulerCommon::HandleWatchMemRead(Inst *inst, address_t addr, size_t size,
-                                   bool cand) {
+void SchedulerCommon::HandleWatchMemRead(SchedTarget *target, Inst *inst,
+                                         address_t addr, size_t size,
+                                         bool cand) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1WatchMemRead(inst, addr, size, cand);
-      break;
-    case IDIOM_2:
-      Idiom2WatchMemRead(inst, addr, size, cand);
-      break;
-    case IDIOM_3:
-      Idiom3WatchMemRead(inst, addr, size, cand);
-      break;
-    case IDIOM_4:
-      Idiom4WatchMemRead(inst, addr, size, cand);
-      break;
-    case IDIOM_5:
-      Idiom5WatchMemRead(inst, addr, size, cand);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
-  }
+  if (!EnterTarget(target))
+    return;
+
+  (this->*target->ops_->watch_mem_read)(inst, addr, size, cand);
 }
 
-void SchedulerCommon::HandleWatchMemWrite(Inst *inst, address_t addr, size_t size,
-                                    bool cand) {
+void SchedulerCommon::HandleWatchMemWrite(SchedTarget *target, Inst *inst,
+                                          address_t addr, size_t size,
+                                          bool cand) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1WatchMemWrite(inst, addr, size, cand);
-      break;
-    case IDIOM_2:
-      Idiom2WatchMemWrite(inst, addr, size, cand);
-      break;
-    case IDIOM_3:
-      Idiom3WatchMemWrite(inst, addr, size, cand);
-      break;
-    case IDIOM_4:
-      Idiom4WatchMemWrite(inst, addr, size, cand);
-      break;
-    case IDIOM_5:
-      Idiom5WatchMemWrite(inst, addr, size, cand);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
-  }
+  if (!EnterTarget(target))
+    return;
+
+  (this->*target->ops_->watch_mem_write)(inst, addr, size, cand);
 }
 
 void SchedulerCommon::HandleWatchInstCount(timestamp_t c) {
   if (!start_schedule_)
     return;
 
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Abort("invalid watch inst count\n");
-      break;
-    case IDIOM_2:
-      Idiom2WatchInstCount(c);
-      break;
-    case IDIOM_3:
-      Idiom3WatchInstCount(c);
-      break;
-    case IDIOM_4:
-      Idiom4WatchInstCount(c);
-      break;
-    case IDIOM_5:
-      Idiom5WatchInstCount(c);
-      break;
-    default:
-      Abort("invalid idiom\n");
-      break;
+  for (size_t i = 0; i < targets_.size(); i++) {
+    SchedTarget *target = targets_[i];
+    // idiom1 does not watch inst count (no entry)
+    if (target->ops_->watch_inst_count && EnterTarget(target))
+      (this->*target->ops_->watch_inst_count)(c);
   }
 }
 
 void SchedulerCommon::HandleSchedYield() {
-  switch (curr_iroot_->idiom()) {
-    case IDIOM_1:
-      Idiom1SchedYield();
-      break;
-    case IDIOM_2:
-      // TODO:
-      break;
-    case IDIOM_3:
-      // TODO:
-      break;
-    case IDIOM_4:
-      // TODO:
-      break;
-    case IDIOM_5:
-      // TODO:
-      break;
-    default:
-      Abort("invalid idiom\n");
+  // TODO: handle sched yield for other idioms
+  for (size_t i = 0; i < targets_.size(); i++) {
+    if (targets_[i]->ops_->sched_yield) {
+      (this->*targets_[i]->ops_->sched_yield)();
       break;
+    }
   }
 }
 
-void SchedulerCommon::Idiom1BeforeiRootMemRead(UINT32 idx, address_t addr,
-                                         size_t size) {
-  if (curr_iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_WRITE)
+template <>
+const SchedulerCommon::BeforeEventFunc
+SchedulerCommon::IdiomHandler<IDIOM_1>::kBeforeEvent[] = {
+  &SchedulerCommon::Idiom1BeforeEvent0,
+  &SchedulerCommon::Idiom1BeforeEvent1
+};
+
+template <>
+const SchedulerCommon::AfterEventFunc
+SchedulerCommon::IdiomHandler<IDIOM_1>::kAfterEvent[] = {
+  &SchedulerCommon::Idiom1AfterEvent0,
+  &SchedulerCommon::Idiom1AfterEvent1
+};
+
+template <>
+const SchedulerCommon::WatchAccessFunc
+SchedulerCommon::IdiomHandler<IDIOM_1>::kWatchAccess =
+    &SchedulerCommon::Idiom1WatchAccess;
+
+template <>
+const SchedulerCommon::WatchInstCountFunc
+SchedulerCommon::IdiomHandler<IDIOM_1>::kWatchInstCount =
+    NULL;
+
+template <>
+const SchedulerCommon::SchedYieldFunc
+SchedulerCommon::IdiomHandler<IDIOM_1>::kSchedYield =
+    &SchedulerCommon::Idiom1SchedYield;
+
+template <>
+const SchedulerCommon::BeforeEventFunc
+SchedulerCommon::IdiomHandler<IDIOM_2>::kBeforeEvent[] = {
+  &SchedulerCommon::Idiom2BeforeEvent0,
+  &SchedulerCommon::Idiom2BeforeEvent1,
+  &SchedulerCommon::Idiom2BeforeEvent2
+};
+
+template <>
+const SchedulerCommon::AfterEventFunc
+SchedulerCommon::IdiomHandler<IDIOM_2>::kAfterEvent[] = {
+  &SchedulerCommon::Idiom2AfterEvent0,
+  &SchedulerCommon::Idiom2AfterEvent1,
+  &SchedulerCommon::Idiom2AfterEvent2
+};
+
+template <>
+const SchedulerCommon::WatchAccessFunc
+SchedulerCommon::IdiomHandler<IDIOM_2>::kWatchAccess =
+    &SchedulerCommon::Idiom2WatchAccess;
+
+template <>
+const SchedulerCommon::WatchInstCountFunc
+SchedulerCommon::IdiomHandler<IDIOM_2>::kWatchInstCount =
+    &SchedulerCommon::Idiom2WatchInstCount;
+
+template <>
+const SchedulerCommon::SchedYieldFunc
+SchedulerCommon::IdiomHandler<IDIOM_2>::kSchedYield =
+    NULL;
+
+template <>
+const SchedulerCommon::BeforeEventFunc
+SchedulerCommon::IdiomHandler<IDIOM_3>::kBeforeEvent[] = {
+  &SchedulerCommon::Idiom3BeforeEvent0,
+  &SchedulerCommon::Idiom3BeforeEvent1,
+  &SchedulerCommon::Idiom3BeforeEvent2,
+  &SchedulerCommon::Idiom3BeforeEvent3
+};
+
+template <>
+const SchedulerCommon::AfterEventFunc
+SchedulerCommon::IdiomHandler<IDIOM_3>::kAfterEvent[] = {
+  &SchedulerCommon::Idiom3AfterEvent0,
+  &SchedulerCommon::Idiom3AfterEvent1,
+  &SchedulerCommon::Idiom3AfterEvent2,
+  &SchedulerCommon::Idiom3AfterEvent3
+};
+
+template <>
+const SchedulerCommon::WatchAccessFunc
+SchedulerCommon::IdiomHandler<IDIOM_3>::kWatchAccess =
+    &SchedulerCommon::Idiom3WatchAccess;
+
+template <>
+const SchedulerCommon::WatchInstCountFunc
+SchedulerCommon::IdiomHandler<IDIOM_3>::kWatchInstCount =
+    &SchedulerCommon::Idiom3WatchInstCount;
+
+template <>
+const SchedulerCommon::SchedYieldFunc
+SchedulerCommon::IdiomHandler<IDIOM_3>::kSchedYield =
+    NULL;
+
+template <>
+const SchedulerCommon::BeforeEventFunc
+SchedulerCommon::IdiomHandler<IDIOM_4>::kBeforeEvent[] = {
+  &SchedulerCommon::Idiom4BeforeEvent0,
+  &SchedulerCommon::Idiom4BeforeEvent1,
+  &SchedulerCommon::Idiom4BeforeEvent2,
+  &SchedulerCommon::Idiom4BeforeEvent3
+};
+
+template <>
+const SchedulerCommon::AfterEventFunc
+SchedulerCommon::IdiomHandler<IDIOM_4>::kAfterEvent[] = {
+  &SchedulerCommon::Idiom4AfterEvent0,
+  &SchedulerCommon::Idiom4AfterEvent1,
+  &SchedulerCommon::Idiom4AfterEvent2,
+  &SchedulerCommon::Idiom4AfterEvent3
+};
+
+template <>
+const SchedulerCommon::WatchAccessFunc
+SchedulerCommon::IdiomHandler<IDIOM_4>::kWatchAccess =
+    &SchedulerCommon::Idiom4WatchAccess;
+
+template <>
+const SchedulerCommon::WatchInstCountFunc
+SchedulerCommon::IdiomHandler<IDIOM_4>::kWatchInstCount =
+    &SchedulerCommon::Idiom4WatchInstCount;
+
+template <>
+const SchedulerCommon::SchedYieldFunc
+SchedulerCommon::IdiomHandler<IDIOM_4>::kSchedYield =
+    NULL;
+
+template <>
+const SchedulerCommon::BeforeEventFunc
+SchedulerCommon::IdiomHandler<IDIOM_5>::kBeforeEvent[] = {
+  &SchedulerCommon::Idiom5BeforeEvent0,
+  &SchedulerCommon::Idiom5BeforeEvent1,
+  &SchedulerCommon::Idiom5BeforeEvent2,
+  &SchedulerCommon::Idiom5BeforeEvent3
+};
+
+template <>
+const SchedulerCommon::AfterEventFunc
+SchedulerCommon::IdiomHandler<IDIOM_5>::kAfterEvent[] = {
+  &SchedulerCommon::Idiom5AfterEvent0,
+  &SchedulerCommon::Idiom5AfterEvent1,
+  &SchedulerCommon::Idiom5AfterEvent2,
+  &SchedulerCommon::Idiom5AfterEvent3
+};
+
+template <>
+const SchedulerCommon::WatchAccessFunc
+SchedulerCommon::IdiomHandler<IDIOM_5>::kWatchAccess =
+    &SchedulerCommon::Idiom5WatchAccess;
+
+template <>
+const SchedulerCommon::WatchInstCountFunc
+SchedulerCommon::IdiomHandler<IDIOM_5>::kWatchInstCount =
+    &SchedulerCommon::Idiom5WatchInstCount;
+
+template <>
+const SchedulerCommon::SchedYieldFunc
+SchedulerCommon::IdiomHandler<IDIOM_5>::kSchedYield =
+    NULL;
+
+template <IdiomType IDIOM>
+bool SchedulerCommon::IdiomInvolved(SchedTarget *target,
+                                    thread_id_t thd_id) {
+  return target->sched_status<IDIOM>()->Involved(thd_id);
+}
+
+template <IdiomType IDIOM>
+const IdiomOps *SchedulerCommon::GetIdiomOps() {
+  static const IdiomOps ops = {
+    &SchedulerCommon::IdiomInvolved<IDIOM>,
+    &SchedulerCommon::IdiomWatching<IDIOM>,
+    &SchedulerCommon::IdiomBeforeiRootMemRead<IDIOM>,
+    &SchedulerCommon::IdiomBeforeiRootMemWrite<IDIOM>,
+    &SchedulerCommon::IdiomAfteriRootMem<IDIOM>,
+    &SchedulerCommon::IdiomBeforeiRootMutexLock<IDIOM>,
+    &SchedulerCommon::IdiomAfteriRootMutexLock<IDIOM>,
+    &SchedulerCommon::IdiomBeforeiRootMutexUnlock<IDIOM>,
+    &SchedulerCommon::IdiomAfteriRootMutexUnlock<IDIOM>,
+    &SchedulerCommon::IdiomWatchMutexLock<IDIOM>,
+    &SchedulerCommon::IdiomWatchMutexUnlock<IDIOM>,
+    &SchedulerCommon::IdiomWatchMemRead<IDIOM>,
+    &SchedulerCommon::IdiomWatchMemWrite<IDIOM>,
+    IdiomHandler<IDIOM>::kWatchInstCount,
+    IdiomHandler<IDIOM>::kSchedYield
+  };
+  return &ops;
+}
+
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomBeforeiRootMemRead(UINT32 idx, address_t addr,
+                                              size_t size) {
+  if (CurrTarget()->iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_WRITE)
     return;
 
-  switch (idx) {
-    case 0:
-      Idiom1BeforeEvent0(addr, size);
-      break;
-    case 1:
-      Idiom1BeforeEvent1(addr, size);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
+  if (idx >= (UINT32)IdiomSchedDesc<IDIOM>::kNumEvents)
+    Abort("idx invalid\n");
+  (this->*IdiomHandler<IDIOM>::kBeforeEvent[idx])(addr, size);
 }
 
-void SchedulerCommon::Idiom1BeforeiRootMemWrite(UINT32 idx, address_t addr,
-                                          size_t size) {
-  if (curr_iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_READ)
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomBeforeiRootMemWrite(UINT32 idx, address_t addr,
+                                               size_t size) {
+  if (CurrTarget()->iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_READ)
     return;
 
-  switch (idx) {
-    case 0:
-      Idiom1BeforeEvent0(addr, size);
-      break;
-    case 1:
-      Idiom1BeforeEvent1(addr, size);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
+  if (idx >= (UINT32)IdiomSchedDesc<IDIOM>::kNumEvents)
+    Abort("idx invalid\n");
+  (this->*IdiomHandler<IDIOM>::kBeforeEvent[idx])(addr, size);
 }
 
-void SchedulerCommon::Idiom1AfteriRootMem(UINT32 idx) {
-  switch (idx) {
-    case 0:
-      Idiom1AfterEvent0();
-      break;
-    case 1:
-      Idiom1AfterEvent1();
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomAfteriRootMem(UINT32 idx) {
+  if (idx >= (UINT32)IdiomSchedDesc<IDIOM>::kNumEvents)
+    Abort("idx invalid\n");
+  (this->*IdiomHandler<IDIOM>::kAfterEvent[idx])();
 }
 
-void SchedulerCommon::Idiom1BeforeiRootMutexLock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 1:
-      Idiom1BeforeEvent1(addr, WORD_SIZE);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomBeforeiRootMutexLock(UINT32 idx, address_t addr) {
+  if (idx >= (UINT32)IdiomSchedDesc<IDIOM>::kNumEvents ||
+      !(IdiomSchedDesc<IDIOM>::kMutexLockEvents & IDIOM_EVENT_BIT(idx)))
+    Abort("idx invalid\n");
+  (this->*IdiomHandler<IDIOM>::kBeforeEvent[idx])(addr, WORD_SIZE);
 }
 
-void SchedulerCommon::Idiom1AfteriRootMutexLock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 1:
-      Idiom1AfterEvent1();
-      break;
-    default:
-      Abort("idx invalid\n");
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomAfteriRootMutexLock(UINT32 idx, address_t addr) {
+  if (idx >= (UINT32)IdiomSchedDesc<IDIOM>::kNumEvents ||
+      !(IdiomSchedDesc<IDIOM>::kMutexLockEvents & IDIOM_EVENT_BIT(idx)))
+    Abort("idx invalid\n");
+  (this->*IdiomHandler<IDIOM>::kAfterEvent[idx])();
+}
+
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomBeforeiRootMutexUnlock(UINT32 idx,
+                                                  address_t addr) {
+  if (idx >= (UINT32)IdiomSchedDesc<IDIOM>::kNumEvents ||
+      !(IdiomSchedDesc<IDIOM>::kMutexUnlockEvents & IDIOM_EVENT_BIT(idx)))
+    Abort("idx invalid\n");
+  (this->*IdiomHandler<IDIOM>::kBeforeEvent[idx])(addr, WORD_SIZE);
+}
+
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomAfteriRootMutexUnlock(UINT32 idx,
+                                                 address_t addr) {
+  if (idx >= (UINT32)IdiomSchedDesc<IDIOM>::kNumEvents ||
+      !(IdiomSchedDesc<IDIOM>::kMutexUnlockEvents & IDIOM_EVENT_BIT(idx)))
+    Abort("idx invalid\n");
+  (this->*IdiomHandler<IDIOM>::kAfterEvent[idx])();
+}
+
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomWatchMutexLock(address_t addr) {
+  (this->*IdiomHandler<IDIOM>::kWatchAccess)(addr, WORD_SIZE);
+}
+
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomWatchMutexUnlock(address_t addr) {
+  (this->*IdiomHandler<IDIOM>::kWatchAccess)(addr, WORD_SIZE);
+}
+
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomWatchMemRead(Inst *inst, address_t addr,
+                                        size_t size, bool cand) {
+  (this->*IdiomHandler<IDIOM>::kWatchAccess)(addr, size);
+  if (!cand)
+    IdiomCheckFlush<IDIOM>();
+}
+
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomWatchMemWrite(Inst *inst, address_t addr,
+                                         size_t size, bool cand) {
+  (this->*IdiomHandler<IDIOM>::kWatchAccess)(addr, size);
+  if (!cand)
+    IdiomCheckFlush<IDIOM>();
+}
+
+template <IdiomType IDIOM>
+bool SchedulerCommon::IdiomWatching(SchedTarget *target, bool inst_count) {
+  if (inst_count && !IdiomSchedDesc<IDIOM>::kWatchInstCount)
+    return false;
+  unsigned long state = target->sched_status<IDIOM>()->state_;
+  return (IdiomSchedDesc<IDIOM>::kWatchStates & IDIOM_STATE_BIT(state)) != 0;
+}
+
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomCheckFlush() {
+  unsigned long state = CurrTarget()->sched_status<IDIOM>()->state_;
+
+  // define a static local variable (one for each idiom)
+  static int token = 0;
+
+  if (IdiomSchedDesc<IDIOM>::kFlushStates & IDIOM_STATE_BIT(state)) {
+    if (token-- <= 0) {
+      // other targets may still need the watch instrumentation
+      if (!Watching(false))
+        FlushWatch();
+      token = 10;
+    }
   }
 }
 
-void SchedulerCommon::Idiom1BeforeiRootMutexUnlock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 0:
-      Idiom1BeforeEvent0(addr, WORD_SIZE);
-      break;
-    default:
-      Abort("idx invalid\n");
+template <IdiomType IDIOM>
+bool SchedulerCommon::IdiomCheckGiveup(int idx) {
+  // return true means actual give up
+  // return false means one more chance
+  if (YieldWithDelay()) {
+    IdiomSchedStatus<IDIOM> *s = CurrTarget()->sched_status<IDIOM>();
+    thread_id_t curr_thd_id = PIN_ThreadUid();
+    DEBUG_FMT_PRINT_SAFE("[T%lx] Check giveup\n", curr_thd_id);
+    if (s->time_delayed_each_[idx] <=
+            knob_->ValueInt("yield_delay_min_each") ||
+        s->time_delayed_total_ <=
+            knob_->ValueInt("yield_delay_max_total")) {
+      if (s->state_ != s->last_state_[idx] ||
+          curr_thd_id != s->last_thd_[idx]) {
+        DEBUG_FMT_PRINT_SAFE("[T%lx] time delay\n", curr_thd_id);
+        int time_unit = knob_->ValueInt("yield_delay_unit");
+        s->last_state_[idx] = s->state_;
+        s->last_thd_[idx] = curr_thd_id;
+        int time_delayed = HandoffWait(time_unit);
+        s->time_delayed_each_[idx] += time_delayed;
+        s->time_delayed_total_ += time_delayed;
+        return false;
+      } else {
+        return true;
+      }
+    } else {
+      return true;
+    }
+  } else {
+    return true;
   }
 }
 
-void SchedulerCommon::Idiom1AfteriRootMutexUnlock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 0:
-      Idiom1AfterEvent0();
-      break;
-    default:
-      Abort("idx invalid\n");
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomSetState(unsigned long s) {
+  DEBUG_FMT_PRINT_SAFE("[T%lx] set state: %s\n", PIN_ThreadUid(),
+                       IdiomSchedStatus<IDIOM>::StateToString(s));
+  CurrTarget()->sched_status<IDIOM>()->state_ = s;
+  HandoffNotify(CurrTarget());
+}
+
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomRecordEvent(int idx, thread_id_t thd_id,
+                                       address_t addr, size_t size) {
+  IdiomSchedStatus<IDIOM> *s = CurrTarget()->sched_status<IDIOM>();
+  s->thd_id_[idx] = thd_id;
+  s->addr_[idx] = addr;
+  s->size_[idx] = size;
+}
+
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomClearDelaySet(DelaySet *copy) {
+  IdiomSchedStatus<IDIOM> *s = CurrTarget()->sched_status<IDIOM>();
+  *copy = s->delay_set_;
+  s->delay_set_.clear();
+}
+
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomWakeDelaySet(DelaySet *copy) {
+  thread_id_t curr_thd_id = PIN_ThreadUid();
+  if (IdiomSchedDesc<IDIOM>::kWakeMaxPriority)
+    SetPriorityMax(curr_thd_id);
+  else
+    SetPriorityHigh(curr_thd_id);
+  for (DelaySet::iterator it = copy->begin(); it != copy->end(); ++it) {
+    if (*it != curr_thd_id)
+      SetPriorityNormal(*it);
   }
 }
 
+template <IdiomType IDIOM>
+void SchedulerCommon::IdiomSetStateAndWake(unsigned long s) {
+  // called with the sched status locked, which is released before the
+  // delayed threads are woken up
+  DelaySet copy;
+  IdiomClearDelaySet<IDIOM>(&copy);
+  IdiomSetState<IDIOM>(s);
+  UnlockSchedStatus();
+  IdiomWakeDelaySet<IDIOM>(&copy);
+}
+
 void SchedulerCommon::Idiom1BeforeEvent0(address_t addr, size_t size) {
-  Idiom1SchedStatus *s = idiom1_sched_status_;
+  Idiom1SchedStatus *s = CurrTarget()->idiom1_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event0", 1);
@@ -1568,10 +1739,8 @@ void SchedulerCommon::Idiom1BeforeEvent0(address_t addr, size_t size) {
     LockSchedStatus();
     switch (s->state_) {
       case IDIOM1_STATE_INIT:
-        s->thd_id_[0] = curr_thd_id;
-        s->addr_[0] = addr;
-        s->size_[0] = size;
-        Idiom1SetState(IDIOM1_STATE_E0);
+        IdiomRecordEvent<IDIOM_1>(0, curr_thd_id, addr, size);
+        IdiomSetState<IDIOM_1>(IDIOM1_STATE_E0);
         UnlockSchedStatus();
         SetPriorityLow(curr_thd_id);
         restart = true;
@@ -1580,7 +1749,7 @@ void SchedulerCommon::Idiom1BeforeEvent0(address_t addr, size_t size) {
         DEBUG_ASSERT(s->thd_id_[0] != INVALID_THD_ID);
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
-          Idiom1SetState(IDIOM1_STATE_E0_WATCH_X);
+          IdiomSetState<IDIOM_1>(IDIOM1_STATE_E0_WATCH_X);
           UnlockSchedStatus();
           SetPriorityHigh(curr_thd_id);
           // force to execute event 0 first
@@ -1589,9 +1758,7 @@ void SchedulerCommon::Idiom1BeforeEvent0(address_t addr, size_t size) {
           // random choice (has to use random choice to avoid livelock)
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
+            IdiomRecordEvent<IDIOM_1>(0, curr_thd_id, addr, size);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -1608,10 +1775,8 @@ void SchedulerCommon::Idiom1BeforeEvent0(address_t addr, size_t size) {
         // check conflict
         if (OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
           thread_id_t target = s->thd_id_[1];
-          s->thd_id_[0] = curr_thd_id;
-          s->addr_[0] = addr;
-          s->size_[0] = size;
-          Idiom1SetState(IDIOM1_STATE_E0_E1);
+          IdiomRecordEvent<IDIOM_1>(0, curr_thd_id, addr, size);
+          IdiomSetState<IDIOM_1>(IDIOM1_STATE_E0_E1);
           UnlockSchedStatus();
           // force to execute event 0
           SetPriorityHigh(curr_thd_id);
@@ -1620,10 +1785,8 @@ void SchedulerCommon::Idiom1BeforeEvent0(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom1SetState(IDIOM1_STATE_E0);
+            IdiomRecordEvent<IDIOM_1>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_1>(IDIOM1_STATE_E0);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -1640,15 +1803,9 @@ void SchedulerCommon::Idiom1BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // cannot be delayed any more
-            if (Idiom1CheckGiveup(0)) {
-              DelaySet copy;
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom1ClearDelaySet(&copy);
-              Idiom1SetState(IDIOM1_STATE_E0);
-              UnlockSchedStatus();
-              Idiom1WakeDelaySet(&copy);
+            if (IdiomCheckGiveup<IDIOM_1>(0)) {
+              IdiomRecordEvent<IDIOM_1>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_1>(IDIOM1_STATE_E0);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -1658,14 +1815,8 @@ void SchedulerCommon::Idiom1BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom1ClearDelaySet(&copy);
-              Idiom1SetState(IDIOM1_STATE_E0);
-              UnlockSchedStatus();
-              Idiom1WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_1>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_1>(IDIOM1_STATE_E0);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -1676,16 +1827,10 @@ void SchedulerCommon::Idiom1BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom1CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_1>(0)) {
                 thread_id_t target = s->thd_id_[0];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom1ClearDelaySet(&copy);
-                Idiom1SetState(IDIOM1_STATE_E0);
-                UnlockSchedStatus();
-                Idiom1WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_1>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_1>(IDIOM1_STATE_E0);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
@@ -1702,15 +1847,9 @@ void SchedulerCommon::Idiom1BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom1ClearDelaySet(&copy);
-              Idiom1SetState(IDIOM1_STATE_E0);
-              UnlockSchedStatus();
-              Idiom1WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_1>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_1>(IDIOM1_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -1731,7 +1870,7 @@ void SchedulerCommon::Idiom1BeforeEvent0(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom1BeforeEvent1(address_t addr, size_t size) {
-  Idiom1SchedStatus *s = idiom1_sched_status_;
+  Idiom1SchedStatus *s = CurrTarget()->idiom1_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event1", 1);
@@ -1744,10 +1883,8 @@ void SchedulerCommon::Idiom1BeforeEvent1(address_t addr, size_t size) {
     LockSchedStatus();
     switch (s->state_) {
       case IDIOM1_STATE_INIT:
-        s->thd_id_[1] = curr_thd_id;
-        s->addr_[1] = addr;
-        s->size_[1] = size;
-        Idiom1SetState(IDIOM1_STATE_E1);
+        IdiomRecordEvent<IDIOM_1>(1, curr_thd_id, addr, size);
+        IdiomSetState<IDIOM_1>(IDIOM1_STATE_E1);
         UnlockSchedStatus();
         SetPriorityLow(curr_thd_id);
         restart = true;
@@ -1758,10 +1895,8 @@ void SchedulerCommon::Idiom1BeforeEvent1(address_t addr, size_t size) {
         // check conflict
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           thread_id_t target = s->thd_id_[0];
-          s->thd_id_[1] = curr_thd_id;
-          s->addr_[1] = addr;
-          s->size_[1] = size;
-          Idiom1SetState(IDIOM1_STATE_E0_E1);
+          IdiomRecordEvent<IDIOM_1>(1, curr_thd_id, addr, size);
+          IdiomSetState<IDIOM_1>(IDIOM1_STATE_E0_E1);
           UnlockSchedStatus();
           // force to execute event 0 first
           SetPriorityHigh(target);
@@ -1769,10 +1904,8 @@ void SchedulerCommon::Idiom1BeforeEvent1(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom1SetState(IDIOM1_STATE_E1);
+            IdiomRecordEvent<IDIOM_1>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_1>(IDIOM1_STATE_E1);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -1787,9 +1920,9 @@ void SchedulerCommon::Idiom1BeforeEvent1(address_t addr, size_t size) {
         DEBUG_ASSERT(s->thd_id_[1] != INVALID_THD_ID);
         if (curr_thd_id == s->thd_id_[1]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
-          if (Idiom1CheckGiveup(1)) {
+          if (IdiomCheckGiveup<IDIOM_1>(1)) {
             // has to go back to initial state
-            Idiom1SetState(IDIOM1_STATE_INIT);
+            IdiomSetState<IDIOM_1>(IDIOM1_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityNormal(curr_thd_id);
           } else {
@@ -1800,9 +1933,7 @@ void SchedulerCommon::Idiom1BeforeEvent1(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
+            IdiomRecordEvent<IDIOM_1>(1, curr_thd_id, addr, size);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -1819,15 +1950,9 @@ void SchedulerCommon::Idiom1BeforeEvent1(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // cannot be delayed any more
-            if (Idiom1CheckGiveup(1)) {
-              DelaySet copy;
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom1ClearDelaySet(&copy);
-              Idiom1SetState(IDIOM1_STATE_E1);
-              UnlockSchedStatus();
-              Idiom1WakeDelaySet(&copy);
+            if (IdiomCheckGiveup<IDIOM_1>(1)) {
+              IdiomRecordEvent<IDIOM_1>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_1>(IDIOM1_STATE_E1);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -1837,14 +1962,8 @@ void SchedulerCommon::Idiom1BeforeEvent1(address_t addr, size_t size) {
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom1ClearDelaySet(&copy);
-              Idiom1SetState(IDIOM1_STATE_E1);
-              UnlockSchedStatus();
-              Idiom1WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_1>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_1>(IDIOM1_STATE_E1);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -1853,28 +1972,16 @@ void SchedulerCommon::Idiom1BeforeEvent1(address_t addr, size_t size) {
           }
         } else {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom1ClearDelaySet(&copy);
-            Idiom1SetState(IDIOM1_STATE_E0_E1);
-            UnlockSchedStatus();
-            Idiom1WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_1>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_1>(IDIOM1_STATE_E0_E1);
             SetPriorityNormal(target);
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom1ClearDelaySet(&copy);
-              Idiom1SetState(IDIOM1_STATE_E1);
-              UnlockSchedStatus();
-              Idiom1WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_1>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_1>(IDIOM1_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -1895,7 +2002,7 @@ void SchedulerCommon::Idiom1BeforeEvent1(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom1AfterEvent0() {
-  Idiom1SchedStatus *s = idiom1_sched_status_;
+  Idiom1SchedStatus *s = CurrTarget()->idiom1_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] post event 0\n", curr_thd_id);
@@ -1904,7 +2011,7 @@ void SchedulerCommon::Idiom1AfterEvent0() {
   switch (s->state_) {
     case IDIOM1_STATE_E0_WATCH_X:
       if (curr_thd_id == s->thd_id_[0]) {
-        Idiom1SetState(IDIOM1_STATE_E0_WATCH);
+        IdiomSetState<IDIOM_1>(IDIOM1_STATE_E0_WATCH);
         UnlockSchedStatus();
         FlushWatch();
         SetPriorityLow(curr_thd_id);
@@ -1930,7 +2037,7 @@ void SchedulerCommon::Idiom1AfterEvent0() {
 }
 
 void SchedulerCommon::Idiom1AfterEvent1() {
-  Idiom1SchedStatus *s = idiom1_sched_status_;
+  Idiom1SchedStatus *s = CurrTarget()->idiom1_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] post event 1\n", curr_thd_id);
@@ -1941,8 +2048,8 @@ void SchedulerCommon::Idiom1AfterEvent1() {
       if (curr_thd_id == s->thd_id_[1]) {
         ActivelyExposed();
         DEBUG_FMT_PRINT_SAFE("[T%lx] iRoot %u exposed.\n",
-                             curr_thd_id, curr_iroot_->id());
-        Idiom1SetState(IDIOM1_STATE_DONE);
+                             curr_thd_id, CurrTarget()->iroot_->id());
+        IdiomSetState<IDIOM_1>(IDIOM1_STATE_DONE);
         UnlockSchedStatus();
         //SetPriorityNormal(curr_thd_id);
       } else {
@@ -1956,7 +2063,7 @@ void SchedulerCommon::Idiom1AfterEvent1() {
 }
 
 void SchedulerCommon::Idiom1WatchAccess(address_t addr, size_t size) {
-  Idiom1SchedStatus *s = idiom1_sched_status_;
+  Idiom1SchedStatus *s = CurrTarget()->idiom1_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("watch_access", 1);
@@ -1973,13 +2080,9 @@ void SchedulerCommon::Idiom1WatchAccess(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // cannot be delayed any more
-            if (Idiom1CheckGiveup(2)) {
+            if (IdiomCheckGiveup<IDIOM_1>(2)) {
               DEBUG_FMT_PRINT_SAFE("[T%lx] watch access give up\n", curr_thd_id);
-              DelaySet copy;
-              Idiom1ClearDelaySet(&copy);
-              Idiom1SetState(IDIOM1_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom1WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_1>(IDIOM1_STATE_INIT);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
@@ -1993,14 +2096,10 @@ void SchedulerCommon::Idiom1WatchAccess(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom1CheckGiveup(2)) {
+              if (IdiomCheckGiveup<IDIOM_1>(2)) {
                 DEBUG_FMT_PRINT_SAFE("[T%lx] watch access give up\n", curr_thd_id);
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[0];
-                Idiom1ClearDelaySet(&copy);
-                Idiom1SetState(IDIOM1_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom1WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_1>(IDIOM1_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -2022,196 +2121,21 @@ void SchedulerCommon::Idiom1WatchAccess(address_t addr, size_t size) {
       default:
         UnlockSchedStatus();
         break;
-    } // end of switch
-
-    if (!restart)
-      break;
-  } // end of while
-}
-
-void SchedulerCommon::Idiom1WatchMutexLock(address_t addr) {
-  Idiom1WatchAccess(addr, WORD_SIZE);
-}
-
-void SchedulerCommon::Idiom1WatchMutexUnlock(address_t addr) {
-  Idiom1WatchAccess(addr, WORD_SIZE);
-}
-
-void SchedulerCommon::Idiom1WatchMemRead(Inst *inst, address_t addr, size_t size,
-                                   bool cand) {
-  Idiom1WatchAccess(addr, size);
-  if (!cand)
-    Idiom1CheckFlush();
-}
-
-void SchedulerCommon::Idiom1WatchMemWrite(Inst *inst, address_t addr, size_t size,
-                                    bool cand) {
-  Idiom1WatchAccess(addr, size);
-  if (!cand)
-    Idiom1CheckFlush();
-}
-
-void SchedulerCommon::Idiom1SchedYield() {
-  thread_id_t curr_thd_id = PIN_ThreadUid();
-  DEBUG_FMT_PRINT_SAFE("[T%lx] sched yield\n", curr_thd_id);
-  SetPriorityMin(curr_thd_id);
-}
-
-void SchedulerCommon::Idiom1CheckFlush() {
-  Idiom1SchedStatus *s = idiom1_sched_status_;
-
-  // define a static local variable
-  static int token = 0;
-
-  switch (s->state_) {
-    case IDIOM1_STATE_INIT:
-    case IDIOM1_STATE_E0:
-    case IDIOM1_STATE_E1:
-    case IDIOM1_STATE_DONE:
-      if (token-- <= 0) {
-        FlushWatch();
-        token = 10;
-      }
-      break;
-    default:
-      break;
-  }
-}
-
-bool SchedulerCommon::Idiom1CheckGiveup(int idx) {
-  // return true means actual give up
-  // return false means one more chance
-  if (YieldWithDelay()) {
-    Idiom1SchedStatus *s = idiom1_sched_status_;
-    thread_id_t curr_thd_id = PIN_ThreadUid();
-    DEBUG_FMT_PRINT_SAFE("[T%lx] Check giveup\n", curr_thd_id);
-    static unsigned long last_state[] = {IDIOM1_STATE_INVALID,
-                                         IDIOM1_STATE_INVALID,
-                                         IDIOM1_STATE_INVALID};
-    static thread_id_t last_thd[] = {INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID};
-    static int time_delayed_each[] = {0, 0, 0};
-    static int time_delayed_total = 0;
-    if (time_delayed_each[idx] <= knob_->ValueInt("yield_delay_min_each") ||
-        time_delayed_total <= knob_->ValueInt("yield_delay_max_total")) {
-      if (s->state_ != last_state[idx] || curr_thd_id != last_thd[idx]) {
-        DEBUG_FMT_PRINT_SAFE("[T%lx] time delay\n", curr_thd_id);
-        int time_unit = knob_->ValueInt("yield_delay_unit");
-        last_state[idx] = s->state_;
-        last_thd[idx] = curr_thd_id;
-        time_delayed_each[idx] += time_unit;
-        time_delayed_total += time_unit;
-        UnlockSchedStatus();
-        DEBUG_STAT_INC("delay", 1);
-        usleep(1000 * time_unit);
-        LockSchedStatus();
-        return false;
-      } else {
-        return true;
-      }
-    } else {
-      return true;
-    }
-  } else {
-    return true;
-  }
-}
-
-void SchedulerCommon::Idiom1SetState(unsigned long s) {
-  DEBUG_FMT_PRINT_SAFE("[T%lx] set state: %s\n", PIN_ThreadUid(),
-                       Idiom1SchedStatus::StateToString(s).c_str());
-  idiom1_sched_status_->state_ = s;
-}
-
-void SchedulerCommon::Idiom1ClearDelaySet(DelaySet *copy) {
-  *copy = idiom1_sched_status_->delay_set_;
-  idiom1_sched_status_->delay_set_.clear();
-}
-
-void SchedulerCommon::Idiom1WakeDelaySet(DelaySet *copy) {
-  thread_id_t curr_thd_id = PIN_ThreadUid();
-  SetPriorityHigh(curr_thd_id);
-  for (DelaySet::iterator it = copy->begin(); it != copy->end(); ++it) {
-    if (*it != curr_thd_id)
-      SetPriorityNormal(*it);
-  }
-}
-
-void SchedulerCommon::Idiom2BeforeiRootMemRead(UINT32 idx, address_t addr,
-                                         size_t size) {
-  if (curr_iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_WRITE)
-    return;
-
-  switch (idx) {
-    case 0:
-      Idiom2BeforeEvent0(addr, size);
-      break;
-    case 1:
-      Idiom2BeforeEvent1(addr, size);
-      break;
-    case 2:
-      Idiom2BeforeEvent2(addr, size);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom2BeforeiRootMemWrite(UINT32 idx, address_t addr,
-                                          size_t size) {
-  if (curr_iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_READ)
-    return;
-
-  switch (idx) {
-    case 0:
-      Idiom2BeforeEvent0(addr, size);
-      break;
-    case 1:
-      Idiom2BeforeEvent1(addr, size);
-      break;
-    case 2:
-      Idiom2BeforeEvent2(addr, size);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
+    } // end of switch
 
-void SchedulerCommon::Idiom2AfteriRootMem(UINT32 idx) {
-  switch (idx) {
-    case 0:
-      Idiom2AfterEvent0();
-      break;
-    case 1:
-      Idiom2AfterEvent1();
-      break;
-    case 2:
-      Idiom2AfterEvent2();
+    if (!restart)
       break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom2BeforeiRootMutexLock(UINT32 idx, address_t addr) {
-  Abort("invalid event\n");
-}
-
-void SchedulerCommon::Idiom2AfteriRootMutexLock(UINT32 idx, address_t addr) {
-  Abort("invalid event\n");
-}
-
-void SchedulerCommon::Idiom2BeforeiRootMutexUnlock(UINT32 idx, address_t addr) {
-  Abort("invalid event\n");
+  } // end of while
 }
 
-void SchedulerCommon::Idiom2AfteriRootMutexUnlock(UINT32 idx, address_t addr) {
-  Abort("invalid event\n");
+void SchedulerCommon::Idiom1SchedYield() {
+  thread_id_t curr_thd_id = PIN_ThreadUid();
+  DEBUG_FMT_PRINT_SAFE("[T%lx] sched yield\n", curr_thd_id);
+  SetPriorityMin(curr_thd_id);
 }
 
 void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
-  Idiom2SchedStatus *s = idiom2_sched_status_;
+  Idiom2SchedStatus *s = CurrTarget()->idiom2_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event0", 1);
@@ -2224,10 +2148,8 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
     LockSchedStatus();
     switch (s->state_) {
       case IDIOM2_STATE_INIT:
-        s->thd_id_[0] = curr_thd_id;
-        s->addr_[0] = addr;
-        s->size_[0] = size;
-        Idiom2SetState(IDIOM2_STATE_E0);
+        IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+        IdiomSetState<IDIOM_2>(IDIOM2_STATE_E0);
         UnlockSchedStatus();
         SetPriorityLow(curr_thd_id);
         restart = true;
@@ -2237,16 +2159,14 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           // has to execute event 0, go to watch mode
-          Idiom2SetState(IDIOM2_STATE_E0_WATCH_X);
+          IdiomSetState<IDIOM_2>(IDIOM2_STATE_E0_WATCH_X);
           UnlockSchedStatus();
           SetPriorityHigh(curr_thd_id);
         } else {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
+            IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -2262,10 +2182,8 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
         DEBUG_ASSERT(curr_thd_id != s->thd_id_[1]);
         // check conflict
         if (OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
-          s->thd_id_[0] = curr_thd_id;
-          s->addr_[0] = addr;
-          s->size_[0] = size;
-          Idiom2SetState(IDIOM2_STATE_E0_E1);
+          IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+          IdiomSetState<IDIOM_2>(IDIOM2_STATE_E0_E1);
           UnlockSchedStatus();
           // force to execute event 0 first, thd_[1] remains low priority
           SetPriorityHigh(curr_thd_id);
@@ -2273,10 +2191,8 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom2SetState(IDIOM2_STATE_E0);
+            IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_2>(IDIOM2_STATE_E0);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -2293,27 +2209,15 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay because event 2 will not be hit
-            DelaySet copy;
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_E0);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E0);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -2324,16 +2228,10 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom2CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_2>(0)) {
                 thread_id_t target = s->thd_id_[0];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom2ClearDelaySet(&copy);
-                Idiom2SetState(IDIOM2_STATE_E0);
-                UnlockSchedStatus();
-                Idiom2WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
@@ -2350,15 +2248,9 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E0);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -2378,29 +2270,17 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 2 will not be hit
-            DelaySet copy;
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_E0_E1);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0_E1);
             // force to execute event 0
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               // TODO: here, one problem is that there is no way to tell
               // thd_[1] to ignore the event 1 (need a flag?)
-              DelaySet copy;
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E0);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -2422,31 +2302,19 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
               SetPriorityMin(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E0_E1);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0_E1);
               SetPriorityNormal(target);
               // force to execute event 0 (curr_thd)
             }
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target1 = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E0);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
               SetPriorityNormal(target0);
               SetPriorityNormal(target1);
               SetPriorityLow(curr_thd_id);
@@ -2466,30 +2334,18 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 2 will not be reached
-            DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_E0);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E0);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -2502,16 +2358,10 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // cannot be delayed anymore
-            if (Idiom2CheckGiveup(0)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_2>(0)) {
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E0);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -2522,15 +2372,9 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E0);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -2543,17 +2387,11 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom2CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_2>(0)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom2ClearDelaySet(&copy);
-                Idiom2SetState(IDIOM2_STATE_E0);
-                UnlockSchedStatus();
-                Idiom2WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target1);
                 SetPriorityLow(curr_thd_id);
@@ -2571,16 +2409,10 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target1 = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E0);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0);
               SetPriorityNormal(target0);
               SetPriorityNormal(target1);
               SetPriorityLow(curr_thd_id);
@@ -2602,7 +2434,7 @@ void SchedulerCommon::Idiom2BeforeEvent0(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
-  Idiom2SchedStatus *s = idiom2_sched_status_;
+  Idiom2SchedStatus *s = CurrTarget()->idiom2_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event1", 1);
@@ -2615,10 +2447,8 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
     LockSchedStatus();
     switch (s->state_) {
       case IDIOM2_STATE_INIT:
-        s->thd_id_[1] = curr_thd_id;
-        s->addr_[1] = addr;
-        s->size_[1] = size;
-        Idiom2SetState(IDIOM2_STATE_E1);
+        IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+        IdiomSetState<IDIOM_2>(IDIOM2_STATE_E1);
         UnlockSchedStatus();
         SetPriorityLow(curr_thd_id);
         restart = true;
@@ -2628,10 +2458,8 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
         // check conflict
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           thread_id_t target = s->thd_id_[0];
-          s->thd_id_[1] = curr_thd_id;
-          s->addr_[1] = addr;
-          s->size_[1] = size;
-          Idiom2SetState(IDIOM2_STATE_E0_E1);
+          IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+          IdiomSetState<IDIOM_2>(IDIOM2_STATE_E0_E1);
           UnlockSchedStatus();
           // force to execute event 0 first
           SetPriorityMax(curr_thd_id);
@@ -2642,10 +2470,8 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom2SetState(IDIOM2_STATE_E1);
+            IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_2>(IDIOM2_STATE_E1);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -2660,9 +2486,9 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
         DEBUG_ASSERT(s->thd_id_[1] != INVALID_THD_ID);
         if (curr_thd_id == s->thd_id_[1]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
-          if (Idiom2CheckGiveup(1)) {
+          if (IdiomCheckGiveup<IDIOM_2>(1)) {
             // has to go back to initial state
-            Idiom2SetState(IDIOM2_STATE_INIT);
+            IdiomSetState<IDIOM_2>(IDIOM2_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityNormal(curr_thd_id);
           } else {
@@ -2673,9 +2499,7 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
+            IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -2692,27 +2516,15 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay because event 2 will not be hit
-            DelaySet copy;
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_E1);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E1);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -2723,15 +2535,9 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             DEBUG_ASSERT(GetPriority(curr_thd_id) != LowerPriority());
             // the dependency e0->e1 is satisfied
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_E0_E1_WATCH);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0_E1_WATCH);
             // prioritize the thread that executed event 0, delay curr thd
             SetPriorityMax(curr_thd_id);
             SetPriorityHigh(target);
@@ -2740,15 +2546,9 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E1);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -2767,30 +2567,18 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 2 will not be hit
-            DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_E1);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E1);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -2800,10 +2588,7 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           }
         } else if (curr_thd_id == s->thd_id_[1]) {
           DelaySet copy;
-          Idiom2ClearDelaySet(&copy);
-          Idiom2SetState(IDIOM2_STATE_E1_WATCH_X);
-          UnlockSchedStatus();
-          Idiom2WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1_WATCH_X);
         } else {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
@@ -2820,12 +2605,10 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
             } else {
               DelaySet copy;
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom2ClearDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+              IdiomClearDelaySet<IDIOM_2>(&copy);
               UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomWakeDelaySet<IDIOM_2>(&copy);
               SetPriorityMin(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -2833,16 +2616,10 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target1 = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E1);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
               SetPriorityNormal(target0);
               SetPriorityNormal(target1);
               SetPriorityLow(curr_thd_id);
@@ -2862,30 +2639,18 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 2 will not be reached
-            DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_E1);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E1);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -2898,16 +2663,10 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // cannot be delayed any more
-            if (Idiom2CheckGiveup(1)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_2>(1)) {
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E1);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -2918,15 +2677,9 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E1);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -2939,17 +2692,11 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom2CheckGiveup(1)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_2>(1)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                s->thd_id_[1] = curr_thd_id;
-                s->addr_[1] = addr;
-                s->size_[1] = size;
-                Idiom2ClearDelaySet(&copy);
-                Idiom2SetState(IDIOM2_STATE_E1);
-                UnlockSchedStatus();
-                Idiom2WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target1);
                 SetPriorityLow(curr_thd_id);
@@ -2967,16 +2714,10 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target1 = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_E1);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_2>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
               SetPriorityNormal(target0);
               SetPriorityNormal(target1);
               SetPriorityLow(curr_thd_id);
@@ -2998,7 +2739,7 @@ void SchedulerCommon::Idiom2BeforeEvent1(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom2BeforeEvent2(address_t addr, size_t size) {
-  Idiom2SchedStatus *s = idiom2_sched_status_;
+  Idiom2SchedStatus *s = CurrTarget()->idiom2_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event2", 1);
@@ -3016,12 +2757,8 @@ void SchedulerCommon::Idiom2BeforeEvent2(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // cannot be delayed any more
-            if (Idiom2CheckGiveup(2)) {
-              DelaySet copy;
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+            if (IdiomCheckGiveup<IDIOM_2>(2)) {
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_INIT);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
@@ -3035,13 +2772,9 @@ void SchedulerCommon::Idiom2BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom2CheckGiveup(2)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_2>(2)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom2ClearDelaySet(&copy);
-                Idiom2SetState(IDIOM2_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom2WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -3069,15 +2802,9 @@ void SchedulerCommon::Idiom2BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // idiom-2 iroot is satisfied
-            DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_E0_E1_E2);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_2>(2, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0_E1_E2);
             SetPriorityMax(curr_thd_id);
             SetPriorityHigh(target);
             SetPriorityNormal(curr_thd_id);
@@ -3106,15 +2833,9 @@ void SchedulerCommon::Idiom2BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // idiom-2 iroot is satisfied
-            DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_E0_E1_E2);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_2>(2, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E0_E1_E2);
             SetPriorityNormal(target);
           } else {
             UnlockSchedStatus();
@@ -3124,13 +2845,9 @@ void SchedulerCommon::Idiom2BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // cannot be delayed any more
-            if (Idiom2CheckGiveup(2)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_2>(2)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -3146,14 +2863,10 @@ void SchedulerCommon::Idiom2BeforeEvent2(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom2CheckGiveup(2)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_2>(2)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom2ClearDelaySet(&copy);
-                Idiom2SetState(IDIOM2_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom2WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_INIT);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -3184,7 +2897,7 @@ void SchedulerCommon::Idiom2BeforeEvent2(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom2AfterEvent0() {
-  Idiom2SchedStatus *s = idiom2_sched_status_;
+  Idiom2SchedStatus *s = CurrTarget()->idiom2_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 0\n", curr_thd_id);
@@ -3194,7 +2907,7 @@ void SchedulerCommon::Idiom2AfterEvent0() {
     case IDIOM2_STATE_E0_E1:
       if (curr_thd_id == s->thd_id_[0]) {
         s->window_ = 0;
-        Idiom2SetState(IDIOM2_STATE_E0_E1_WATCH);
+        IdiomSetState<IDIOM_2>(IDIOM2_STATE_E0_E1_WATCH);
         UnlockSchedStatus();
         SetPriorityHigh(curr_thd_id);
         FlushWatch();
@@ -3205,7 +2918,7 @@ void SchedulerCommon::Idiom2AfterEvent0() {
     case IDIOM2_STATE_E0_WATCH_X:
       if (curr_thd_id == s->thd_id_[0]) {
         s->window_ = 0;
-        Idiom2SetState(IDIOM2_STATE_E0_WATCH);
+        IdiomSetState<IDIOM_2>(IDIOM2_STATE_E0_WATCH);
         UnlockSchedStatus();
         FlushWatch();
         SetPriorityLow(curr_thd_id);
@@ -3220,7 +2933,7 @@ void SchedulerCommon::Idiom2AfterEvent0() {
 }
 
 void SchedulerCommon::Idiom2AfterEvent1() {
-  Idiom2SchedStatus *s = idiom2_sched_status_;
+  Idiom2SchedStatus *s = CurrTarget()->idiom2_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 1\n", curr_thd_id);
@@ -3229,7 +2942,7 @@ void SchedulerCommon::Idiom2AfterEvent1() {
   switch (s->state_) {
     case IDIOM2_STATE_E1_WATCH_X:
       if (curr_thd_id == s->thd_id_[1]) {
-        Idiom2SetState(IDIOM2_STATE_E1_WATCH);
+        IdiomSetState<IDIOM_2>(IDIOM2_STATE_E1_WATCH);
         UnlockSchedStatus();
         SetPriorityLow(curr_thd_id);
       } else {
@@ -3254,7 +2967,7 @@ void SchedulerCommon::Idiom2AfterEvent1() {
 }
 
 void SchedulerCommon::Idiom2AfterEvent2() {
-  Idiom2SchedStatus *s = idiom2_sched_status_;
+  Idiom2SchedStatus *s = CurrTarget()->idiom2_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 2\n", curr_thd_id);
@@ -3265,8 +2978,8 @@ void SchedulerCommon::Idiom2AfterEvent2() {
       if (curr_thd_id == s->thd_id_[2]) {
         ActivelyExposed();
         DEBUG_FMT_PRINT_SAFE("[T%lx] iRoot %u exposed.\n",
-                             curr_thd_id, curr_iroot_->id());
-        Idiom2SetState(IDIOM2_STATE_DONE);
+                             curr_thd_id, CurrTarget()->iroot_->id());
+        IdiomSetState<IDIOM_2>(IDIOM2_STATE_DONE);
         UnlockSchedStatus();
         SetPriorityNormal(curr_thd_id);
       } else {
@@ -3280,7 +2993,7 @@ void SchedulerCommon::Idiom2AfterEvent2() {
 }
 
 void SchedulerCommon::Idiom2WatchAccess(address_t addr, size_t size) {
-  Idiom2SchedStatus *s = idiom2_sched_status_;
+  Idiom2SchedStatus *s = CurrTarget()->idiom2_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("watch_access", 1);
@@ -3297,11 +3010,7 @@ void SchedulerCommon::Idiom2WatchAccess(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -3311,13 +3020,9 @@ void SchedulerCommon::Idiom2WatchAccess(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom2CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_2>(3)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom2ClearDelaySet(&copy);
-                Idiom2SetState(IDIOM2_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom2WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -3345,11 +3050,7 @@ void SchedulerCommon::Idiom2WatchAccess(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay
-            DelaySet copy;
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_E1);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -3378,12 +3079,8 @@ void SchedulerCommon::Idiom2WatchAccess(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            Idiom2ClearDelaySet(&copy);
-            Idiom2SetState(IDIOM2_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom2WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_INIT);
             SetPriorityNormal(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -3395,13 +3092,9 @@ void SchedulerCommon::Idiom2WatchAccess(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // cannot be delayed any more
-            if (Idiom2CheckGiveup(3)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_2>(3)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom2ClearDelaySet(&copy);
-              Idiom2SetState(IDIOM2_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom2WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -3417,14 +3110,10 @@ void SchedulerCommon::Idiom2WatchAccess(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot by delayed any more
-              if (Idiom2CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_2>(3)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom2ClearDelaySet(&copy);
-                Idiom2SetState(IDIOM2_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom2WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_INIT);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -3455,7 +3144,7 @@ void SchedulerCommon::Idiom2WatchAccess(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom2WatchInstCount(timestamp_t c) {
-  Idiom2SchedStatus *s = idiom2_sched_status_;
+  Idiom2SchedStatus *s = CurrTarget()->idiom2_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   LockSchedStatus();
@@ -3466,11 +3155,7 @@ void SchedulerCommon::Idiom2WatchInstCount(timestamp_t c) {
         if (s->window_ >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
-          Idiom2ClearDelaySet(&copy);
-          Idiom2SetState(IDIOM2_STATE_INIT);
-          UnlockSchedStatus();
-          Idiom2WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_INIT);
           SetPriorityNormal(curr_thd_id);
         } else {
           UnlockSchedStatus();
@@ -3485,11 +3170,7 @@ void SchedulerCommon::Idiom2WatchInstCount(timestamp_t c) {
         if (s->window_ >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
-          Idiom2ClearDelaySet(&copy);
-          Idiom2SetState(IDIOM2_STATE_E1);
-          UnlockSchedStatus();
-          Idiom2WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_E1);
           SetPriorityNormal(curr_thd_id);
         } else {
           UnlockSchedStatus();
@@ -3504,12 +3185,8 @@ void SchedulerCommon::Idiom2WatchInstCount(timestamp_t c) {
         if (s->window_ >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
           thread_id_t target = s->thd_id_[1];
-          Idiom2ClearDelaySet(&copy);
-          Idiom2SetState(IDIOM2_STATE_INIT);
-          UnlockSchedStatus();
-          Idiom2WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_2>(IDIOM2_STATE_INIT);
           SetPriorityNormal(target);
           SetPriorityNormal(curr_thd_id);
         } else {
@@ -3525,230 +3202,8 @@ void SchedulerCommon::Idiom2WatchInstCount(timestamp_t c) {
   } // end of switch
 }
 
-void SchedulerCommon::Idiom2WatchMutexLock(address_t addr) {
-  Idiom2WatchAccess(addr, WORD_SIZE);
-}
-
-void SchedulerCommon::Idiom2WatchMutexUnlock(address_t addr) {
-  Idiom2WatchAccess(addr, WORD_SIZE);
-}
-
-void SchedulerCommon::Idiom2WatchMemRead(Inst *inst, address_t addr, size_t size,
-                                   bool cand) {
-  Idiom2WatchAccess(addr, size);
-  if (!cand)
-    Idiom2CheckFlush();
-}
-
-void SchedulerCommon::Idiom2WatchMemWrite(Inst *inst, address_t addr, size_t size,
-                                    bool cand) {
-  Idiom2WatchAccess(addr, size);
-  if (!cand)
-    Idiom2CheckFlush();
-}
-
-
-void SchedulerCommon::Idiom2CheckFlush() {
-  Idiom2SchedStatus *s = idiom2_sched_status_;
-
-  // define a static local variable
-  static int token = 0;
-
-  switch (s->state_) {
-    case IDIOM2_STATE_INIT:
-    case IDIOM2_STATE_E0:
-    case IDIOM2_STATE_E1:
-    case IDIOM2_STATE_DONE:
-      if (token-- <= 0) {
-        FlushWatch();
-        token = 10;
-      }
-      break;
-    default:
-      break;
-  }
-}
-
-bool SchedulerCommon::Idiom2CheckGiveup(int idx) {
-  // return true means actual give up
-  // return false means one more chance
-  if (YieldWithDelay()) {
-    Idiom2SchedStatus *s = idiom2_sched_status_;
-    thread_id_t curr_thd_id = PIN_ThreadUid();
-    DEBUG_FMT_PRINT_SAFE("[T%lx] Check giveup\n", curr_thd_id);
-    static unsigned long last_state[] = {IDIOM2_STATE_INVALID,
-                                         IDIOM2_STATE_INVALID,
-                                         IDIOM2_STATE_INVALID,
-                                         IDIOM2_STATE_INVALID};
-    static thread_id_t last_thd[] = {INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID};
-    static int time_delayed_each[] = {0, 0, 0, 0};
-    static int time_delayed_total = 0;
-    if (time_delayed_each[idx] <= knob_->ValueInt("yield_delay_min_each") ||
-        time_delayed_total <= knob_->ValueInt("yield_delay_max_total")) {
-      if (s->state_ != last_state[idx] || curr_thd_id != last_thd[idx]) {
-        DEBUG_FMT_PRINT_SAFE("[T%lx] time delay\n", curr_thd_id);
-        int time_unit = knob_->ValueInt("yield_delay_unit");
-        last_state[idx] = s->state_;
-        last_thd[idx] = curr_thd_id;
-        time_delayed_each[idx] += time_unit;
-        time_delayed_total += time_unit;
-        UnlockSchedStatus();
-        usleep(1000 * time_unit);
-        LockSchedStatus();
-        return false;
-      } else {
-        return true;
-      }
-    } else {
-      return true;
-    }
-  } else {
-    return true;
-  }
-}
-
-void SchedulerCommon::Idiom2SetState(unsigned long s) {
-  DEBUG_FMT_PRINT_SAFE("[T%lx] set state: %s\n", PIN_ThreadUid(),
-                       Idiom2SchedStatus::StateToString(s).c_str());
-  idiom2_sched_status_->state_ = s;
-}
-
-void SchedulerCommon::Idiom2ClearDelaySet(DelaySet *copy) {
-  *copy = idiom2_sched_status_->delay_set_;
-  idiom2_sched_status_->delay_set_.clear();
-}
-
-void SchedulerCommon::Idiom2WakeDelaySet(DelaySet *copy) {
-  thread_id_t curr_thd_id = PIN_ThreadUid();
-  SetPriorityHigh(curr_thd_id);
-  for (DelaySet::iterator it = copy->begin(); it != copy->end(); ++it) {
-    if (*it != curr_thd_id)
-      SetPriorityNormal(*it);
-  }
-}
-
-void SchedulerCommon::Idiom3BeforeiRootMemRead(UINT32 idx, address_t addr,
-                                         size_t size) {
-  if (curr_iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_WRITE)
-    return;
-
-  switch (idx) {
-    case 0:
-      Idiom3BeforeEvent0(addr, size);
-      break;
-    case 1:
-      Idiom3BeforeEvent1(addr, size);
-      break;
-    case 2:
-      Idiom3BeforeEvent2(addr, size);
-      break;
-    case 3:
-      Idiom3BeforeEvent3(addr, size);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom3BeforeiRootMemWrite(UINT32 idx, address_t addr,
-                                          size_t size) {
-  if (curr_iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_READ)
-    return;
-
-  switch (idx) {
-    case 0:
-      Idiom3BeforeEvent0(addr, size);
-      break;
-    case 1:
-      Idiom3BeforeEvent1(addr, size);
-      break;
-    case 2:
-      Idiom3BeforeEvent2(addr, size);
-      break;
-    case 3:
-      Idiom3BeforeEvent3(addr, size);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom3AfteriRootMem(UINT32 idx) {
-  switch (idx) {
-    case 0:
-      Idiom3AfterEvent0();
-      break;
-    case 1:
-      Idiom3AfterEvent1();
-      break;
-    case 2:
-      Idiom3AfterEvent2();
-      break;
-    case 3:
-      Idiom3AfterEvent3();
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom3BeforeiRootMutexLock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 1:
-      Idiom3BeforeEvent1(addr, WORD_SIZE);
-      break;
-    case 3:
-      Idiom3BeforeEvent3(addr, WORD_SIZE);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom3AfteriRootMutexLock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 1:
-      Idiom3AfterEvent1();
-      break;
-    case 3:
-      Idiom3AfterEvent3();
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom3BeforeiRootMutexUnlock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 0:
-      Idiom3BeforeEvent0(addr, WORD_SIZE);
-      break;
-    case 2:
-      Idiom3BeforeEvent2(addr, WORD_SIZE);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom3AfteriRootMutexUnlock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 0:
-      Idiom3AfterEvent0();
-      break;
-    case 2:
-      Idiom3AfterEvent2();
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
 void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
+  Idiom3SchedStatus *s = CurrTarget()->idiom3_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event0", 1);
@@ -3761,10 +3216,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
     LockSchedStatus();
     switch (s->state_) {
       case IDIOM3_STATE_INIT:
-        s->thd_id_[0] = curr_thd_id;
-        s->addr_[0] = addr;
-        s->size_[0] = size;
-        Idiom3SetState(IDIOM3_STATE_E0);
+        IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+        IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0);
         UnlockSchedStatus();
         SetPriorityLow(curr_thd_id);
         restart = true;
@@ -3774,16 +3227,14 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           // has to execute event 0, go to watch mode
-          Idiom3SetState(IDIOM3_STATE_E0_WATCH_X);
+          IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0_WATCH_X);
           UnlockSchedStatus();
           SetPriorityHigh(curr_thd_id);
         } else {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -3800,10 +3251,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
         // check conflict
         if (OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
           thread_id_t target = s->thd_id_[1];
-          s->thd_id_[0] = curr_thd_id;
-          s->addr_[0] = addr;
-          s->size_[0] = size;
-          Idiom3SetState(IDIOM3_STATE_E0_E1);
+          IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+          IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0_E1);
           UnlockSchedStatus();
           // force to execute event 0 first
           SetPriorityHigh(curr_thd_id);
@@ -3812,10 +3261,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom3SetState(IDIOM3_STATE_E0);
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -3832,27 +3279,15 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay since event 3 will not be hit
-            DelaySet copy;
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_E0);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E0);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E0);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E0);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -3863,16 +3298,10 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom3CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_3>(0)) {
                 thread_id_t target = s->thd_id_[0];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom3ClearDelaySet(&copy);
-                Idiom3SetState(IDIOM3_STATE_E0);
-                UnlockSchedStatus();
-                Idiom3WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E0);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
@@ -3889,15 +3318,9 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E0);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -3922,10 +3345,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 3 will not be reached
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom3SetState(IDIOM3_STATE_E0);
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target);
@@ -3935,10 +3356,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom3SetState(IDIOM3_STATE_E0);
+              IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+              IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0);
               UnlockSchedStatus();
               SetPriorityMax(curr_thd_id);
               SetPriorityNormal(target);
@@ -3953,10 +3372,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom3SetState(IDIOM3_STATE_E0);
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -3971,10 +3388,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom3SetState(IDIOM3_STATE_E0);
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -3995,16 +3410,10 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
             OVERLAP(addr, size, s->addr_[3], s->size_[3])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed any more
-            if (Idiom3CheckGiveup(0)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_3>(0)) {
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E0);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -4021,15 +3430,9 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
         } else {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_E0);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E0);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
@@ -4050,10 +3453,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom3SetState(IDIOM3_STATE_E0);
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -4067,10 +3468,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom3SetState(IDIOM3_STATE_E0);
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -4096,10 +3495,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom3SetState(IDIOM3_STATE_E0);
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -4109,10 +3506,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom3SetState(IDIOM3_STATE_E0);
+              IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+              IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0);
               UnlockSchedStatus();
               SetPriorityHigh(curr_thd_id);
               SetPriorityNormal(target);
@@ -4127,10 +3522,8 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom3SetState(IDIOM3_STATE_E0);
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -4154,30 +3547,18 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1]) ||
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay since event 3 will not be reached
-            DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_E0);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E0);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E0);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -4191,13 +3572,9 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1]) ||
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed any more
-            if (Idiom3CheckGiveup(0)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_3>(0)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E1_WATCH);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1_WATCH);
               SetPriorityNormal(target);
               SetPriorityHigh(curr_thd_id);
               restart = true;
@@ -4208,15 +3585,9 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E0);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -4230,14 +3601,10 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom3CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_3>(0)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom3ClearDelaySet(&copy);
-                Idiom3SetState(IDIOM3_STATE_E1_WATCH);
-                UnlockSchedStatus();
-                Idiom3WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityHigh(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -4255,16 +3622,10 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target1 = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E0);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_3>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E0);
               SetPriorityNormal(target0);
               SetPriorityNormal(target1);
               SetPriorityLow(curr_thd_id);
@@ -4286,7 +3647,7 @@ void SchedulerCommon::Idiom3BeforeEvent0(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
+  Idiom3SchedStatus *s = CurrTarget()->idiom3_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event1", 1);
@@ -4299,10 +3660,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
     LockSchedStatus();
     switch (s->state_) {
       case IDIOM3_STATE_INIT:
-        s->thd_id_[1] = curr_thd_id;
-        s->addr_[1] = addr;
-        s->size_[1] = size;
-        Idiom3SetState(IDIOM3_STATE_E1);
+        IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+        IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1);
         UnlockSchedStatus();
         SetPriorityLow(curr_thd_id);
         restart = true;
@@ -4313,10 +3672,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
         // check conflict
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           thread_id_t target = s->thd_id_[0];
-          s->thd_id_[1] = curr_thd_id;
-          s->addr_[1] = addr;
-          s->size_[1] = size;
-          Idiom3SetState(IDIOM3_STATE_E0_E1);
+          IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+          IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0_E1);
           UnlockSchedStatus();
           // force to execute event 0 first
           SetPriorityMax(curr_thd_id);
@@ -4327,10 +3684,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3SetState(IDIOM3_STATE_E1);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -4345,9 +3700,9 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
         DEBUG_ASSERT(s->thd_id_[1] != INVALID_THD_ID);
         if (curr_thd_id == s->thd_id_[1]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
-          if (Idiom3CheckGiveup(1)) {
+          if (IdiomCheckGiveup<IDIOM_3>(1)) {
             // has to go back to initial state
-            Idiom3SetState(IDIOM3_STATE_INIT);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityNormal(curr_thd_id);
           } else {
@@ -4358,9 +3713,7 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -4377,27 +3730,15 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay because event 3 will not be hit
-            DelaySet copy;
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_E1);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E1);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -4409,10 +3750,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
             DEBUG_ASSERT(GetPriority(curr_thd_id) != LowerPriority());
             // the dependency e0->e1 is satisfied
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3SetState(IDIOM3_STATE_E0_E1_WATCH);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0_E1_WATCH);
             UnlockSchedStatus();
             // force to execute thd[1] first
             SetPriorityHigh(curr_thd_id);
@@ -4421,15 +3760,9 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E1);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -4446,7 +3779,7 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
         DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
         // XXX confirm here since e1 might be blocked
         // since it might be acquiring a lock
-        Idiom3SetState(IDIOM3_STATE_E1_WATCH_X);
+        IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1_WATCH_X);
         UnlockSchedStatus();
         break;
       case IDIOM3_STATE_E1_WATCH:
@@ -4460,10 +3793,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay sine event 3 will not be reached
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3SetState(IDIOM3_STATE_E1);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target);
@@ -4473,10 +3804,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom3SetState(IDIOM3_STATE_E1);
+              IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+              IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1);
               UnlockSchedStatus();
               SetPriorityMax(curr_thd_id);
               SetPriorityNormal(target);
@@ -4491,10 +3820,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3SetState(IDIOM3_STATE_E1);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -4509,10 +3836,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3SetState(IDIOM3_STATE_E1);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -4532,28 +3857,16 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
             OVERLAP(addr, size, s->addr_[3], s->size_[3])) {
           // should execute this e1 and goto E1_WATCH_E3
-          DelaySet copy;
-          s->thd_id_[1] = curr_thd_id;
-          s->addr_[1] = addr;
-          s->size_[1] = size;
-          Idiom3ClearDelaySet(&copy);
-          Idiom3SetState(IDIOM3_STATE_E1_WATCH_E3_X);
-          UnlockSchedStatus();
-          Idiom3WakeDelaySet(&copy);
+          IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+          IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1_WATCH_E3_X);
           SetPriorityHigh(curr_thd_id);
           // force to execute this event 1 first
         } else {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_E1);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
@@ -4574,10 +3887,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3SetState(IDIOM3_STATE_E1);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -4591,10 +3902,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3SetState(IDIOM3_STATE_E1);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -4619,10 +3928,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3SetState(IDIOM3_STATE_E1);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -4632,10 +3939,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom3SetState(IDIOM3_STATE_E1);
+              IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+              IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1);
               UnlockSchedStatus();
               SetPriorityHigh(curr_thd_id);
               SetPriorityNormal(target);
@@ -4650,10 +3955,8 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3SetState(IDIOM3_STATE_E1);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -4677,30 +3980,18 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1]) ||
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay since event 3 will not be reached
-            DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_E1);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E1);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -4714,13 +4005,9 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1]) ||
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed any more
-            if (Idiom3CheckGiveup(1)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_3>(1)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E1_WATCH);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1_WATCH);
               SetPriorityNormal(target);
               SetPriorityHigh(curr_thd_id);
               restart = true;
@@ -4731,15 +4018,9 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E1);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -4753,14 +4034,10 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom3CheckGiveup(1)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_3>(1)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom3ClearDelaySet(&copy);
-                Idiom3SetState(IDIOM3_STATE_E1_WATCH);
-                UnlockSchedStatus();
-                Idiom3WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityHigh(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -4778,16 +4055,10 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target1 = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E1);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_3>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1);
               SetPriorityNormal(target0);
               SetPriorityNormal(target1);
               SetPriorityLow(curr_thd_id);
@@ -4809,7 +4080,7 @@ void SchedulerCommon::Idiom3BeforeEvent1(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
+  Idiom3SchedStatus *s = CurrTarget()->idiom3_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event2", 1);
@@ -4827,11 +4098,7 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay since event 3 will not be hit
-            DelaySet copy;
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -4841,13 +4108,9 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom3CheckGiveup(2)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_3>(2)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom3ClearDelaySet(&copy);
-                Idiom3SetState(IDIOM3_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom3WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -4880,7 +4143,7 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            Idiom3SetState(IDIOM3_STATE_INIT);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target);
@@ -4895,10 +4158,8 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // goto state E1_WATCH_E2
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
-            Idiom3SetState(IDIOM3_STATE_E1_WATCH_E2);
+            IdiomRecordEvent<IDIOM_3>(2, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1_WATCH_E2);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityHigh(target);
@@ -4920,13 +4181,9 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
             OVERLAP(addr, size, s->addr_[3], s->size_[3])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed any more
-            if (Idiom3CheckGiveup(2)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_3>(2)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -4958,10 +4215,8 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[3], s->size_[3])) {
             // iroot conditions are satisfied
             thread_id_t target = s->thd_id_[3];
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
-            Idiom3SetState(IDIOM3_STATE_E0_E1_E2_E3);
+            IdiomRecordEvent<IDIOM_3>(2, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0_E1_E2_E3);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -4986,7 +4241,7 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            Idiom3SetState(IDIOM3_STATE_INIT);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -4998,7 +4253,7 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
         } else if (curr_thd_id == s->thd_id_[1]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           thread_id_t target = s->thd_id_[0];
-          Idiom3SetState(IDIOM3_STATE_E1_WATCH_E2_WATCH_X);
+          IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1_WATCH_E2_WATCH_X);
           UnlockSchedStatus();
           SetPriorityHigh(curr_thd_id);
           SetPriorityNormal(target);
@@ -5017,12 +4272,8 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1]) ||
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
             SetPriorityNormal(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -5035,13 +4286,9 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1]) ||
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed any more
-            if (Idiom3CheckGiveup(2)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_3>(2)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E1_WATCH);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1_WATCH);
               SetPriorityNormal(target);
               SetPriorityHigh(curr_thd_id);
               restart = true;
@@ -5058,14 +4305,10 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom3CheckGiveup(2)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_3>(2)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom3ClearDelaySet(&copy);
-                Idiom3SetState(IDIOM3_STATE_E1_WATCH);
-                UnlockSchedStatus();
-                Idiom3WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityHigh(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -5096,7 +4339,7 @@ void SchedulerCommon::Idiom3BeforeEvent2(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
+  Idiom3SchedStatus *s = CurrTarget()->idiom3_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event3", 1);
@@ -5114,10 +4357,8 @@ void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // goto state E0_WATCH_E3
-            s->thd_id_[3] = curr_thd_id;
-            s->addr_[3] = addr;
-            s->size_[3] = size;
-            Idiom3SetState(IDIOM3_STATE_E0_WATCH_E3);
+            IdiomRecordEvent<IDIOM_3>(3, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0_WATCH_E3);
             UnlockSchedStatus();
             SetPriorityLow(curr_thd_id);
             restart = true;
@@ -5128,13 +4369,9 @@ void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom3CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_3>(3)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom3ClearDelaySet(&copy);
-                Idiom3SetState(IDIOM3_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom3WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -5167,10 +4404,8 @@ void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // goto state E1_WATCH_E3
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[3] = curr_thd_id;
-            s->addr_[3] = addr;
-            s->size_[3] = size;
-            Idiom3SetState(IDIOM3_STATE_E1_WATCH_E3);
+            IdiomRecordEvent<IDIOM_3>(3, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1_WATCH_E3);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityHigh(target);
@@ -5191,12 +4426,8 @@ void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
         DEBUG_ASSERT(s->thd_id_[0] == s->thd_id_[3]);
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
-          if (Idiom3CheckGiveup(3)) {
-            DelaySet copy;
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+          if (IdiomCheckGiveup<IDIOM_3>(3)) {
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -5208,13 +4439,9 @@ void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[3], s->size_[3])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom3CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_3>(3)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom3ClearDelaySet(&copy);
-                Idiom3SetState(IDIOM3_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom3WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -5242,7 +4469,7 @@ void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           thread_id_t target = s->thd_id_[1];
-          Idiom3SetState(IDIOM3_STATE_INIT);
+          IdiomSetState<IDIOM_3>(IDIOM3_STATE_INIT);
           UnlockSchedStatus();
           SetPriorityMax(curr_thd_id);
           SetPriorityNormal(target);
@@ -5267,10 +4494,8 @@ void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // iroot conditions are satisfied
             thread_id_t target = s->thd_id_[2];
-            s->thd_id_[3] = curr_thd_id;
-            s->addr_[3] = addr;
-            s->size_[3] = size;
-            Idiom3SetState(IDIOM3_STATE_E0_E1_E2_E3);
+            IdiomRecordEvent<IDIOM_3>(3, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0_E1_E2_E3);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityHigh(target);
@@ -5294,15 +4519,9 @@ void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1]) ||
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // iroot conditions are satisfied
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            s->thd_id_[3] = curr_thd_id;
-            s->addr_[3] = addr;
-            s->size_[3] = size;
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_E0_E1_E2_E3);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_3>(3, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E0_E1_E2_E3);
             SetPriorityNormal(target);
             SetPriorityHigh(curr_thd_id);
             // force to execute current event 3
@@ -5315,13 +4534,9 @@ void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1]) ||
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed any more
-            if (Idiom3CheckGiveup(3)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_3>(3)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E1_WATCH);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1_WATCH);
               SetPriorityNormal(target);
               SetPriorityHigh(curr_thd_id);
               restart = true;
@@ -5338,14 +4553,10 @@ void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom3CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_3>(3)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom3ClearDelaySet(&copy);
-                Idiom3SetState(IDIOM3_STATE_E1_WATCH);
-                UnlockSchedStatus();
-                Idiom3WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityHigh(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -5376,7 +4587,7 @@ void SchedulerCommon::Idiom3BeforeEvent3(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom3AfterEvent0() {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
+  Idiom3SchedStatus *s = CurrTarget()->idiom3_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 0\n", curr_thd_id);
@@ -5387,7 +4598,7 @@ void SchedulerCommon::Idiom3AfterEvent0() {
       if (curr_thd_id == s->thd_id_[0]) {
         thread_id_t target = s->thd_id_[1];
         s->window_ = 0;
-        Idiom3SetState(IDIOM3_STATE_E0_E1_WATCH);
+        IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0_E1_WATCH);
         UnlockSchedStatus();
         FlushWatch();
         SetPriorityMax(curr_thd_id);
@@ -5400,7 +4611,7 @@ void SchedulerCommon::Idiom3AfterEvent0() {
     case IDIOM3_STATE_E0_WATCH_X:
       if (curr_thd_id == s->thd_id_[0]) {
         s->window_ = 0;
-        Idiom3SetState(IDIOM3_STATE_E0_WATCH);
+        IdiomSetState<IDIOM_3>(IDIOM3_STATE_E0_WATCH);
         UnlockSchedStatus();
         FlushWatch();
         SetPriorityLow(curr_thd_id);
@@ -5415,7 +4626,7 @@ void SchedulerCommon::Idiom3AfterEvent0() {
 }
 
 void SchedulerCommon::Idiom3AfterEvent1() {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
+  Idiom3SchedStatus *s = CurrTarget()->idiom3_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 1\n", curr_thd_id);
@@ -5425,7 +4636,7 @@ void SchedulerCommon::Idiom3AfterEvent1() {
     case IDIOM3_STATE_E1_WATCH_X:
       if (curr_thd_id == s->thd_id_[1]) {
         thread_id_t target = s->thd_id_[0];
-        Idiom3SetState(IDIOM3_STATE_E1_WATCH);
+        IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1_WATCH);
         UnlockSchedStatus();
         SetPriorityHigh(curr_thd_id);
         SetPriorityNormal(target);
@@ -5435,7 +4646,7 @@ void SchedulerCommon::Idiom3AfterEvent1() {
       break;
     case IDIOM3_STATE_E1_WATCH_E3_X:
       if (curr_thd_id == s->thd_id_[1]) {
-        Idiom3SetState(IDIOM3_STATE_E1_WATCH_E3);
+        IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1_WATCH_E3);
         UnlockSchedStatus();
         SetPriorityHigh(curr_thd_id);
       } else {
@@ -5449,7 +4660,7 @@ void SchedulerCommon::Idiom3AfterEvent1() {
 }
 
 void SchedulerCommon::Idiom3AfterEvent2() {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
+  Idiom3SchedStatus *s = CurrTarget()->idiom3_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 2\n", curr_thd_id);
@@ -5459,7 +4670,7 @@ void SchedulerCommon::Idiom3AfterEvent2() {
     case IDIOM3_STATE_E1_WATCH_E2_WATCH_X:
       if (curr_thd_id == s->thd_id_[2]) {
         thread_id_t target = s->thd_id_[0];
-        Idiom3SetState(IDIOM3_STATE_E1_WATCH_E2_WATCH);
+        IdiomSetState<IDIOM_3>(IDIOM3_STATE_E1_WATCH_E2_WATCH);
         UnlockSchedStatus();
         SetPriorityMax(curr_thd_id);
         SetPriorityHigh(target);
@@ -5486,7 +4697,7 @@ void SchedulerCommon::Idiom3AfterEvent2() {
 }
 
 void SchedulerCommon::Idiom3AfterEvent3() {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
+  Idiom3SchedStatus *s = CurrTarget()->idiom3_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 3\n", curr_thd_id);
@@ -5497,8 +4708,8 @@ void SchedulerCommon::Idiom3AfterEvent3() {
       if (curr_thd_id == s->thd_id_[3]) {
         ActivelyExposed();
         DEBUG_FMT_PRINT_SAFE("[T%lx] iRoot %u exposed.\n",
-                             curr_thd_id, curr_iroot_->id());
-        Idiom3SetState(IDIOM3_STATE_DONE);
+                             curr_thd_id, CurrTarget()->iroot_->id());
+        IdiomSetState<IDIOM_3>(IDIOM3_STATE_DONE);
         UnlockSchedStatus();
         SetPriorityNormal(curr_thd_id);
       } else {
@@ -5512,7 +4723,7 @@ void SchedulerCommon::Idiom3AfterEvent3() {
 }
 
 void SchedulerCommon::Idiom3WatchAccess(address_t addr, size_t size) {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
+  Idiom3SchedStatus *s = CurrTarget()->idiom3_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("watch_access", 1);
@@ -5529,11 +4740,7 @@ void SchedulerCommon::Idiom3WatchAccess(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need delay since event 3 will not be hit
-            DelaySet copy;
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -5542,13 +4749,9 @@ void SchedulerCommon::Idiom3WatchAccess(address_t addr, size_t size) {
         } else {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
-              if (Idiom3CheckGiveup(4)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_3>(4)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom3ClearDelaySet(&copy);
-                Idiom3SetState(IDIOM3_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom3WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -5581,7 +4784,7 @@ void SchedulerCommon::Idiom3WatchAccess(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            Idiom3SetState(IDIOM3_STATE_INIT);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target);
@@ -5606,13 +4809,9 @@ void SchedulerCommon::Idiom3WatchAccess(address_t addr, size_t size) {
             OVERLAP(addr, size, s->addr_[3], s->size_[3])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed any more
-            if (Idiom3CheckGiveup(4)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_3>(4)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -5651,7 +4850,7 @@ void SchedulerCommon::Idiom3WatchAccess(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            Idiom3SetState(IDIOM3_STATE_INIT);
+            IdiomSetState<IDIOM_3>(IDIOM3_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -5675,12 +4874,8 @@ void SchedulerCommon::Idiom3WatchAccess(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1]) ||
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay since event 3 will not be reached
-            DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            Idiom3ClearDelaySet(&copy);
-            Idiom3SetState(IDIOM3_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom3WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
             SetPriorityNormal(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -5693,13 +4888,9 @@ void SchedulerCommon::Idiom3WatchAccess(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1]) ||
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed any more
-            if (Idiom3CheckGiveup(4)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_3>(4)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom3ClearDelaySet(&copy);
-              Idiom3SetState(IDIOM3_STATE_E1_WATCH);
-              UnlockSchedStatus();
-              Idiom3WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1_WATCH);
               SetPriorityNormal(target);
               SetPriorityHigh(curr_thd_id);
               restart = true;
@@ -5716,14 +4907,10 @@ void SchedulerCommon::Idiom3WatchAccess(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom3CheckGiveup(4)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_3>(4)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom3ClearDelaySet(&copy);
-                Idiom3SetState(IDIOM3_STATE_E1_WATCH);
-                UnlockSchedStatus();
-                Idiom3WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_E1_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityHigh(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -5754,7 +4941,7 @@ void SchedulerCommon::Idiom3WatchAccess(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom3WatchInstCount(timestamp_t c) {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
+  Idiom3SchedStatus *s = CurrTarget()->idiom3_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   LockSchedStatus();
@@ -5765,11 +4952,7 @@ void SchedulerCommon::Idiom3WatchInstCount(timestamp_t c) {
         if (s->window_ >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
-          Idiom3ClearDelaySet(&copy);
-          Idiom3SetState(IDIOM3_STATE_INIT);
-          UnlockSchedStatus();
-          Idiom3WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
           SetPriorityNormal(curr_thd_id);
         } else {
           UnlockSchedStatus();
@@ -5789,7 +4972,7 @@ void SchedulerCommon::Idiom3WatchInstCount(timestamp_t c) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
           thread_id_t target = s->thd_id_[1];
-          Idiom3SetState(IDIOM3_STATE_INIT);
+          IdiomSetState<IDIOM_3>(IDIOM3_STATE_INIT);
           UnlockSchedStatus();
           SetPriorityMax(curr_thd_id);
           SetPriorityNormal(target);
@@ -5814,7 +4997,7 @@ void SchedulerCommon::Idiom3WatchInstCount(timestamp_t c) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
           thread_id_t target = s->thd_id_[1];
-          Idiom3SetState(IDIOM3_STATE_INIT);
+          IdiomSetState<IDIOM_3>(IDIOM3_STATE_INIT);
           UnlockSchedStatus();
           SetPriorityHigh(curr_thd_id);
           SetPriorityNormal(target);
@@ -5832,12 +5015,8 @@ void SchedulerCommon::Idiom3WatchInstCount(timestamp_t c) {
         if (s->window_ >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
           thread_id_t target = s->thd_id_[1];
-          Idiom3ClearDelaySet(&copy);
-          Idiom3SetState(IDIOM3_STATE_INIT);
-          UnlockSchedStatus();
-          Idiom3WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_3>(IDIOM3_STATE_INIT);
           SetPriorityNormal(target);
           SetPriorityNormal(curr_thd_id);
         } else {
@@ -5853,231 +5032,8 @@ void SchedulerCommon::Idiom3WatchInstCount(timestamp_t c) {
   } // end of switch
 }
 
-void SchedulerCommon::Idiom3WatchMutexLock(address_t addr) {
-  Idiom3WatchAccess(addr, WORD_SIZE);
-}
-
-void SchedulerCommon::Idiom3WatchMutexUnlock(address_t addr) {
-  Idiom3WatchAccess(addr, WORD_SIZE);
-}
-
-void SchedulerCommon::Idiom3WatchMemRead(Inst *inst, address_t addr, size_t size,
-                                   bool cand) {
-  Idiom3WatchAccess(addr, size);
-  if (!cand)
-    Idiom3CheckFlush();
-}
-
-void SchedulerCommon::Idiom3WatchMemWrite(Inst *inst, address_t addr, size_t size,
-                                    bool cand) {
-  Idiom3WatchAccess(addr, size);
-  if (!cand)
-    Idiom3CheckFlush();
-}
-
-void SchedulerCommon::Idiom3CheckFlush() {
-  Idiom3SchedStatus *s = idiom3_sched_status_;
-
-  // define a static local variable
-  static int token = 0;
-
-  switch (s->state_) {
-    case IDIOM3_STATE_INIT:
-    case IDIOM3_STATE_E0:
-    case IDIOM3_STATE_E1:
-    case IDIOM3_STATE_DONE:
-      if (token-- <= 0) {
-        FlushWatch();
-        token = 10;
-      }
-      break;
-    default:
-      break;
-  }
-}
-
-bool SchedulerCommon::Idiom3CheckGiveup(int idx) {
-  // return true means actual give up
-  // return false means one more chance
-  if (YieldWithDelay()) {
-    Idiom3SchedStatus *s = idiom3_sched_status_;
-    thread_id_t curr_thd_id = PIN_ThreadUid();
-    DEBUG_FMT_PRINT_SAFE("[T%lx] Check giveup\n", curr_thd_id);
-    static unsigned long last_state[] = {IDIOM3_STATE_INVALID,
-                                         IDIOM3_STATE_INVALID,
-                                         IDIOM3_STATE_INVALID,
-                                         IDIOM3_STATE_INVALID,
-                                         IDIOM3_STATE_INVALID};
-    static thread_id_t last_thd[] = {INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID};
-    static int time_delayed_each[] = {0, 0, 0, 0, 0};
-    static int time_delayed_total = 0;
-    if (time_delayed_each[idx] <= knob_->ValueInt("yield_delay_min_each") ||
-        time_delayed_total <= knob_->ValueInt("yield_delay_max_total")) {
-      if (s->state_ != last_state[idx] || curr_thd_id != last_thd[idx]) {
-        DEBUG_FMT_PRINT_SAFE("[T%lx] time delay\n", curr_thd_id);
-        int time_unit = knob_->ValueInt("yield_delay_unit");
-        last_state[idx] = s->state_;
-        last_thd[idx] = curr_thd_id;
-        time_delayed_each[idx] += time_unit;
-        time_delayed_total += time_unit;
-        UnlockSchedStatus();
-        usleep(1000 * time_unit);
-        LockSchedStatus();
-        return false;
-      } else {
-        return true;
-      }
-    } else {
-      return true;
-    }
-  } else {
-    return true;
-  }
-}
-
-void SchedulerCommon::Idiom3SetState(unsigned long s) {
-  DEBUG_FMT_PRINT_SAFE("[T%lx] set state: %s\n", PIN_ThreadUid(),
-                       Idiom3SchedStatus::StateToString(s).c_str());
-  idiom3_sched_status_->state_ = s;
-}
-
-void SchedulerCommon::Idiom3ClearDelaySet(DelaySet *copy) {
-  *copy = idiom3_sched_status_->delay_set_;
-  idiom3_sched_status_->delay_set_.clear();
-}
-
-void SchedulerCommon::Idiom3WakeDelaySet(DelaySet *copy) {
-  thread_id_t curr_thd_id = PIN_ThreadUid();
-  SetPriorityMax(curr_thd_id);
-  for (DelaySet::iterator it = copy->begin(); it != copy->end(); ++it) {
-    if (*it != curr_thd_id)
-      SetPriorityNormal(*it);
-  }
-}
-
-void SchedulerCommon::Idiom4BeforeiRootMemRead(UINT32 idx, address_t addr,
-                                         size_t size) {
-  if (curr_iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_WRITE)
-    return;
-
-  switch (idx) {
-    case 0:
-      Idiom4BeforeEvent0(addr, size);
-      break;
-    case 1:
-      Idiom4BeforeEvent1(addr, size);
-      break;
-    case 2:
-      Idiom4BeforeEvent2(addr, size);
-      break;
-    case 3:
-      Idiom4BeforeEvent3(addr, size);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom4BeforeiRootMemWrite(UINT32 idx, address_t addr,
-                                          size_t size) {
-  if (curr_iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_READ)
-    return;
-
-  switch (idx) {
-    case 0:
-      Idiom4BeforeEvent0(addr, size);
-      break;
-    case 1:
-      Idiom4BeforeEvent1(addr, size);
-      break;
-    case 2:
-      Idiom4BeforeEvent2(addr, size);
-      break;
-    case 3:
-      Idiom4BeforeEvent3(addr, size);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom4AfteriRootMem(UINT32 idx) {
-  switch (idx) {
-    case 0:
-      Idiom4AfterEvent0();
-      break;
-    case 1:
-      Idiom4AfterEvent1();
-      break;
-    case 2:
-      Idiom4AfterEvent2();
-      break;
-    case 3:
-      Idiom4AfterEvent3();
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom4BeforeiRootMutexLock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 1:
-      Idiom4BeforeEvent1(addr, WORD_SIZE);
-      break;
-    case 3:
-      Idiom4BeforeEvent3(addr, WORD_SIZE);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom4AfteriRootMutexLock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 1:
-      Idiom4AfterEvent1();
-      break;
-    case 3:
-      Idiom4AfterEvent3();
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom4BeforeiRootMutexUnlock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 0:
-      Idiom4BeforeEvent0(addr, WORD_SIZE);
-      break;
-    case 2:
-      Idiom4BeforeEvent2(addr, WORD_SIZE);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom4AfteriRootMutexUnlock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 0:
-      Idiom4AfterEvent0();
-      break;
-    case 2:
-      Idiom4AfterEvent2();
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
 void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event0", 1);
@@ -6093,10 +5049,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
     LockSchedStatus();
     switch (s->state_) {
       case IDIOM4_STATE_INIT:
-        s->thd_id_[0] = curr_thd_id;
-        s->addr_[0] = addr;
-        s->size_[0] = size;
-        Idiom4SetState(IDIOM4_STATE_E0);
+        IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+        IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0);
         UnlockSchedStatus();
         SetPriorityLow(curr_thd_id);
         restart = true;
@@ -6106,16 +5060,14 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           // has to execute event 0, go to watch mode
-          Idiom4SetState(IDIOM4_STATE_E0_WATCH_X);
+          IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0_WATCH_X);
           UnlockSchedStatus();
           SetPriorityHigh(curr_thd_id);
         } else {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -6132,10 +5084,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
         // check overlap
         if (OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
           thread_id_t target = s->thd_id_[1];
-          s->thd_id_[0] = curr_thd_id;
-          s->addr_[0] = addr;
-          s->size_[0] = size;
-          Idiom4SetState(IDIOM4_STATE_E0_E1);
+          IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+          IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0_E1);
           UnlockSchedStatus();
           // force to execute event 0 first
           SetPriorityHigh(curr_thd_id);
@@ -6144,10 +5094,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom4SetState(IDIOM4_STATE_E0);
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -6164,27 +5112,15 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay since event 3 will not be hit
-            DelaySet copy;
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_E0);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E0);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E0);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E0);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -6196,16 +5132,10 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom4CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_4>(0)) {
                 thread_id_t target = s->thd_id_[0];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom4ClearDelaySet(&copy);
-                Idiom4SetState(IDIOM4_STATE_E0);
-                UnlockSchedStatus();
-                Idiom4WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E0);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
@@ -6222,15 +5152,9 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E0);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -6255,10 +5179,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 3 will not be reached
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom4SetState(IDIOM4_STATE_E0);
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target);
@@ -6268,10 +5190,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom4SetState(IDIOM4_STATE_E0);
+              IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+              IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0);
               UnlockSchedStatus();
               SetPriorityMax(curr_thd_id);
               SetPriorityNormal(target);
@@ -6287,10 +5207,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom4SetState(IDIOM4_STATE_E0);
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -6305,10 +5223,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom4SetState(IDIOM4_STATE_E0);
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -6328,16 +5244,10 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed any more
-            if (Idiom4CheckGiveup(0)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_4>(0)) {
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E0);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -6354,15 +5264,9 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
         } else {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_E0);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E0);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
@@ -6382,10 +5286,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom4SetState(IDIOM4_STATE_E0);
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -6399,10 +5301,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom4SetState(IDIOM4_STATE_E0);
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -6427,10 +5327,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom4SetState(IDIOM4_STATE_E0);
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -6438,7 +5336,7 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_E1_WATCH);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
             Idiom4RecordAccess(s->addr_[2], s->size_[2]); // XXX this is a hack
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
@@ -6449,10 +5347,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom4SetState(IDIOM4_STATE_E0);
+              IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+              IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0);
               UnlockSchedStatus();
               SetPriorityHigh(curr_thd_id);
               SetPriorityNormal(target);
@@ -6468,10 +5364,8 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom4SetState(IDIOM4_STATE_E0);
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -6496,39 +5390,28 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
             // no need to delay since event 3 will not be reached
             DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_E0);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E0);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_E1_WATCH);
+            IdiomClearDelaySet<IDIOM_4>(&copy);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
             Idiom4RecordAccess(s->addr_[2], s->size_[2]); // XXX this is a hack
             UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomWakeDelaySet<IDIOM_4>(&copy);
             SetPriorityHigh(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E0);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -6541,13 +5424,9 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed any more
-            if (Idiom4CheckGiveup(0)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_4>(0)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E1_WATCH);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
               SetPriorityNormal(target);
               SetPriorityHigh(curr_thd_id);
               restart = true;
@@ -6558,15 +5437,9 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E0);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -6578,14 +5451,10 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom4CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_4>(0)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom4ClearDelaySet(&copy);
-                Idiom4SetState(IDIOM4_STATE_E1_WATCH);
-                UnlockSchedStatus();
-                Idiom4WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityHigh(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -6603,16 +5472,10 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target1 = s->thd_id_[1];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E0);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_4>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E0);
               SetPriorityNormal(target0);
               SetPriorityNormal(target1);
               SetPriorityLow(curr_thd_id);
@@ -6634,7 +5497,7 @@ void SchedulerCommon::Idiom4BeforeEvent0(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event1", 1);
@@ -6650,10 +5513,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
     LockSchedStatus();
     switch (s->state_) {
       case IDIOM4_STATE_INIT:
-        s->thd_id_[1] = curr_thd_id;
-        s->addr_[1] = addr;
-        s->size_[1] = size;
-        Idiom4SetState(IDIOM4_STATE_E1);
+        IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+        IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1);
         UnlockSchedStatus();
         SetPriorityLow(curr_thd_id);
         restart = true;
@@ -6664,10 +5525,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
         // check conflict
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           thread_id_t target = s->thd_id_[0];
-          s->thd_id_[1] = curr_thd_id;
-          s->addr_[1] = addr;
-          s->size_[1] = size;
-          Idiom4SetState(IDIOM4_STATE_E0_E1);
+          IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+          IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0_E1);
           UnlockSchedStatus();
           // force to execute event 0 first
           SetPriorityMax(curr_thd_id);
@@ -6678,10 +5537,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4SetState(IDIOM4_STATE_E1);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -6696,9 +5553,9 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
         DEBUG_ASSERT(s->thd_id_[1] != INVALID_THD_ID);
         if (curr_thd_id == s->thd_id_[1]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
-          if (Idiom4CheckGiveup(1)) {
+          if (IdiomCheckGiveup<IDIOM_4>(1)) {
             // has to go back to initial state
-            Idiom4SetState(IDIOM4_STATE_INIT);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityNormal(curr_thd_id);
           } else {
@@ -6709,9 +5566,7 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -6728,27 +5583,15 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay because event 3 will not be hit
-            DelaySet copy;
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_E1);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E1);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -6761,10 +5604,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
             DEBUG_ASSERT(GetPriority(curr_thd_id) != LowerPriority());
             // the dependency e0->e1 is satisfied
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4SetState(IDIOM4_STATE_E0_E1_WATCH);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0_E1_WATCH);
             UnlockSchedStatus();
             // force to execute thd[1] first
             SetPriorityHigh(curr_thd_id);
@@ -6773,15 +5614,9 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E1);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -6798,7 +5633,7 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
         DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
         // XXX confirm there since e1 might be blocked
         // since it might be acquiring a lock
-        Idiom4SetState(IDIOM4_STATE_E1_WATCH_X);
+        IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH_X);
         UnlockSchedStatus();
         break;
       case IDIOM4_STATE_E1_WATCH:
@@ -6812,10 +5647,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay sine event 3 will not be reached
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4SetState(IDIOM4_STATE_E1);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target);
@@ -6825,10 +5658,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom4SetState(IDIOM4_STATE_E1);
+              IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+              IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1);
               UnlockSchedStatus();
               SetPriorityMax(curr_thd_id);
               SetPriorityNormal(target);
@@ -6844,10 +5675,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4SetState(IDIOM4_STATE_E1);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -6862,10 +5691,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4SetState(IDIOM4_STATE_E1);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -6884,28 +5711,16 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
         DEBUG_ASSERT(curr_thd_id != s->thd_id_[0]);
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           // should execute this e1 and goto E1_WATCH_E3
-          DelaySet copy;
-          s->thd_id_[1] = curr_thd_id;
-          s->addr_[1] = addr;
-          s->size_[1] = size;
-          Idiom4ClearDelaySet(&copy);
-          Idiom4SetState(IDIOM4_STATE_E1_WATCH_E3_X);
-          UnlockSchedStatus();
-          Idiom4WakeDelaySet(&copy);
+          IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+          IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH_E3_X);
           SetPriorityHigh(curr_thd_id);
           // force to execute this event 1 first
         } else {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_E1);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
@@ -6926,10 +5741,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4SetState(IDIOM4_STATE_E1);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -6943,10 +5756,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4SetState(IDIOM4_STATE_E1);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -6970,10 +5781,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4SetState(IDIOM4_STATE_E1);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -6981,7 +5790,7 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_E1_WATCH);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
             Idiom4RecordAccess(s->addr_[2], s->size_[2]); // XXX this is a hack
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
@@ -6992,10 +5801,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom4SetState(IDIOM4_STATE_E1);
+              IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+              IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1);
               UnlockSchedStatus();
               SetPriorityHigh(curr_thd_id);
               SetPriorityNormal(target);
@@ -7011,10 +5818,8 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           if (RandomChoice(0.2)) {
             thread_id_t target0 = s->thd_id_[0];
             thread_id_t target1 = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4SetState(IDIOM4_STATE_E1);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target0);
@@ -7039,39 +5844,28 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
             // no need to delay since event 3 will not be reached
             DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_E1);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_E1_WATCH);
+            IdiomClearDelaySet<IDIOM_4>(&copy);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
             Idiom4RecordAccess(s->addr_[2], s->size_[2]); // XXX this is a hack
             UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomWakeDelaySet<IDIOM_4>(&copy);
             SetPriorityHigh(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E1);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -7084,13 +5878,9 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed any more
-            if (Idiom4CheckGiveup(1)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_4>(1)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E1_WATCH);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
               SetPriorityNormal(target);
               SetPriorityHigh(curr_thd_id);
               restart = true;
@@ -7101,15 +5891,9 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E1);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -7121,14 +5905,10 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom4CheckGiveup(1)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_4>(1)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom4ClearDelaySet(&copy);
-                Idiom4SetState(IDIOM4_STATE_E1_WATCH);
-                UnlockSchedStatus();
-                Idiom4WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityHigh(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -7146,16 +5926,10 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target1 = s->thd_id_[1];
-              s->thd_id_[1] = curr_thd_id;
-              s->addr_[1] = addr;
-              s->size_[1] = size;
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E1);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_4>(1, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1);
               SetPriorityNormal(target0);
               SetPriorityNormal(target1);
               SetPriorityLow(curr_thd_id);
@@ -7177,7 +5951,7 @@ void SchedulerCommon::Idiom4BeforeEvent1(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event2", 1);
@@ -7198,11 +5972,7 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay since event 3 will not be hit
-            DelaySet copy;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -7213,13 +5983,9 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom4CheckGiveup(2)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_4>(2)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom4ClearDelaySet(&copy);
-                Idiom4SetState(IDIOM4_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom4WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -7252,7 +6018,7 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_INIT);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target);
@@ -7276,10 +6042,8 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
             } else {
               // goto state E1_WATCH_E2
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom4SetState(IDIOM4_STATE_E1_WATCH_E2);
+              IdiomRecordEvent<IDIOM_4>(2, curr_thd_id, addr, size);
+              IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH_E2);
               UnlockSchedStatus();
               SetPriorityMax(curr_thd_id);
               SetPriorityHigh(target);
@@ -7299,13 +6063,9 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed any more
-            if (Idiom4CheckGiveup(2)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_4>(2)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -7335,10 +6095,8 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[3], s->size_[3])) {
             // iroot conditions are satisfied
             thread_id_t target = s->thd_id_[3];
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
-            Idiom4SetState(IDIOM4_STATE_E0_E1_E2_E3);
+            IdiomRecordEvent<IDIOM_4>(2, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0_E1_E2_E3);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -7357,10 +6115,8 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
               //  2) ignore this event2
               if (RandomChoice(0.5)) {
                 thread_id_t target = s->thd_id_[3];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom4SetState(IDIOM4_STATE_E1_WATCH_E2);
+                IdiomRecordEvent<IDIOM_4>(2, curr_thd_id, addr, size);
+                IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH_E2);
                 UnlockSchedStatus();
                 SetPriorityMax(curr_thd_id);
                 SetPriorityHigh(target);
@@ -7387,7 +6143,7 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_INIT);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -7396,7 +6152,7 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // goto state E1_WATCH
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_E1_WATCH);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
             Idiom4RecordAccess(s->addr_[2], s->size_[2]); // XXX this is a hack
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
@@ -7410,7 +6166,7 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
         } else if (curr_thd_id == s->thd_id_[1]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           thread_id_t target = s->thd_id_[0];
-          Idiom4SetState(IDIOM4_STATE_E1_WATCH_E2_WATCH_X);
+          IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH_E2_WATCH_X);
           UnlockSchedStatus();
           SetPriorityHigh(curr_thd_id);
           SetPriorityNormal(target);
@@ -7430,21 +6186,18 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
             // cannot be delayed any more
             DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
             SetPriorityNormal(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_E1_WATCH);
+            IdiomClearDelaySet<IDIOM_4>(&copy);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
             Idiom4RecordAccess(s->addr_[2], s->size_[2]); // XXX this is a hack
             UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomWakeDelaySet<IDIOM_4>(&copy);
             SetPriorityHigh(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -7456,13 +6209,9 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed any more
-            if (Idiom4CheckGiveup(2)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_4>(2)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E1_WATCH);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
               SetPriorityNormal(target);
               SetPriorityHigh(curr_thd_id);
               restart = true;
@@ -7477,14 +6226,10 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom4CheckGiveup(2)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_4>(2)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom4ClearDelaySet(&copy);
-                Idiom4SetState(IDIOM4_STATE_E1_WATCH);
-                UnlockSchedStatus();
-                Idiom4WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityHigh(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -7515,7 +6260,7 @@ void SchedulerCommon::Idiom4BeforeEvent2(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event3", 1);
@@ -7536,11 +6281,7 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // go back to initial state
-            DelaySet copy;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -7549,10 +6290,8 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
               UnlockSchedStatus();
             } else {
               // goto state E0_WATCH_E3
-              s->thd_id_[3] = curr_thd_id;
-              s->addr_[3] = addr;
-              s->size_[3] = size;
-              Idiom4SetState(IDIOM4_STATE_E0_WATCH_E3);
+              IdiomRecordEvent<IDIOM_4>(3, curr_thd_id, addr, size);
+              IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0_WATCH_E3);
               UnlockSchedStatus();
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -7562,13 +6301,9 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom4CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_4>(3)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom4ClearDelaySet(&copy);
-                Idiom4SetState(IDIOM4_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom4WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -7601,7 +6336,7 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // go back to initial state
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_INIT);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target);
@@ -7614,10 +6349,8 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
             } else {
               // goto state E1_WATCH_E3
               thread_id_t target = s->thd_id_[1];
-              s->thd_id_[3] = curr_thd_id;
-              s->addr_[3] = addr;
-              s->size_[3] = size;
-              Idiom4SetState(IDIOM4_STATE_E1_WATCH_E3);
+              IdiomRecordEvent<IDIOM_4>(3, curr_thd_id, addr, size);
+              IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH_E3);
               UnlockSchedStatus();
               SetPriorityMax(curr_thd_id);
               SetPriorityHigh(target);
@@ -7637,13 +6370,13 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
         DEBUG_ASSERT(s->thd_id_[0] == s->thd_id_[3]);
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
-          if (Idiom4CheckGiveup(3)) {
+          if (IdiomCheckGiveup<IDIOM_4>(3)) {
             DelaySet copy;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_E0_WATCH);
+            IdiomClearDelaySet<IDIOM_4>(&copy);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0_WATCH);
             Idiom4RecordAccess(addr, size);
             UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomWakeDelaySet<IDIOM_4>(&copy);
             SetPriorityLow(curr_thd_id);
           } else {
             UnlockSchedStatus();
@@ -7653,13 +6386,9 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom4CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_4>(3)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom4ClearDelaySet(&copy);
-                Idiom4SetState(IDIOM4_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom4WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -7687,7 +6416,7 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           thread_id_t target = s->thd_id_[1];
-          Idiom4SetState(IDIOM4_STATE_E1_WATCH);
+          IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
           Idiom4RecordAccess(addr, size);
           UnlockSchedStatus();
           SetPriorityMax(curr_thd_id);
@@ -7710,10 +6439,8 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // iroot conditions are satisfied
             thread_id_t target = s->thd_id_[2];
-            s->thd_id_[3] = curr_thd_id;
-            s->addr_[3] = addr;
-            s->size_[3] = size;
-            Idiom4SetState(IDIOM4_STATE_E0_E1_E2_E3);
+            IdiomRecordEvent<IDIOM_4>(3, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0_E1_E2_E3);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityHigh(target);
@@ -7722,7 +6449,7 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
                      OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // go to initial state
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_INIT);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -7738,10 +6465,8 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
               //  2) ignore this event 3
               if (RandomChoice(0.5)) {
                 thread_id_t target = s->thd_id_[2];
-                s->thd_id_[3] = curr_thd_id;
-                s->addr_[3] = addr;
-                s->size_[3] = size;
-                Idiom4SetState(IDIOM4_STATE_E1_WATCH_E3);
+                IdiomRecordEvent<IDIOM_4>(3, curr_thd_id, addr, size);
+                IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH_E3);
                 UnlockSchedStatus();
                 SetPriorityMax(curr_thd_id);
                 SetPriorityHigh(target);
@@ -7767,27 +6492,17 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // iroot conditions are satisfied
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            s->thd_id_[3] = curr_thd_id;
-            s->addr_[3] = addr;
-            s->size_[3] = size;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_E0_E1_E2_E3);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_4>(3, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E0_E1_E2_E3);
             SetPriorityNormal(target);
             SetPriorityHigh(curr_thd_id);
             // force to execute current event 3
           } else if (OVERLAP(addr, size, s->addr_[0], s->size_[0]) ||
                      OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // go to initial state
-            DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
             SetPriorityNormal(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -7800,15 +6515,9 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
               //  1) goto state E1_WATCH_E3
               //  2) ignore this event 3
               if (RandomChoice(0.5)) {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[2];
-                s->thd_id_[3] = curr_thd_id;
-                s->addr_[3] = addr;
-                s->size_[3] = size;
-                Idiom4ClearDelaySet(&copy);
-                Idiom4SetState(IDIOM4_STATE_E1_WATCH_E3);
-                UnlockSchedStatus();
-                Idiom4WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_4>(3, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH_E3);
                 SetPriorityHigh(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
@@ -7822,13 +6531,9 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed any more
-            if (Idiom4CheckGiveup(3)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_4>(3)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E1_WATCH);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
               SetPriorityNormal(target);
               SetPriorityHigh(curr_thd_id);
               restart = true;
@@ -7843,14 +6548,10 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom4CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_4>(3)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom4ClearDelaySet(&copy);
-                Idiom4SetState(IDIOM4_STATE_E1_WATCH);
-                UnlockSchedStatus();
-                Idiom4WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityHigh(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -7881,7 +6582,7 @@ void SchedulerCommon::Idiom4BeforeEvent3(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom4AfterEvent0() {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 0\n", curr_thd_id);
@@ -7893,7 +6594,7 @@ void SchedulerCommon::Idiom4AfterEvent0() {
         thread_id_t target = s->thd_id_[1];
         s->window_ = 0;
         Idiom4ClearRecordedAccess();
-        Idiom4SetState(IDIOM4_STATE_E0_E1_WATCH);
+        IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0_E1_WATCH);
         UnlockSchedStatus();
         FlushWatch();
         SetPriorityMax(curr_thd_id);
@@ -7907,7 +6608,7 @@ void SchedulerCommon::Idiom4AfterEvent0() {
       if (curr_thd_id == s->thd_id_[0]) {
         s->window_ = 0;
         Idiom4ClearRecordedAccess();
-        Idiom4SetState(IDIOM4_STATE_E0_WATCH);
+        IdiomSetState<IDIOM_4>(IDIOM4_STATE_E0_WATCH);
         UnlockSchedStatus();
         FlushWatch();
         SetPriorityLow(curr_thd_id);
@@ -7922,7 +6623,7 @@ void SchedulerCommon::Idiom4AfterEvent0() {
 }
 
 void SchedulerCommon::Idiom4AfterEvent1() {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 1\n", curr_thd_id);
@@ -7932,7 +6633,7 @@ void SchedulerCommon::Idiom4AfterEvent1() {
     case IDIOM4_STATE_E1_WATCH_X:
       if (curr_thd_id == s->thd_id_[1]) {
         thread_id_t target = s->thd_id_[0];
-        Idiom4SetState(IDIOM4_STATE_E1_WATCH);
+        IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
         UnlockSchedStatus();
         SetPriorityHigh(curr_thd_id);
         SetPriorityNormal(target);
@@ -7942,7 +6643,7 @@ void SchedulerCommon::Idiom4AfterEvent1() {
       break;
     case IDIOM4_STATE_E1_WATCH_E3_X:
       if (curr_thd_id == s->thd_id_[1]) {
-        Idiom4SetState(IDIOM4_STATE_E1_WATCH_E3);
+        IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH_E3);
         UnlockSchedStatus();
         SetPriorityHigh(curr_thd_id);
       } else {
@@ -7956,7 +6657,7 @@ void SchedulerCommon::Idiom4AfterEvent1() {
 }
 
 void SchedulerCommon::Idiom4AfterEvent2() {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 2\n", curr_thd_id);
@@ -7966,7 +6667,7 @@ void SchedulerCommon::Idiom4AfterEvent2() {
     case IDIOM4_STATE_E1_WATCH_E2_WATCH_X:
       if (curr_thd_id == s->thd_id_[2]) {
         thread_id_t target = s->thd_id_[0];
-        Idiom4SetState(IDIOM4_STATE_E1_WATCH_E2_WATCH);
+        IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH_E2_WATCH);
         UnlockSchedStatus();
         SetPriorityMax(curr_thd_id);
         SetPriorityHigh(target);
@@ -7993,7 +6694,7 @@ void SchedulerCommon::Idiom4AfterEvent2() {
 }
 
 void SchedulerCommon::Idiom4AfterEvent3() {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 3\n", curr_thd_id);
@@ -8004,8 +6705,8 @@ void SchedulerCommon::Idiom4AfterEvent3() {
       if (curr_thd_id == s->thd_id_[3]) {
         ActivelyExposed();
         DEBUG_FMT_PRINT_SAFE("[T%lx] iRoot %u exposed.\n",
-                             curr_thd_id, curr_iroot_->id());
-        Idiom4SetState(IDIOM4_STATE_DONE);
+                             curr_thd_id, CurrTarget()->iroot_->id());
+        IdiomSetState<IDIOM_4>(IDIOM4_STATE_DONE);
         UnlockSchedStatus();
         SetPriorityNormal(curr_thd_id);
       } else {
@@ -8019,7 +6720,7 @@ void SchedulerCommon::Idiom4AfterEvent3() {
 }
 
 void SchedulerCommon::Idiom4WatchAccess(address_t addr, size_t size) {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("watch_access", 1);
@@ -8036,11 +6737,7 @@ void SchedulerCommon::Idiom4WatchAccess(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need delay since event 3 will not be hit
-            DelaySet copy;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -8050,13 +6747,9 @@ void SchedulerCommon::Idiom4WatchAccess(address_t addr, size_t size) {
         } else {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
-              if (Idiom4CheckGiveup(4)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_4>(4)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom4ClearDelaySet(&copy);
-                Idiom4SetState(IDIOM4_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom4WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -8089,7 +6782,7 @@ void SchedulerCommon::Idiom4WatchAccess(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_INIT);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target);
@@ -8114,13 +6807,9 @@ void SchedulerCommon::Idiom4WatchAccess(address_t addr, size_t size) {
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed any more
-            if (Idiom4CheckGiveup(4)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_4>(4)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -8158,7 +6847,7 @@ void SchedulerCommon::Idiom4WatchAccess(address_t addr, size_t size) {
               OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
             // no need to delay since event 3 will not be hit
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_INIT);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -8167,7 +6856,7 @@ void SchedulerCommon::Idiom4WatchAccess(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // goto state E1_WATCH
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_E1_WATCH);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
             Idiom4RecordAccess(s->addr_[2], s->size_[2]); // XXX this is a hack
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
@@ -8194,20 +6883,17 @@ void SchedulerCommon::Idiom4WatchAccess(address_t addr, size_t size) {
             // no need to delay since event 3 will not be reached
             DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
             SetPriorityNormal(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             DelaySet copy;
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_E1_WATCH);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
             Idiom4RecordAccess(s->addr_[2], s->size_[2]); // XXX this is a hack
             UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomWakeDelaySet<IDIOM_4>(&copy);
             SetPriorityHigh(target);
             SetPriorityNormal(curr_thd_id);
           } else {
@@ -8218,13 +6904,9 @@ void SchedulerCommon::Idiom4WatchAccess(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed any more
-            if (Idiom4CheckGiveup(4)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_4>(4)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom4ClearDelaySet(&copy);
-              Idiom4SetState(IDIOM4_STATE_E1_WATCH);
-              UnlockSchedStatus();
-              Idiom4WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
               SetPriorityNormal(target);
               SetPriorityHigh(curr_thd_id);
               restart = true;
@@ -8239,14 +6921,10 @@ void SchedulerCommon::Idiom4WatchAccess(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom4CheckGiveup(4)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_4>(4)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target1 = s->thd_id_[1];
-                Idiom4ClearDelaySet(&copy);
-                Idiom4SetState(IDIOM4_STATE_E1_WATCH);
-                UnlockSchedStatus();
-                Idiom4WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_E1_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityHigh(target1);
                 SetPriorityNormal(curr_thd_id);
@@ -8277,7 +6955,7 @@ void SchedulerCommon::Idiom4WatchAccess(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom4WatchInstCount(timestamp_t c) {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   while (true) {
@@ -8292,11 +6970,7 @@ void SchedulerCommon::Idiom4WatchInstCount(timestamp_t c) {
           if (s->window_ >= vw_) {
             // window expired
             DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-            DelaySet copy;
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
           } else {
             UnlockSchedStatus();
@@ -8316,7 +6990,7 @@ void SchedulerCommon::Idiom4WatchInstCount(timestamp_t c) {
             // window expired
             DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_INIT);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityMax(curr_thd_id);
             SetPriorityNormal(target);
@@ -8341,7 +7015,7 @@ void SchedulerCommon::Idiom4WatchInstCount(timestamp_t c) {
             // window expired
             DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
             thread_id_t target = s->thd_id_[1];
-            Idiom4SetState(IDIOM4_STATE_INIT);
+            IdiomSetState<IDIOM_4>(IDIOM4_STATE_INIT);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -8355,302 +7029,51 @@ void SchedulerCommon::Idiom4WatchInstCount(timestamp_t c) {
         break;
       case IDIOM4_STATE_E1_WATCH_E2_WATCH:
         if (curr_thd_id == s->thd_id_[0]) {
-          s->window_ += c;
-          if (s->window_ >= vw_) {
-            // window expired
-            DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-            DelaySet copy;
-            thread_id_t target = s->thd_id_[1];
-            Idiom4ClearDelaySet(&copy);
-            Idiom4SetState(IDIOM4_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom4WakeDelaySet(&copy);
-            SetPriorityNormal(target);
-            SetPriorityNormal(curr_thd_id);
-          } else {
-            UnlockSchedStatus();
-          }
-        } else {
-          UnlockSchedStatus();
-        }
-        break;
-      default:
-        UnlockSchedStatus();
-        break;
-    } // end of switch
-
-    if (!restart)
-      break;
-  } // end of while
-}
-
-void SchedulerCommon::Idiom4WatchMutexLock(address_t addr) {
-  Idiom4WatchAccess(addr, WORD_SIZE);
-}
-
-void SchedulerCommon::Idiom4WatchMutexUnlock(address_t addr) {
-  Idiom4WatchAccess(addr, WORD_SIZE);
-}
-
-void SchedulerCommon::Idiom4WatchMemRead(Inst *inst, address_t addr, size_t size,
-                                   bool cand) {
-  Idiom4WatchAccess(addr, size);
-  if (!cand)
-    Idiom4CheckFlush();
-}
-
-void SchedulerCommon::Idiom4WatchMemWrite(Inst *inst, address_t addr, size_t size,
-                                    bool cand) {
-  Idiom4WatchAccess(addr, size);
-  if (!cand)
-    Idiom4CheckFlush();
-}
-
-void SchedulerCommon::Idiom4CheckFlush() {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
-
-  // define a static local variable
-  static int token = 0;
-
-  switch (s->state_) {
-    case IDIOM4_STATE_INIT:
-    case IDIOM4_STATE_E0:
-    case IDIOM4_STATE_E1:
-    case IDIOM4_STATE_DONE:
-      if (token-- <= 0) {
-        FlushWatch();
-        token = 10;
-      }
-      break;
-    default:
-      break;
-  }
-}
-
-bool SchedulerCommon::Idiom4CheckGiveup(int idx) {
-  // return true means actual give up
-  // return false means one more chance
-  if (YieldWithDelay()) {
-    Idiom4SchedStatus *s = idiom4_sched_status_;
-    thread_id_t curr_thd_id = PIN_ThreadUid();
-    DEBUG_FMT_PRINT_SAFE("[T%lx] Check giveup\n", curr_thd_id);
-    static unsigned long last_state[] = {IDIOM4_STATE_INVALID,
-                                         IDIOM4_STATE_INVALID,
-                                         IDIOM4_STATE_INVALID,
-                                         IDIOM4_STATE_INVALID,
-                                         IDIOM4_STATE_INVALID};
-    static thread_id_t last_thd[] = {INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID};
-    static int time_delayed_each[] = {0, 0, 0, 0, 0};
-    static int time_delayed_total = 0;
-    if (time_delayed_each[idx] <= knob_->ValueInt("yield_delay_min_each") ||
-        time_delayed_total <= knob_->ValueInt("yield_delay_max_total")) {
-      if (s->state_ != last_state[idx] || curr_thd_id != last_thd[idx]) {
-        DEBUG_FMT_PRINT_SAFE("[T%lx] time delay\n", curr_thd_id);
-        int time_unit = knob_->ValueInt("yield_delay_unit");
-        last_state[idx] = s->state_;
-        last_thd[idx] = curr_thd_id;
-        time_delayed_each[idx] += time_unit;
-        time_delayed_total += time_unit;
+          s->window_ += c;
+          if (s->window_ >= vw_) {
+            // window expired
+            DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
+            thread_id_t target = s->thd_id_[1];
+            IdiomSetStateAndWake<IDIOM_4>(IDIOM4_STATE_INIT);
+            SetPriorityNormal(target);
+            SetPriorityNormal(curr_thd_id);
+          } else {
+            UnlockSchedStatus();
+          }
+        } else {
+          UnlockSchedStatus();
+        }
+        break;
+      default:
         UnlockSchedStatus();
-        usleep(1000 * time_unit);
-        LockSchedStatus();
-        return false;
-      } else {
-        return true;
-      }
-    } else {
-      return true;
-    }
-  } else {
-    return true;
-  }
-}
-
-void SchedulerCommon::Idiom4SetState(unsigned long s) {
-  DEBUG_FMT_PRINT_SAFE("[T%lx] set state: %s\n", PIN_ThreadUid(),
-                       Idiom4SchedStatus::StateToString(s).c_str());
-  idiom4_sched_status_->state_ = s;
-}
-
-void SchedulerCommon::Idiom4ClearDelaySet(DelaySet *copy) {
-  *copy = idiom4_sched_status_->delay_set_;
-  idiom4_sched_status_->delay_set_.clear();
-}
+        break;
+    } // end of switch
 
-void SchedulerCommon::Idiom4WakeDelaySet(DelaySet *copy) {
-  thread_id_t curr_thd_id = PIN_ThreadUid();
-  SetPriorityMax(curr_thd_id);
-  for (DelaySet::iterator it = copy->begin(); it != copy->end(); ++it) {
-    if (*it != curr_thd_id)
-      SetPriorityNormal(*it);
-  }
+    if (!restart)
+      break;
+  } // end of while
 }
 
 void SchedulerCommon::Idiom4RecordAccess(address_t addr, size_t size) {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   s->recorded_addr_set_.insert(addr);
 }
 
 void SchedulerCommon::Idiom4ClearRecordedAccess() {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   s->recorded_addr_set_.clear();
 }
 
 bool SchedulerCommon::Idiom4Recorded(address_t addr, size_t size) {
-  Idiom4SchedStatus *s = idiom4_sched_status_;
+  Idiom4SchedStatus *s = CurrTarget()->idiom4_sched_status_;
   if (s->recorded_addr_set_.find(addr) != s->recorded_addr_set_.end())
     return true;
   else
     return false;
 }
 
-void SchedulerCommon::Idiom5BeforeiRootMemRead(UINT32 idx, address_t addr,
-                                         size_t size) {
-  if (curr_iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_WRITE)
-    return;
-
-  switch (idx) {
-    case 0:
-      Idiom5BeforeEvent0(addr, size);
-      break;
-    case 1:
-      Idiom5BeforeEvent1(addr, size);
-      break;
-    case 2:
-      Idiom5BeforeEvent2(addr, size);
-      break;
-    case 3:
-      Idiom5BeforeEvent3(addr, size);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom5BeforeiRootMemWrite(UINT32 idx, address_t addr,
-                                          size_t size) {
-  if (curr_iroot_->GetEvent(idx)->type() == IROOT_EVENT_MEM_READ)
-    return;
-
-  switch (idx) {
-    case 0:
-      Idiom5BeforeEvent0(addr, size);
-      break;
-    case 1:
-      Idiom5BeforeEvent1(addr, size);
-      break;
-    case 2:
-      Idiom5BeforeEvent2(addr, size);
-      break;
-    case 3:
-      Idiom5BeforeEvent3(addr, size);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom5AfteriRootMem(UINT32 idx) {
-  switch (idx) {
-    case 0:
-      Idiom5AfterEvent0();
-      break;
-    case 1:
-      Idiom5AfterEvent1();
-      break;
-    case 2:
-      Idiom5AfterEvent2();
-      break;
-    case 3:
-      Idiom5AfterEvent3();
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom5BeforeiRootMutexLock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 0:
-      Idiom5BeforeEvent0(addr, WORD_SIZE);
-      break;
-    case 1:
-      Idiom5BeforeEvent1(addr, WORD_SIZE);
-      break;
-    case 2:
-      Idiom5BeforeEvent2(addr, WORD_SIZE);
-      break;
-    case 3:
-      Idiom5BeforeEvent3(addr, WORD_SIZE);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom5AfteriRootMutexLock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 0:
-      Idiom5AfterEvent0();
-      break;
-    case 1:
-      Idiom5AfterEvent1();
-      break;
-    case 2:
-      Idiom5AfterEvent2();
-      break;
-    case 3:
-      Idiom5AfterEvent3();
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom5BeforeiRootMutexUnlock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 0:
-      Idiom5BeforeEvent0(addr, WORD_SIZE);
-      break;
-    case 1:
-      Idiom5BeforeEvent1(addr, WORD_SIZE);
-      break;
-    case 2:
-      Idiom5BeforeEvent2(addr, WORD_SIZE);
-      break;
-    case 3:
-      Idiom5BeforeEvent3(addr, WORD_SIZE);
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
-void SchedulerCommon::Idiom5AfteriRootMutexUnlock(UINT32 idx, address_t addr) {
-  switch (idx) {
-    case 0:
-      Idiom5AfterEvent0();
-      break;
-    case 1:
-      Idiom5AfterEvent1();
-      break;
-    case 2:
-      Idiom5AfterEvent2();
-      break;
-    case 3:
-      Idiom5AfterEvent3();
-      break;
-    default:
-      Abort("idx invalid\n");
-  }
-}
-
 void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event0", 1);
@@ -8663,10 +7086,8 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
     LockSchedStatus();
     switch (s->state_) {
       case IDIOM5_STATE_INIT:
-        s->thd_id_[0] = curr_thd_id;
-        s->addr_[0] = addr;
-        s->size_[0] = size;
-        Idiom5SetState(IDIOM5_STATE_E0);
+        IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+        IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0);
         UnlockSchedStatus();
         SetPriorityLow(curr_thd_id);
         restart = true;
@@ -8676,16 +7097,14 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           // has to execute event 0, go to watch mode
-          Idiom5SetState(IDIOM5_STATE_E0_WATCH_X);
+          IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_WATCH_X);
           UnlockSchedStatus();
           SetPriorityHigh(curr_thd_id);
         } else {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
+            IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -8702,10 +7121,8 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
         // check NON overlap
         if (!OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
           thread_id_t target = s->thd_id_[2];
-          s->thd_id_[0] = curr_thd_id;
-          s->addr_[0] = addr;
-          s->size_[0] = size;
-          Idiom5SetState(IDIOM5_STATE_E0_E2);
+          IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+          IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E2);
           UnlockSchedStatus();
           // execute event 0 first, then event 2
           SetPriorityHigh(curr_thd_id);
@@ -8714,10 +7131,8 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[2];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom5SetState(IDIOM5_STATE_E0);
+            IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -8734,27 +7149,15 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -8766,16 +7169,10 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom5CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(0)) {
                 thread_id_t target = s->thd_id_[0];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
@@ -8792,15 +7189,9 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -8815,27 +7206,15 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[2]) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -8846,31 +7225,19 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
         } else {
           if (!Idiom5Recorded(2, addr, size)) {
             // goto state E0_E2_WATCH_X
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_X);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_X);
             SetPriorityNormal(target);
             // force to execute event 0
           } else {
             // check overlap
             if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
               if (GetPriority(curr_thd_id) == LowerPriority()) {
-                if (Idiom5CheckGiveup(0)) {
-                  DelaySet copy;
+                if (IdiomCheckGiveup<IDIOM_5>(0)) {
                   thread_id_t target = s->thd_id_[2];
-                  s->thd_id_[0] = curr_thd_id;
-                  s->addr_[0] = addr;
-                  s->size_[0] = size;
-                  Idiom5ClearDelaySet(&copy);
-                  Idiom5SetState(IDIOM5_STATE_E0);
-                  UnlockSchedStatus();
-                  Idiom5WakeDelaySet(&copy);
+                  IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                  IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                   SetPriorityNormal(target);
                   SetPriorityLow(curr_thd_id);
                   restart = true;
@@ -8887,15 +7254,9 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
             } else {
               // random choice
               if (RandomChoice(0.5)) {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[2];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
@@ -8915,16 +7276,10 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(0)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(0)) {
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -8941,15 +7296,9 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
         } else {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[0] = curr_thd_id;
-            s->addr_[0] = addr;
-            s->size_[0] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
@@ -8965,28 +7314,16 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
         DEBUG_ASSERT(!OVERLAP(s->addr_[1], s->size_[1], s->addr_[2], s->size_[2]));
         DEBUG_ASSERT(curr_thd_id != s->thd_id_[1]);
         if (OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
-          DelaySet copy;
-          s->thd_id_[0] = curr_thd_id;
-          s->addr_[0] = addr;
-          s->size_[0] = size;
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_E1_X);
-          UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+          IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_E1_X);
           // force to execute event 0
         } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed any more
-            if (Idiom5CheckGiveup(0)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(0)) {
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9005,15 +7342,9 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           if (Idiom5Recorded(2, addr, size)) {
             // restart with low prob
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9022,15 +7353,9 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
             }
           } else {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_X);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_X);
               SetPriorityNormal(target);
             } else {
               UnlockSchedStatus();
@@ -9047,33 +7372,21 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9082,25 +7395,15 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(2, addr, size)) {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[2];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityLow(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -9114,49 +7417,31 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
             }
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay, goto state E0_WATCH
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9169,14 +7454,10 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom5CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(0)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityLow(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -9194,14 +7475,10 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom5CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(0)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -9220,28 +7497,18 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(2, addr, size)) {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityLow(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -9264,31 +7531,19 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH_E1);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH_E1);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9297,25 +7552,15 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(2, addr, size)) {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[2];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityLow(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -9344,28 +7589,18 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(2, addr, size)) {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityLow(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -9388,49 +7623,31 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
             }
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9458,28 +7675,18 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(2, addr, size)) {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityLow(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -9501,23 +7708,15 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -9525,25 +7724,15 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(2, addr, size)) {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[2];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityLow(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -9558,15 +7747,9 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9576,16 +7759,10 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
             }
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(0)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(0)) {
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9596,15 +7773,9 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9617,16 +7788,10 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target2 = s->thd_id_[2];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target0);
               SetPriorityNormal(target2);
               SetPriorityLow(curr_thd_id);
@@ -9637,17 +7802,11 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(0)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
@@ -9666,28 +7825,18 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(2, addr, size)) {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityLow(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -9709,16 +7858,10 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(0)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(0)) {
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9729,15 +7872,9 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9748,15 +7885,9 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9769,38 +7900,24 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -9813,17 +7930,11 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(0)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(0)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[0] = curr_thd_id;
-                s->addr_[0] = addr;
-                s->size_[0] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
@@ -9841,16 +7952,10 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target2 = s->thd_id_[2];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target0);
               SetPriorityNormal(target2);
               SetPriorityLow(curr_thd_id);
@@ -9861,16 +7966,10 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target2 = s->thd_id_[2];
-              s->thd_id_[0] = curr_thd_id;
-              s->addr_[0] = addr;
-              s->size_[0] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(0, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0);
               SetPriorityNormal(target0);
               SetPriorityNormal(target2);
               SetPriorityLow(curr_thd_id);
@@ -9892,7 +7991,7 @@ void SchedulerCommon::Idiom5BeforeEvent0(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event1", 1);
@@ -9910,11 +8009,7 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -9925,13 +8020,9 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom5CheckGiveup(1)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(1)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -9957,24 +8048,14 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           if (!Idiom5Recorded(2, addr, size)) {
             // TODO: check assertion could fail
             DEBUG_ASSERT(!OVERLAP(addr, size, s->addr_[2], s->size_[2]));
-            DelaySet copy;
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH_E1);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH_E1);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
               // no need to delay
-              DelaySet copy;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
@@ -9986,13 +8067,9 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(1)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(1)) {
                 thread_id_t target = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -10020,13 +8097,9 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(1)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(1)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -10051,13 +8124,13 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
         DEBUG_ASSERT(!OVERLAP(s->addr_[1], s->size_[1], s->addr_[2], s->size_[2]));
         if (curr_thd_id == s->thd_id_[2]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
-          if (Idiom5CheckGiveup(1)) {
+          if (IdiomCheckGiveup<IDIOM_5>(1)) {
             DelaySet copy;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
+            IdiomClearDelaySet<IDIOM_5>(&copy);
+            IdiomSetState<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             Idiom5RecordAccess(2, addr, size);
             UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomWakeDelaySet<IDIOM_5>(&copy);
             SetPriorityLow(curr_thd_id);
           } else {
             UnlockSchedStatus();
@@ -10067,13 +8140,9 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(1)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(1)) {
                 thread_id_t target = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -10101,33 +8170,21 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -10141,24 +8198,14 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // goto state E0_E2_WATCH_E1
             // set priority of thd[0] to high
-            DelaySet copy;
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_E1);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(1, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_E1);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // goto state E0_WATCH
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -10170,14 +8217,10 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(1)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(1)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityLow(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -10195,14 +8238,10 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(1)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(1)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -10232,31 +8271,19 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH_E1);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH_E1);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -10270,11 +8297,11 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           DEBUG_ASSERT(OVERLAP(addr, size, s->addr_[1], s->size_[1]));
           DelaySet copy;
           thread_id_t target = s->thd_id_[0];
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_E1_WATCH_X);
+          IdiomClearDelaySet<IDIOM_5>(&copy);
+          IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_E1_WATCH_X);
           Idiom5RecordAccess(2, addr, size);
           UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomWakeDelaySet<IDIOM_5>(&copy);
           SetPriorityNormal(target);
         } else {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
@@ -10309,25 +8336,19 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
             // done, goto state E0_E1_E2_E3
             DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_E1_E2_E3);
+            IdiomRecordEvent<IDIOM_5>(1, curr_thd_id, addr, size);
+            IdiomClearDelaySet<IDIOM_5>(&copy);
+            IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E1_E2_E3);
             ActivelyExposed();
             DEBUG_FMT_PRINT_SAFE("[T%lx] iRoot %u exposed.\n",
-                                 curr_thd_id, curr_iroot_->id());
+                                 curr_thd_id, CurrTarget()->iroot_->id());
             UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomWakeDelaySet<IDIOM_5>(&copy);
             SetPriorityHigh(target);
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -10365,23 +8386,15 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -10396,13 +8409,9 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
             UnlockSchedStatus();
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(1)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(1)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -10420,14 +8429,10 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(1)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(1)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -10457,13 +8462,9 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(1)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(1)) {
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -10484,24 +8485,18 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
             // iroot satisfied
             DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[1] = curr_thd_id;
-            s->addr_[1] = addr;
-            s->size_[1] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_E1_E2_E3);
+            IdiomRecordEvent<IDIOM_5>(1, curr_thd_id, addr, size);
+            IdiomClearDelaySet<IDIOM_5>(&copy);
+            IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E1_E2_E3);
             ActivelyExposed();
             DEBUG_FMT_PRINT_SAFE("[T%lx] iRoot %u exposed.\n",
-                                 curr_thd_id, curr_iroot_->id());
+                                 curr_thd_id, CurrTarget()->iroot_->id());
             UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomWakeDelaySet<IDIOM_5>(&copy);
             SetPriorityNormal(target);
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -10513,14 +8508,10 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(1)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(1)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -10553,7 +8544,7 @@ void SchedulerCommon::Idiom5BeforeEvent1(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event2", 1);
@@ -10566,10 +8557,8 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
     LockSchedStatus();
     switch (s->state_) {
       case IDIOM5_STATE_INIT:
-        s->thd_id_[2] = curr_thd_id;
-        s->addr_[2] = addr;
-        s->size_[2] = size;
-        Idiom5SetState(IDIOM5_STATE_E2);
+        IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+        IdiomSetState<IDIOM_5>(IDIOM5_STATE_E2);
         UnlockSchedStatus();
         SetPriorityLow(curr_thd_id);
         restart = true;
@@ -10580,10 +8569,8 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
         // check NON overlap
         if (!OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           thread_id_t target = s->thd_id_[0];
-          s->thd_id_[2] = curr_thd_id;
-          s->addr_[2] = addr;
-          s->size_[2] = size;
-          Idiom5SetState(IDIOM5_STATE_E0_E2);
+          IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+          IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E2);
           UnlockSchedStatus();
           // execute event 0 first, then event 2
           SetPriorityMax(curr_thd_id);
@@ -10593,10 +8580,8 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
-            Idiom5SetState(IDIOM5_STATE_E2);
+            IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+            IdiomSetState<IDIOM_5>(IDIOM5_STATE_E2);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -10612,16 +8597,14 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[2]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           // has to execute event 2, go to watch mode
-          Idiom5SetState(IDIOM5_STATE_E2_WATCH_X);
+          IdiomSetState<IDIOM_5>(IDIOM5_STATE_E2_WATCH_X);
           UnlockSchedStatus();
           SetPriorityHigh(curr_thd_id);
         } else {
           // random choice
           if (RandomChoice(0.5)) {
             thread_id_t target = s->thd_id_[2];
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
+            IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
             UnlockSchedStatus();
             SetPriorityHigh(curr_thd_id);
             SetPriorityNormal(target);
@@ -10637,27 +8620,15 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[0]) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -10668,15 +8639,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
         } else {
           if (!Idiom5Recorded(0, addr, size)) {
             // goto state E0_E2_WATCH_X
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_X);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_X);
             SetPriorityNormal(target);
             // force to execute event 2
           } else {
@@ -10684,16 +8649,10 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
             if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
               if (GetPriority(curr_thd_id) == LowerPriority()) {
                 // cannot be delayed any more
-                if (Idiom5CheckGiveup(2)) {
-                  DelaySet copy;
+                if (IdiomCheckGiveup<IDIOM_5>(2)) {
                   thread_id_t target = s->thd_id_[0];
-                  s->thd_id_[2] = curr_thd_id;
-                  s->addr_[2] = addr;
-                  s->size_[2] = size;
-                  Idiom5ClearDelaySet(&copy);
-                  Idiom5SetState(IDIOM5_STATE_E2);
-                  UnlockSchedStatus();
-                  Idiom5WakeDelaySet(&copy);
+                  IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                  IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                   SetPriorityNormal(target);
                   SetPriorityLow(curr_thd_id);
                   restart = true;
@@ -10710,15 +8669,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
             } else {
               // random choice
               if (RandomChoice(0.5)) {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[0];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
@@ -10734,28 +8687,16 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[2]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
-            // no need to delay
-            DelaySet copy;
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            // no need to delay
+            IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
@@ -10767,16 +8708,10 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom5CheckGiveup(2)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(2)) {
                 thread_id_t target = s->thd_id_[2];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
@@ -10793,15 +8728,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           } else {
             // random choice
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -10820,16 +8749,10 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(2)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(2)) {
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -10844,29 +8767,17 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
             restart = true;
           }
         } else if (OVERLAP(addr, size, s->addr_[3], s->size_[3])) {
-          DelaySet copy;
-          s->thd_id_[2] = curr_thd_id;
-          s->addr_[2] = addr;
-          s->size_[2] = size;
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_E3_X);
-          UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+          IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_E3_X);
           // force to execute event 2
         } else {
           // random choice
           if (Idiom5Recorded(0, addr, size)) {
             // restart with low prob
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -10875,15 +8786,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
             }
           } else {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_X);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_X);
               SetPriorityNormal(target);
             } else {
               UnlockSchedStatus();
@@ -10900,15 +8805,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
         if (OVERLAP(addr, size, s->addr_[1], s->size_[1])) {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
@@ -10918,16 +8817,10 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
         } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot not be delayed
-            if (Idiom5CheckGiveup(2)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(2)) {
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -10944,15 +8837,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
         } else {
           // random choice (restart with low prob)
           if (RandomChoice(0.2)) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            s->thd_id_[2] = curr_thd_id;
-            s->addr_[2] = addr;
-            s->size_[2] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
             SetPriorityNormal(target);
             SetPriorityLow(curr_thd_id);
             restart = true;
@@ -10970,33 +8857,21 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay, goto state E2_WATCH
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -11004,15 +8879,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -11025,34 +8894,22 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
             }
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -11060,25 +8917,15 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(0, addr, size)) {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[0];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[0];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -11092,14 +8939,10 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(2)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(2)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityLow(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -11117,14 +8960,10 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(2)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(2)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -11143,28 +8982,18 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(0, addr, size)) {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -11187,33 +9016,21 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -11221,15 +9038,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -11256,28 +9067,18 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           } else {
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(0, addr, size)) {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -11300,58 +9101,36 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
             }
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH_E3);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH_E3);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(0, addr, size)) {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[0];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[0];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -11380,28 +9159,18 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(0, addr, size)) {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -11423,38 +9192,24 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
             DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -11468,15 +9223,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -11486,16 +9235,10 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
             }
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(2)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(2)) {
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -11506,15 +9249,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -11527,16 +9264,10 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target2 = s->thd_id_[2];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target0);
               SetPriorityNormal(target2);
               SetPriorityLow(curr_thd_id);
@@ -11547,17 +9278,11 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(2)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(2)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
@@ -11575,16 +9300,10 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target2 = s->thd_id_[2];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target0);
               SetPriorityNormal(target2);
               SetPriorityLow(curr_thd_id);
@@ -11605,16 +9324,10 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(2)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(2)) {
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -11625,15 +9338,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -11644,15 +9351,9 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           } else {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -11665,23 +9366,15 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -11689,25 +9382,15 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(0, addr, size)) {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[0];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                 SetPriorityNormal(target);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target = s->thd_id_[0];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -11721,17 +9404,11 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(2)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(2)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
@@ -11749,16 +9426,10 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
-              DelaySet copy;
               thread_id_t target0 = s->thd_id_[0];
               thread_id_t target2 = s->thd_id_[2];
-              s->thd_id_[2] = curr_thd_id;
-              s->addr_[2] = addr;
-              s->size_[2] = size;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
               SetPriorityNormal(target0);
               SetPriorityNormal(target2);
               SetPriorityLow(curr_thd_id);
@@ -11770,28 +9441,18 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
             // random choice (restart with low prob)
             if (RandomChoice(0.2)) {
               if (Idiom5Recorded(0, addr, size)) {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                s->thd_id_[2] = curr_thd_id;
-                s->addr_[2] = addr;
-                s->size_[2] = size;
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomRecordEvent<IDIOM_5>(2, curr_thd_id, addr, size);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityLow(curr_thd_id);
                 restart = true;
               } else {
-                DelaySet copy;
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -11814,7 +9475,7 @@ void SchedulerCommon::Idiom5BeforeEvent2(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("event3", 1);
@@ -11832,24 +9493,14 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (!Idiom5Recorded(0, addr, size)) {
             DEBUG_ASSERT(!OVERLAP(addr, size, s->addr_[0], s->size_[0]));
-            DelaySet copy;
-            s->thd_id_[3] = curr_thd_id;
-            s->addr_[3] = addr;
-            s->size_[3] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH_E3);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(3, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH_E3);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
             if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
               // no need to delay
-              DelaySet copy;
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
@@ -11861,13 +9512,9 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(3)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -11892,11 +9539,7 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -11907,13 +9550,9 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(3)) {
                 thread_id_t target = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -11939,13 +9578,13 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
         DEBUG_ASSERT(!OVERLAP(s->addr_[0], s->size_[0], s->addr_[3], s->size_[3]));
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
-          if (Idiom5CheckGiveup(3)) {
+          if (IdiomCheckGiveup<IDIOM_5>(3)) {
             DelaySet copy;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
+            IdiomClearDelaySet<IDIOM_5>(&copy);
+            IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             Idiom5RecordAccess(0, addr, size);
             UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomWakeDelaySet<IDIOM_5>(&copy);
             SetPriorityLow(curr_thd_id);
           } else {
             UnlockSchedStatus();
@@ -11955,13 +9594,9 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(3)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -11989,13 +9624,9 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
         if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(3)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(3)) {
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -12022,26 +9653,16 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // goto state E2_WATCH
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // goto state E0_E2_WATCH_E3
             // set priority of thd[2] to high
-            DelaySet copy;
-            s->thd_id_[3] = curr_thd_id;
-            s->addr_[3] = addr;
-            s->size_[3] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_E3);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomRecordEvent<IDIOM_5>(3, curr_thd_id, addr, size);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_E3);
             SetPriorityLow(curr_thd_id);
             restart = true;
           } else {
@@ -12052,34 +9673,22 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
             }
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -12091,14 +9700,10 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(3)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityLow(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -12116,14 +9721,10 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(3)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -12156,10 +9757,7 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
             // no need to delay
             DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -12168,16 +9766,14 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
             // force to execute event 1 first
             DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            s->thd_id_[3] = curr_thd_id;
-            s->addr_[3] = addr;
-            s->size_[3] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_E1_E2_E3);
+            IdiomRecordEvent<IDIOM_5>(3, curr_thd_id, addr, size);
+            IdiomClearDelaySet<IDIOM_5>(&copy);
+            IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E1_E2_E3);
             ActivelyExposed();
             DEBUG_FMT_PRINT_SAFE("[T%lx] iRoot %u exposed.\n",
-                                 curr_thd_id, curr_iroot_->id());
+                                 curr_thd_id, CurrTarget()->iroot_->id());
             UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomWakeDelaySet<IDIOM_5>(&copy);
             SetPriorityHigh(target);
           } else {
             Idiom5RecordAccess(0, addr, size);
@@ -12214,43 +9810,31 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           DEBUG_ASSERT(OVERLAP(addr, size, s->addr_[3], s->size_[3]));
           DelaySet copy;
           thread_id_t target = s->thd_id_[2];
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_E3_WATCH_X);
+          IdiomClearDelaySet<IDIOM_5>(&copy);
+          IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_E3_WATCH_X);
           Idiom5RecordAccess(0, addr, size);
           UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomWakeDelaySet<IDIOM_5>(&copy);
           SetPriorityNormal(target);
         } else if (curr_thd_id == s->thd_id_[2]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
             }
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH_E3);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH_E3);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -12286,10 +9870,7 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -12297,16 +9878,14 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
             // iroot satisfied
             DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            s->thd_id_[3] = curr_thd_id;
-            s->addr_[3] = addr;
-            s->size_[3] = size;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_E1_E2_E3);
+            IdiomRecordEvent<IDIOM_5>(3, curr_thd_id, addr, size);
+            IdiomClearDelaySet<IDIOM_5>(&copy);
+            IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E1_E2_E3);
             ActivelyExposed();
             DEBUG_FMT_PRINT_SAFE("[T%lx] iRoot %u exposed.\n",
-                                 curr_thd_id, curr_iroot_->id());
+                                 curr_thd_id, CurrTarget()->iroot_->id());
             UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomWakeDelaySet<IDIOM_5>(&copy);
             SetPriorityNormal(target);
           } else {
             Idiom5RecordAccess(0, addr, size);
@@ -12319,13 +9898,9 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
             UnlockSchedStatus();
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(3)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(3)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -12343,14 +9918,10 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed any more
-              if (Idiom5CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(3)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -12380,13 +9951,9 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(3)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(3)) {
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -12405,23 +9972,15 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -12433,14 +9992,10 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(3)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(3)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -12473,7 +10028,7 @@ void SchedulerCommon::Idiom5BeforeEvent3(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom5AfterEvent0() {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 0\n", curr_thd_id);
@@ -12499,7 +10054,7 @@ void SchedulerCommon::Idiom5AfterEvent0() {
         s->window_[0] = 0;
         Idiom5ClearRecordedAccess(0);
         Idiom5RecordAccess(0, s->addr_[0], s->size_[0]);
-        Idiom5SetState(IDIOM5_STATE_E0_WATCH);
+        IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
         UnlockSchedStatus();
         FlushWatch();
         SetPriorityLow(curr_thd_id);
@@ -12513,7 +10068,7 @@ void SchedulerCommon::Idiom5AfterEvent0() {
         s->window_[0] = 0;
         Idiom5ClearRecordedAccess(0);
         Idiom5RecordAccess(0, s->addr_[0], s->size_[0]);
-        Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH);
+        IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH);
         UnlockSchedStatus();
         SetPriorityMax(curr_thd_id);
         SetPriorityHigh(target);
@@ -12527,7 +10082,7 @@ void SchedulerCommon::Idiom5AfterEvent0() {
         s->window_[0] = 0;
         Idiom5ClearRecordedAccess(0);
         Idiom5RecordAccess(0, s->addr_[0], s->size_[0]);
-        Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_E1);
+        IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_E1);
         UnlockSchedStatus();
         SetPriorityHigh(curr_thd_id);
       } else {
@@ -12541,7 +10096,7 @@ void SchedulerCommon::Idiom5AfterEvent0() {
 }
 
 void SchedulerCommon::Idiom5AfterEvent1() {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 1\n", curr_thd_id);
@@ -12551,7 +10106,7 @@ void SchedulerCommon::Idiom5AfterEvent1() {
     case IDIOM5_STATE_E0_E2_WATCH_E1_WATCH_X:
       if (curr_thd_id == s->thd_id_[1]) {
         thread_id_t target = s->thd_id_[0];
-        Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_E1_WATCH);
+        IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_E1_WATCH);
         UnlockSchedStatus();
         SetPriorityMax(curr_thd_id);
         SetPriorityHigh(target);
@@ -12577,7 +10132,7 @@ void SchedulerCommon::Idiom5AfterEvent1() {
 }
 
 void SchedulerCommon::Idiom5AfterEvent2() {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 2\n", curr_thd_id);
@@ -12589,7 +10144,7 @@ void SchedulerCommon::Idiom5AfterEvent2() {
         s->window_[1] = 0;
         Idiom5ClearRecordedAccess(2);
         Idiom5RecordAccess(2, s->addr_[2], s->size_[2]);
-        Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH);
+        IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH);
         UnlockSchedStatus();
         SetPriorityHigh(curr_thd_id);
       } else {
@@ -12601,7 +10156,7 @@ void SchedulerCommon::Idiom5AfterEvent2() {
         s->window_[1] = 0;
         Idiom5ClearRecordedAccess(2);
         Idiom5RecordAccess(2, s->addr_[2], s->size_[2]);
-        Idiom5SetState(IDIOM5_STATE_E2_WATCH);
+        IdiomSetState<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
         UnlockSchedStatus();
         FlushWatch();
         SetPriorityLow(curr_thd_id);
@@ -12615,7 +10170,7 @@ void SchedulerCommon::Idiom5AfterEvent2() {
         s->window_[1] = 0;
         Idiom5ClearRecordedAccess(2);
         Idiom5RecordAccess(2, s->addr_[2], s->size_[2]);
-        Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH);
+        IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH);
         UnlockSchedStatus();
         SetPriorityMax(curr_thd_id);
         SetPriorityHigh(target);
@@ -12629,7 +10184,7 @@ void SchedulerCommon::Idiom5AfterEvent2() {
         s->window_[1] = 0;
         Idiom5ClearRecordedAccess(2);
         Idiom5RecordAccess(2, s->addr_[2], s->size_[2]);
-        Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_E3);
+        IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_E3);
         UnlockSchedStatus();
         SetPriorityHigh(curr_thd_id);
       } else {
@@ -12643,7 +10198,7 @@ void SchedulerCommon::Idiom5AfterEvent2() {
 }
 
 void SchedulerCommon::Idiom5AfterEvent3() {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_FMT_PRINT_SAFE("[T%lx] after event 3\n", curr_thd_id);
@@ -12653,7 +10208,7 @@ void SchedulerCommon::Idiom5AfterEvent3() {
     case IDIOM5_STATE_E0_E2_WATCH_E3_WATCH_X:
       if (curr_thd_id == s->thd_id_[3]) {
         thread_id_t target = s->thd_id_[2];
-        Idiom5SetState(IDIOM5_STATE_E0_E2_WATCH_E3_WATCH);
+        IdiomSetState<IDIOM_5>(IDIOM5_STATE_E0_E2_WATCH_E3_WATCH);
         UnlockSchedStatus();
         SetPriorityMax(curr_thd_id);
         SetPriorityHigh(target);
@@ -12679,7 +10234,7 @@ void SchedulerCommon::Idiom5AfterEvent3() {
 }
 
 void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   DEBUG_STAT_INC("watch_access", 1);
@@ -12696,11 +10251,7 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // no need to delay
-            DelaySet copy;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -12711,13 +10262,9 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(4)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(4)) {
                 thread_id_t target = s->thd_id_[0];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -12742,11 +10289,7 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // no need to delay
-            DelaySet copy;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_INIT);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else {
@@ -12757,13 +10300,9 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(4)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(4)) {
                 thread_id_t target = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target);
                 SetPriorityNormal(curr_thd_id);
                 restart = true;
@@ -12791,13 +10330,9 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
         if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(4)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(4)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -12824,13 +10359,9 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
         if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
           if (GetPriority(curr_thd_id) == LowerPriority()) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(4)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(4)) {
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -12856,33 +10387,21 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -12895,33 +10414,21 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             }
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -12933,14 +10440,10 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(4)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(4)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
                 SetPriorityNormal(target0);
                 SetPriorityLow(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -12958,14 +10461,10 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(4)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(4)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
                 SetPriorityLow(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -12995,31 +10494,19 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
-            DelaySet copy;
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH_E1);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH_E1);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
@@ -13059,33 +10546,21 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (RandomChoice(0.5)) {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
               SetPriorityLow(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
             } else {
-              DelaySet copy;
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
               SetPriorityNormal(target);
               SetPriorityLow(curr_thd_id);
               restart = true;
             }
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -13122,22 +10597,14 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
         if (curr_thd_id == s->thd_id_[0]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[2];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -13152,13 +10619,9 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
             UnlockSchedStatus();
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(4)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(4)) {
               thread_id_t target = s->thd_id_[0];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -13176,14 +10639,10 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(4)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(4)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -13213,13 +10672,9 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == LowerPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             // cannot be delayed
-            if (Idiom5CheckGiveup(4)) {
-              DelaySet copy;
+            if (IdiomCheckGiveup<IDIOM_5>(4)) {
               thread_id_t target = s->thd_id_[2];
-              Idiom5ClearDelaySet(&copy);
-              Idiom5SetState(IDIOM5_STATE_INIT);
-              UnlockSchedStatus();
-              Idiom5WakeDelaySet(&copy);
+              IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
               SetPriorityNormal(target);
               SetPriorityNormal(curr_thd_id);
               restart = true;
@@ -13237,22 +10692,14 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
         } else if (curr_thd_id == s->thd_id_[2]) {
           DEBUG_ASSERT(GetPriority(curr_thd_id) == HigherPriority());
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
           } else if (OVERLAP(addr, size, s->addr_[2], s->size_[2])) {
-            DelaySet copy;
             thread_id_t target = s->thd_id_[0];
-            Idiom5ClearDelaySet(&copy);
-            Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-            UnlockSchedStatus();
-            Idiom5WakeDelaySet(&copy);
+            IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
             SetPriorityLow(target);
             SetPriorityNormal(curr_thd_id);
             restart = true;
@@ -13264,14 +10711,10 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
           if (OVERLAP(addr, size, s->addr_[0], s->size_[0])) {
             if (GetPriority(curr_thd_id) == LowerPriority()) {
               // cannot be delayed
-              if (Idiom5CheckGiveup(4)) {
-                DelaySet copy;
+              if (IdiomCheckGiveup<IDIOM_5>(4)) {
                 thread_id_t target0 = s->thd_id_[0];
                 thread_id_t target2 = s->thd_id_[2];
-                Idiom5ClearDelaySet(&copy);
-                Idiom5SetState(IDIOM5_STATE_INIT);
-                UnlockSchedStatus();
-                Idiom5WakeDelaySet(&copy);
+                IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
                 SetPriorityNormal(target0);
                 SetPriorityNormal(target2);
                 SetPriorityNormal(curr_thd_id);
@@ -13304,7 +10747,7 @@ void SchedulerCommon::Idiom5WatchAccess(address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom5WatchInstCount(timestamp_t c) {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   thread_id_t curr_thd_id = PIN_ThreadUid();
 
   LockSchedStatus();
@@ -13316,11 +10759,7 @@ void SchedulerCommon::Idiom5WatchInstCount(timestamp_t c) {
         if (s->window_[0] >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_INIT);
-          UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
           SetPriorityNormal(curr_thd_id);
         } else {
           UnlockSchedStatus();
@@ -13336,11 +10775,7 @@ void SchedulerCommon::Idiom5WatchInstCount(timestamp_t c) {
         if (s->window_[1] >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_INIT);
-          UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_INIT);
           SetPriorityNormal(curr_thd_id);
         } else {
           UnlockSchedStatus();
@@ -13362,12 +10797,8 @@ void SchedulerCommon::Idiom5WatchInstCount(timestamp_t c) {
         if (s->window_[0] >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
           thread_id_t target = s->thd_id_[2];
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-          UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
           SetPriorityLow(target);
           SetPriorityNormal(curr_thd_id);
         } else {
@@ -13379,12 +10810,8 @@ void SchedulerCommon::Idiom5WatchInstCount(timestamp_t c) {
         if (s->window_[1] >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
           thread_id_t target = s->thd_id_[0];
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-          UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
           SetPriorityLow(target);
           SetPriorityNormal(curr_thd_id);
         } else {
@@ -13400,11 +10827,7 @@ void SchedulerCommon::Idiom5WatchInstCount(timestamp_t c) {
         if (s->window_[0] >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_E2_WATCH_E1);
-          UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH_E1);
           SetPriorityNormal(curr_thd_id);
         } else {
           UnlockSchedStatus();
@@ -13419,11 +10842,7 @@ void SchedulerCommon::Idiom5WatchInstCount(timestamp_t c) {
         if (s->window_[1] >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_E0_WATCH_E3);
-          UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH_E3);
           SetPriorityNormal(curr_thd_id);
         } else {
           UnlockSchedStatus();
@@ -13438,12 +10857,8 @@ void SchedulerCommon::Idiom5WatchInstCount(timestamp_t c) {
         if (s->window_[0] >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
           thread_id_t target = s->thd_id_[2];
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_E2_WATCH);
-          UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E2_WATCH);
           SetPriorityLow(target);
           SetPriorityNormal(curr_thd_id);
         } else {
@@ -13459,12 +10874,8 @@ void SchedulerCommon::Idiom5WatchInstCount(timestamp_t c) {
         if (s->window_[1] >= vw_) {
           // window expired
           DEBUG_FMT_PRINT_SAFE("[T%lx] window expired\n", curr_thd_id);
-          DelaySet copy;
           thread_id_t target = s->thd_id_[0];
-          Idiom5ClearDelaySet(&copy);
-          Idiom5SetState(IDIOM5_STATE_E0_WATCH);
-          UnlockSchedStatus();
-          Idiom5WakeDelaySet(&copy);
+          IdiomSetStateAndWake<IDIOM_5>(IDIOM5_STATE_E0_WATCH);
           SetPriorityLow(target);
           SetPriorityNormal(curr_thd_id);
         } else {
@@ -13480,115 +10891,8 @@ void SchedulerCommon::Idiom5WatchInstCount(timestamp_t c) {
   } // end of switch
 }
 
-void SchedulerCommon::Idiom5WatchMutexLock(address_t addr) {
-  Idiom5WatchAccess(addr, WORD_SIZE);
-}
-
-void SchedulerCommon::Idiom5WatchMutexUnlock(address_t addr) {
-  Idiom5WatchAccess(addr, WORD_SIZE);
-}
-
-void SchedulerCommon::Idiom5WatchMemRead(Inst *inst, address_t addr, size_t size,
-                                   bool cand) {
-  Idiom5WatchAccess(addr, size);
-  if (!cand)
-    Idiom5CheckFlush();
-}
-
-void SchedulerCommon::Idiom5WatchMemWrite(Inst *inst, address_t addr, size_t size,
-                                    bool cand) {
-  Idiom5WatchAccess(addr, size);
-  if (!cand)
-    Idiom5CheckFlush();
-}
-
-void SchedulerCommon::Idiom5CheckFlush() {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
-
-  // define a static local variable
-  static int token = 0;
-
-  switch (s->state_) {
-    case IDIOM5_STATE_INIT:
-    case IDIOM5_STATE_E0:
-    case IDIOM5_STATE_E2:
-    case IDIOM5_STATE_E0_E1_E2_E3:
-    case IDIOM5_STATE_DONE:
-      if (token-- <= 0) {
-        FlushWatch();
-        token = 10;
-      }
-      break;
-    default:
-      break;
-  }
-}
-
-bool SchedulerCommon::Idiom5CheckGiveup(int idx) {
-  // return true means actual give up
-  // return false means one more chance
-  if (YieldWithDelay()) {
-    Idiom5SchedStatus *s = idiom5_sched_status_;
-    thread_id_t curr_thd_id = PIN_ThreadUid();
-    DEBUG_FMT_PRINT_SAFE("[T%lx] Check giveup\n", curr_thd_id);
-    static unsigned long last_state[] = {IDIOM5_STATE_INVALID,
-                                         IDIOM5_STATE_INVALID,
-                                         IDIOM5_STATE_INVALID,
-                                         IDIOM5_STATE_INVALID,
-                                         IDIOM5_STATE_INVALID};
-    static thread_id_t last_thd[] = {INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID,
-                                     INVALID_THD_ID};
-    static int time_delayed_each[] = {0, 0, 0, 0, 0};
-    static int time_delayed_total = 0;
-    if (time_delayed_each[idx] <= knob_->ValueInt("yield_delay_min_each") ||
-        time_delayed_total <= knob_->ValueInt("yield_delay_max_total")) {
-      if (s->state_ != last_state[idx] || curr_thd_id != last_thd[idx]) {
-        DEBUG_FMT_PRINT_SAFE("[T%lx] time delay\n", curr_thd_id);
-        int time_unit = knob_->ValueInt("yield_delay_unit");
-        last_state[idx] = s->state_;
-        last_thd[idx] = curr_thd_id;
-        time_delayed_each[idx] += time_unit;
-        time_delayed_total += time_unit;
-        UnlockSchedStatus();
-        usleep(1000 * time_unit);
-        LockSchedStatus();
-        return false;
-      } else {
-        return true;
-      }
-    } else {
-      return true;
-    }
-  } else {
-    return true;
-  }
-}
-
-void SchedulerCommon::Idiom5SetState(unsigned long s) {
-  DEBUG_FMT_PRINT_SAFE("[T%lx] set state: %s\n", PIN_ThreadUid(),
-                       Idiom5SchedStatus::StateToString(s).c_str());
-  idiom5_sched_status_->state_ = s;
-}
-
-void SchedulerCommon::Idiom5ClearDelaySet(DelaySet *copy) {
-  *copy = idiom5_sched_status_->delay_set_;
-  idiom5_sched_status_->delay_set_.clear();
-}
-
-void SchedulerCommon::Idiom5WakeDelaySet(DelaySet *copy) {
-  thread_id_t curr_thd_id = PIN_ThreadUid();
-  SetPriorityHigh(curr_thd_id);
-  for (DelaySet::iterator it = copy->begin(); it != copy->end(); ++it) {
-    if (*it != curr_thd_id)
-      SetPriorityNormal(*it);
-  }
-}
-
 void SchedulerCommon::Idiom5RecordAccess(int idx, address_t addr, size_t size) {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   if (idx == 0) {
     s->recorded_addr_set0_.insert(addr);
   } else if (idx == 2) {
@@ -13599,7 +10903,7 @@ void SchedulerCommon::Idiom5RecordAccess(int idx, address_t addr, size_t size) {
 }
 
 void SchedulerCommon::Idiom5ClearRecordedAccess(int idx) {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   if (idx == 0) {
     s->recorded_addr_set0_.clear();
   } else if (idx == 2) {
@@ -13610,7 +10914,7 @@ void SchedulerCommon::Idiom5ClearRecordedAccess(int idx) {
 }
 
 bool SchedulerCommon::Idiom5Recorded(int idx, address_t addr, size_t size) {
-  Idiom5SchedStatus *s = idiom5_sched_status_;
+  Idiom5SchedStatus *s = CurrTarget()->idiom5_sched_status_;
   if (idx == 0) {
     return s->recorded_addr_set0_.find(addr) != s->recorded_addr_set0_.end();
   } else if (idx == 2) {
@@ -13621,16 +10925,20 @@ bool SchedulerCommon::Idiom5Recorded(int idx, address_t addr, size_t size) {
   }
 }
 
-void SchedulerCommon::__BeforeiRootMemRead(UINT32 idx, ADDRINT addr, UINT32 size) {
-  ((SchedulerCommon *)ctrl_)->HandleBeforeiRootMemRead(idx, addr, size);
+void SchedulerCommon::__BeforeiRootMemRead(SchedTarget *target, UINT32 idx,
+                                           ADDRINT addr, UINT32 size) {
+  ((SchedulerCommon *)ctrl_)->HandleBeforeiRootMemRead(target, idx, addr,
+                                                       size);
 }
 
-void SchedulerCommon::__BeforeiRootMemWrite(UINT32 idx, ADDRINT addr, UINT32 size) {
-  ((SchedulerCommon *)ctrl_)->HandleBeforeiRootMemWrite(idx, addr, size);
+void SchedulerCommon::__BeforeiRootMemWrite(SchedTarget *target, UINT32 idx,
+                                            ADDRINT addr, UINT32 size) {
+  ((SchedulerCommon *)ctrl_)->HandleBeforeiRootMemWrite(target, idx, addr,
+                                                        size);
 }
 
-void SchedulerCommon::__AfteriRootMem(UINT32 idx) {
-  ((SchedulerCommon *)ctrl_)->HandleAfteriRootMem(idx);
+void SchedulerCommon::__AfteriRootMem(SchedTarget *target, UINT32 idx) {
+  ((SchedulerCommon *)ctrl_)->HandleAfteriRootMem(target, idx);
 }
 
 void SchedulerCommon::__WatchMemRead(Inst *inst, ADDRINT addr, UINT32 size,
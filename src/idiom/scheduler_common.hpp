@@ -21,7 +21,11 @@
 #define IDIOM_SCHEDULER_COMMON_HPP_
 
 #include <cstring>
+#include <map>
 #include <set>
+#include <string>
+#include <vector>
+#include <tr1/unordered_map>
 #include <tr1/unordered_set>
 #include "core/basictypes.h"
 #include "core/execution_control.hpp"
@@ -31,10 +35,108 @@
 namespace idiom {
 
 class SchedulerCommon;
+class SchedTarget;
+struct IdiomOps;
 
 // a set of thread that have been delayed
 typedef std::set<thread_id_t> DelaySet;
 
+// set the bit of a state (or an event index) in a description mask
+#define IDIOM_STATE_BIT(s) (1 << (s))
+#define IDIOM_EVENT_BIT(i) (1 << (i))
+
+// The compile-time description of an idiom used by the active
+// scheduler. It does not encode the event order or the thread and
+// variable constraints, and it does not drive the state transitions:
+// those are hand written for each idiom (see IdiomXBeforeEventY),
+// because their delay, give-up and random choices differ per idiom and
+// state. The transitions are built from shared steps (IdiomRecordEvent,
+// IdiomSetState, IdiomSetStateAndWake, IdiomCheckGiveup). Only the
+// parts that are common to the state machines (the watch states, the
+// events that can be mutex operations and the delay bookkeeping) are
+// shared templates parameterized by this description. Each
+// specialization defines:
+//   kNumEvents         - the number of events in the idiom
+//   kNumStates         - the number of states (states are 0..n-1)
+//   kInvalidState, kInitState, kDoneState
+//   kWatchStates       - the states in which memory accesses are watched
+//   kWatchInstCount    - whether inst counts are watched in kWatchStates
+//   kFlushStates       - the states in which no watch is needed
+//   kMutexLockEvents   - the events that can be mutex locks
+//   kMutexUnlockEvents - the events that can be mutex unlocks
+//   kWakeMaxPriority   - whether the waker runs with the max priority
+//   kStateNames        - the names of the states (for debugging)
+template <IdiomType IDIOM>
+struct IdiomSchedDesc;
+
+// The common part of the state machine status of an idiom.
+template <IdiomType IDIOM>
+class IdiomSchedStatus {
+ public:
+  typedef IdiomSchedDesc<IDIOM> Desc;
+
+  IdiomSchedStatus();
+  ~IdiomSchedStatus() {}
+
+  bool Involved(thread_id_t thd_id);
+
+  static const char *StateToString(unsigned long s) {
+    if (s >= (unsigned long)Desc::kNumStates)
+      return "INVALID";
+    return Desc::kStateNames[s];
+  }
+
+ protected:
+  unsigned long state_;
+  thread_id_t thd_id_[Desc::kNumEvents];
+  address_t addr_[Desc::kNumEvents];
+  size_t size_[Desc::kNumEvents];
+  DelaySet delay_set_;
+
+  // the last delays (see CheckGiveup)
+  unsigned long last_state_[Desc::kNumEvents + 1];
+  thread_id_t last_thd_[Desc::kNumEvents + 1];
+  int time_delayed_each_[Desc::kNumEvents + 1];
+  int time_delayed_total_;
+
+  friend class SchedulerCommon;
+
+ private:
+  DISALLOW_COPY_CONSTRUCTORS(IdiomSchedStatus);
+};
+
+template <IdiomType IDIOM>
+IdiomSchedStatus<IDIOM>::IdiomSchedStatus()
+    : state_(Desc::kInitState),
+      time_delayed_total_(0) {
+  for (int i = 0; i < Desc::kNumEvents; i++) {
+    thd_id_[i] = INVALID_THD_ID;
+    addr_[i] = 0;
+    size_[i] = 0;
+  }
+  for (int i = 0; i < Desc::kNumEvents + 1; i++) {
+    last_state_[i] = Desc::kInvalidState;
+    last_thd_[i] = INVALID_THD_ID;
+    time_delayed_each_[i] = 0;
+  }
+}
+
+template <IdiomType IDIOM>
+bool IdiomSchedStatus<IDIOM>::Involved(thread_id_t thd_id) {
+  // a thread is involved if it is delayed or has executed an event
+  // while the state machine is in progress
+  if (state_ == (unsigned long)Desc::kInitState ||
+      state_ == (unsigned long)Desc::kDoneState)
+    return false;
+  if (delay_set_.find(thd_id) != delay_set_.end())
+    return true;
+  for (int i = 0; i < Desc::kNumEvents; i++) {
+    if (thd_id_[i] == thd_id)
+      return true;
+  }
+  return false;
+}
+
 #define IDIOM1_STATE_INVALID          0
 #define IDIOM1_STATE_INIT             1
 #define IDIOM1_STATE_E0               2
@@ -44,41 +146,35 @@ typedef std::set<thread_id_t> DelaySet;
 #define IDIOM1_STATE_E0_WATCH_X       6
 #define IDIOM1_STATE_DONE             7
 
-class Idiom1SchedStatus {
+template <>
+struct IdiomSchedDesc<IDIOM_1> {
+  enum {
+    kNumEvents = 2,
+    kNumStates = IDIOM1_STATE_DONE + 1,
+    kInvalidState = IDIOM1_STATE_INVALID,
+    kInitState = IDIOM1_STATE_INIT,
+    kDoneState = IDIOM1_STATE_DONE,
+    kWatchStates =
+      IDIOM_STATE_BIT(IDIOM1_STATE_E0_WATCH),
+    kWatchInstCount = 0,
+    kFlushStates =
+      IDIOM_STATE_BIT(IDIOM1_STATE_INIT) |
+      IDIOM_STATE_BIT(IDIOM1_STATE_E0) |
+      IDIOM_STATE_BIT(IDIOM1_STATE_E1) |
+      IDIOM_STATE_BIT(IDIOM1_STATE_DONE),
+    kMutexLockEvents = IDIOM_EVENT_BIT(1),
+    kMutexUnlockEvents = IDIOM_EVENT_BIT(0),
+    kWakeMaxPriority = 0
+  };
+  static const char *const kStateNames[kNumStates];
+};
+
+class Idiom1SchedStatus : public IdiomSchedStatus<IDIOM_1> {
  public:
-  Idiom1SchedStatus();
+  Idiom1SchedStatus() {}
   ~Idiom1SchedStatus() {}
 
-  static std::string StateToString(long s) {
-    switch (s) {
-      case IDIOM1_STATE_INIT:
-        return "INIT";
-      case IDIOM1_STATE_E0:
-        return "E0";
-      case IDIOM1_STATE_E1:
-        return "E1";
-      case IDIOM1_STATE_E0_E1:
-        return "E0_E1";
-      case IDIOM1_STATE_E0_WATCH:
-        return "E0_WATCH";
-      case IDIOM1_STATE_E0_WATCH_X:
-        return "E0_WATCH_X";
-      case IDIOM1_STATE_DONE:
-        return "DONE";
-      default:
-        return "INVALID";
-    }
-  }
-
  private:
-  unsigned long state_;
-  thread_id_t thd_id_[2];
-  address_t addr_[2];
-  size_t size_[2];
-  DelaySet delay_set_;
-
-  friend class SchedulerCommon;
-
   DISALLOW_COPY_CONSTRUCTORS(Idiom1SchedStatus);
 };
 
@@ -96,49 +192,38 @@ class Idiom1SchedStatus {
 #define IDIOM2_STATE_E0_E1_E2          11
 #define IDIOM2_STATE_DONE              12
 
-class Idiom2SchedStatus {
+template <>
+struct IdiomSchedDesc<IDIOM_2> {
+  enum {
+    kNumEvents = 3,
+    kNumStates = IDIOM2_STATE_DONE + 1,
+    kInvalidState = IDIOM2_STATE_INVALID,
+    kInitState = IDIOM2_STATE_INIT,
+    kDoneState = IDIOM2_STATE_DONE,
+    kWatchStates =
+      IDIOM_STATE_BIT(IDIOM2_STATE_E0_WATCH) |
+      IDIOM_STATE_BIT(IDIOM2_STATE_E0_E1_WATCH) |
+      IDIOM_STATE_BIT(IDIOM2_STATE_E1_WATCH),
+    kWatchInstCount = 1,
+    kFlushStates =
+      IDIOM_STATE_BIT(IDIOM2_STATE_INIT) |
+      IDIOM_STATE_BIT(IDIOM2_STATE_E0) |
+      IDIOM_STATE_BIT(IDIOM2_STATE_E1) |
+      IDIOM_STATE_BIT(IDIOM2_STATE_DONE),
+    kMutexLockEvents = 0,
+    kMutexUnlockEvents = 0,
+    kWakeMaxPriority = 0
+  };
+  static const char *const kStateNames[kNumStates];
+};
+
+class Idiom2SchedStatus : public IdiomSchedStatus<IDIOM_2> {
  public:
   Idiom2SchedStatus();
   ~Idiom2SchedStatus() {}
 
-  static std::string StateToString(unsigned long s) {
-    switch (s) {
-      case IDIOM2_STATE_INIT:
-        return "INIT";
-      case IDIOM2_STATE_E0:
-        return "E0";
-      case IDIOM2_STATE_E1:
-        return "E1";
-      case IDIOM2_STATE_E0_E1:
-        return "E0_E1";
-      case IDIOM2_STATE_E0_E1_WATCH:
-        return "E0_E1_WATCH";
-      case IDIOM2_STATE_E0_E1_WATCH_X:
-        return "E0_E1_WATCH_X";
-      case IDIOM2_STATE_E0_WATCH:
-        return "E0_WATCH";
-      case IDIOM2_STATE_E0_WATCH_X:
-        return "E0_WATCH_X";
-      case IDIOM2_STATE_E1_WATCH:
-        return "E1_WATCH";
-      case IDIOM2_STATE_E1_WATCH_X:
-        return "E1_WATCH_X";
-      case IDIOM2_STATE_E0_E1_E2:
-        return "E0_E1_E2";
-      case IDIOM2_STATE_DONE:
-        return "DONE";
-      default:
-        return "INVALID";
-    }
-  }
-
  private:
-  unsigned long state_;
-  thread_id_t thd_id_[3];
-  address_t addr_[3];
-  size_t size_[3];
   timestamp_t window_;
-  DelaySet delay_set_;
 
   friend class SchedulerCommon;
 
@@ -164,59 +249,42 @@ class Idiom2SchedStatus {
 #define IDIOM3_STATE_E0_E1_E2_E3          16
 #define IDIOM3_STATE_DONE                 17
 
-class Idiom3SchedStatus {
+template <>
+struct IdiomSchedDesc<IDIOM_3> {
+  enum {
+    kNumEvents = 4,
+    kNumStates = IDIOM3_STATE_DONE + 1,
+    kInvalidState = IDIOM3_STATE_INVALID,
+    kInitState = IDIOM3_STATE_INIT,
+    kDoneState = IDIOM3_STATE_DONE,
+    kWatchStates =
+      IDIOM_STATE_BIT(IDIOM3_STATE_E0_WATCH) |
+      IDIOM_STATE_BIT(IDIOM3_STATE_E0_E1_WATCH) |
+      IDIOM_STATE_BIT(IDIOM3_STATE_E1_WATCH) |
+      IDIOM_STATE_BIT(IDIOM3_STATE_E0_WATCH_E3) |
+      IDIOM_STATE_BIT(IDIOM3_STATE_E1_WATCH_E3) |
+      IDIOM_STATE_BIT(IDIOM3_STATE_E1_WATCH_E2) |
+      IDIOM_STATE_BIT(IDIOM3_STATE_E1_WATCH_E2_WATCH),
+    kWatchInstCount = 1,
+    kFlushStates =
+      IDIOM_STATE_BIT(IDIOM3_STATE_INIT) |
+      IDIOM_STATE_BIT(IDIOM3_STATE_E0) |
+      IDIOM_STATE_BIT(IDIOM3_STATE_E1) |
+      IDIOM_STATE_BIT(IDIOM3_STATE_DONE),
+    kMutexLockEvents = IDIOM_EVENT_BIT(1) | IDIOM_EVENT_BIT(3),
+    kMutexUnlockEvents = IDIOM_EVENT_BIT(0) | IDIOM_EVENT_BIT(2),
+    kWakeMaxPriority = 1
+  };
+  static const char *const kStateNames[kNumStates];
+};
+
+class Idiom3SchedStatus : public IdiomSchedStatus<IDIOM_3> {
  public:
   Idiom3SchedStatus();
   ~Idiom3SchedStatus() {}
 
-  static std::string StateToString(unsigned long s) {
-    switch (s) {
-      case IDIOM3_STATE_INIT:
-        return "INIT";
-      case IDIOM3_STATE_E0:
-        return "E0";
-      case IDIOM3_STATE_E1:
-        return "E1";
-      case IDIOM3_STATE_E0_WATCH:
-        return "E0_WATCH";
-      case IDIOM3_STATE_E0_WATCH_X:
-        return "E0_WATCH_X";
-      case IDIOM3_STATE_E0_E1:
-        return "E0_E1";
-      case IDIOM3_STATE_E0_E1_WATCH:
-        return "E0_E1_WATCH";
-      case IDIOM3_STATE_E1_WATCH:
-        return "E1_WATCH";
-      case IDIOM3_STATE_E1_WATCH_X:
-        return "E1_WATCH_X";
-      case IDIOM3_STATE_E0_WATCH_E3:
-        return "E0_WATCH_E3";
-      case IDIOM3_STATE_E1_WATCH_E3:
-        return "E1_WATCH_E3";
-      case IDIOM3_STATE_E1_WATCH_E3_X:
-        return "E1_WATCH_E3_X";
-      case IDIOM3_STATE_E1_WATCH_E2:
-        return "E1_WATCH_E2";
-      case IDIOM3_STATE_E1_WATCH_E2_WATCH:
-        return "E1_WATCH_E2_WATCH";
-      case IDIOM3_STATE_E1_WATCH_E2_WATCH_X:
-        return "E1_WATCH_E2_WATCH_X";
-      case IDIOM3_STATE_E0_E1_E2_E3:
-        return "E0_E1_E2_E3";
-      case IDIOM3_STATE_DONE:
-        return "DONE";
-      default:
-        return "INVALID";
-    }
-  }
-
  private:
-  unsigned long state_;
-  thread_id_t thd_id_[4];
-  address_t addr_[4];
-  size_t size_[4];
   timestamp_t window_;
-  DelaySet delay_set_;
 
   friend class SchedulerCommon;
 
@@ -242,61 +310,44 @@ class Idiom3SchedStatus {
 #define IDIOM4_STATE_E0_E1_E2_E3          16
 #define IDIOM4_STATE_DONE                 17
 
-class Idiom4SchedStatus {
+template <>
+struct IdiomSchedDesc<IDIOM_4> {
+  enum {
+    kNumEvents = 4,
+    kNumStates = IDIOM4_STATE_DONE + 1,
+    kInvalidState = IDIOM4_STATE_INVALID,
+    kInitState = IDIOM4_STATE_INIT,
+    kDoneState = IDIOM4_STATE_DONE,
+    kWatchStates =
+      IDIOM_STATE_BIT(IDIOM4_STATE_E0_WATCH) |
+      IDIOM_STATE_BIT(IDIOM4_STATE_E0_E1_WATCH) |
+      IDIOM_STATE_BIT(IDIOM4_STATE_E1_WATCH) |
+      IDIOM_STATE_BIT(IDIOM4_STATE_E0_WATCH_E3) |
+      IDIOM_STATE_BIT(IDIOM4_STATE_E1_WATCH_E3) |
+      IDIOM_STATE_BIT(IDIOM4_STATE_E1_WATCH_E2) |
+      IDIOM_STATE_BIT(IDIOM4_STATE_E1_WATCH_E2_WATCH),
+    kWatchInstCount = 1,
+    kFlushStates =
+      IDIOM_STATE_BIT(IDIOM4_STATE_INIT) |
+      IDIOM_STATE_BIT(IDIOM4_STATE_E0) |
+      IDIOM_STATE_BIT(IDIOM4_STATE_E1) |
+      IDIOM_STATE_BIT(IDIOM4_STATE_DONE),
+    kMutexLockEvents = IDIOM_EVENT_BIT(1) | IDIOM_EVENT_BIT(3),
+    kMutexUnlockEvents = IDIOM_EVENT_BIT(0) | IDIOM_EVENT_BIT(2),
+    kWakeMaxPriority = 1
+  };
+  static const char *const kStateNames[kNumStates];
+};
+
+class Idiom4SchedStatus : public IdiomSchedStatus<IDIOM_4> {
  public:
   Idiom4SchedStatus();
   ~Idiom4SchedStatus() {}
 
-  static std::string StateToString(unsigned long s) {
-    switch (s) {
-      case IDIOM4_STATE_INIT:
-        return "INIT";
-      case IDIOM4_STATE_E0:
-        return "E0";
-      case IDIOM4_STATE_E1:
-        return "E1";
-      case IDIOM4_STATE_E0_WATCH:
-        return "E0_WATCH";
-      case IDIOM4_STATE_E0_WATCH_X:
-        return "E0_WATCH_X";
-      case IDIOM4_STATE_E0_E1:
-        return "E0_E1";
-      case IDIOM4_STATE_E0_E1_WATCH:
-        return "E0_E1_WATCH";
-      case IDIOM4_STATE_E1_WATCH:
-        return "E1_WATCH";
-      case IDIOM4_STATE_E1_WATCH_X:
-        return "E1_WATCH_X";
-      case IDIOM4_STATE_E0_WATCH_E3:
-        return "E0_WATCH_E3";
-      case IDIOM4_STATE_E1_WATCH_E3:
-        return "E1_WATCH_E3";
-      case IDIOM4_STATE_E1_WATCH_E3_X:
-        return "E1_WATCH_E3_X";
-      case IDIOM4_STATE_E1_WATCH_E2:
-        return "E1_WATCH_E2";
-      case IDIOM4_STATE_E1_WATCH_E2_WATCH:
-        return "E1_WATCH_E2_WATCH";
-      case IDIOM4_STATE_E1_WATCH_E2_WATCH_X:
-        return "E1_WATCH_E2_WATCH_X";
-      case IDIOM4_STATE_E0_E1_E2_E3:
-        return "E0_E1_E2_E3";
-      case IDIOM4_STATE_DONE:
-        return "DONE";
-      default:
-        return "INVALID";
-    }
-  }
-
  private:
   typedef std::tr1::unordered_set<address_t> RecordedAddrSet;
 
-  unsigned long state_;
-  thread_id_t thd_id_[4];
-  address_t addr_[4];
-  size_t size_[4];
   timestamp_t window_;
-  DelaySet delay_set_;
   RecordedAddrSet recorded_addr_set_;
 
   friend class SchedulerCommon;
@@ -328,73 +379,47 @@ class Idiom4SchedStatus {
 #define IDIOM5_STATE_E0_E1_E2_E3            21
 #define IDIOM5_STATE_DONE                   22
 
-class Idiom5SchedStatus {
+template <>
+struct IdiomSchedDesc<IDIOM_5> {
+  enum {
+    kNumEvents = 4,
+    kNumStates = IDIOM5_STATE_DONE + 1,
+    kInvalidState = IDIOM5_STATE_INVALID,
+    kInitState = IDIOM5_STATE_INIT,
+    kDoneState = IDIOM5_STATE_DONE,
+    kWatchStates =
+      IDIOM_STATE_BIT(IDIOM5_STATE_E0_WATCH) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_E2_WATCH) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_E0_E2_WATCH) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_E0_WATCH_E3) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_E2_WATCH_E1) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_E0_E2_WATCH_E3) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_E0_E2_WATCH_E1) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_E0_E2_WATCH_E3_WATCH) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_E0_E2_WATCH_E1_WATCH),
+    kWatchInstCount = 1,
+    kFlushStates =
+      IDIOM_STATE_BIT(IDIOM5_STATE_INIT) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_E0) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_E2) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_E0_E1_E2_E3) |
+      IDIOM_STATE_BIT(IDIOM5_STATE_DONE),
+    kMutexLockEvents = IDIOM_EVENT_BIT(0) | IDIOM_EVENT_BIT(1) | IDIOM_EVENT_BIT(2) | IDIOM_EVENT_BIT(3),
+    kMutexUnlockEvents = IDIOM_EVENT_BIT(0) | IDIOM_EVENT_BIT(1) | IDIOM_EVENT_BIT(2) | IDIOM_EVENT_BIT(3),
+    kWakeMaxPriority = 0
+  };
+  static const char *const kStateNames[kNumStates];
+};
+
+class Idiom5SchedStatus : public IdiomSchedStatus<IDIOM_5> {
  public:
   Idiom5SchedStatus();
-  ~Idiom5SchedStatus();
-
-  static std::string StateToString(unsigned long s) {
-    switch (s) {
-      case IDIOM5_STATE_INVALID:
-        return "INVALID";
-      case IDIOM5_STATE_INIT:
-        return "INIT";
-      case IDIOM5_STATE_E0:
-        return "E0";
-      case IDIOM5_STATE_E2:
-        return "E2";
-      case IDIOM5_STATE_E0_WATCH:
-        return "E0_WATCH";
-      case IDIOM5_STATE_E0_WATCH_X:
-        return "E0_WATCH_X";
-      case IDIOM5_STATE_E2_WATCH:
-        return "E2_WATCH";
-      case IDIOM5_STATE_E2_WATCH_X:
-        return "E2_WATCH_X";
-      case IDIOM5_STATE_E0_E2:
-        return "E0_E2";
-      case IDIOM5_STATE_E0_E2_WATCH:
-        return "E0_E2_WATCH";
-      case IDIOM5_STATE_E0_E2_WATCH_X:
-        return "E0_E2_WATCH_X";
-      case IDIOM5_STATE_E0_WATCH_E3:
-        return "E0_WATCH_E3";
-      case IDIOM5_STATE_E2_WATCH_E1:
-        return "E2_WATCH_E1";
-      case IDIOM5_STATE_E0_E2_WATCH_E3:
-        return "E0_E2_WATCH_E3";
-      case IDIOM5_STATE_E0_E2_WATCH_E3_X:
-        return "E0_E2_WATCH_E3_X";
-      case IDIOM5_STATE_E0_E2_WATCH_E1:
-        return "E0_E2_WATCH_E1";
-      case IDIOM5_STATE_E0_E2_WATCH_E1_X:
-        return "E0_E2_WATCH_E1_X";
-      case IDIOM5_STATE_E0_E2_WATCH_E3_WATCH:
-        return "E0_E2_WATCH_E3_WATCH";
-      case IDIOM5_STATE_E0_E2_WATCH_E3_WATCH_X:
-        return "E0_E2_WATCH_E3_WATCH_X";
-      case IDIOM5_STATE_E0_E2_WATCH_E1_WATCH:
-        return "E0_E2_WATCH_E1_WATCH";
-      case IDIOM5_STATE_E0_E2_WATCH_E1_WATCH_X:
-        return "E0_E2_WATCH_E1_WATCH_X";
-      case IDIOM5_STATE_E0_E1_E2_E3:
-        return "E0_E1_E2_E3";
-      case IDIOM5_STATE_DONE:
-        return "DONE";
-      default:
-        return "INVALID";
-    }
-  }
+  ~Idiom5SchedStatus() {}
 
  private:
   typedef std::tr1::unordered_set<address_t> RecordedAddrSet;
 
-  unsigned long state_;
-  thread_id_t thd_id_[4];
-  address_t addr_[4];
-  size_t size_[4];
   timestamp_t window_[2];
-  DelaySet delay_set_;
   RecordedAddrSet recorded_addr_set0_;
   RecordedAddrSet recorded_addr_set2_;
 
@@ -403,13 +428,81 @@ class Idiom5SchedStatus {
   DISALLOW_COPY_CONSTRUCTORS(Idiom5SchedStatus);
 };
 
-// The controller for the idiom driven active scheduler.
+// The scheduling status of a target iroot. Each target has its own
+// state machine, so that multiple iroots can be tested in one run.
+class SchedTarget {
+ public:
+  explicit SchedTarget(iRoot *iroot);
+  ~SchedTarget() {}
+
+  iRoot *iroot() { return iroot_; }
+  bool success() { return success_; }
+  timestamp_t first_event_time() { return first_event_time_; }
+  bool Involved(thread_id_t thd_id);
+
+ private:
+  // the common part of the sched status of the target idiom
+  template <IdiomType IDIOM>
+  IdiomSchedStatus<IDIOM> *sched_status();
+
+  iRoot *iroot_;
+  Idiom1SchedStatus *idiom1_sched_status_;
+  Idiom2SchedStatus *idiom2_sched_status_;
+  Idiom3SchedStatus *idiom3_sched_status_;
+  Idiom4SchedStatus *idiom4_sched_status_;
+  Idiom5SchedStatus *idiom5_sched_status_;
+  const IdiomOps *ops_; // the entry points of the idiom
+  bool volatile success_;
+  timestamp_t volatile first_event_time_; // time to reach the first event
+  std::set<THREADID> handoff_set_; // threads waiting for a state change
+
+  friend class SchedulerCommon;
+
+  DISALLOW_COPY_CONSTRUCTORS(SchedTarget);
+};
+
+template <>
+inline IdiomSchedStatus<IDIOM_1> *SchedTarget::sched_status<IDIOM_1>() {
+  return idiom1_sched_status_;
+}
+
+template <>
+inline IdiomSchedStatus<IDIOM_2> *SchedTarget::sched_status<IDIOM_2>() {
+  return idiom2_sched_status_;
+}
+
+template <>
+inline IdiomSchedStatus<IDIOM_3> *SchedTarget::sched_status<IDIOM_3>() {
+  return idiom3_sched_status_;
+}
+
+template <>
+inline IdiomSchedStatus<IDIOM_4> *SchedTarget::sched_status<IDIOM_4>() {
+  return idiom4_sched_status_;
+}
+
+template <>
+inline IdiomSchedStatus<IDIOM_5> *SchedTarget::sched_status<IDIOM_5>() {
+  return idiom5_sched_status_;
+}
+
+typedef std::vector<SchedTarget *> SchedTargetVec;
+
+// The controller for the idiom driven active scheduler. Multiple
+// target iroots can be tested in one run if their events do not
+// share instructions. A thread is controlled by at most one target
+// at a time, so that the state machines do not interfere.
 class SchedulerCommon : public ExecutionControl {
  public:
   SchedulerCommon();
   virtual ~SchedulerCommon() {}
 
  protected:
+  // the offsets of the candidate insts in an image (true if the inst
+  // is a memory iroot event), indexed by the image name
+  typedef std::tr1::unordered_map<ADDRINT, bool> CandidateOffsetMap;
+  typedef std::map<std::string, CandidateOffsetMap> CandidateMap;
+
   Mutex *CreateMutex() { return new PinMutex; }
   virtual void HandlePreSetup();
   virtual void HandlePostSetup();
@@ -421,19 +514,27 @@ class SchedulerCommon : public ExecutionControl {
   virtual void HandleProgramExit();
   virtual void HandleThreadStart();
   virtual void HandleThreadExit();
+  virtual void HandleAfterForkInChild();
   virtual void HandleMain(THREADID tid, CONTEXT *ctxt);
   virtual void HandleThreadMain(THREADID tid, CONTEXT *ctxt);
 
   // virtual functions to be overrided
   virtual void Choose();
-  virtual void TestSuccess() {}
-  virtual void TestFail() {}
+  virtual void TestSuccess(iRoot *iroot) {}
+  virtual void TestFail(iRoot *iroot) {}
   virtual bool UseDecreasingPriorities();
   virtual bool YieldWithDelay();
 
+  // manage target iRoots
+  void AddTarget(iRoot *iroot);
+  bool EnterTarget(SchedTarget *target);
+  SchedTarget *CurrTarget() { return tls_target_[PIN_ThreadId()]; }
+  bool TargetHasMem();
+  bool TargetHasSync();
+
   // instrument iRoots
   void InstrumentMemiRootEvent(TRACE trace);
-  void InstrumentMemiRootEvent(TRACE trace, UINT32 idx);
+  void InstrumentMemiRootEvent(TRACE trace, SchedTarget *target, UINT32 idx);
   void ReplacePthreadMutexWrappers(IMG img);
   void CheckiRootBeforeMutexLock(Inst *inst, address_t addr);
   void CheckiRootAfterMutexLock(Inst *inst, address_t addr);
@@ -443,28 +544,27 @@ class SchedulerCommon : public ExecutionControl {
   // instrument to watch memeory accesses and maintain inst count
   void InstrumentWatchMem(TRACE trace);
   void InstrumentWatchInstCount(TRACE trace);
-  void Idiom1InstrumentWatchMem(TRACE trace);
-  void Idiom1InstrumentWatchInstCount(TRACE trace);
-  void Idiom2InstrumentWatchMem(TRACE trace);
-  void Idiom2InstrumentWatchInstCount(TRACE trace);
-  void Idiom3InstrumentWatchMem(TRACE trace);
-  void Idiom3InstrumentWatchInstCount(TRACE trace);
-  void Idiom4InstrumentWatchMem(TRACE trace);
-  void Idiom4InstrumentWatchInstCount(TRACE trace);
-  void Idiom5InstrumentWatchMem(TRACE trace);
-  void Idiom5InstrumentWatchInstCount(TRACE trace);
+  bool Watching(bool inst_count);
   void __InstrumentWatchInstCount(TRACE trace);
   void __InstrumentWatchMem(TRACE trace, bool cand);
+  void __InstrumentWatchAccess(INS ins, AFUNPTR func, Inst *inst,
+                               IARG_TYPE ea, IARG_TYPE size, bool cand);
+  void AddCandidates(iRoot *iroot);
+  CandidateOffsetMap *FindCandidates(TRACE trace, ADDRINT *img_low_addr);
   bool ContainCandidates(TRACE trace);
-  bool IsCandidate(TRACE trace, INS ins);
+  bool IsCandidate(CandidateOffsetMap *cands, ADDRINT img_low_addr, INS ins);
   void FlushWatch();
 
   // utility functions
   void LockSchedStatus() { sched_status_lock_->Lock(); }
   void UnlockSchedStatus() { sched_status_lock_->Unlock(); }
+  int HandoffWait(int timeout);
+  void HandoffNotify(SchedTarget *target);
   void LockMisc() { misc_lock_->Lock(); }
   void UnlockMisc() { misc_lock_->Unlock(); }
   void ActivelyExposed();
+  void RecordFirstEvent();
+  timestamp_t CurrentTime();
   Inst *FindInst(ADDRINT pc);
   void CalculatePriorities();
   int NormalPriority() { return normal_priority_; }
@@ -493,54 +593,105 @@ class SchedulerCommon : public ExecutionControl {
   void RecordRandomSeed(unsigned int seed);
 
   // iRoot handler
-  void HandleBeforeiRootMemRead(UINT32 idx, address_t addr, size_t size);
-  void HandleBeforeiRootMemWrite(UINT32 idx, address_t addr, size_t size);
-  void HandleAfteriRootMem(UINT32 idx);
-  void HandleBeforeiRootMutexLock(UINT32 idx, address_t addr);
-  void HandleAfteriRootMutexLock(UINT32 idx, address_t addr);
-  void HandleBeforeiRootMutexUnlock(UINT32 idx, address_t addr);
-  void HandleAfteriRootMutexUnlock(UINT32 idx, address_t addr);
-  void HandleWatchMutexLock(address_t addr);
-  void HandleWatchMutexUnlock(address_t addr);
+  void HandleBeforeiRootMemRead(SchedTarget *target, UINT32 idx,
+                                address_t addr, size_t size);
+  void HandleBeforeiRootMemWrite(SchedTarget *target, UINT32 idx,
+                                 address_t addr, size_t size);
+  void HandleAfteriRootMem(SchedTarget *target, UINT32 idx);
+  void HandleBeforeiRootMutexLock(SchedTarget *target, UINT32 idx,
+                                  address_t addr);
+  void HandleAfteriRootMutexLock(SchedTarget *target, UINT32 idx,
+                                 address_t addr);
+  void HandleBeforeiRootMutexUnlock(SchedTarget *target, UINT32 idx,
+                                    address_t addr);
+  void HandleAfteriRootMutexUnlock(SchedTarget *target, UINT32 idx,
+                                   address_t addr);
+  void HandleWatchMutexLock(SchedTarget *target, address_t addr);
+  void HandleWatchMutexUnlock(SchedTarget *target, address_t addr);
   void HandleWatchMemRead(Inst *inst, address_t addr, size_t size,
                           bool cand);
   void HandleWatchMemWrite(Inst *inst, address_t addr, size_t size,
                            bool cand);
+  void HandleWatchMemRead(SchedTarget *target, Inst *inst, address_t addr,
+                          size_t size, bool cand);
+  void HandleWatchMemWrite(SchedTarget *target, Inst *inst, address_t addr,
+                           size_t size, bool cand);
   void HandleWatchInstCount(timestamp_t c);
   void HandleSchedYield();
 
+  // generic iRoot handler (see IdiomSchedDesc)
+  typedef void (SchedulerCommon::*BeforeEventFunc)(address_t, size_t);
+  typedef void (SchedulerCommon::*AfterEventFunc)();
+  typedef void (SchedulerCommon::*WatchAccessFunc)(address_t, size_t);
+  typedef void (SchedulerCommon::*WatchInstCountFunc)(timestamp_t);
+  typedef void (SchedulerCommon::*SchedYieldFunc)();
+
+  // the hand written handlers of an idiom (the event handlers are
+  // indexed by event, the others are NULL if not handled)
+  template <IdiomType IDIOM>
+  struct IdiomHandler {
+    static const BeforeEventFunc kBeforeEvent[];
+    static const AfterEventFunc kAfterEvent[];
+    static const WatchAccessFunc kWatchAccess;
+    static const WatchInstCountFunc kWatchInstCount;
+    static const SchedYieldFunc kSchedYield;
+  };
+
+  // return the entry points of an idiom (see IdiomOps)
+  template <IdiomType IDIOM>
+  static const IdiomOps *GetIdiomOps();
+  template <IdiomType IDIOM>
+  static bool IdiomInvolved(SchedTarget *target, thread_id_t thd_id);
+
+  template <IdiomType IDIOM>
+  void IdiomBeforeiRootMemRead(UINT32 idx, address_t addr, size_t size);
+  template <IdiomType IDIOM>
+  void IdiomBeforeiRootMemWrite(UINT32 idx, address_t addr, size_t size);
+  template <IdiomType IDIOM>
+  void IdiomAfteriRootMem(UINT32 idx);
+  template <IdiomType IDIOM>
+  void IdiomBeforeiRootMutexLock(UINT32 idx, address_t addr);
+  template <IdiomType IDIOM>
+  void IdiomAfteriRootMutexLock(UINT32 idx, address_t addr);
+  template <IdiomType IDIOM>
+  void IdiomBeforeiRootMutexUnlock(UINT32 idx, address_t addr);
+  template <IdiomType IDIOM>
+  void IdiomAfteriRootMutexUnlock(UINT32 idx, address_t addr);
+  template <IdiomType IDIOM>
+  void IdiomWatchMutexLock(address_t addr);
+  template <IdiomType IDIOM>
+  void IdiomWatchMutexUnlock(address_t addr);
+  template <IdiomType IDIOM>
+  void IdiomWatchMemRead(Inst *inst, address_t addr, size_t size, bool cand);
+  template <IdiomType IDIOM>
+  void IdiomWatchMemWrite(Inst *inst, address_t addr, size_t size, bool cand);
+  template <IdiomType IDIOM>
+  bool IdiomWatching(SchedTarget *target, bool inst_count);
+  template <IdiomType IDIOM>
+  void IdiomCheckFlush();
+  template <IdiomType IDIOM>
+  bool IdiomCheckGiveup(int idx);
+  template <IdiomType IDIOM>
+  void IdiomSetState(unsigned long s);
+  template <IdiomType IDIOM>
+  void IdiomRecordEvent(int idx, thread_id_t thd_id, address_t addr,
+                        size_t size);
+  template <IdiomType IDIOM>
+  void IdiomClearDelaySet(DelaySet *copy);
+  template <IdiomType IDIOM>
+  void IdiomWakeDelaySet(DelaySet *copy);
+  template <IdiomType IDIOM>
+  void IdiomSetStateAndWake(unsigned long s);
+
   // idiom1 iRoot handler
-  void Idiom1BeforeiRootMemRead(UINT32 idx, address_t addr, size_t size);
-  void Idiom1BeforeiRootMemWrite(UINT32 idx, address_t addr, size_t size);
-  void Idiom1AfteriRootMem(UINT32 idx);
-  void Idiom1BeforeiRootMutexLock(UINT32 idx, address_t addr);
-  void Idiom1AfteriRootMutexLock(UINT32 idx, address_t addr);
-  void Idiom1BeforeiRootMutexUnlock(UINT32 idx, address_t addr);
-  void Idiom1AfteriRootMutexUnlock(UINT32 idx, address_t addr);
   void Idiom1BeforeEvent0(address_t addr, size_t size);
   void Idiom1BeforeEvent1(address_t addr, size_t size);
   void Idiom1AfterEvent0();
   void Idiom1AfterEvent1();
   void Idiom1WatchAccess(address_t addr, size_t size);
-  void Idiom1WatchMutexLock(address_t addr);
-  void Idiom1WatchMutexUnlock(address_t addr);
-  void Idiom1WatchMemRead(Inst *inst, address_t addr, size_t size, bool cand);
-  void Idiom1WatchMemWrite(Inst *inst, address_t addr, size_t size, bool cand);
   void Idiom1SchedYield();
-  void Idiom1CheckFlush();
-  bool Idiom1CheckGiveup(int idx);
-  void Idiom1SetState(unsigned long s);
-  void Idiom1ClearDelaySet(DelaySet *copy);
-  void Idiom1WakeDelaySet(DelaySet *copy);
 
   // idiom2 iRoot handler
-  void Idiom2BeforeiRootMemRead(UINT32 idx, address_t addr, size_t size);
-  void Idiom2BeforeiRootMemWrite(UINT32 idx, address_t addr, size_t size);
-  void Idiom2AfteriRootMem(UINT32 idx);
-  void Idiom2BeforeiRootMutexLock(UINT32 idx, address_t addr);
-  void Idiom2AfteriRootMutexLock(UINT32 idx, address_t addr);
-  void Idiom2BeforeiRootMutexUnlock(UINT32 idx, address_t addr);
-  void Idiom2AfteriRootMutexUnlock(UINT32 idx, address_t addr);
   void Idiom2BeforeEvent0(address_t addr, size_t size);
   void Idiom2BeforeEvent1(address_t addr, size_t size);
   void Idiom2BeforeEvent2(address_t addr, size_t size);
@@ -549,24 +700,8 @@ class SchedulerCommon : public ExecutionControl {
   void Idiom2AfterEvent2();
   void Idiom2WatchAccess(address_t addr, size_t size);
   void Idiom2WatchInstCount(timestamp_t c);
-  void Idiom2WatchMutexLock(address_t addr);
-  void Idiom2WatchMutexUnlock(address_t addr);
-  void Idiom2WatchMemRead(Inst *inst, address_t addr, size_t size, bool cand);
-  void Idiom2WatchMemWrite(Inst *inst, address_t addr, size_t size, bool cand);
-  void Idiom2CheckFlush();
-  bool Idiom2CheckGiveup(int idx);
-  void Idiom2SetState(unsigned long s);
-  void Idiom2ClearDelaySet(DelaySet *copy);
-  void Idiom2WakeDelaySet(DelaySet *copy);
 
   // idiom3 iRoot handler
-  void Idiom3BeforeiRootMemRead(UINT32 idx, address_t addr, size_t size);
-  void Idiom3BeforeiRootMemWrite(UINT32 idx, address_t addr, size_t size);
-  void Idiom3AfteriRootMem(UINT32 idx);
-  void Idiom3BeforeiRootMutexLock(UINT32 idx, address_t addr);
-  void Idiom3AfteriRootMutexLock(UINT32 idx, address_t addr);
-  void Idiom3BeforeiRootMutexUnlock(UINT32 idx, address_t addr);
-  void Idiom3AfteriRootMutexUnlock(UINT32 idx, address_t addr);
   void Idiom3BeforeEvent0(address_t addr, size_t size);
   void Idiom3BeforeEvent1(address_t addr, size_t size);
   void Idiom3BeforeEvent2(address_t addr, size_t size);
@@ -577,24 +712,8 @@ class SchedulerCommon : public ExecutionControl {
   void Idiom3AfterEvent3();
   void Idiom3WatchAccess(address_t addr, size_t size);
   void Idiom3WatchInstCount(timestamp_t c);
-  void Idiom3WatchMutexLock(address_t addr);
-  void Idiom3WatchMutexUnlock(address_t addr);
-  void Idiom3WatchMemRead(Inst *inst, address_t addr, size_t size, bool cand);
-  void Idiom3WatchMemWrite(Inst *inst, address_t addr, size_t size, bool cand);
-  void Idiom3CheckFlush();
-  bool Idiom3CheckGiveup(int idx);
-  void Idiom3SetState(unsigned long s);
-  void Idiom3ClearDelaySet(DelaySet *copy);
-  void Idiom3WakeDelaySet(DelaySet *copy);
 
   // idiom4 iRoot handler
-  void Idiom4BeforeiRootMemRead(UINT32 idx, address_t addr, size_t size);
-  void Idiom4BeforeiRootMemWrite(UINT32 idx, address_t addr, size_t size);
-  void Idiom4AfteriRootMem(UINT32 idx);
-  void Idiom4BeforeiRootMutexLock(UINT32 idx, address_t addr);
-  void Idiom4AfteriRootMutexLock(UINT32 idx, address_t addr);
-  void Idiom4BeforeiRootMutexUnlock(UINT32 idx, address_t addr);
-  void Idiom4AfteriRootMutexUnlock(UINT32 idx, address_t addr);
   void Idiom4BeforeEvent0(address_t addr, size_t size);
   void Idiom4BeforeEvent1(address_t addr, size_t size);
   void Idiom4BeforeEvent2(address_t addr, size_t size);
@@ -605,27 +724,11 @@ class SchedulerCommon : public ExecutionControl {
   void Idiom4AfterEvent3();
   void Idiom4WatchAccess(address_t addr, size_t size);
   void Idiom4WatchInstCount(timestamp_t c);
-  void Idiom4WatchMutexLock(address_t addr);
-  void Idiom4WatchMutexUnlock(address_t addr);
-  void Idiom4WatchMemRead(Inst *inst, address_t addr, size_t size, bool cand);
-  void Idiom4WatchMemWrite(Inst *inst, address_t addr, size_t size, bool cand);
-  void Idiom4CheckFlush();
-  bool Idiom4CheckGiveup(int idx);
-  void Idiom4SetState(unsigned long s);
-  void Idiom4ClearDelaySet(DelaySet *copy);
-  void Idiom4WakeDelaySet(DelaySet *copy);
   void Idiom4RecordAccess(address_t addr, size_t size);
   void Idiom4ClearRecordedAccess();
   bool Idiom4Recorded(address_t addr, size_t size);
 
   // idiom5 iRoot handler
-  void Idiom5BeforeiRootMemRead(UINT32 idx, address_t addr, size_t size);
-  void Idiom5BeforeiRootMemWrite(UINT32 idx, address_t addr, size_t size);
-  void Idiom5AfteriRootMem(UINT32 idx);
-  void Idiom5BeforeiRootMutexLock(UINT32 idx, address_t addr);
-  void Idiom5AfteriRootMutexLock(UINT32 idx, address_t addr);
-  void Idiom5BeforeiRootMutexUnlock(UINT32 idx, address_t addr);
-  void Idiom5AfteriRootMutexUnlock(UINT32 idx, address_t addr);
   void Idiom5BeforeEvent0(address_t addr, size_t size);
   void Idiom5BeforeEvent1(address_t addr, size_t size);
   void Idiom5BeforeEvent2(address_t addr, size_t size);
@@ -636,27 +739,21 @@ class SchedulerCommon : public ExecutionControl {
   void Idiom5AfterEvent3();
   void Idiom5WatchAccess(address_t addr, size_t size);
   void Idiom5WatchInstCount(timestamp_t c);
-  void Idiom5WatchMutexLock(address_t addr);
-  void Idiom5WatchMutexUnlock(address_t addr);
-  void Idiom5WatchMemRead(Inst *inst, address_t addr, size_t size, bool cand);
-  void Idiom5WatchMemWrite(Inst *inst, address_t addr, size_t size, bool cand);
-  void Idiom5CheckFlush();
-  bool Idiom5CheckGiveup(int idx);
-  void Idiom5SetState(unsigned long s);
-  void Idiom5ClearDelaySet(DelaySet *copy);
-  void Idiom5WakeDelaySet(DelaySet *copy);
   void Idiom5RecordAccess(int idx, address_t addr, size_t size);
   void Idiom5ClearRecordedAccess(int idx);
   bool Idiom5Recorded(int idx, address_t addr, size_t size);
 
-  static void __BeforeiRootMemRead(UINT32 idx, ADDRINT addr, UINT32 size);
-  static void __BeforeiRootMemWrite(UINT32 idx, ADDRINT addr, UINT32 size);
-  static void __AfteriRootMem(UINT32 idx);
+  static void __BeforeiRootMemRead(SchedTarget *target, UINT32 idx,
+                                   ADDRINT addr, UINT32 size);
+  static void __BeforeiRootMemWrite(SchedTarget *target, UINT32 idx,
+                                    ADDRINT addr, UINT32 size);
+  static void __AfteriRootMem(SchedTarget *target, UINT32 idx);
   static void __WatchMemRead(Inst *inst, ADDRINT addr, UINT32 size,
                              BOOL cand);
   static void __WatchMemWrite(Inst *inst, ADDRINT addr, UINT32 size,
                               BOOL cand);
   static void __WatchInstCount(UINT32 c);
+  static ADDRINT __WatchGuard(bool volatile *flag) { return *flag; }
 
   iRootDB *iroot_db_;
   TestHistory *history_;
@@ -670,19 +767,19 @@ class SchedulerCommon : public ExecutionControl {
   int new_thread_priorities_cursor_;
   address_t unit_size_;
   timestamp_t vw_;
-  iRoot *curr_iroot_;
-  Idiom1SchedStatus *idiom1_sched_status_;
-  Idiom2SchedStatus *idiom2_sched_status_;
-  Idiom3SchedStatus *idiom3_sched_status_;
-  Idiom4SchedStatus *idiom4_sched_status_;
-  Idiom5SchedStatus *idiom5_sched_status_;
+  SchedTargetVec targets_;
+  CandidateMap cand_map_; // the candidate insts of the targets
+  bool volatile watch_mem_; // guard of the watch mem instrumentation
+  bool volatile watch_inst_count_; // guard of the inst count instrumentation
+  SchedTarget *tls_target_[PIN_MAX_THREADS]; // the target being handled
+  Semaphore *tls_handoff_sem_[PIN_MAX_THREADS]; // posted on hand-off
   Mutex *sched_status_lock_;
   Mutex *misc_lock_;
   std::map<thread_id_t, int> priority_map_;
   std::map<thread_id_t, int> ori_priority_map_;
   std::map<thread_id_t, OS_THREAD_ID> thd_id_os_tid_map_;
+  timestamp_t start_time_;
   bool volatile start_schedule_; // start scheduling when 2 threads are started
-  bool volatile test_success_;
 
  private:
   DISALLOW_COPY_CONSTRUCTORS(SchedulerCommon);
@@ -690,6 +787,33 @@ class SchedulerCommon : public ExecutionControl {
   // Override wrappers.
   DECLARE_MEMBER_WRAPPER_HANDLER(PthreadMutexLock);
   DECLARE_MEMBER_WRAPPER_HANDLER(PthreadMutexUnlock);
+
+  friend struct IdiomOps;
+};
+
+// The entry points of an idiom. They are resolved once when a target
+// is added, so that the analysis routines call them directly instead
+// of switching on the idiom of the target.
+struct IdiomOps {
+  bool (*involved)(SchedTarget *target, thread_id_t thd_id);
+  bool (SchedulerCommon::*watching)(SchedTarget *target, bool inst_count);
+  void (SchedulerCommon::*before_mem_read)(UINT32 idx, address_t addr,
+                                           size_t size);
+  void (SchedulerCommon::*before_mem_write)(UINT32 idx, address_t addr,
+                                            size_t size);
+  void (SchedulerCommon::*after_mem)(UINT32 idx);
+  void (SchedulerCommon::*before_mutex_lock)(UINT32 idx, address_t addr);
+  void (SchedulerCommon::*after_mutex_lock)(UINT32 idx, address_t addr);
+  void (SchedulerCommon::*before_mutex_unlock)(UINT32 idx, address_t addr);
+  void (SchedulerCommon::*after_mutex_unlock)(UINT32 idx, address_t addr);
+  void (SchedulerCommon::*watch_mutex_lock)(address_t addr);
+  void (SchedulerCommon::*watch_mutex_unlock)(address_t addr);
+  void (SchedulerCommon::*watch_mem_read)(Inst *inst, address_t addr,
+                                          size_t size, bool cand);
+  void (SchedulerCommon::*watch_mem_write)(Inst *inst, address_t addr,
+                                           size_t size, bool cand);
+  SchedulerCommon::WatchInstCountFunc watch_inst_count; // NULL if none
+  SchedulerCommon::SchedYieldFunc sched_yield; // NULL if none
 };
 
 } // namespace idiom
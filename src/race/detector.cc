@@ -45,6 +45,7 @@ void Detector::Setup(Mutex *lock, RaceDB *race_db) {
   race_db_ = race_db;
   unit_size_ = knob_->ValueInt("unit_size");
   filter_ = new RegionFilter(internal_lock_->Clone());
+  meta_table_.Setup(unit_size_);
 
   // set analyzer descriptor
   desc_.SetHookBeforeMem();
@@ -321,6 +322,27 @@ void Detector::AfterValloc(thread_id_t curr_thd_id, timestamp_t curr_thd_clk,
   AllocAddrRegion(addr, size);
 }
 
+VectorClock *Detector::GetVectorClock(thread_id_t thd_id) {
+  ScopedLock locker(internal_lock_);
+  std::map<thread_id_t, VectorClock *>::iterator it = curr_vc_map_.find(thd_id);
+  if (it == curr_vc_map_.end())
+    return NULL;
+  else
+    return it->second;
+}
+
+void Detector::SetVectorClock(thread_id_t thd_id, VectorClock *vc) {
+  ScopedLock locker(internal_lock_);
+  VectorClock *curr_vc = curr_vc_map_[thd_id];
+  if (!curr_vc) {
+    // the thread is not started in this detector
+    curr_vc = new VectorClock;
+    curr_vc_map_[thd_id] = curr_vc;
+    atomic_map_[thd_id] = false;
+  }
+  *curr_vc = *vc;
+}
+
 // helper functions
 void Detector::AllocAddrRegion(address_t addr, size_t size) {
   ScopedLock locker(internal_lock_);
@@ -334,32 +356,43 @@ void Detector::FreeAddrRegion(address_t addr) {
   size_t size = filter_->RemoveRegion(addr, false);
   address_t start_addr = UNIT_DOWN_ALIGN(addr, unit_size_);
   address_t end_addr = UNIT_UP_ALIGN(addr + size, unit_size_);
-  for (address_t iaddr = start_addr; iaddr < end_addr; iaddr += unit_size_) {
-    Meta::Table::iterator it = meta_table_.find(iaddr);
-    if (it != meta_table_.end()) {
-      ProcessFree(it->second);
-      meta_table_.erase(it);
-    }
+  // free meta data using range operations
+  std::vector<Meta *> meta_vec;
+  meta_table_.RemoveRange(start_addr, end_addr, &meta_vec);
+  for (std::vector<Meta *>::iterator it = meta_vec.begin();
+       it != meta_vec.end(); ++it) {
+    ProcessFree(*it);
   }
-  for (address_t iaddr = start_addr; iaddr < end_addr; iaddr += unit_size_) {
-    MutexMeta::Table::iterator it = mutex_meta_table_.find(iaddr);
-    if (it != mutex_meta_table_.end()) {
-      ProcessFree(it->second);
-      mutex_meta_table_.erase(it);
-    }
-  }
-  for (address_t iaddr = start_addr; iaddr < end_addr; iaddr += unit_size_) {
-    CondMeta::Table::iterator it = cond_meta_table_.find(iaddr);
-    if (it != cond_meta_table_.end()) {
-      ProcessFree(it->second);
-      cond_meta_table_.erase(it);
+  // free synchronization meta data
+  FreeSyncMeta(&mutex_meta_table_, start_addr, end_addr);
+  FreeSyncMeta(&cond_meta_table_, start_addr, end_addr);
+  FreeSyncMeta(&barrier_meta_table_, start_addr, end_addr);
+}
+
+template <typename T>
+void Detector::FreeSyncMeta(T *table, address_t start_addr,
+                            address_t end_addr) {
+  // the synchronization meta tables are usually small, scan the whole
+  // table if it has fewer entries than the units in the region
+  if (table->empty())
+    return;
+  if (table->size() < (end_addr - start_addr) / unit_size_) {
+    for (typename T::iterator it = table->begin(); it != table->end(); ) {
+      if (it->first >= start_addr && it->first < end_addr) {
+        ProcessFree(it->second);
+        table->erase(it++);
+      } else {
+        ++it;
+      }
     }
-  }
-  for (address_t iaddr = start_addr; iaddr < end_addr; iaddr += unit_size_) {
-    BarrierMeta::Table::iterator it = barrier_meta_table_.find(iaddr);
-    if (it != barrier_meta_table_.end()) {
-      ProcessFree(it->second);
-      barrier_meta_table_.erase(it);
+  } else {
+    for (address_t iaddr = start_addr; iaddr < end_addr;
+         iaddr += unit_size_) {
+      typename T::iterator it = table->find(iaddr);
+      if (it != table->end()) {
+        ProcessFree(it->second);
+        table->erase(it);
+      }
     }
   }
 }
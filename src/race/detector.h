@@ -25,6 +25,7 @@
 #include "core/analyzer.h"
 #include "core/vector_clock.h"
 #include "core/filter.h"
+#include "core/shadow_map.h"
 #include "race/race.h"
 
 namespace race {
@@ -106,11 +107,15 @@ class Detector : public Analyzer {
   virtual void AfterValloc(thread_id_t curr_thd_id, timestamp_t curr_thd_clk,
                            Inst *inst, size_t size, address_t addr);
 
+  // used by offline analyses that compute vector clocks separately
+  VectorClock *GetVectorClock(thread_id_t thd_id);
+  void SetVectorClock(thread_id_t thd_id, VectorClock *vc);
+
  protected:
   // the abstract meta data for the memory access
   class Meta {
    public:
-    typedef std::tr1::unordered_map<address_t, Meta *> Table;
+    typedef ShadowMap<Meta> Table;
 
     explicit Meta(address_t a) : addr(a) {}
     virtual ~Meta() {}
@@ -163,6 +168,8 @@ class Detector : public Analyzer {
   // helper functions
   void AllocAddrRegion(address_t addr, size_t size);
   void FreeAddrRegion(address_t addr);
+  template <typename T>
+  void FreeSyncMeta(T *table, address_t start_addr, address_t end_addr);
   bool FilterAccess(address_t addr) { return filter_->Filter(addr, false); }
   MutexMeta *GetMutexMeta(address_t iaddr);
   CondMeta *GetCondMeta(address_t iaddr);
@@ -20,6 +20,7 @@
 #include "race/djit.h"
 
 #include "core/logging.h"
+#include "core/stat.h"
 
 namespace race {
 
@@ -49,14 +50,35 @@ void Djit::Setup(Mutex *lock, RaceDB *race_db) {
 }
 
 Djit::Meta *Djit::GetMeta(address_t iaddr) {
-  Meta::Table::iterator it = meta_table_.find(iaddr);
-  if (it == meta_table_.end()) {
-    Meta *meta = new DjitMeta(iaddr);
-    meta_table_[iaddr] = meta;
-    return meta;
-  } else {
-    return it->second;
+  Meta *meta = meta_table_.Find(iaddr);
+  if (!meta) {
+    meta = new DjitMeta(iaddr);
+    meta_table_.Insert(iaddr, meta);
   }
+  return meta;
+}
+
+void Djit::ProgramExit() {
+  ScopedLock locker(internal_lock_);
+  // report the meta data size of the monitored units
+  size_t num_units = 0;
+  size_t num_spilled = 0;
+  size_t meta_bytes = meta_table_.Bytes();
+  std::vector<Meta *> meta_vec;
+  meta_table_.GetValues(&meta_vec);
+  for (std::vector<Meta *>::iterator it = meta_vec.begin();
+       it != meta_vec.end(); ++it) {
+    DjitMeta *djit_meta = dynamic_cast<DjitMeta *>(*it);
+    DEBUG_ASSERT(djit_meta);
+    num_units++;
+    if (djit_meta->writer_history.Spilled() ||
+        djit_meta->reader_history.Spilled())
+      num_spilled++;
+    meta_bytes += MetaBytes(djit_meta);
+  }
+  STAT_INC("djit_units", num_units);
+  STAT_INC("djit_spilled_units", num_spilled);
+  STAT_INC("djit_meta_bytes", meta_bytes);
 }
 
 void Djit::ProcessRead(thread_id_t curr_thd_id, Meta *meta, Inst *inst) {
@@ -66,21 +88,20 @@ void Djit::ProcessRead(thread_id_t curr_thd_id, Meta *meta, Inst *inst) {
   // get the current vector clock
   VectorClock *curr_vc = curr_vc_map_[curr_thd_id];
   // check writers
-  VectorClock &writer_vc = djit_meta->writer_vc;
-  if (!writer_vc.HappensBefore(curr_vc)) {
+  AccessHistory &writer_history = djit_meta->writer_history;
+  if (!writer_history.HappensBefore(curr_vc)) {
     DEBUG_FMT_PRINT_SAFE("RAW race detcted [T%lx]\n", curr_thd_id);
     DEBUG_FMT_PRINT_SAFE("  addr = 0x%lx\n", djit_meta->addr);
     DEBUG_FMT_PRINT_SAFE("  inst = [%s]\n", inst->ToString().c_str());
     // mark the meta as racy
     djit_meta->racy = true;
     // RAW race detected, report them
-    for (writer_vc.IterBegin(); !writer_vc.IterEnd(); writer_vc.IterNext()) {
-      thread_id_t thd_id = writer_vc.IterCurrThd();
-      timestamp_t clk = writer_vc.IterCurrClk();
-      if (curr_thd_id != thd_id && clk > curr_vc->GetClock(thd_id)) {
-        DEBUG_ASSERT(djit_meta->writer_inst_table.find(thd_id) !=
-                     djit_meta->writer_inst_table.end());
-        Inst *writer_inst = djit_meta->writer_inst_table[thd_id];
+    for (size_t i = 0; i < writer_history.Size(); i++) {
+      AccessHistory::Entry *entry = writer_history.At(i);
+      thread_id_t thd_id = entry->thd_id;
+      if (curr_thd_id != thd_id && entry->clk > curr_vc->GetClock(thd_id)) {
+        Inst *writer_inst = GetInst(entry->inst_id);
+        DEBUG_ASSERT(writer_inst);
         // report the race
         ReportRace(djit_meta, thd_id, writer_inst, RACE_EVENT_WRITE,
                    curr_thd_id, inst, RACE_EVENT_READ);
@@ -88,12 +109,7 @@ void Djit::ProcessRead(thread_id_t curr_thd_id, Meta *meta, Inst *inst) {
     }
   }
   // update meta data
-  djit_meta->reader_vc.SetClock(curr_thd_id, curr_vc->GetClock(curr_thd_id));
-  djit_meta->reader_inst_table[curr_thd_id] = inst;
-  // update race inst set if needed
-  if (track_racy_inst_) {
-    djit_meta->race_inst_set.insert(inst);
-  }
+  RecordRead(curr_thd_id, djit_meta, inst);
 }
 
 void Djit::ProcessWrite(thread_id_t curr_thd_id, Meta *meta, Inst *inst) {
@@ -102,23 +118,22 @@ void Djit::ProcessWrite(thread_id_t curr_thd_id, Meta *meta, Inst *inst) {
   DEBUG_ASSERT(djit_meta);
   // get the current vector clock
   VectorClock *curr_vc = curr_vc_map_[curr_thd_id];
-  VectorClock &writer_vc = djit_meta->writer_vc;
-  VectorClock &reader_vc = djit_meta->reader_vc;
+  AccessHistory &writer_history = djit_meta->writer_history;
+  AccessHistory &reader_history = djit_meta->reader_history;
   // check writers
-  if (!writer_vc.HappensBefore(curr_vc)) {
+  if (!writer_history.HappensBefore(curr_vc)) {
     DEBUG_FMT_PRINT_SAFE("WAW race detcted [T%lx]\n", curr_thd_id);
     DEBUG_FMT_PRINT_SAFE("  addr = 0x%lx\n", djit_meta->addr);
     DEBUG_FMT_PRINT_SAFE("  inst = [%s]\n", inst->ToString().c_str());
     // mark the meta as racy
     djit_meta->racy = true;
     // WAW race detected, report them
-    for (writer_vc.IterBegin(); !writer_vc.IterEnd(); writer_vc.IterNext()) {
-      thread_id_t thd_id = writer_vc.IterCurrThd();
-      timestamp_t clk = writer_vc.IterCurrClk();
-      if (curr_thd_id != thd_id && clk > curr_vc->GetClock(thd_id)) {
-        DEBUG_ASSERT(djit_meta->writer_inst_table.find(thd_id) !=
-                     djit_meta->writer_inst_table.end());
-        Inst *writer_inst = djit_meta->writer_inst_table[thd_id];
+    for (size_t i = 0; i < writer_history.Size(); i++) {
+      AccessHistory::Entry *entry = writer_history.At(i);
+      thread_id_t thd_id = entry->thd_id;
+      if (curr_thd_id != thd_id && entry->clk > curr_vc->GetClock(thd_id)) {
+        Inst *writer_inst = GetInst(entry->inst_id);
+        DEBUG_ASSERT(writer_inst);
         // report the race
         ReportRace(djit_meta, thd_id, writer_inst, RACE_EVENT_WRITE,
                    curr_thd_id, inst, RACE_EVENT_WRITE);
@@ -126,20 +141,19 @@ void Djit::ProcessWrite(thread_id_t curr_thd_id, Meta *meta, Inst *inst) {
     }
   }
   // check readers
-  if (!reader_vc.HappensBefore(curr_vc)) {
+  if (!reader_history.HappensBefore(curr_vc)) {
     DEBUG_FMT_PRINT_SAFE("WAR race detcted [T%lx]\n", curr_thd_id);
     DEBUG_FMT_PRINT_SAFE("  addr = 0x%lx\n", djit_meta->addr);
     DEBUG_FMT_PRINT_SAFE("  inst = [%s]\n", inst->ToString().c_str());
     // mark the meta as racy
     djit_meta->racy = true;
     // WAR race detected, report them
-    for (reader_vc.IterBegin(); !reader_vc.IterEnd(); reader_vc.IterNext()) {
-      thread_id_t thd_id = reader_vc.IterCurrThd();
-      timestamp_t clk = reader_vc.IterCurrClk();
-      if (curr_thd_id != thd_id && clk > curr_vc->GetClock(thd_id)) {
-        DEBUG_ASSERT(djit_meta->reader_inst_table.find(thd_id) !=
-                     djit_meta->reader_inst_table.end());
-        Inst *reader_inst = djit_meta->reader_inst_table[thd_id];
+    for (size_t i = 0; i < reader_history.Size(); i++) {
+      AccessHistory::Entry *entry = reader_history.At(i);
+      thread_id_t thd_id = entry->thd_id;
+      if (curr_thd_id != thd_id && entry->clk > curr_vc->GetClock(thd_id)) {
+        Inst *reader_inst = GetInst(entry->inst_id);
+        DEBUG_ASSERT(reader_inst);
         // report the race
         ReportRace(djit_meta, thd_id, reader_inst, RACE_EVENT_READ,
                    curr_thd_id, inst, RACE_EVENT_WRITE);
@@ -147,12 +161,7 @@ void Djit::ProcessWrite(thread_id_t curr_thd_id, Meta *meta, Inst *inst) {
     }
   }
   // update meta data
-  writer_vc.SetClock(curr_thd_id, curr_vc->GetClock(curr_thd_id));
-  djit_meta->writer_inst_table[curr_thd_id] = inst;
-  // update race inst set if needed
-  if (track_racy_inst_) {
-    djit_meta->race_inst_set.insert(inst);
-  }
+  RecordWrite(curr_thd_id, djit_meta, inst);
 }
 
 void Djit::ProcessFree(Meta *meta) {
@@ -161,13 +170,99 @@ void Djit::ProcessFree(Meta *meta) {
   DEBUG_ASSERT(djit_meta);
   // update racy inst set if needed
   if (track_racy_inst_ && djit_meta->racy) {
-    for (DjitMeta::InstSet::iterator it = djit_meta->race_inst_set.begin();
-         it != djit_meta->race_inst_set.end(); ++it) {
+    DEBUG_ASSERT(djit_meta->race_inst_set);
+    for (DjitMeta::InstSet::iterator it = djit_meta->race_inst_set->begin();
+         it != djit_meta->race_inst_set->end(); ++it) {
       race_db_->SetRacyInst(*it, true);
     }
   }
   delete djit_meta;
 }
 
+void Djit::RecordRead(thread_id_t curr_thd_id, DjitMeta *meta, Inst *inst) {
+  VectorClock *curr_vc = curr_vc_map_[curr_thd_id];
+  meta->reader_history.Update(curr_thd_id, curr_vc->GetClock(curr_thd_id),
+                              RegisterInst(inst));
+  RecordRacyInst(meta, inst);
+}
+
+void Djit::RecordWrite(thread_id_t curr_thd_id, DjitMeta *meta, Inst *inst) {
+  VectorClock *curr_vc = curr_vc_map_[curr_thd_id];
+  meta->writer_history.Update(curr_thd_id, curr_vc->GetClock(curr_thd_id),
+                              RegisterInst(inst));
+  RecordRacyInst(meta, inst);
+}
+
+void Djit::RecordRacyInst(DjitMeta *meta, Inst *inst) {
+  // update race inst set if needed
+  if (track_racy_inst_) {
+    if (!meta->race_inst_set)
+      meta->race_inst_set = new DjitMeta::InstSet;
+    meta->race_inst_set->insert(inst);
+  }
+}
+
+inst_id_type Djit::RegisterInst(Inst *inst) {
+  inst_id_type inst_id = inst->id();
+  if (inst_id >= inst_vec_.size())
+    inst_vec_.resize(inst_id + 1, NULL);
+  inst_vec_[inst_id] = inst;
+  return inst_id;
+}
+
+size_t Djit::MetaBytes(DjitMeta *meta) {
+  size_t bytes = sizeof(DjitMeta);
+  bytes += meta->writer_history.SpillBytes();
+  bytes += meta->reader_history.SpillBytes();
+  if (meta->race_inst_set) {
+    // a tree node holds three links, the color and the value
+    bytes += sizeof(DjitMeta::InstSet)
+             + meta->race_inst_set->size() * 5 * sizeof(void *);
+  }
+  return bytes;
+}
+
+bool Djit::AccessHistory::HappensBefore(VectorClock *vc) {
+  for (size_t i = 0; i < size_; i++) {
+    Entry *entry = At(i);
+    if (entry->clk > vc->GetClock(entry->thd_id))
+      return false;
+  }
+  return true;
+}
+
+void Djit::AccessHistory::Update(thread_id_t thd_id, timestamp_t clk,
+                                 inst_id_type inst_id) {
+  // find the entry of the thread
+  for (size_t i = 0; i < size_; i++) {
+    Entry *entry = At(i);
+    if (entry->thd_id == thd_id) {
+      entry->clk = clk;
+      entry->inst_id = inst_id;
+      return;
+    }
+  }
+  // add a new entry, spill to the side vector if necessary
+  Entry *entry = NULL;
+  if (size_ < INLINE_HISTORY_SIZE) {
+    entry = &inline_entries_[size_];
+  } else {
+    if (!spill_vec_)
+      spill_vec_ = new EntryVec;
+    spill_vec_->push_back(Entry());
+    entry = &spill_vec_->back();
+  }
+  entry->thd_id = thd_id;
+  entry->clk = clk;
+  entry->inst_id = inst_id;
+  size_++;
+}
+
+size_t Djit::AccessHistory::SpillBytes() {
+  if (!spill_vec_)
+    return 0;
+  return sizeof(EntryVec) + spill_vec_->capacity() * sizeof(Entry);
+}
+
 } // namespace race
 
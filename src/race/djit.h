@@ -20,16 +20,22 @@
 #ifndef RACE_DJIT_H_
 #define RACE_DJIT_H_
 
+#include <set>
+#include <vector>
 #include <tr1/unordered_map>
 
 #include "core/basictypes.h"
 #include "core/vector_clock.h"
 #include "core/filter.h"
+#include "core/static_info.h"
 #include "race/detector.h"
 #include "race/race.h"
 
 namespace race {
 
+// the number of accessors stored inline in an access history
+#define INLINE_HISTORY_SIZE 2
+
 class Djit : public Detector {
  public:
   Djit();
@@ -38,34 +44,86 @@ class Djit : public Detector {
   void Register();
   bool Enabled();
   void Setup(Mutex *lock, RaceDB *race_db);
+  void ProgramExit();
 
  protected:
+  // The compact access history of a memory location. It records the
+  // last access (clock and instruction id) of each accessing thread.
+  // The common cases (one or two accessing threads) are stored inline,
+  // and more accessors spill to a side vector.
+  class AccessHistory {
+   public:
+    struct Entry {
+      thread_id_t thd_id;
+      timestamp_t clk;
+      inst_id_type inst_id;
+    };
+
+    typedef std::vector<Entry> EntryVec;
+
+    AccessHistory() : size_(0), spill_vec_(NULL) {}
+    ~AccessHistory() { delete spill_vec_; }
+
+    size_t Size() { return size_; }
+    bool Spilled() { return spill_vec_ != NULL; }
+    Entry *At(size_t idx) {
+      if (idx < INLINE_HISTORY_SIZE)
+        return &inline_entries_[idx];
+      else
+        return &(*spill_vec_)[idx - INLINE_HISTORY_SIZE];
+    }
+    bool HappensBefore(VectorClock *vc);
+    void Update(thread_id_t thd_id, timestamp_t clk, inst_id_type inst_id);
+    size_t SpillBytes();
+
+   private:
+    uint32 size_;
+    Entry inline_entries_[INLINE_HISTORY_SIZE];
+    EntryVec *spill_vec_;
+
+    DISALLOW_COPY_CONSTRUCTORS(AccessHistory);
+  };
+
   // the meta data for the memory access
   class DjitMeta : public Meta {
    public:
-    typedef std::map<thread_id_t, Inst *> InstMap;
     typedef std::set<Inst *> InstSet;
 
-    explicit DjitMeta(address_t a) : Meta(a), racy(false) {}
-    ~DjitMeta() {}
+    explicit DjitMeta(address_t a)
+        : Meta(a),
+          racy(false),
+          race_inst_set(NULL) {}
+
+    ~DjitMeta() { delete race_inst_set; }
 
     bool racy; // whether this meta is involved in any race
-    VectorClock writer_vc;
-    InstMap writer_inst_table;
-    VectorClock reader_vc;
-    InstMap reader_inst_table;
-    InstSet race_inst_set;
+    AccessHistory writer_history;
+    AccessHistory reader_history;
+    InstSet *race_inst_set; // only allocated if racy insts are tracked
   };
 
+  typedef std::vector<Inst *> InstVec;
+
   // overrided virtual functions
   Meta *GetMeta(address_t iaddr);
   void ProcessRead(thread_id_t curr_thd_id, Meta *meta, Inst *inst);
   void ProcessWrite(thread_id_t curr_thd_id, Meta *meta, Inst *inst);
   void ProcessFree(Meta *meta);
 
+  // helper functions
+  void RecordRead(thread_id_t curr_thd_id, DjitMeta *meta, Inst *inst);
+  void RecordWrite(thread_id_t curr_thd_id, DjitMeta *meta, Inst *inst);
+  void RecordRacyInst(DjitMeta *meta, Inst *inst);
+  inst_id_type RegisterInst(Inst *inst);
+  Inst *GetInst(inst_id_type inst_id) { return inst_vec_[inst_id]; }
+  virtual size_t MetaBytes(DjitMeta *meta);
+
   // settings and flasg
   bool track_racy_inst_;
 
+  // the instructions indexed by their ids
+  InstVec inst_vec_;
+
  private:
   DISALLOW_COPY_CONSTRUCTORS(Djit);
 };
@@ -0,0 +1,218 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: race/hybrid.cc - Implementation of the hybrid data race
+// detector which uses lock sets to filter the happens-before checks.
+
+#include "race/hybrid.h"
+
+#include <algorithm>
+#include <iterator>
+#include "core/logging.h"
+
+namespace race {
+
+Hybrid::Hybrid() {
+  // the empty lock set
+  Intern(LockVec());
+}
+
+Hybrid::~Hybrid() {
+  // empty
+}
+
+void Hybrid::Register() {
+  Djit::Register();
+
+  knob_->RegisterBool("enable_hybrid", "whether enable the hybrid (lock set and happens-before) data race detector", "0");
+}
+
+bool Hybrid::Enabled() {
+  return knob_->ValueBool("enable_hybrid");
+}
+
+void Hybrid::AfterPthreadMutexLock(thread_id_t curr_thd_id,
+                                   timestamp_t curr_thd_clk, Inst *inst,
+                                   address_t addr) {
+  Djit::AfterPthreadMutexLock(curr_thd_id, curr_thd_clk, inst, addr);
+
+  ScopedLock locker(internal_lock_);
+  AddLock(curr_thd_id, addr);
+}
+
+void Hybrid::BeforePthreadMutexUnlock(thread_id_t curr_thd_id,
+                                      timestamp_t curr_thd_clk, Inst *inst,
+                                      address_t addr) {
+  Djit::BeforePthreadMutexUnlock(curr_thd_id, curr_thd_clk, inst, addr);
+
+  ScopedLock locker(internal_lock_);
+  RemoveLock(curr_thd_id, addr);
+}
+
+void Hybrid::BeforePthreadCondWait(thread_id_t curr_thd_id,
+                                   timestamp_t curr_thd_clk, Inst *inst,
+                                   address_t cond_addr, address_t mutex_addr) {
+  Djit::BeforePthreadCondWait(curr_thd_id, curr_thd_clk, inst,
+                              cond_addr, mutex_addr);
+
+  ScopedLock locker(internal_lock_);
+  RemoveLock(curr_thd_id, mutex_addr);
+}
+
+void Hybrid::AfterPthreadCondWait(thread_id_t curr_thd_id,
+                                  timestamp_t curr_thd_clk, Inst *inst,
+                                  address_t cond_addr, address_t mutex_addr) {
+  Djit::AfterPthreadCondWait(curr_thd_id, curr_thd_clk, inst,
+                             cond_addr, mutex_addr);
+
+  ScopedLock locker(internal_lock_);
+  AddLock(curr_thd_id, mutex_addr);
+}
+
+void Hybrid::BeforePthreadCondTimedwait(thread_id_t curr_thd_id,
+                                        timestamp_t curr_thd_clk, Inst *inst,
+                                        address_t cond_addr,
+                                        address_t mutex_addr) {
+  Djit::BeforePthreadCondTimedwait(curr_thd_id, curr_thd_clk, inst,
+                                   cond_addr, mutex_addr);
+
+  ScopedLock locker(internal_lock_);
+  RemoveLock(curr_thd_id, mutex_addr);
+}
+
+void Hybrid::AfterPthreadCondTimedwait(thread_id_t curr_thd_id,
+                                       timestamp_t curr_thd_clk, Inst *inst,
+                                       address_t cond_addr,
+                                       address_t mutex_addr) {
+  Djit::AfterPthreadCondTimedwait(curr_thd_id, curr_thd_clk, inst,
+                                  cond_addr, mutex_addr);
+
+  ScopedLock locker(internal_lock_);
+  AddLock(curr_thd_id, mutex_addr);
+}
+
+Hybrid::Meta *Hybrid::GetMeta(address_t iaddr) {
+  Meta *meta = meta_table_.Find(iaddr);
+  if (!meta) {
+    meta = new HybridMeta(iaddr);
+    meta_table_.Insert(iaddr, meta);
+  }
+  return meta;
+}
+
+void Hybrid::ProcessRead(thread_id_t curr_thd_id, Meta *meta, Inst *inst) {
+  // cast the meta
+  HybridMeta *hybrid_meta = dynamic_cast<HybridMeta *>(meta);
+  DEBUG_ASSERT(hybrid_meta);
+  // perform the vector clock checks only if the lock set is empty
+  if (UpdateLockSet(curr_thd_id, hybrid_meta))
+    Djit::ProcessRead(curr_thd_id, meta, inst);
+  else
+    RecordRead(curr_thd_id, hybrid_meta, inst);
+}
+
+void Hybrid::ProcessWrite(thread_id_t curr_thd_id, Meta *meta, Inst *inst) {
+  // cast the meta
+  HybridMeta *hybrid_meta = dynamic_cast<HybridMeta *>(meta);
+  DEBUG_ASSERT(hybrid_meta);
+  // perform the vector clock checks only if the lock set is empty
+  if (UpdateLockSet(curr_thd_id, hybrid_meta))
+    Djit::ProcessWrite(curr_thd_id, meta, inst);
+  else
+    RecordWrite(curr_thd_id, hybrid_meta, inst);
+}
+
+size_t Hybrid::MetaBytes(DjitMeta *meta) {
+  return Djit::MetaBytes(meta) + sizeof(HybridMeta) - sizeof(DjitMeta);
+}
+
+void Hybrid::AddLock(thread_id_t thd_id, address_t addr) {
+  LockVec locks = ls_table_[curr_ls_map_[thd_id]];
+  LockVec::iterator it = std::lower_bound(locks.begin(), locks.end(), addr);
+  if (it != locks.end() && *it == addr)
+    return;
+  locks.insert(it, addr);
+  curr_ls_map_[thd_id] = Intern(locks);
+}
+
+void Hybrid::RemoveLock(thread_id_t thd_id, address_t addr) {
+  LockVec locks = ls_table_[curr_ls_map_[thd_id]];
+  LockVec::iterator it = std::lower_bound(locks.begin(), locks.end(), addr);
+  if (it == locks.end() || *it != addr)
+    return;
+  locks.erase(it);
+  curr_ls_map_[thd_id] = Intern(locks);
+}
+
+Hybrid::lockset_id_t Hybrid::Intern(const LockVec &locks) {
+  std::map<LockVec, lockset_id_t>::iterator it = ls_id_map_.find(locks);
+  if (it != ls_id_map_.end())
+    return it->second;
+  lockset_id_t id = (lockset_id_t)ls_table_.size();
+  ls_table_.push_back(locks);
+  ls_id_map_[locks] = id;
+  return id;
+}
+
+Hybrid::lockset_id_t Hybrid::Intersect(lockset_id_t ls1, lockset_id_t ls2) {
+  if (ls1 == ls2)
+    return ls1;
+  if (ls1 == kEmptyLockSet || ls2 == kEmptyLockSet)
+    return kEmptyLockSet;
+  // the intersection is symmetric, cache it under the ordered pair
+  if (ls1 > ls2)
+    std::swap(ls1, ls2);
+  uint64 key = ((uint64)ls1 << 32) | ls2;
+  std::tr1::unordered_map<uint64, lockset_id_t>::iterator it =
+      intersect_cache_.find(key);
+  if (it != intersect_cache_.end())
+    return it->second;
+  LockVec locks;
+  std::set_intersection(ls_table_[ls1].begin(), ls_table_[ls1].end(),
+                        ls_table_[ls2].begin(), ls_table_[ls2].end(),
+                        std::back_inserter(locks));
+  lockset_id_t id = Intern(locks);
+  intersect_cache_[key] = id;
+  return id;
+}
+
+bool Hybrid::UpdateLockSet(thread_id_t curr_thd_id, HybridMeta *meta) {
+  // return true if the vector clock checks are needed
+  lockset_id_t curr_ls = curr_ls_map_[curr_thd_id];
+  switch (meta->state) {
+    case HybridMeta::STATE_VIRGIN:
+      meta->state = HybridMeta::STATE_EXCLUSIVE;
+      meta->owner = curr_thd_id;
+      meta->lockset = curr_ls;
+      return false;
+    case HybridMeta::STATE_EXCLUSIVE:
+      meta->lockset = Intersect(meta->lockset, curr_ls);
+      if (meta->owner == curr_thd_id)
+        return false;
+      meta->state = HybridMeta::STATE_SHARED;
+      return meta->lockset == kEmptyLockSet;
+    case HybridMeta::STATE_SHARED:
+      // once empty, the lock set stays empty
+      meta->lockset = Intersect(meta->lockset, curr_ls);
+      return meta->lockset == kEmptyLockSet;
+    default:
+      DEBUG_ASSERT(0); // impossible
+      return true;
+  }
+}
+
+} // namespace race
+
@@ -0,0 +1,118 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: race/hybrid.h - Define the hybrid data race detector which uses
+// lock sets to filter the happens-before checks.
+
+#ifndef RACE_HYBRID_H_
+#define RACE_HYBRID_H_
+
+#include <map>
+#include <vector>
+#include <tr1/unordered_map>
+
+#include "core/basictypes.h"
+#include "race/djit.h"
+
+namespace race {
+
+// The hybrid detector tracks the candidate lock set of each location
+// (the locks held on every access so far). As long as the candidate
+// lock set is not empty, all the accesses are ordered by a common lock,
+// thus only the access history is updated. The vector clock checks of
+// Djit are performed only after the candidate lock set becomes empty.
+// The lock sets are interned, so that a location only stores the id of
+// its candidate lock set and the intersections are cached.
+class Hybrid : public Djit {
+ public:
+  Hybrid();
+  ~Hybrid();
+
+  void Register();
+  bool Enabled();
+  void AfterPthreadMutexLock(thread_id_t curr_thd_id,
+                             timestamp_t curr_thd_clk,
+                             Inst *inst, address_t addr);
+  void BeforePthreadMutexUnlock(thread_id_t curr_thd_id,
+                                timestamp_t curr_thd_clk, Inst *inst,
+                                address_t addr);
+  void BeforePthreadCondWait(thread_id_t curr_thd_id,
+                             timestamp_t curr_thd_clk, Inst *inst,
+                             address_t cond_addr, address_t mutex_addr);
+  void AfterPthreadCondWait(thread_id_t curr_thd_id,
+                            timestamp_t curr_thd_clk, Inst *inst,
+                            address_t cond_addr, address_t mutex_addr);
+  void BeforePthreadCondTimedwait(thread_id_t curr_thd_id,
+                                  timestamp_t curr_thd_clk, Inst *inst,
+                                  address_t cond_addr, address_t mutex_addr);
+  void AfterPthreadCondTimedwait(thread_id_t curr_thd_id,
+                                 timestamp_t curr_thd_clk, Inst *inst,
+                                 address_t cond_addr, address_t mutex_addr);
+
+ protected:
+  typedef uint32 lockset_id_t; // the id of an interned lock set
+  typedef std::vector<address_t> LockVec; // sorted lock addresses
+
+  // the id of the empty lock set
+  static const lockset_id_t kEmptyLockSet = 0;
+
+  // the meta data for the memory access
+  class HybridMeta : public DjitMeta {
+   public:
+    enum State {
+      STATE_VIRGIN = 0,
+      STATE_EXCLUSIVE, // only accessed by the owner thread
+      STATE_SHARED,
+    };
+
+    explicit HybridMeta(address_t a)
+        : DjitMeta(a),
+          state(STATE_VIRGIN),
+          owner(INVALID_THD_ID),
+          lockset(kEmptyLockSet) {}
+
+    ~HybridMeta() {}
+
+    State state;
+    thread_id_t owner;
+    lockset_id_t lockset; // the candidate lock set
+  };
+
+  // overrided virtual functions
+  Meta *GetMeta(address_t iaddr);
+  void ProcessRead(thread_id_t curr_thd_id, Meta *meta, Inst *inst);
+  void ProcessWrite(thread_id_t curr_thd_id, Meta *meta, Inst *inst);
+  size_t MetaBytes(DjitMeta *meta);
+
+  void AddLock(thread_id_t thd_id, address_t addr);
+  void RemoveLock(thread_id_t thd_id, address_t addr);
+  lockset_id_t Intern(const LockVec &locks);
+  lockset_id_t Intersect(lockset_id_t ls1, lockset_id_t ls2);
+  bool UpdateLockSet(thread_id_t curr_thd_id, HybridMeta *meta);
+
+  std::map<thread_id_t, lockset_id_t> curr_ls_map_; // the locks held
+  std::vector<LockVec> ls_table_; // indexed by lock set id
+  std::map<LockVec, lockset_id_t> ls_id_map_;
+  std::tr1::unordered_map<uint64, lockset_id_t> intersect_cache_;
+
+ private:
+  DISALLOW_COPY_CONSTRUCTORS(Hybrid);
+};
+
+} // namespace race
+
+#endif
+
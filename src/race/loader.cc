@@ -0,0 +1,293 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: race/loader.cc - Implementation of the offline data race
+// detector which replays recorded trace logs.
+
+#include "race/loader.h"
+
+#include <pthread.h>
+#include <cstdio>
+#include <cstdlib>
+
+#include "core/logging.h"
+
+namespace race {
+
+Loader::Loader()
+    : race_db_(NULL),
+      sync_detector_(NULL),
+      sync_race_db_(NULL),
+      partition_size_(0) {
+  // empty
+}
+
+void Loader::HandlePreSetup() {
+  tracer::Loader::HandlePreSetup();
+
+  knob_->RegisterStr("race_in", "the input race database path", "race.db");
+  knob_->RegisterStr("race_out", "the output race database path", "race.db");
+  knob_->RegisterInt("num_workers", "the number of worker threads (0 means the number of cpus)", "0");
+  knob_->RegisterInt("partition_size", "the size of each address partition in bytes", "4096");
+
+  sync_detector_ = CreateDetector();
+  sync_detector_->Register();
+}
+
+void Loader::HandlePostSetup() {
+  tracer::Loader::HandlePostSetup();
+
+  if (!sync_detector_->Enabled()) {
+    printf("Please choose a data race detector\n");
+    exit(1);
+  }
+
+  // load race db
+  race_db_ = new RaceDB(CreateMutex());
+  race_db_->Load(knob_->ValueStr("race_in"), sinfo_);
+
+  // the first pass only tracks vector clocks, thus the races
+  // reported to this database are ignored
+  sync_race_db_ = new RaceDB(CreateMutex());
+  sync_detector_->Setup(CreateMutex(), sync_race_db_);
+  AddAnalyzer(sync_detector_);
+
+  partition_size_ = PartitionSize(knob_->ValueInt("partition_size"),
+                                  knob_->ValueInt("unit_size"));
+
+  // create workers
+  int num_workers = NumWorkers(knob_->ValueInt("num_workers"));
+  for (int i = 0; i < num_workers; i++) {
+    Worker *worker = new Worker;
+    worker->id = i;
+    worker->loader = this;
+    worker->race_db = new RaceDB(CreateMutex());
+    worker->detector = CreateDetector();
+    worker->detector->Setup(CreateMutex(), worker->race_db);
+    workers_.push_back(worker);
+  }
+}
+
+void Loader::HandleStart() {
+  ComputeSegments();
+  DetectRaces();
+}
+
+void Loader::HandleExit() {
+  race_db_->Save(knob_->ValueStr("race_out"), sinfo_);
+}
+
+Detector *Loader::CreateDetector() {
+  // FastTrack is not implemented yet, thus only Djit is supported
+  return new Djit;
+}
+
+void Loader::ComputeSegments() {
+  uint64 idx = 0;
+  trace_log_->OpenForRead();
+  while (trace_log_->HasNextEntry()) {
+    tracer::LogEntry entry = trace_log_->NextEntry();
+    if (!IsMemEntry(&entry)) {
+      HandleEvent(&entry);
+      // only the current thread (and the parent thread when a new
+      // thread starts) can have its vector clock changed
+      UpdateSegment(entry.thd_id(), idx + 1);
+      if (entry.type() == tracer::LOG_ENTRY_THREAD_START)
+        UpdateSegment(entry.arg(0), idx + 1);
+    }
+    idx++;
+  }
+  trace_log_->CloseForRead();
+}
+
+void Loader::UpdateSegment(thread_id_t thd_id, uint64 start) {
+  VectorClock *vc = sync_detector_->GetVectorClock(thd_id);
+  if (!vc)
+    return;
+  SegmentVec &segment_vec = segment_map_[thd_id];
+  if (!segment_vec.empty() && segment_vec.back().vc.Equal(vc))
+    return;
+  segment_vec.push_back(Segment());
+  segment_vec.back().start = start;
+  segment_vec.back().vc = *vc;
+}
+
+void Loader::DetectRaces() {
+  std::vector<pthread_t> tid_vec(workers_.size());
+  for (size_t i = 0; i < workers_.size(); i++)
+    pthread_create(&tid_vec[i], NULL, WorkerMain, workers_[i]);
+  for (size_t i = 0; i < workers_.size(); i++)
+    pthread_join(tid_vec[i], NULL);
+
+  // let the detectors report their statistics
+  for (size_t i = 0; i < workers_.size(); i++)
+    workers_[i]->detector->ProgramExit();
+
+  // merge the race databases of the workers
+  for (size_t i = 0; i < workers_.size(); i++)
+    race_db_->Merge(workers_[i]->race_db);
+}
+
+void Loader::WorkerLoop(Worker *worker) {
+  // each worker reads the trace log on its own
+  tracer::TraceLog trace_log(knob_->ValueStr("trace_log_path"));
+  uint64 idx = 0;
+  trace_log.OpenForRead();
+  while (trace_log.HasNextEntry()) {
+    tracer::LogEntry entry = trace_log.NextEntry();
+    WorkerHandleEvent(worker, &entry, idx);
+    idx++;
+  }
+  trace_log.CloseForRead();
+}
+
+void Loader::WorkerHandleEvent(Worker *worker, tracer::LogEntry *e,
+                               uint64 idx) {
+  Detector *detector = worker->detector;
+  switch (e->type()) {
+    case tracer::LOG_ENTRY_IMAGE_LOAD:
+    case tracer::LOG_ENTRY_IMAGE_UNLOAD:
+      {
+        Image *image = sinfo_->FindImage((image_id_type)e->arg(0));
+        DEBUG_ASSERT(image);
+        if (e->type() == tracer::LOG_ENTRY_IMAGE_LOAD)
+          detector->ImageLoad(image, e->arg(1), e->arg(2), e->arg(3),
+                              e->arg(4), e->arg(5), e->arg(6));
+        else
+          detector->ImageUnload(image, e->arg(1), e->arg(2), e->arg(3),
+                                e->arg(4), e->arg(5), e->arg(6));
+      }
+      break;
+    case tracer::LOG_ENTRY_BEFORE_MEM_READ:
+      WorkerHandleMem(worker, e, idx, true);
+      break;
+    case tracer::LOG_ENTRY_BEFORE_MEM_WRITE:
+      WorkerHandleMem(worker, e, idx, false);
+      break;
+    case tracer::LOG_ENTRY_BEFORE_ATOMIC_INST:
+      WorkerSetVectorClock(worker, e->thd_id(), idx);
+      detector->BeforeAtomicInst(e->thd_id(), e->thd_clk(),
+                                 sinfo_->FindInst(e->inst_id()),
+                                 e->str_arg(0), e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_AFTER_ATOMIC_INST:
+      WorkerSetVectorClock(worker, e->thd_id(), idx);
+      detector->AfterAtomicInst(e->thd_id(), e->thd_clk(),
+                                sinfo_->FindInst(e->inst_id()),
+                                e->str_arg(0), e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_AFTER_MALLOC:
+      detector->AfterMalloc(e->thd_id(), e->thd_clk(),
+                            sinfo_->FindInst(e->inst_id()),
+                            e->arg(0), e->arg(1));
+      break;
+    case tracer::LOG_ENTRY_AFTER_CALLOC:
+      detector->AfterCalloc(e->thd_id(), e->thd_clk(),
+                            sinfo_->FindInst(e->inst_id()),
+                            e->arg(0), e->arg(1), e->arg(2));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_REALLOC:
+      detector->BeforeRealloc(e->thd_id(), e->thd_clk(),
+                              sinfo_->FindInst(e->inst_id()),
+                              e->arg(0), e->arg(1));
+      break;
+    case tracer::LOG_ENTRY_AFTER_REALLOC:
+      detector->AfterRealloc(e->thd_id(), e->thd_clk(),
+                             sinfo_->FindInst(e->inst_id()),
+                             e->arg(0), e->arg(1), e->arg(2));
+      break;
+    case tracer::LOG_ENTRY_BEFORE_FREE:
+      detector->BeforeFree(e->thd_id(), e->thd_clk(),
+                           sinfo_->FindInst(e->inst_id()), e->arg(0));
+      break;
+    case tracer::LOG_ENTRY_AFTER_VALLOC:
+      detector->AfterValloc(e->thd_id(), e->thd_clk(),
+                            sinfo_->FindInst(e->inst_id()),
+                            e->arg(0), e->arg(1));
+      break;
+    default:
+      // synchronization events are handled in the first pass
+      break;
+  }
+}
+
+void Loader::WorkerHandleMem(Worker *worker, tracer::LogEntry *e,
+                             uint64 idx, bool is_read) {
+  thread_id_t self = e->thd_id();
+  timestamp_t curr_thd_clk = e->thd_clk();
+  Inst *inst = sinfo_->FindInst(e->inst_id());
+  DEBUG_ASSERT(inst);
+  address_t addr = e->arg(0);
+  address_t end_addr = addr + e->arg(1);
+  // split the access at the partition boundaries, and only process
+  // the parts owned by this worker
+  bool vc_set = false;
+  while (addr < end_addr) {
+    address_t next_addr = UNIT_DOWN_ALIGN(addr, partition_size_)
+                          + partition_size_;
+    if (next_addr > end_addr)
+      next_addr = end_addr;
+    if (Owner(addr) == worker->id) {
+      if (!vc_set) {
+        WorkerSetVectorClock(worker, self, idx);
+        vc_set = true;
+      }
+      if (is_read)
+        worker->detector->BeforeMemRead(self, curr_thd_clk, inst,
+                                        addr, next_addr - addr);
+      else
+        worker->detector->BeforeMemWrite(self, curr_thd_clk, inst,
+                                         addr, next_addr - addr);
+    }
+    addr = next_addr;
+  }
+}
+
+bool Loader::WorkerSetVectorClock(Worker *worker, thread_id_t thd_id,
+                                  uint64 idx) {
+  SegmentMap::iterator it = segment_map_.find(thd_id);
+  if (it == segment_map_.end())
+    return false;
+  SegmentVec &segment_vec = it->second;
+  // segments are sorted by their start indices, and the log entries of
+  // a thread are visited in order, thus the cursor only moves forward
+  std::map<thread_id_t, size_t>::iterator cit =
+      worker->cursor_map.find(thd_id);
+  size_t cursor;
+  if (cit == worker->cursor_map.end()) {
+    if (segment_vec.empty() || segment_vec[0].start > idx)
+      return false;
+    cursor = 0;
+  } else {
+    cursor = cit->second;
+  }
+  size_t next = cursor;
+  while (next + 1 < segment_vec.size() && segment_vec[next + 1].start <= idx)
+    next++;
+  if (cit != worker->cursor_map.end() && next == cursor)
+    return false;
+  worker->cursor_map[thd_id] = next;
+  worker->detector->SetVectorClock(thd_id, &segment_vec[next].vc);
+  return true;
+}
+
+void *Loader::WorkerMain(void *arg) {
+  Worker *worker = (Worker *)arg;
+  worker->loader->WorkerLoop(worker);
+  return NULL;
+}
+
+} // namespace race
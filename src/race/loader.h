@@ -0,0 +1,111 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: race/loader.h - Define the offline data race detector which
+// replays recorded trace logs.
+
+#ifndef RACE_LOADER_H_
+#define RACE_LOADER_H_
+
+#include <map>
+#include <vector>
+
+#include "core/basictypes.h"
+#include "core/sync.h"
+#include "core/vector_clock.h"
+#include "tracer/log.h"
+#include "tracer/loader.h"
+#include "race/race.h"
+#include "race/detector.h"
+#include "race/djit.h"
+
+namespace race {
+
+// The offline data race detector. The trace log is processed in two
+// passes. The first pass replays the non-memory events sequentially to
+// compute the vector clock of each thread segment. The second pass
+// partitions the memory events by address across worker threads. Each
+// worker has its own detector (thus its own meta data) and race
+// database. The race databases of the workers are merged at the end.
+class Loader : public tracer::Loader {
+ public:
+  Loader();
+  ~Loader() {}
+
+ protected:
+  // A thread segment is a sequence of log entries from a thread during
+  // which the vector clock of the thread does not change.
+  struct Segment {
+    uint64 start; // the index of the first log entry of the segment
+    VectorClock vc;
+  };
+
+  typedef std::vector<Segment> SegmentVec;
+  typedef std::map<thread_id_t, SegmentVec> SegmentMap;
+
+  // The state of a worker thread.
+  struct Worker {
+    Worker() : id(0), loader(NULL), detector(NULL), race_db(NULL) {}
+
+    int id;
+    Loader *loader;
+    Detector *detector;
+    RaceDB *race_db;
+    std::map<thread_id_t, size_t> cursor_map; // the current segments
+  };
+
+  Mutex *CreateMutex() { return new SysMutex; }
+  void HandlePreSetup();
+  void HandlePostSetup();
+  void HandleStart();
+  void HandleExit();
+
+  Detector *CreateDetector();
+  void ComputeSegments();
+  void UpdateSegment(thread_id_t thd_id, uint64 start);
+  void DetectRaces();
+  void WorkerLoop(Worker *worker);
+  void WorkerHandleEvent(Worker *worker, tracer::LogEntry *e, uint64 idx);
+  void WorkerHandleMem(Worker *worker, tracer::LogEntry *e, uint64 idx,
+                       bool is_read);
+  bool WorkerSetVectorClock(Worker *worker, thread_id_t thd_id, uint64 idx);
+  int Owner(address_t addr) {
+    return (int)((addr / partition_size_) % workers_.size());
+  }
+
+  static bool IsMemEntry(tracer::LogEntry *e) {
+    return e->type() == tracer::LOG_ENTRY_BEFORE_MEM_READ ||
+           e->type() == tracer::LOG_ENTRY_AFTER_MEM_READ ||
+           e->type() == tracer::LOG_ENTRY_BEFORE_MEM_WRITE ||
+           e->type() == tracer::LOG_ENTRY_AFTER_MEM_WRITE;
+  }
+
+  static void *WorkerMain(void *arg);
+
+  RaceDB *race_db_;
+  Detector *sync_detector_; // used in the first pass
+  RaceDB *sync_race_db_;
+  address_t partition_size_;
+  SegmentMap segment_map_;
+  std::vector<Worker *> workers_;
+
+ private:
+  DISALLOW_COPY_CONSTRUCTORS(Loader);
+};
+
+} // namespace race
+
+#endif
@@ -0,0 +1,122 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: race/merge_tool.cc - Implementation of the command line tool
+// that merges race database deltas.
+
+#include "race/merge_tool.h"
+
+#include <dirent.h>
+#include <algorithm>
+#include <fstream>
+
+#include "core/atomic.h"
+#include "core/logging.h"
+
+namespace race {
+
+MergeTool::MergeTool()
+    : race_db_(NULL),
+      next_delta_(0),
+      next_merge_(0) {
+  pthread_mutex_init(&merge_mutex_, NULL);
+  pthread_cond_init(&merge_cond_, NULL);
+}
+
+void MergeTool::HandlePreSetup() {
+  OfflineTool::HandlePreSetup();
+
+  knob_->RegisterStr("race_in", "the input race database path", "race.db");
+  knob_->RegisterStr("race_out", "the output race database path", "race.db");
+  knob_->RegisterStr("delta_path", "the directory that contains the race database deltas", "race-delta");
+  knob_->RegisterInt("num_workers", "the number of worker threads (0 means the number of cpus)", "0");
+}
+
+void MergeTool::HandlePostSetup() {
+  OfflineTool::HandlePostSetup();
+
+  // load race db
+  race_db_ = new RaceDB(CreateMutex());
+  race_db_->Load(knob_->ValueStr("race_in"), sinfo_);
+
+  ListDeltas(knob_->ValueStr("delta_path"));
+}
+
+void MergeTool::HandleStart() {
+  OfflineTool::HandleStart();
+
+  int num_workers = NumWorkers(knob_->ValueInt("num_workers"));
+  if ((size_t)num_workers > delta_vec_.size())
+    num_workers = delta_vec_.size();
+
+  std::vector<pthread_t> tid_vec(num_workers);
+  for (int i = 0; i < num_workers; i++)
+    pthread_create(&tid_vec[i], NULL, WorkerMain, this);
+  for (int i = 0; i < num_workers; i++)
+    pthread_join(tid_vec[i], NULL);
+}
+
+void MergeTool::HandleExit() {
+  OfflineTool::HandleExit();
+
+  race_db_->Save(knob_->ValueStr("race_out"), sinfo_);
+}
+
+void MergeTool::ListDeltas(const std::string &path) {
+  DIR *dir = opendir(path.c_str());
+  if (!dir)
+    return;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    std::string name(entry->d_name);
+    if (name.empty() || name[0] == '.')
+      continue;
+    delta_vec_.push_back(path + "/" + name);
+  }
+  closedir(dir);
+  std::sort(delta_vec_.begin(), delta_vec_.end());
+}
+
+void MergeTool::WorkerLoop() {
+  while (true) {
+    size_t idx = ATOMIC_FETCH_AND_ADD(&next_delta_, 1);
+    if (idx >= delta_vec_.size())
+      break;
+    // parse the delta (the expensive part) in parallel
+    RaceDBProto proto;
+    std::fstream in(delta_vec_[idx].c_str(), std::ios::in | std::ios::binary);
+    if (in.is_open())
+      proto.ParseFromIstream(&in);
+    in.close();
+    // merge the deltas in order
+    pthread_mutex_lock(&merge_mutex_);
+    while (next_merge_ != idx)
+      pthread_cond_wait(&merge_cond_, &merge_mutex_);
+    race_db_->MergeDelta(&proto, sinfo_, true);
+    next_merge_++;
+    pthread_cond_broadcast(&merge_cond_);
+    pthread_mutex_unlock(&merge_mutex_);
+  }
+}
+
+void *MergeTool::WorkerMain(void *arg) {
+  MergeTool *tool = (MergeTool *)arg;
+  tool->WorkerLoop();
+  return NULL;
+}
+
+} // namespace race
+
@@ -0,0 +1,69 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: race/merge_tool.h - Define the command line tool that merges
+// race database deltas.
+
+#ifndef RACE_MERGE_TOOL_H_
+#define RACE_MERGE_TOOL_H_
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+#include "core/basictypes.h"
+#include "core/offline_tool.h"
+#include "race/race.h"
+
+namespace race {
+
+// Merges the race database deltas saved by parallel profiling runs
+// (see knob race_delta) into a race database. The delta files are
+// parsed by multiple worker threads, but merged in file name order so
+// that the result is deterministic. At most one delta per worker is in
+// memory at any time.
+class MergeTool : public OfflineTool {
+ public:
+  MergeTool();
+  ~MergeTool() {}
+
+ protected:
+  Mutex *CreateMutex() { return new SysMutex; }
+  void HandlePreSetup();
+  void HandlePostSetup();
+  void HandleStart();
+  void HandleExit();
+
+  void ListDeltas(const std::string &path);
+  void WorkerLoop();
+
+  static void *WorkerMain(void *arg);
+
+  RaceDB *race_db_;
+  std::vector<std::string> delta_vec_;
+  size_t next_delta_; // the next delta to parse
+  size_t next_merge_; // the next delta to merge
+  pthread_mutex_t merge_mutex_;
+  pthread_cond_t merge_cond_;
+
+ private:
+  DISALLOW_COPY_CONSTRUCTORS(MergeTool);
+};
+
+} // namespace race
+
+#endif
+
@@ -0,0 +1,33 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: race/merge_tool_main.cc - The main entrance of the race database
+// merge tool.
+
+#include "race/merge_tool.h"
+
+static race::MergeTool *merge_tool = new race::MergeTool;
+
+int main(int argc, char *argv[]) {
+  merge_tool->Initialize();
+  merge_tool->PreSetup();
+  merge_tool->Parse(argc, argv);
+  merge_tool->PostSetup();
+  merge_tool->Start();
+  merge_tool->Exit();
+  return 0;
+}
+
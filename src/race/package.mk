@@ -7,6 +7,11 @@ srcs += \
   race/detector.cc \
   race/djit.cc \
   race/fasttrack.cc \
+  race/hybrid.cc \
+  race/loader.cc \
+  race/loader_main.cc \
+  race/merge_tool.cc \
+  race/merge_tool_main.cc \
   race/pct_profiler.cpp \
   race/pct_profiler_main.cpp \
   race/profiler.cpp \
@@ -18,10 +23,15 @@ pintools += \
   race_pct_profiler.so \
   race_profiler.so
 
+cmdtools += \
+  race_loader \
+  race_merge
+
 race_profiler_objs := \
   race/detector.o \
   race/djit.o \
   race/fasttrack.o \
+  race/hybrid.o \
   race/profiler.o \
   race/profiler_main.o \
   race/race.o \
@@ -32,6 +42,7 @@ race_pct_profiler_objs := \
   race/detector.o \
   race/djit.o \
   race/fasttrack.o \
+  race/hybrid.o \
   race/pct_profiler.o \
   race/pct_profiler_main.o \
   race/race.o \
@@ -39,10 +50,29 @@ race_pct_profiler_objs := \
   $(pct_objs) \
   $(core_objs)
 
+race_loader_objs := \
+  race/detector.o \
+  race/djit.o \
+  race/fasttrack.o \
+  race/loader.o \
+  race/loader_main.o \
+  race/race.o \
+  race/race.pb.o \
+  $(tracer_cmd_objs) \
+  $(core_cmd_objs)
+
+race_merge_objs := \
+  race/merge_tool.o \
+  race/merge_tool_main.o \
+  race/race.o \
+  race/race.pb.o \
+  $(core_cmd_objs)
+
 race_objs := \
   race/detector.o \
   race/djit.o \
   race/fasttrack.o \
+  race/hybrid.o \
   race/race.o \
   race/race.pb.o
 
@@ -27,9 +27,13 @@ void Profiler::HandlePreSetup() {
   knob_->RegisterBool("ignore_lib", "whether ignore accesses from common libraries", "0");
   knob_->RegisterStr("race_in", "the input race database path", "race.db");
   knob_->RegisterStr("race_out", "the output race database path", "race.db");
+  knob_->RegisterBool("race_delta", "whether only save the races of this execution (to a new file under delta_path, to be merged by race_merge) without saving the static info and statistics", "0");
+  knob_->RegisterStr("delta_path", "the directory that contains the race database deltas", "race-delta");
 
   djit_analyzer_ = new Djit;
   djit_analyzer_->Register();
+  hybrid_analyzer_ = new Hybrid;
+  hybrid_analyzer_->Register();
 }
 
 void Profiler::HandlePostSetup() {
@@ -39,8 +43,16 @@ void Profiler::HandlePostSetup() {
   race_db_ = new RaceDB(CreateMutex());
   race_db_->Load(knob_->ValueStr("race_in"), sinfo_);
 
+  // parallel runs saving deltas share the static info and statistics
+  // files. a delta refers to instructions by image name and offset, so
+  // the static info of this run need not be saved
+  read_only_ = knob_->ValueBool("race_delta");
+
   // add data race detector
-  if (djit_analyzer_->Enabled()) {
+  if (hybrid_analyzer_->Enabled()) {
+    hybrid_analyzer_->Setup(CreateMutex(), race_db_);
+    AddAnalyzer(hybrid_analyzer_);
+  } else if (djit_analyzer_->Enabled()) {
     djit_analyzer_->Setup(CreateMutex(), race_db_);
     AddAnalyzer(djit_analyzer_);
   }
@@ -68,7 +80,10 @@ void Profiler::HandleProgramExit() {
   ExecutionControl::HandleProgramExit();
 
   // save race db
-  race_db_->Save(knob_->ValueStr("race_out"), sinfo_);
+  if (knob_->ValueBool("race_delta"))
+    race_db_->SaveDelta(knob_->ValueStr("delta_path"), sinfo_);
+  else
+    race_db_->Save(knob_->ValueStr("race_out"), sinfo_);
 }
 
 } // namespace race
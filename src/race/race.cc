@@ -18,6 +18,13 @@
 
 #include "race/race.h"
 
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+
 #include "core/logging.h"
 
 namespace race {
@@ -97,6 +104,106 @@ bool RaceDB::RacyInst(Inst *inst, bool locking) {
   return racy_inst_set_.find(inst) != racy_inst_set_.end();
 }
 
+void RaceDB::Merge(RaceDB *other) {
+  ScopedLock locker(internal_lock_);
+
+  // merge static races (including those without dynamic instances)
+  for (StaticRace::Map::iterator it = other->static_race_table_.begin();
+       it != other->static_race_table_.end(); ++it) {
+    StaticRace *r = it->second;
+    DEBUG_ASSERT(r->event_vec_.size() == 2);
+    StaticRaceEvent *e0 = r->event_vec_[0];
+    StaticRaceEvent *e1 = r->event_vec_[1];
+    GetStaticRace(GetStaticRaceEvent(e0->inst_, e0->type_, false),
+                  GetStaticRaceEvent(e1->inst_, e1->type_, false),
+                  false);
+  }
+  // merge races, they belong to the current execution
+  for (Race::Vec::iterator it = other->race_vec_.begin();
+       it != other->race_vec_.end(); ++it) {
+    Race *r = *it;
+    DEBUG_ASSERT(r->event_vec_.size() == 2);
+    RaceEvent *e0 = r->event_vec_[0];
+    RaceEvent *e1 = r->event_vec_[1];
+    CreateRace(r->addr_, e0->thd_id_, e0->inst(), e0->type(),
+               e1->thd_id_, e1->inst(), e1->type(), false);
+  }
+  // merge racy insts
+  for (RacyInstSet::iterator it = other->racy_inst_set_.begin();
+       it != other->racy_inst_set_.end(); ++it) {
+    racy_inst_set_.insert(*it);
+  }
+}
+
+void RaceDB::MergeDelta(RaceDBProto *proto, StaticInfo *sinfo,
+                        bool locking) {
+  ScopedLock locker(internal_lock_, locking);
+
+  // resolve the instructions. a delta carries the image name and the
+  // offset of each instruction so that it does not depend on the inst
+  // ids of the static info it was recorded with. note that the static
+  // info is not protected by the internal lock.
+  std::map<inst_id_type, Inst *> inst_map;
+  for (int i = 0; i < proto->inst_size(); i++) {
+    RaceInstProto *inst_proto = proto->mutable_inst(i);
+    Image *image = sinfo->FindImage(inst_proto->image_name());
+    if (!image)
+      image = sinfo->CreateImage(inst_proto->image_name());
+    Inst *inst = image->Find(inst_proto->offset());
+    if (!inst)
+      inst = sinfo->CreateInst(image, inst_proto->offset());
+    inst_map[inst_proto->id()] = inst;
+  }
+  // merge static events
+  std::map<StaticRaceEvent::id_t, StaticRaceEvent *> event_map;
+  for (int i = 0; i < proto->static_event_size(); i++) {
+    StaticRaceEventProto *e_proto = proto->mutable_static_event(i);
+    Inst *inst = proto->inst_size() ? inst_map[e_proto->inst_id()]
+                                    : sinfo->FindInst(e_proto->inst_id());
+    DEBUG_ASSERT(inst);
+    event_map[e_proto->id()] = GetStaticRaceEvent(inst, e_proto->type(),
+                                                  false);
+  }
+  // merge static races
+  std::map<StaticRace::id_t, StaticRace *> race_map;
+  for (int i = 0; i < proto->static_race_size(); i++) {
+    StaticRaceProto *r_proto = proto->mutable_static_race(i);
+    DEBUG_ASSERT(r_proto->event_id_size() == 2);
+    StaticRaceEvent *e0 = event_map[r_proto->event_id(0)];
+    StaticRaceEvent *e1 = event_map[r_proto->event_id(1)];
+    DEBUG_ASSERT(e0 && e1);
+    race_map[r_proto->id()] = GetStaticRace(e0, e1, false);
+  }
+  // merge races, each execution in the delta gets a new execution id
+  std::map<int, int> exec_map;
+  for (int i = 0; i < proto->race_size(); i++) {
+    RaceProto *r_proto = proto->mutable_race(i);
+    Race *r = new Race;
+    if (exec_map.find(r_proto->exec_id()) == exec_map.end())
+      exec_map[r_proto->exec_id()] = curr_exec_id_++;
+    r->exec_id_ = exec_map[r_proto->exec_id()];
+    r->addr_ = r_proto->addr();
+    for (int j = 0; j < r_proto->event_size(); j++) {
+      RaceEventProto *e_proto = r_proto->mutable_event(j);
+      RaceEvent *e = new RaceEvent;
+      e->thd_id_ = e_proto->thd_id();
+      e->static_event_ = event_map[e_proto->static_id()];
+      DEBUG_ASSERT(e->static_event_);
+      r->event_vec_.push_back(e);
+    }
+    r->static_race_ = race_map[r_proto->static_id()];
+    DEBUG_ASSERT(r->static_race_);
+    race_vec_.push_back(r);
+  }
+  // merge racy insts
+  for (int i = 0; i < proto->racy_inst_id_size(); i++) {
+    Inst *inst = proto->inst_size() ? inst_map[proto->racy_inst_id(i)]
+                                    : sinfo->FindInst(proto->racy_inst_id(i));
+    DEBUG_ASSERT(inst);
+    racy_inst_set_.insert(inst);
+  }
+}
+
 void RaceDB::Load(const std::string &db_name, StaticInfo *sinfo) {
   RaceDBProto proto;
   // load from file
@@ -213,6 +320,90 @@ void RaceDB::Save(const std::string &db_name, StaticInfo *sinfo) {
   out.close();
 }
 
+void RaceDB::SaveDelta(const std::string &delta_path, StaticInfo *sinfo) {
+  RaceDBProto proto;
+  std::set<StaticRaceEvent *> event_set;
+  std::set<StaticRace *> static_race_set;
+  std::set<Inst *> inst_set;
+  // save the races of the current execution
+  for (Race::Vec::iterator it = race_vec_.begin();
+       it != race_vec_.end(); ++it) {
+    Race *r = *it;
+    if (r->exec_id_ != curr_exec_id_)
+      continue;
+    RaceProto *r_proto = proto.add_race();
+    r_proto->set_exec_id(r->exec_id_);
+    r_proto->set_addr(r->addr_);
+    for (RaceEvent::Vec::iterator eit = r->event_vec_.begin();
+         eit != r->event_vec_.end(); ++eit) {
+      RaceEvent *e = *eit;
+      RaceEventProto *e_proto = r_proto->add_event();
+      e_proto->set_thd_id(e->thd_id_);
+      e_proto->set_static_id(e->static_event_->id_);
+    }
+    r_proto->set_static_id(r->static_race_->id_);
+    static_race_set.insert(r->static_race_);
+  }
+  // save the static races referenced by the races
+  for (std::set<StaticRace *>::iterator it = static_race_set.begin();
+       it != static_race_set.end(); ++it) {
+    StaticRace *r = *it;
+    StaticRaceProto *r_proto = proto.add_static_race();
+    r_proto->set_id(r->id_);
+    for (StaticRaceEvent::Vec::iterator vit = r->event_vec_.begin();
+         vit != r->event_vec_.end(); ++vit) {
+      StaticRaceEvent *e = *vit;
+      r_proto->add_event_id(e->id_);
+      event_set.insert(e);
+    }
+  }
+  // save the static events referenced by the static races
+  for (std::set<StaticRaceEvent *>::iterator it = event_set.begin();
+       it != event_set.end(); ++it) {
+    StaticRaceEvent *e = *it;
+    StaticRaceEventProto *e_proto = proto.add_static_event();
+    e_proto->set_id(e->id_);
+    e_proto->set_inst_id(e->inst_->id());
+    e_proto->set_type(e->type_);
+    inst_set.insert(e->inst_);
+  }
+  // save racy insts
+  for (RacyInstSet::iterator it = racy_inst_set_.begin();
+       it != racy_inst_set_.end(); ++it) {
+    Inst *inst = *it;
+    proto.add_racy_inst_id(inst->id());
+    inst_set.insert(inst);
+  }
+  // save the referenced instructions
+  for (std::set<Inst *>::iterator it = inst_set.begin();
+       it != inst_set.end(); ++it) {
+    Inst *inst = *it;
+    RaceInstProto *inst_proto = proto.add_inst();
+    inst_proto->set_id(inst->id());
+    inst_proto->set_image_name(inst->image()->name());
+    inst_proto->set_offset(inst->offset());
+  }
+  // save to a file that no concurrent run can clash with. the name
+  // starts with the time so that the deltas sort in creation order,
+  // and the file is written under a dot name (skipped by race_merge)
+  // and renamed once it is complete.
+  int res = mkdir(delta_path.c_str(), 0755);
+  SANITY_ASSERT(res == 0 || errno == EEXIST);
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  char name[64];
+  snprintf(name, sizeof(name), "%010lu.%06lu.%d.db",
+           (unsigned long)tv.tv_sec, (unsigned long)tv.tv_usec, getpid());
+  std::string db_name = delta_path + "/" + name;
+  std::string tmp_name = delta_path + "/." + name;
+  std::fstream out(tmp_name.c_str(),
+                   std::ios::out | std::ios::trunc | std::ios::binary);
+  proto.SerializeToOstream(&out);
+  out.close();
+  res = rename(tmp_name.c_str(), db_name.c_str());
+  SANITY_ASSERT(res == 0);
+}
+
 // helper functions
 StaticRaceEvent *RaceDB::CreateStaticRaceEvent(Inst *inst,
                                                RaceEventType type,
@@ -20,6 +20,8 @@
 #ifndef RACE_RACE_H_
 #define RACE_RACE_H_
 
+#include <map>
+#include <set>
 #include <vector>
 #include <tr1/unordered_set>
 
@@ -142,8 +144,11 @@ class RaceDB {
                    thread_id_t t1, Inst *i1, RaceEventType p1, bool locking);
   void SetRacyInst(Inst *inst, bool locking);
   bool RacyInst(Inst *inst, bool locking);
+  void Merge(RaceDB *other);
+  void MergeDelta(RaceDBProto *proto, StaticInfo *sinfo, bool locking);
   void Load(const std::string &db_name, StaticInfo *sinfo);
   void Save(const std::string &db_name, StaticInfo *sinfo);
+  void SaveDelta(const std::string &delta_path, StaticInfo *sinfo);
 
  protected:
   typedef std::tr1::unordered_set<Inst *> RacyInstSet;
@@ -49,6 +49,7 @@ void SharedInstAnalyzer::Setup(Mutex *lock, SharedInstDB *sinst_db) {
   internal_lock_ = lock;
   sinst_db_ = sinst_db;
   unit_size_ = knob_->ValueInt("unit_size");
+  meta_table_.Setup(unit_size_);
   filter_ = new RegionFilter(internal_lock_->Clone());
   // set analyzer descriptor
   desc_.SetHookBeforeMem();
@@ -90,19 +91,24 @@ void SharedInstAnalyzer::BeforeMemRead(thread_id_t curr_thd_id,
   // normalize accesses
   address_t start_addr = UNIT_DOWN_ALIGN(addr, unit_size_);
   address_t end_addr = UNIT_UP_ALIGN(addr + size, unit_size_);
+  bool shared_read = false;
+  bool after_write = false;
   for (address_t iaddr = start_addr; iaddr < end_addr; iaddr += unit_size_) {
     // check shared for iaddr
-    Meta::Table::iterator mit = meta_table_.find(iaddr);
-    if (mit == meta_table_.end()) {
-      Meta &meta = meta_table_[iaddr];
-      meta.last_thd_id = curr_thd_id;
-      meta.inst_set.insert(inst);
+    Meta *mit = meta_table_.Find(iaddr);
+    if (!mit) {
+      Meta *meta = new Meta;
+      meta_table_.Insert(iaddr, meta);
+      meta->last_thd_id = curr_thd_id;
+      meta->inst_set.insert(inst);
     } else {
       // shared info exists
-      Meta &meta = mit->second;
+      Meta &meta = *mit;
       if (meta.shared) {
         // meta is shared
         sinst_db_->SetShared(inst);
+        shared_read = true;
+        after_write = after_write || meta.written;
       } else {
         // meta is not currently shared
         meta.inst_set.insert(inst);
@@ -121,8 +127,12 @@ void SharedInstAnalyzer::BeforeMemRead(thread_id_t curr_thd_id,
           }
         }
       } // end of else meta.shared
+      meta.written = false;
     } // end of else meta not exist
   } // end of for each iaddr
+  // record the read for the read-mostly check (one per access)
+  if (shared_read)
+    sinst_db_->AddSharedRead(inst, after_write);
 }
 
 void SharedInstAnalyzer::BeforeMemWrite(thread_id_t curr_thd_id,
@@ -136,15 +146,18 @@ void SharedInstAnalyzer::BeforeMemWrite(thread_id_t curr_thd_id,
   address_t end_addr = UNIT_UP_ALIGN(addr + size, unit_size_);
   for (address_t iaddr = start_addr; iaddr < end_addr; iaddr += unit_size_) {
     // check shared for iaddr
-    Meta::Table::iterator mit = meta_table_.find(iaddr);
-    if (mit == meta_table_.end()) {
-      Meta &meta = meta_table_[iaddr];
-      meta.has_write = true;
-      meta.last_thd_id = curr_thd_id;
-      meta.inst_set.insert(inst);
+    Meta *mit = meta_table_.Find(iaddr);
+    if (!mit) {
+      Meta *meta = new Meta;
+      meta_table_.Insert(iaddr, meta);
+      meta->has_write = true;
+      meta->written = true;
+      meta->last_thd_id = curr_thd_id;
+      meta->inst_set.insert(inst);
     } else {
       // shared info exists
-      Meta &meta = mit->second;
+      Meta &meta = *mit;
+      meta.written = true;
       if (meta.shared) {
         // meta is shared
         sinst_db_->SetShared(inst);
@@ -216,11 +229,11 @@ void SharedInstAnalyzer::FreeAddrRegion(address_t addr) {
   size_t size = filter_->RemoveRegion(addr, false);
   address_t start_addr = UNIT_DOWN_ALIGN(addr, unit_size_);
   address_t end_addr = UNIT_UP_ALIGN(addr + size, unit_size_);
-  for (address_t iaddr = start_addr; iaddr < end_addr; iaddr += unit_size_) {
-    Meta::Table::iterator it = meta_table_.find(iaddr);
-    if (it != meta_table_.end()) {
-      meta_table_.erase(it);
-    }
+  std::vector<Meta *> meta_vec;
+  meta_table_.RemoveRange(start_addr, end_addr, &meta_vec);
+  for (std::vector<Meta *>::iterator it = meta_vec.begin();
+       it != meta_vec.end(); ++it) {
+    delete *it;
   }
 }
 
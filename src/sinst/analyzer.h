@@ -27,6 +27,7 @@
 #include "core/analyzer.h"
 #include "core/sync.h"
 #include "core/filter.h"
+#include "core/shadow_map.h"
 #include "sinst/sinst.h"
 
 namespace sinst {
@@ -68,12 +69,13 @@ class SharedInstAnalyzer : public Analyzer {
   class Meta {
    public:
     typedef std::set<Inst *> InstSet;
-    typedef std::tr1::unordered_map<address_t, Meta> Table;
+    typedef ShadowMap<Meta> Table;
 
     Meta()
         : shared(false),
           has_write(false),
           multi_read(false),
+          written(false),
           last_thd_id(INVALID_THD_ID) {}
 
     ~Meta() {}
@@ -81,6 +83,7 @@ class SharedInstAnalyzer : public Analyzer {
     bool shared;
     bool has_write;
     bool multi_read;
+    bool written; // whether written since the last read
     thread_id_t last_thd_id;
     InstSet inst_set;
   };
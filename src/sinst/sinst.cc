@@ -27,8 +27,8 @@ namespace sinst {
 bool SharedInstDB::Shared(Inst *inst, bool locking) {
   ScopedLock locker(internal_lock_, locking);
 
-  SharedInstSet::iterator it = shared_inst_set_.find(inst);
-  if (it == shared_inst_set_.end())
+  SharedInstMap::iterator it = shared_inst_map_.find(inst);
+  if (it == shared_inst_map_.end())
     return false;
   else
     return true;
@@ -37,24 +37,48 @@ bool SharedInstDB::Shared(Inst *inst, bool locking) {
 void SharedInstDB::SetShared(Inst *inst, bool locking) {
   ScopedLock locker(internal_lock_, locking);
 
-  SharedInstSet::iterator it = shared_inst_set_.find(inst);
-  if (it == shared_inst_set_.end()) {
-    shared_inst_set_.insert(inst);
+  SharedInstMap::iterator it = shared_inst_map_.find(inst);
+  if (it == shared_inst_map_.end()) {
     SharedInstProto *proto = table_proto_.add_shared_inst();
     proto->set_inst_id(inst->id());
+    shared_inst_map_[inst] = proto;
   }
 }
 
+void SharedInstDB::AddSharedRead(Inst *inst, bool after_write, bool locking) {
+  ScopedLock locker(internal_lock_, locking);
+
+  SharedInstMap::iterator it = shared_inst_map_.find(inst);
+  DEBUG_ASSERT(it != shared_inst_map_.end());
+  SharedInstProto *proto = it->second;
+  proto->set_num_reads(proto->num_reads() + 1);
+  if (after_write)
+    proto->set_num_reads_after_write(proto->num_reads_after_write() + 1);
+}
+
+bool SharedInstDB::ReadMostly(Inst *inst, int ratio, bool locking) {
+  ScopedLock locker(internal_lock_, locking);
+
+  // no evidence if the reads are never profiled
+  SharedInstMap::iterator it = shared_inst_map_.find(inst);
+  if (it == shared_inst_map_.end() || ratio <= 0)
+    return false;
+  SharedInstProto *proto = it->second;
+  if (!proto->num_reads())
+    return false;
+  return proto->num_reads_after_write() * ratio <= proto->num_reads();
+}
+
 void SharedInstDB::Load(const std::string &db_name, StaticInfo *sinfo) {
   std::fstream in(db_name.c_str(), std::ios::in | std::ios::binary);
   table_proto_.ParseFromIstream(&in);
   in.close();
-  // setup shared inst set
+  // setup shared inst map
   for (int i = 0; i < table_proto_.shared_inst_size(); i++) {
-    const SharedInstProto &proto = table_proto_.shared_inst(i);
-    Inst *inst = sinfo->FindInst(proto.inst_id());
+    SharedInstProto *proto = table_proto_.mutable_shared_inst(i);
+    Inst *inst = sinfo->FindInst(proto->inst_id());
     DEBUG_ASSERT(inst);
-    shared_inst_set_.insert(inst);
+    shared_inst_map_[inst] = proto;
   }
 }
 
@@ -19,7 +19,7 @@
 #ifndef SINST_SINST_H_
 #define SINST_SINST_H_
 
-#include <tr1/unordered_set>
+#include <tr1/unordered_map>
 
 #include "core/basictypes.h"
 #include "core/sync.h"
@@ -36,16 +36,25 @@ class SharedInstDB {
 
   bool Shared(Inst *inst) { return Shared(inst, true); }
   void SetShared(Inst *inst) { SetShared(inst, true); }
+  void AddSharedRead(Inst *inst, bool after_write) {
+    AddSharedRead(inst, after_write, true);
+  }
   bool Shared(Inst *inst, bool locking);
   void SetShared(Inst *inst, bool locking);
+  // record a read of shared data by a shared inst, after_write is true
+  // if the data is written since it was last read
+  void AddSharedRead(Inst *inst, bool after_write, bool locking);
+  // return whether the shared read inst reads read-mostly data, i.e.
+  // at most 1/ratio of its reads follow a write
+  bool ReadMostly(Inst *inst, int ratio, bool locking);
   void Load(const std::string &db_name, StaticInfo *sinfo);
   void Save(const std::string &db_name, StaticInfo *sinfo);
 
  private:
-  typedef std::tr1::unordered_set<Inst *> SharedInstSet;
+  typedef std::tr1::unordered_map<Inst *, SharedInstProto *> SharedInstMap;
 
   Mutex *internal_lock_;
-  SharedInstSet shared_inst_set_;
+  SharedInstMap shared_inst_map_;
   SharedInstTableProto table_proto_;
 
   DISALLOW_COPY_CONSTRUCTORS(SharedInstDB);
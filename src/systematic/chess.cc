@@ -21,6 +21,7 @@
 #include "systematic/chess.h"
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <sstream>
 #include "core/logging.h"
 
@@ -30,6 +31,8 @@ ChessScheduler::ChessScheduler(ControllerInterface *controller)
     : Scheduler(controller),
       pb_enable_(false),
       por_enable_(false),
+      dpor_enable_(false),
+      por_verify_(false),
       pb_limit_(0),
       useless_(false),
       divergence_(false),
@@ -38,7 +41,8 @@ ChessScheduler::ChessScheduler(ControllerInterface *controller)
       curr_node_(NULL),
       prefix_size_(0),
       curr_preemptions_(0),
-      curr_hash_val_(0),
+      curr_hash_val_(),
+      por_store_(NULL),
       curr_exec_id_(0) {
   // empty
 }
@@ -52,6 +56,8 @@ void ChessScheduler::Register() {
   knob()->RegisterBool("fair", "whether enable the fair control module", "1");
   knob()->RegisterBool("pb", "whether enable preemption bound search", "1");
   knob()->RegisterBool("por", "whether enable parital order reduction", "1");
+  knob()->RegisterBool("dpor", "whether enable dynamic partial order reduction", "0");
+  knob()->RegisterBool("por_verify", "whether verify state hash hits by matching the past executions", "0");
   knob()->RegisterBool("abort_diverge", "whether abort when divergence happens", "1");
   knob()->RegisterInt("pb_limit", "the maximum number of preemption an execution can have", "2");
   knob()->RegisterStr("search_in", "the input file that contains the search information", "search.db");
@@ -68,6 +74,8 @@ void ChessScheduler::Setup() {
   fair_enable_ = knob()->ValueBool("fair");
   pb_enable_ = knob()->ValueBool("pb");
   por_enable_ = knob()->ValueBool("por");
+  dpor_enable_ = knob()->ValueBool("dpor");
+  por_verify_ = knob()->ValueBool("por_verify");
   pb_limit_ = knob()->ValueInt("pb_limit");
   por_info_path_ = knob()->ValueStr("por_info_path");
 
@@ -93,6 +101,8 @@ void ChessScheduler::ProgramStart() {
     PbInit();
   if (por_enable_)
     PorInit();
+  if (dpor_enable_)
+    DporInit();
 }
 
 void ChessScheduler::ProgramExit() {
@@ -109,6 +119,17 @@ void ChessScheduler::ProgramExit() {
   }
 }
 
+void ChessScheduler::Reload() {
+  // load the search info saved by the previous execution
+  search_info_.Load(knob()->ValueStr("search_out"), sinfo(), program());
+  prefix_size_ = search_info_.StackSize();
+  DEBUG_FMT_PRINT_SAFE("prefix size = %d\n", (int)prefix_size_);
+}
+
+bool ChessScheduler::Done() {
+  return search_info_.Done();
+}
+
 void ChessScheduler::Explore(State *init_state) {
   // start with the initial state
   curr_state_ = init_state;
@@ -138,8 +159,14 @@ void ChessScheduler::Explore(State *init_state) {
     }
     // update search node
     curr_node_->set_sel(next_action->thd());
-    if (!IsPrefix())
+    if (!IsPrefix()) {
       curr_node_->AddDone(next_action->thd());
+      curr_node_->AddExplored(next_action->thd());
+      // with dpor, the backtrack set of a new node only contains
+      // the selected thread initially
+      if (dpor_enable_)
+        curr_node_->AddBacktrack(next_action->thd());
+    }
     DEBUG_FMT_PRINT_SAFE("Schedule Point: %s\n",
                          curr_node_->ToString().c_str());
     // execute the action and move to next state
@@ -147,6 +174,8 @@ void ChessScheduler::Explore(State *init_state) {
       PbUpdate(next_action);
     if (por_enable_)
       PorUpdate(next_action);
+    if (dpor_enable_)
+      DporUpdate(next_action);
     curr_action_ = next_action;
     curr_state_ = Execute(curr_state_, next_action);
   }
@@ -224,6 +253,13 @@ Action *ChessScheduler::PickNext() {
           curr_node_->AddDone(action->thd());
         }
       }
+      // 4) check sleep set (if dpor is enabled)
+      if (dpor_enable_) {
+        if (DporSleeping(action)) {
+          DEBUG_FMT_PRINT_SAFE("Sleep set pruned\n");
+          curr_node_->AddDone(action->thd());
+        }
+      }
     }
   }
   // second pass, find an undone enabled action
@@ -233,6 +269,11 @@ Action *ChessScheduler::PickNext() {
   for (Action::Map::iterator it = curr_state_->enabled()->begin();
        it != curr_state_->enabled()->end(); ++it) {
     Action *action = it->second;
+    // with dpor, only the threads in the backtrack set need to be
+    // explored at the frontier
+    if (dpor_enable_ && IsFrontier() &&
+        !curr_node_->IsBacktrack(action->thd()))
+      continue;
     if (!curr_node_->IsDone(action->thd())) {
       // action is not done
       if (!next_action) {
@@ -282,6 +323,13 @@ bool ChessScheduler::IsPrefix() {
 }
 
 void ChessScheduler::UpdateBacktrack() {
+  // with dpor, backtrack points are only added where conflicting
+  // actions could be reordered
+  if (dpor_enable_) {
+    DporBacktrack();
+    return;
+  }
+
   for (Action::Map::iterator it = curr_state_->enabled()->begin();
        it != curr_state_->enabled()->end(); ++it) {
     Action *action = it->second;
@@ -297,16 +345,40 @@ bool ChessScheduler::RandomChoice(double true_rate) {
     return false;
 }
 
-ChessScheduler::hash_val_t ChessScheduler::Hash(Action *action) {
+// the splitmix64 finalizer, used to derive zobrist keys
+static uint64 HashMix(uint64 x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+ChessScheduler::StateHash ChessScheduler::Hash(Action *action) {
   DEBUG_ASSERT(action->obj() && action->inst());
-  hash_val_t hash_val = 0;
-  hash_val += (hash_val_t)action->thd()->uid();
-  hash_val += (hash_val_t)(action->obj()->uid() << 2);
-  hash_val += (hash_val_t)(action->op() << 5);
-  hash_val += (hash_val_t)(action->inst()->id() << 7);
-  hash_val += (hash_val_t)(action->tc() << 13);
-  hash_val += (hash_val_t)(action->oc() << 23);
-  return hash_val;
+  ActionRecord record;
+  PorStore::Encode(action, &record);
+  return Hash(record);
+}
+
+ChessScheduler::StateHash ChessScheduler::Hash(const ActionRecord &record) {
+  // the zobrist key of an action is a pseudo random function of
+  // (thread, object, op, inst, tc, oc). the two halves are chained
+  // from different seeds so that they are independent
+  uint64 fields[] = {
+    (uint64)record.thd_uid,
+    (uint64)record.obj_uid,
+    (uint64)record.op,
+    (uint64)record.inst_id,
+    (uint64)record.tc,
+    (uint64)record.oc
+  };
+  uint64 lo = 0;
+  uint64 hi = 0x5bd1e9955bd1e995ULL;
+  for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+    lo = HashMix(lo ^ fields[i]);
+    hi = HashMix(hi ^ fields[i]);
+  }
+  return StateHash(lo, hi);
 }
 
 // fair related
@@ -351,7 +423,7 @@ bool ChessScheduler::PbEnabled(Action *next_action) {
 // partial order reduction related functions
 void ChessScheduler::PorInit() {
   DEBUG_ASSERT(por_enable_);
-  curr_hash_val_ = 0;
+  curr_hash_val_ = StateHash();
   PorLoad();
 }
 
@@ -359,6 +431,7 @@ void ChessScheduler::PorFini() {
   DEBUG_ASSERT(por_enable_);
   if (!divergence_ && !useless_)
     PorSave();
+  por_store_->Close();
 }
 
 void ChessScheduler::PorUpdate(Action *next_action) {
@@ -368,7 +441,7 @@ void ChessScheduler::PorUpdate(Action *next_action) {
   if (!next_action->obj())
     return;
 
-  curr_hash_val_ = HashJoin(curr_hash_val_, Hash(next_action));
+  curr_hash_val_.Join(Hash(next_action));
   // update visited states
   VisitedState *vs = new VisitedState;
   vs->hash_val = curr_hash_val_;
@@ -387,103 +460,97 @@ bool ChessScheduler::PorVisited(Action *next_action) {
 
   // check whether the state to which the next_action will
   // lead is visted or not
-  hash_val_t new_hash_val = HashJoin(curr_hash_val_, Hash(next_action));
+  StateHash new_hash_val = curr_hash_val_;
+  new_hash_val.Join(Hash(next_action));
   int new_preemptions = curr_preemptions_;
   if (IsPreemptiveChoice(next_action))
     new_preemptions += 1;
   VisitedState::HashMap::iterator hit = visited_states_.find(new_hash_val);
-  if (hit != visited_states_.end()) {
-    for (VisitedState::Vec::iterator vit = hit->second.begin();
-         vit != hit->second.end(); ++vit) {
-      VisitedState *vs = *vit;
-      Execution *vs_exec = PorGetExec(vs->exec_id);
-      State *vs_state = vs_exec->FindState(vs->state_idx);
-      DEBUG_ASSERT(vs_state);
-      DEBUG_FMT_PRINT_SAFE("matching hash found, val = 0x%lx\n", new_hash_val);
-      DEBUG_FMT_PRINT_SAFE("   preemption = %d, exec_id = %d, state_idx = %d\n",
-                           vs->preemptions, vs->exec_id, (int)vs->state_idx);
-      if (vs->preemptions <= new_preemptions &&
-          PorStateMatch(curr_state_, next_action, vs_state)) {
-        return true;
-      }
-    }
+  if (hit == visited_states_.end())
+    return false;
+
+  VisitedState *vs = hit->second;
+  DEBUG_FMT_PRINT_SAFE("matching hash found, val = 0x%016lx%016lx\n",
+                       (unsigned long)new_hash_val.hi,
+                       (unsigned long)new_hash_val.lo);
+  DEBUG_FMT_PRINT_SAFE("   preemption = %d, exec_id = %d, state_idx = %d\n",
+                       vs->preemptions, vs->exec_id, (int)vs->state_idx);
+  if (vs->preemptions > new_preemptions)
+    return false;
+  // the expensive execution matching is only performed on request
+  if (por_verify_ && !PorStateMatch(curr_state_, next_action, vs)) {
+    printf("[CHESS] state hash collision\n");
+    return false;
   }
-  return false;
+  return true;
+}
+
+static bool ActionRecordLess(const ActionRecord *r1, const ActionRecord *r2) {
+  if (r1->thd_uid != r2->thd_uid)
+    return r1->thd_uid < r2->thd_uid;
+  return r1->tc < r2->tc;
 }
 
 bool ChessScheduler::PorStateMatch(State *state,
                                    Action *action,
-                                   State *vs_state) {
-  DEBUG_ASSERT(state->exec() != vs_state->exec());
-  // check whether there will is an one-on-one mapping
-  // between actions in the two executions
-
-  // 1) get all actions before vs_state in vs_exec
-  ActionHashMap vs_action_hash_table;
-  for (State *s = vs_state->Prev(); s; s = s->Prev()) {
-    Action *a = s->taken();
+                                   VisitedState *vs) {
+  // check whether there will is an one-on-one mapping between
+  // actions in the two executions. an action is identified by its
+  // thread and its tc in an execution
+
+  // 1) get all actions before the visited state, which are read in
+  // place from the por store
+  const ActionRecord *begin = NULL;
+  const ActionRecord *end = NULL;
+  if (!por_store_->FindActions(vs->exec_id, vs->state_idx, &begin, &end)) {
+    DEBUG_FMT_PRINT_SAFE("   vs exec not found\n");
+    return false;
+  }
+  por_match_vec_.clear();
+  for (const ActionRecord *r = begin; r != end; ++r) {
     // skip transparent actions
-    if (!a->obj())
+    if (!(r->flags & ActionRecord::HAS_OBJ))
       continue;
-    vs_action_hash_table[Hash(a)].push_back(a);
+    por_match_vec_.push_back(r);
   }
+  std::sort(por_match_vec_.begin(), por_match_vec_.end(), ActionRecordLess);
 
   // 2) check with all actions in exec
+  size_t num_actions = 0;
   for (State *s = state; s; s = s->Prev()) {
     Action *a = (s == state ? action : s->taken());
     // skip transparent actions
     if (!a->obj())
       continue;
-    ActionHashMap::iterator hit = vs_action_hash_table.find(Hash(a));
-    if (hit == vs_action_hash_table.end()) {
-      DEBUG_FMT_PRINT_SAFE("   vs hash not found\n");
+    num_actions++;
+    ActionRecord record;
+    PorStore::Encode(a, &record);
+    std::vector<const ActionRecord *>::iterator it
+        = std::lower_bound(por_match_vec_.begin(), por_match_vec_.end(),
+                           &record, ActionRecordLess);
+    if (it == por_match_vec_.end() || !PorStore::Equal(**it, record)) {
+      DEBUG_FMT_PRINT_SAFE("   vs match not found\n");
       DEBUG_FMT_PRINT_SAFE("   %s\n", a->ToString().c_str());
       return false;
-    } else {
-      bool found = false;
-      for (Action::List::iterator lit = hit->second.begin();
-           lit != hit->second.end(); ++lit) {
-        Action *vs_a = *lit;
-        if (a->thd() == vs_a->thd() &&
-            a->obj() == vs_a->obj() &&
-            a->op() == vs_a->op() &&
-            a->inst() == vs_a->inst() &&
-            a->tc() == vs_a->tc() &&
-            a->oc() == vs_a->oc()) {
-          hit->second.erase(lit);
-          found = true;
-          break;
-        }
-      }
-      if (!found) {
-        DEBUG_FMT_PRINT_SAFE("   vs match not found\n");
-        return false;
-      }
     }
   }
   // two states match when reach here
-  return true;
+  return num_actions == por_match_vec_.size();
 }
 
-Execution *ChessScheduler::PorGetExec(int exec_id) {
-  DEBUG_ASSERT(por_enable_);
-
-  // check whether the execution is loaded or not
-  // if not, load it from file
-  ExecutionTable::iterator it = loaded_execs_.find(exec_id);
-  if (it == loaded_execs_.end()) {
-    DEBUG_FMT_PRINT_SAFE("loading execution %d\n", exec_id);
-    // prepare the directory for por
-    PorPrepareDir();
-    // load execution from file
-    std::stringstream exec_path_ss;
-    exec_path_ss << por_info_path_ << '/' << std::dec << exec_id;
-    Execution *exec = new Execution;
-    exec->Load(exec_path_ss.str().c_str(), sinfo(), program());
-    loaded_execs_[exec_id] = exec;
-    return exec;
+bool ChessScheduler::PorAddVisited(VisitedState *vs) {
+  // keep the one with the fewest preemptions
+  VisitedState::HashMap::iterator hit = visited_states_.find(vs->hash_val);
+  if (hit == visited_states_.end()) {
+    visited_states_[vs->hash_val] = vs;
+    return true;
+  } else if (vs->preemptions < hit->second->preemptions) {
+    delete hit->second;
+    hit->second = vs;
+    return true;
   } else {
-    return it->second;
+    delete vs;
+    return false;
   }
 }
 
@@ -493,69 +560,42 @@ void ChessScheduler::PorLoad() {
   // prepare the directory for por
   PorPrepareDir();
 
-  // load info from file
-  ChessPorProto info_proto;
-  std::stringstream por_info_path_ss;
-  por_info_path_ss << por_info_path_ << "/info";
-  std::fstream in(por_info_path_ss.str().c_str(),
-                  std::ios::in | std::ios::binary);
-  if (in.is_open())
-    info_proto.ParseFromIstream(&in);
-  in.close();
-  curr_exec_id_ = info_proto.num_execs() + 1; // initially is zero
-  for (int i = 0; i < info_proto.visited_state_size(); i++) {
-    ChessPorProto::VisitedStateProto *proto
-        = info_proto.mutable_visited_state(i);
+  // map the past executions and load the visited states
+  if (!por_store_)
+    por_store_ = new PorStore(por_info_path_);
+  por_store_->Open();
+  curr_exec_id_ = por_store_->num_execs() + 1; // exec ids start from 1
+  for (size_t i = 0; i < por_store_->num_visited(); i++) {
+    const VisitedRecord *record = por_store_->visited(i);
     VisitedState *vs = new VisitedState;
-    vs->hash_val = proto->hash_val();
-    vs->preemptions = proto->preemptions();
-    vs->exec_id = proto->exec_id();
-    vs->state_idx = proto->state_idx();
-    visited_states_[vs->hash_val].push_back(vs);
+    vs->hash_val = StateHash(record->hash_lo, record->hash_hi);
+    vs->preemptions = record->preemptions;
+    vs->exec_id = record->exec_id;
+    vs->state_idx = record->state_idx;
+    PorAddVisited(vs);
   }
 }
 
 void ChessScheduler::PorSave() {
   DEBUG_ASSERT(por_enable_);
 
-  // prepare the directory for por
-  PorPrepareDir();
-
-  // save info to file
-  ChessPorProto info_proto;
-  std::stringstream por_info_path_ss;
-  por_info_path_ss << por_info_path_ << "/info";
-  info_proto.set_num_execs(curr_exec_id_);
-  for (VisitedState::HashMap::iterator hit = visited_states_.begin();
-       hit != visited_states_.end(); ++hit) {
-    for (VisitedState::Vec::iterator vit = hit->second.begin();
-         vit != hit->second.end(); ++vit) {
-      VisitedState *vs = *vit;
-      ChessPorProto::VisitedStateProto *proto = info_proto.add_visited_state();
-      proto->set_hash_val(vs->hash_val);
-      proto->set_preemptions(vs->preemptions);
-      proto->set_exec_id(vs->exec_id);
-      proto->set_state_idx(vs->state_idx);
-    }
-  }
+  // append the current execution, then the states visited in it
+  // that are new or reached with fewer preemptions
+  por_store_->AppendExec(execution());
+  DEBUG_ASSERT(por_store_->num_execs() == (size_t)curr_exec_id_);
   for (VisitedState::Vec::iterator vit = curr_visited_states_.begin();
        vit != curr_visited_states_.end(); ++vit) {
     VisitedState *vs = *vit;
-    ChessPorProto::VisitedStateProto *proto = info_proto.add_visited_state();
-    proto->set_hash_val(vs->hash_val);
-    proto->set_preemptions(vs->preemptions);
-    proto->set_exec_id(vs->exec_id);
-    proto->set_state_idx(vs->state_idx);
+    VisitedRecord record;
+    record.hash_lo = vs->hash_val.lo;
+    record.hash_hi = vs->hash_val.hi;
+    record.preemptions = vs->preemptions;
+    record.exec_id = vs->exec_id;
+    record.state_idx = vs->state_idx;
+    if (PorAddVisited(vs))
+      por_store_->AppendVisited(record);
   }
-  std::fstream out(por_info_path_ss.str().c_str(),
-                   std::ios::out | std::ios::trunc | std::ios::binary);
-  info_proto.SerializeToOstream(&out);
-  out.close();
-
-  // save the current execution to file
-  std::stringstream exec_path_ss;
-  exec_path_ss << por_info_path_ << '/' << std::dec << curr_exec_id_;
-  execution()->Save(exec_path_ss.str().c_str(), sinfo(), program());
+  curr_visited_states_.clear();
 }
 
 void ChessScheduler::PorPrepareDir() {
@@ -570,5 +610,172 @@ void ChessScheduler::PorPrepareDir() {
   }
 }
 
+// dynamic partial order reduction related functions
+void ChessScheduler::DporInit() {
+  DEBUG_ASSERT(dpor_enable_);
+  dpor_steps_.clear();
+  dpor_step_clocks_.clear();
+  dpor_thd_clocks_.clear();
+  dpor_obj_steps_.clear();
+  dpor_sleep_set_.clear();
+}
+
+void ChessScheduler::DporUpdate(Action *next_action) {
+  DEBUG_ASSERT(dpor_enable_);
+
+  // update the sleep set for the next state
+  DporUpdateSleep(next_action);
+
+  // compute the vector clock of the step. it happens after the
+  // previous step of the same thread and the previous dependent steps
+  // on the same object. it is sufficient to join the last write and
+  // the reads after it as their clocks include the earlier ones
+  size_t step = dpor_steps_.size();
+  DporClock clock = dpor_thd_clocks_[next_action->thd()];
+  if (next_action->obj()) {
+    std::vector<size_t> &obj_steps = dpor_obj_steps_[next_action->obj()];
+    for (std::vector<size_t>::reverse_iterator it = obj_steps.rbegin();
+         it != obj_steps.rend(); ++it) {
+      Action *action = dpor_steps_[*it];
+      if (!DporDependent(action, next_action))
+        continue;
+      DporClock &step_clock = dpor_step_clocks_[*it];
+      for (DporClock::iterator cit = step_clock.begin();
+           cit != step_clock.end(); ++cit) {
+        if (clock[cit->first] < cit->second)
+          clock[cit->first] = cit->second;
+      }
+      if (action->IsWrite())
+        break;
+    }
+    obj_steps.push_back(step);
+  }
+  clock[next_action->thd()] = step + 1;
+  dpor_thd_clocks_[next_action->thd()] = clock;
+  dpor_steps_.push_back(next_action);
+  dpor_step_clocks_.push_back(clock);
+}
+
+void ChessScheduler::DporBacktrack() {
+  DEBUG_ASSERT(dpor_enable_);
+
+  // for each enabled action, find the last step that is dependent
+  // with it and does not happen before it. the two could be reordered
+  // by scheduling the thread before that step
+  for (Action::Map::iterator it = curr_state_->enabled()->begin();
+       it != curr_state_->enabled()->end(); ++it) {
+    Action *action = it->second;
+    // skip transparent actions
+    if (!action->obj())
+      continue;
+    DporObjectMap::iterator oit = dpor_obj_steps_.find(action->obj());
+    if (oit == dpor_obj_steps_.end())
+      continue;
+    std::vector<size_t> &obj_steps = oit->second;
+    for (std::vector<size_t>::reverse_iterator sit = obj_steps.rbegin();
+         sit != obj_steps.rend(); ++sit) {
+      Action *step_action = dpor_steps_[*sit];
+      if (!DporDependent(step_action, action))
+        continue;
+      if (!DporHappensBefore(*sit, action->thd())) {
+        DporAddBacktrack(*sit, action->thd());
+        break;
+      }
+      // all the previous dependent steps happen before a write
+      if (step_action->IsWrite())
+        break;
+    }
+  }
+}
+
+void ChessScheduler::DporAddBacktrack(size_t step, Thread *thd) {
+  DEBUG_ASSERT(dpor_enable_);
+
+  // add the thread to the backtrack set of the state from which the
+  // step is taken. if the thread is not enabled there, add all the
+  // enabled threads instead. with preemption bound, the thread is also
+  // added at the beginning of the run of the thread that takes the step
+  // so that the reordering can be reached without a preemption
+  // (bounded partial order reduction)
+  std::vector<size_t> steps;
+  steps.push_back(step);
+  if (pb_enable_) {
+    size_t start = step;
+    while (start > 0 &&
+           dpor_steps_[start - 1]->thd() == dpor_steps_[step]->thd())
+      start--;
+    if (start != step)
+      steps.push_back(start);
+  }
+  for (std::vector<size_t>::iterator it = steps.begin();
+       it != steps.end(); ++it) {
+    State *state = execution()->FindState(*it);
+    SearchNode *node = search_info_.FindNode(*it);
+    DEBUG_ASSERT(state && node);
+    if (state->IsEnabled(thd)) {
+      node->AddBacktrack(thd);
+    } else {
+      for (Action::Map::iterator eit = state->enabled()->begin();
+           eit != state->enabled()->end(); ++eit) {
+        node->AddBacktrack(eit->first);
+      }
+    }
+  }
+}
+
+void ChessScheduler::DporUpdateSleep(Action *next_action) {
+  DEBUG_ASSERT(dpor_enable_);
+
+  // sleep sets are not used with preemption bound because a state
+  // covered by a sibling subtree might have been reached with a
+  // different number of preemptions
+  if (pb_enable_)
+    return;
+
+  // a thread sleeps in the next state if it sleeps in the current
+  // state or has been explored from the current state before, and its
+  // action is independent with the next action
+  Action::Map sleep_set;
+  for (Action::Map::iterator it = dpor_sleep_set_.begin();
+       it != dpor_sleep_set_.end(); ++it) {
+    if (!DporDependent(it->second, next_action))
+      sleep_set[it->first] = it->second;
+  }
+  for (Thread::Set::iterator it = curr_node_->explored()->begin();
+       it != curr_node_->explored()->end(); ++it) {
+    Action *action = curr_state_->FindEnabled(*it);
+    if (!action || action->thd() == next_action->thd())
+      continue;
+    if (!DporDependent(action, next_action))
+      sleep_set[action->thd()] = action;
+  }
+  dpor_sleep_set_ = sleep_set;
+}
+
+bool ChessScheduler::DporSleeping(Action *action) {
+  DEBUG_ASSERT(dpor_enable_);
+  return dpor_sleep_set_.find(action->thd()) != dpor_sleep_set_.end();
+}
+
+bool ChessScheduler::DporDependent(Action *a1, Action *a2) {
+  // actions of the same thread are always dependent, and actions on
+  // the same object are dependent unless both of them are reads
+  if (a1->thd() == a2->thd())
+    return true;
+  if (!a1->obj() || a1->obj() != a2->obj())
+    return false;
+  return a1->IsWrite() || a2->IsWrite();
+}
+
+bool ChessScheduler::DporHappensBefore(size_t step, Thread *thd) {
+  std::map<Thread *, DporClock>::iterator it = dpor_thd_clocks_.find(thd);
+  if (it == dpor_thd_clocks_.end())
+    return false;
+  DporClock::iterator cit = it->second.find(dpor_steps_[step]->thd());
+  if (cit == it->second.end())
+    return false;
+  return step + 1 <= cit->second;
+}
+
 } // namespace systematic
 
@@ -25,7 +25,7 @@
 #include "systematic/scheduler.h"
 #include "systematic/search.h"
 #include "systematic/fair.h"
-#include "systematic/chess.pb.h"
+#include "systematic/por_store.h"
 
 namespace systematic {
 
@@ -42,36 +42,59 @@ class ChessScheduler : public Scheduler {
   void ProgramStart();
   void ProgramExit();
   void Explore(State *init_state);
+  void Reload();
+  bool Done();
 
  protected:
-  // define the hash value type (used for partial order reduction)
-  typedef size_t hash_val_t;
+  // define the hash value type (used for partial order reduction).
+  // the hash of a state is the xor of the zobrist keys of all the
+  // non-transparent actions leading to it, so that it can be updated
+  // incrementally and does not depend on the order of the actions.
+  // 128 bits make collisions negligible, thus a hash hit is taken as
+  // a state match unless por_verify is set
+  class StateHash {
+   public:
+    StateHash() : lo(0), hi(0) {}
+    StateHash(uint64 l, uint64 h) : lo(l), hi(h) {}
+    ~StateHash() {}
+
+    void Join(const StateHash &h) { lo ^= h.lo; hi ^= h.hi; }
+    bool operator==(const StateHash &h) const {
+      return lo == h.lo && hi == h.hi;
+    }
+
+    uint64 lo;
+    uint64 hi;
+  };
 
-  // define hash map for actions
-  typedef std::tr1::unordered_map<hash_val_t, Action::List> ActionHashMap;
+  struct StateHashHasher {
+    size_t operator()(const StateHash &h) const { return (size_t)h.lo; }
+  };
+
+  // define the vector clock used by dpor. the clock of a thread is
+  // the idx (starting from 1) of the last step it knows
+  typedef std::map<Thread *, size_t> DporClock;
 
-  // define the table for past executions. this is only useful
-  // when performing partial order reduction. the reason we have
-  // that is because we need to know whether two states match by
-  // checking with past executions. the loading of past executions
-  // can be lazy (demand driven)
-  typedef std::tr1::unordered_map<int, Execution *> ExecutionTable;
+  // define the steps that access each object (used by dpor)
+  typedef std::tr1::unordered_map<Object *, std::vector<size_t> > DporObjectMap;
 
-  // define a visited state (used for partial order reduction)
+  // define a visited state (used for partial order reduction). only
+  // the one with the fewest preemptions is kept for each hash value
   class VisitedState {
    public:
     typedef std::vector<VisitedState *> Vec;
-    typedef std::tr1::unordered_map<hash_val_t, Vec> HashMap;
+    typedef std::tr1::unordered_map<StateHash, VisitedState *,
+                                    StateHashHasher> HashMap;
 
     VisitedState()
-        : hash_val(0),
+        : hash_val(),
           preemptions(0),
           exec_id(0),
           state_idx(0) {}
 
     ~VisitedState() {}
 
-    hash_val_t hash_val;
+    StateHash hash_val;
     int preemptions;
     int exec_id;
     size_t state_idx;
@@ -87,8 +110,8 @@ class ChessScheduler : public Scheduler {
   bool IsPreemptiveChoice(Action *action);
   void UpdateBacktrack();
   bool RandomChoice(double true_rate);
-  hash_val_t Hash(Action *action);
-  hash_val_t HashJoin(hash_val_t h1, hash_val_t h2) { return h1 ^ h2; }
+  StateHash Hash(Action *action);
+  StateHash Hash(const ActionRecord &record);
 
   // fair related
   void FairUpdate();
@@ -105,16 +128,28 @@ class ChessScheduler : public Scheduler {
   void PorFini();
   void PorUpdate(Action *next_action);
   bool PorVisited(Action *next_action);
-  bool PorStateMatch(State *state, Action *action, State *vs_state);
-  Execution *PorGetExec(int exec_id);
+  bool PorStateMatch(State *state, Action *action, VisitedState *vs);
+  bool PorAddVisited(VisitedState *vs);
   void PorLoad();
   void PorSave();
   void PorPrepareDir();
 
+  // dynamic partial order reduction related
+  void DporInit();
+  void DporUpdate(Action *next_action);
+  void DporBacktrack();
+  void DporAddBacktrack(size_t step, Thread *thd);
+  void DporUpdateSleep(Action *next_action);
+  bool DporSleeping(Action *action);
+  bool DporDependent(Action *a1, Action *a2);
+  bool DporHappensBefore(size_t step, Thread *thd);
+
   // settings and flags
   bool fair_enable_; // whether use the fair control module
   bool pb_enable_; // whether bound the number of preemptions
   bool por_enable_; // whether perform sleep-set based por
+  bool dpor_enable_; // whether perform dynamic partial order reduction
+  bool por_verify_; // whether verify hash hits by matching executions
   int pb_limit_; // the bound of the number of preemptions
   std::string por_info_path_; // the dir storing por information
 
@@ -134,12 +169,20 @@ class ChessScheduler : public Scheduler {
   int curr_preemptions_;
 
   // partial order reduction related
-  hash_val_t curr_hash_val_;
+  StateHash curr_hash_val_;
   VisitedState::HashMap visited_states_;
   VisitedState::Vec curr_visited_states_; // visited states in this exec
-  ExecutionTable loaded_execs_; // in-memory past executions
+  PorStore *por_store_; // past executions and visited states
+  std::vector<const ActionRecord *> por_match_vec_;
   int curr_exec_id_;
 
+  // dynamic partial order reduction related
+  Action::Vec dpor_steps_; // the actions taken in this execution
+  std::vector<DporClock> dpor_step_clocks_;
+  std::map<Thread *, DporClock> dpor_thd_clocks_;
+  DporObjectMap dpor_obj_steps_;
+  Action::Map dpor_sleep_set_; // the sleeping threads and their actions
+
  private:
   DISALLOW_COPY_CONSTRUCTORS(ChessScheduler);
 };
@@ -19,7 +19,10 @@
 
 #include "systematic/controller.hpp"
 
+#include <sys/prctl.h>
 #include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include <cassert>
 #include <cerrno>
 
@@ -44,11 +47,21 @@ Controller::Controller()
       program_(NULL),
       execution_(NULL),
       race_db_(NULL),
+      sinst_db_(NULL),
+      read_mostly_ratio_(0),
       unit_size_(4),
+      fork_server_(false),
+      fork_server_runs_(0),
+      handoff_spin_(0),
+      inline_schedule_(false),
+      os_fifo_(true),
+      export_schedule_(false),
       scheduler_thd_uid_(INVALID_PIN_THREAD_UID),
       program_exiting_(false),
       next_state_ready_(false),
-      next_state_sem_(NULL) {
+      next_state_sem_(NULL),
+      fork_funptr_(NULL),
+      fork_server_pipe_(-1) {
   // empty
 }
 
@@ -61,6 +74,8 @@ void Controller::HandlePreSetup() {
 
   knob_->RegisterBool("sched_app", "whether only schedule operations from the application", "1");
   knob_->RegisterBool("sched_race", "whether schedule racy memory operations (for racy programs)", "0");
+  knob_->RegisterBool("sched_sinst", "whether schedule shared memory operations (using the shared inst database)", "0");
+  knob_->RegisterInt("read_mostly_ratio", "coalesce the shared reads of the same address in a bbl if at most 1/ratio of the profiled reads follow a write (0 means never)", "10");
   knob_->RegisterInt("cpu", "specify which cpu to run on", "0");
   knob_->RegisterInt("unit_size", "the monitoring granularity in bytes", "4");
   knob_->RegisterInt("realtime_priority", "the realtime priority on which all the user thread should be run", "1");
@@ -68,11 +83,22 @@ void Controller::HandlePreSetup() {
   knob_->RegisterStr("program_out", "the output database for the modeled program", "program.db");
   knob_->RegisterStr("race_in", "the input race database path", "race.db");
   knob_->RegisterStr("race_out", "the output race database path", "race.db");
+  knob_->RegisterStr("sinst_in", "the input shared inst database path", "sinst.db");
+  knob_->RegisterBool("fork_server", "whether fork each execution from the main function instead of restarting the program", "0");
+  knob_->RegisterInt("fork_server_runs", "the maximum number of executions forked by the fork server (0 means until the search is done)", "0");
+  knob_->RegisterInt("handoff_spin", "the number of spin iterations before a thread parks at a scheduling point", "0");
+  knob_->RegisterBool("inline_schedule", "whether pick the next thread at a scheduling point directly instead of in the scheduler thread (random, pct and replay schedulers)", "1");
+  knob_->RegisterBool("export_schedule", "whether export the schedule of each execution for replay", "0");
+  knob_->RegisterStr("schedule_out", "the output schedule file path", "schedule.db");
 
   random_scheduler_ = new RandomScheduler(this);
   random_scheduler_->Register();
+  pct_scheduler_ = new PctScheduler(this);
+  pct_scheduler_->Register();
   chess_scheduler_ = new ChessScheduler(this);
   chess_scheduler_->Register();
+  replay_scheduler_ = new ReplayScheduler(this);
+  replay_scheduler_->Register();
 }
 
 void Controller::HandlePostSetup() {
@@ -81,7 +107,14 @@ void Controller::HandlePostSetup() {
   // read settings and flags
   sched_app_ = knob_->ValueBool("sched_app");
   sched_race_ = knob_->ValueBool("sched_race");
+  sched_sinst_ = knob_->ValueBool("sched_sinst");
+  sched_mem_ = sched_race_ || sched_sinst_;
+  read_mostly_ratio_ = knob_->ValueInt("read_mostly_ratio");
   unit_size_ = knob_->ValueInt("unit_size");
+  fork_server_ = knob_->ValueBool("fork_server");
+  fork_server_runs_ = knob_->ValueInt("fork_server_runs");
+  handoff_spin_ = knob_->ValueInt("handoff_spin");
+  export_schedule_ = knob_->ValueBool("export_schedule");
 
   // init global states
   program_ = new Program;
@@ -91,17 +124,28 @@ void Controller::HandlePostSetup() {
     race_db_ = new race::RaceDB(CreateMutex());
     race_db_->Load(knob_->ValueStr("race_in"), sinfo_);
   }
+  if (sched_sinst_) {
+    sinst_db_ = new sinst::SharedInstDB(CreateMutex());
+    sinst_db_->Load(knob_->ValueStr("sinst_in"), sinfo_);
+  }
   next_state_sem_ = CreateSemaphore(0);
 
   // init the scheduler
   if (random_scheduler_->Enabled())
     SetScheduler(random_scheduler_);
+  if (pct_scheduler_->Enabled())
+    SetScheduler(pct_scheduler_);
   if (chess_scheduler_->Enabled())
     SetScheduler(chess_scheduler_);
+  if (replay_scheduler_->Enabled())
+    SetScheduler(replay_scheduler_);
 
   // make sure that we use one scheduler
   if (!scheduler_)
     Abort("please choose a scheduler\n");
+  inline_schedule_ = knob_->ValueBool("inline_schedule") &&
+                     scheduler_->Inline();
+  os_fifo_ = scheduler_->OsFifo();
 
   // setup instrumentation
   desc_.SetHookPthreadFunc();
@@ -111,10 +155,16 @@ void Controller::HandlePostSetup() {
 void Controller::HandlePreInstrumentTrace(TRACE trace) {
   ExecutionControl::HandlePreInstrumentTrace(trace);
 
-  if (sched_race_) {
-    // instrument every racy memory operation
+  if (sched_mem_) {
+    // instrument every memory operation that is a scheduling point
     for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
+      INS read_point = INS_Invalid();
       for (INS ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins)) {
+        // the read point expires if the previous inst may change the
+        // value or the address it reads
+        if (INS_Valid(read_point) && ClobberReadPoint(read_point, INS_Prev(ins)))
+          read_point = INS_Invalid();
+
         // skip stack access
         if (INS_IsStackRead(ins) || INS_IsStackWrite(ins))
           continue;
@@ -125,8 +175,8 @@ void Controller::HandlePreInstrumentTrace(TRACE trace) {
           Inst *inst = GetInst(INS_Address(ins));
           UpdateInstOpcode(inst, ins);
 
-          // check whether inst is racy
-          if (race_db_->RacyInst(inst, false)) {
+          // check whether inst is a scheduling point
+          if (SchedMemInst(ins, inst, &read_point)) {
             // instrument inst (before)
             if (INS_IsMemoryRead(ins)) {
               INS_InsertCall(ins, IPOINT_BEFORE,
@@ -221,34 +271,31 @@ void Controller::HandlePreInstrumentTrace(TRACE trace) {
                                IARG_END);
               }
             }
-          } // end of if racy
+          } // end of if scheduling point
         } // end of if memory ins
       } // end of for each ins
     } // end of for each bbl
-  } // end of if sched_race_
+  } // end of if sched_mem_
 }
 
 void Controller::HandleProgramStart() {
   ExecutionControl::HandleProgramStart();
 
-  // create the scheduler thread (internal pintool thread)
-  THREADID tid = PIN_SpawnInternalThread(__SchedulerThread,
-                                         NULL, // no argument passed
-                                         0, // use default stack size
-                                         &scheduler_thd_uid_);
-  if (tid == INVALID_THREADID)
-    Abort("fail to create the scheduler thread\n");
-
   // register fini unlock function
   // this funciton is used to join the scheduler thread
   PIN_AddFiniUnlockedFunction(__SchedulerThreadReclaim, NULL);
 
-  // invoke the callback in the scheduler
-  scheduler_->ProgramStart();
+  // in fork server mode, each execution is started in a forked
+  // process when the main function is reached (see ForkServer)
+  if (fork_server_)
+    PIN_AddFiniFunction(__ForkServerReport, NULL);
+  else
+    StartExecution();
 
   // set affinity and os sched policy (FIFO)
   SetAffinity();
-  SetSchedPolicy();
+  if (os_fifo_)
+    SetSchedPolicy();
 }
 
 void Controller::HandleProgramExit() {
@@ -259,6 +306,13 @@ void Controller::HandleProgramExit() {
 
   // save status
   program_->Save(knob_->ValueStr("program_out"), sinfo_);
+
+  // export the schedule so that the execution can be replayed
+  if (export_schedule_) {
+    systematic::Schedule schedule;
+    schedule.Update(execution_);
+    schedule.Save(knob_->ValueStr("schedule_out"));
+  }
 }
 
 void Controller::HandleImageLoad(IMG img, Image *image) {
@@ -283,6 +337,13 @@ void Controller::HandleImageLoad(IMG img, Image *image) {
   CALL_ANALYSIS_FUNC(ImageLoad, image, low_addr, high_addr, data_start,
                      data_size, bss_start, bss_size);
 
+  // find the fork function used by the fork server
+  if (fork_server_ && !fork_funptr_) {
+    RTN rtn = RTN_FindByName(img, "fork");
+    if (RTN_Valid(rtn))
+      fork_funptr_ = (AFUNPTR)RTN_Address(rtn);
+  }
+
   // update region table
   LockKernel();
   if (data_start) {
@@ -353,7 +414,7 @@ void Controller::HandleThreadStart() {
   enable_table_[self] = true;
   thread_creation_info_[self] = 0;
   active_table_[self] = true;
-  if (sched_race_)
+  if (sched_mem_)
     race_active_table_[self] = false;
   UnlockKernel();
 
@@ -378,13 +439,21 @@ void Controller::HandleThreadExit() {
   // clean up self
   enable_table_[self] = false;
   active_table_[self] = false;
-  if (sched_race_)
+  if (sched_mem_)
     race_active_table_[self] = false;
   // schedule on exit
   ScheduleOnExit(self);
   UnlockKernel();
 }
 
+void Controller::HandleMain(THREADID tid, CONTEXT *ctxt) {
+  // the fork server only returns in a forked execution
+  if (fork_server_)
+    ForkServer(tid, ctxt);
+
+  ExecutionControl::HandleMain(tid, ctxt);
+}
+
 void Controller::HandleSchedulerThread() {
   // this is the main entrance of the scheduler thread
   LockKernel();
@@ -403,6 +472,10 @@ void Controller::HandleSchedulerThread() {
 }
 
 void Controller::HandleSchedulerThreadReclaim() {
+  // no scheduler thread if the scheduler runs inline
+  if (inline_schedule_)
+    return;
+
   DEBUG_ASSERT(scheduler_thd_uid_ != INVALID_PIN_THREAD_UID);
 
   // wait until the scheduler thread finish
@@ -415,7 +488,7 @@ void Controller::HandleSchedulerThreadReclaim() {
 
 void Controller::HandleBeforeRaceRead(THREADID tid, Inst *inst,
                                       address_t addr, size_t size) {
-  DEBUG_ASSERT(sched_race_);
+  DEBUG_ASSERT(sched_mem_);
   if (sched_app_ && inst->image()->IsCommonLib())
     return;
 
@@ -434,7 +507,7 @@ void Controller::HandleBeforeRaceRead(THREADID tid, Inst *inst,
 
 void Controller::HandleAfterRaceRead(THREADID tid, Inst *inst,
                                      address_t addr, size_t size) {
-  DEBUG_ASSERT(sched_race_);
+  DEBUG_ASSERT(sched_mem_);
   if (sched_app_ && inst->image()->IsCommonLib())
     return;
 
@@ -446,7 +519,7 @@ void Controller::HandleAfterRaceRead(THREADID tid, Inst *inst,
 
 void Controller::HandleBeforeRaceWrite(THREADID tid, Inst *inst,
                                        address_t addr, size_t size) {
-  DEBUG_ASSERT(sched_race_);
+  DEBUG_ASSERT(sched_mem_);
   if (sched_app_ && inst->image()->IsCommonLib())
     return;
 
@@ -465,7 +538,7 @@ void Controller::HandleBeforeRaceWrite(THREADID tid, Inst *inst,
 
 void Controller::HandleAfterRaceWrite(THREADID tid, Inst *inst,
                                       address_t addr, size_t size) {
-  DEBUG_ASSERT(sched_race_);
+  DEBUG_ASSERT(sched_mem_);
   if (sched_app_ && inst->image()->IsCommonLib())
     return;
 
@@ -753,7 +826,7 @@ Action *Controller::CreateAction(thread_id_t thd_id,
 State *Controller::CreateState() {
   State *state = execution_->CreateState();
 
-  if (sched_race_) {
+  if (sched_mem_) {
     // sched race mode
     for (std::map<thread_id_t, bool>::iterator it = race_active_table_.begin();
          it != race_active_table_.end(); ++it) {
@@ -812,13 +885,33 @@ Action *Controller::Schedule(thread_id_t self,
     // go to wait status immediately if they call this func
     next_state_ready_ = true;
     // make sure that other runnable threads can be executed
-    // as far as they can (assume the os sched policy is FIFO)
-    // we use multiple yields here to reduce the noise
-    UnlockKernel();
-    for (int i = 0; i < 2; i++) Yield();
-    LockKernel();
-    // notify the scheduler thread to process the next state
-    SemPost(next_state_sem_);
+    // as far as they can. under the os FIFO policy, we use multiple
+    // yields here to reduce the noise. otherwise, wait until they
+    // reach their scheduling points (or exit) so that the next state
+    // does not depend on the os scheduler
+    if (os_fifo_) {
+      if (OtherActive(self)) {
+        UnlockKernel();
+        for (int i = 0; i < 2; i++) Yield();
+        LockKernel();
+      }
+    } else {
+      while (OtherActive(self)) {
+        UnlockKernel();
+        Yield();
+        LockKernel();
+      }
+    }
+    if (inline_schedule_) {
+      // pick the next action here, no need to wait if it is ours
+      if (ScheduleInline(self)) {
+        action_table_[self] = NULL;
+        return action;
+      }
+    } else {
+      // notify the scheduler thread to process the next state
+      SemPost(next_state_sem_);
+    }
   }
   // wait for permission to proceed
   active_table_[self] = false;
@@ -843,7 +936,130 @@ void Controller::ScheduleOnExit(thread_id_t self) {
   if (self == main_thd_id_)
     program_exiting_ = true;
   next_state_ready_ = true;
-  SemPost(next_state_sem_);
+  if (inline_schedule_)
+    ScheduleInline(self);
+  else
+    SemPost(next_state_sem_);
+}
+
+bool Controller::ScheduleInline(thread_id_t self) {
+  // take the place of the scheduler thread: create the next state,
+  // let the scheduler pick the next action and grant the permission
+  // to its thread directly. return true if self is picked.
+  DEBUG_ASSERT(next_state_ready_);
+  next_state_ready_ = false;
+  State *state = CreateState();
+  Action *action = scheduler_->Step(state);
+  if (!action) {
+    // no enabled thread
+    if (!program_exiting_)
+      printf("[CHESS] program deadlock\n");
+    return false;
+  }
+  thread_id_t target = thread_reverse_table_[action->thd()];
+  if (target == self)
+    return true;
+  SemPost(perm_sem_table_[target]);
+  return false;
+}
+
+void Controller::StartExecution() {
+  // create the scheduler thread (internal pintool thread), an inline
+  // scheduler is run by the threads at the scheduling points instead
+  if (!inline_schedule_) {
+    THREADID tid = PIN_SpawnInternalThread(__SchedulerThread,
+                                           NULL, // no argument passed
+                                           0, // use default stack size
+                                           &scheduler_thd_uid_);
+    if (tid == INVALID_THREADID)
+      Abort("fail to create the scheduler thread\n");
+  }
+
+  // invoke the callback in the scheduler
+  scheduler_->ProgramStart();
+}
+
+void Controller::ForkServer(THREADID tid, CONTEXT *ctxt) {
+  // the program is snapshotted at the beginning of the main function
+  // where only the main thread exists. each execution is a forked
+  // child of the snapshot which reports back through a pipe whether
+  // the search is done. the fork server stops when the search is
+  // done or when an execution fails to report (e.g. crashes), and the
+  // child is forked using the fork function in the application so
+  // that pin can follow it
+  if (!fork_funptr_)
+    Abort("fail to find the fork function\n");
+
+  int status = 0;
+  for (int run = 0; !fork_server_runs_ || run < fork_server_runs_; run++) {
+    int fds[2];
+    if (pipe(fds))
+      Abort("fail to create the fork server pipe\n");
+
+    int pid = -1;
+    PIN_CallApplicationFunction(ctxt,
+                                tid,
+                                CALLINGSTD_DEFAULT,
+                                fork_funptr_,
+                                CALL_ORIGINAL_PARAM
+                                PIN_PARG(int), &pid,
+                                PIN_PARG_END());
+    if (pid < 0)
+      Abort("fail to fork an execution\n");
+
+    if (pid == 0) {
+      // this is the forked execution
+      close(fds[0]);
+      fork_server_pipe_ = fds[1];
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      // the states saved by the previous execution are not in the
+      // snapshot, thus load them again
+      if (run > 0) {
+        sinfo_->Load(knob_->ValueStr("sinfo_out"));
+        program_->Load(knob_->ValueStr("program_out"), sinfo_);
+        scheduler_->Reload();
+      }
+      StartExecution();
+      return;
+    }
+
+    // wait for the report from the forked execution
+    close(fds[1]);
+    char done = 0;
+    ssize_t res = 0;
+    do {
+      res = read(fds[0], &done, 1);
+    } while (res < 0 && errno == EINTR);
+    close(fds[0]);
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+
+    if (res != 1 || WIFSIGNALED(status))
+      break;
+    if (done)
+      break;
+  }
+
+  // the program is not executed in the fork server process, thus exit
+  // without calling the fini functions, passing on the exit status of
+  // the last execution. the signal that killed an execution cannot be
+  // re-raised from the tool, thus use SIGKILL instead
+  if (WIFSIGNALED(status))
+    kill(getpid(), SIGKILL);
+  PIN_ExitProcess(WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+}
+
+void Controller::ForkServerReport() {
+  if (fork_server_pipe_ < 0)
+    return;
+
+  // called after all the databases are saved
+  char done = scheduler_->Done() ? 1 : 0;
+  ssize_t res = 0;
+  do {
+    res = write(fork_server_pipe_, &done, 1);
+  } while (res < 0 && errno == EINTR);
+  close(fork_server_pipe_);
+  fork_server_pipe_ = -1;
 }
 
 // helper functions
@@ -898,6 +1114,21 @@ void Controller::Yield() {
   sched_yield();
 }
 
+bool Controller::OtherActive(thread_id_t self) {
+  // a thread that has started but is not in the active table yet is
+  // also running (e.g. a newly created thread)
+  for (std::map<OS_THREAD_ID, thread_id_t>::iterator it = os_tid_map_.begin();
+       it != os_tid_map_.end(); ++it) {
+    thread_id_t thd_id = it->second;
+    if (thd_id == self)
+      continue;
+    std::map<thread_id_t, bool>::iterator ait = active_table_.find(thd_id);
+    if (ait == active_table_.end() || ait->second)
+      return true;
+  }
+  return false;
+}
+
 Controller::JoinInfo *Controller::GetJoinInfo(thread_id_t thd_id) {
   JoinInfo::Map::iterator it = join_info_table_.find(thd_id);
   JoinInfo *join_info = NULL;
@@ -1069,6 +1300,60 @@ void Controller::FreeCondInfo(Region *region) {
   }
 }
 
+bool Controller::SchedMemInst(INS ins, Inst *inst, INS *read_point) {
+  if (!sched_sinst_)
+    return race_db_->RacyInst(inst, false);
+
+  // instructions that never access shared data are not scheduled
+  if (!sinst_db_->Shared(inst, false))
+    return false;
+  // a shared read that is profiled to read read-mostly data is not a
+  // new scheduling point if the previous read point in the bbl reads
+  // the same address (nothing in between may change it)
+  bool racy = race_db_ && race_db_->RacyInst(inst, false);
+  if (!racy && !INS_IsMemoryWrite(ins) &&
+      sinst_db_->ReadMostly(inst, read_mostly_ratio_, false)) {
+    if (INS_Valid(*read_point) && SameReadAddr(*read_point, ins))
+      return false;
+    *read_point = ins;
+    return true;
+  }
+  *read_point = INS_Invalid();
+  return true;
+}
+
+bool Controller::SameReadAddr(INS ins1, INS ins2) {
+  if (INS_MemoryOperandCount(ins1) != 1 || INS_MemoryOperandCount(ins2) != 1)
+    return false;
+  if (INS_MemoryReadSize(ins1) != INS_MemoryReadSize(ins2))
+    return false;
+  if (INS_SegmentRegPrefix(ins1) != INS_SegmentRegPrefix(ins2) ||
+      INS_MemoryBaseReg(ins1) != INS_MemoryBaseReg(ins2) ||
+      INS_MemoryIndexReg(ins1) != INS_MemoryIndexReg(ins2) ||
+      INS_MemoryScale(ins1) != INS_MemoryScale(ins2))
+    return false;
+  ADDRDELTA disp1 = INS_MemoryDisplacement(ins1);
+  ADDRDELTA disp2 = INS_MemoryDisplacement(ins2);
+  // ip relative addresses depend on the address of the next inst
+  if (INS_MemoryBaseReg(ins1) == REG_INST_PTR) {
+    disp1 += INS_Address(ins1) + INS_Size(ins1);
+    disp2 += INS_Address(ins2) + INS_Size(ins2);
+  }
+  return disp1 == disp2;
+}
+
+bool Controller::ClobberReadPoint(INS read_point, INS ins) {
+  if (INS_IsMemoryWrite(ins))
+    return true;
+  REG base = INS_MemoryBaseReg(read_point);
+  REG index = INS_MemoryIndexReg(read_point);
+  if (REG_valid(base) && INS_RegWContain(ins, base))
+    return true;
+  if (REG_valid(index) && INS_RegWContain(ins, index))
+    return true;
+  return false;
+}
+
 Object::idx_t Controller::GetCreatorIdx(thread_id_t thd_id, Inst *inst) {
   CreationInfo info;
   info.creator_thd_id = thd_id;
@@ -1097,6 +1382,10 @@ void Controller::__SchedulerThreadReclaim(INT32 code, VOID *v) {
   ((Controller *)ctrl_)->HandleSchedulerThreadReclaim();
 }
 
+void Controller::__ForkServerReport(INT32 code, VOID *v) {
+  ((Controller *)ctrl_)->ForkServerReport();
+}
+
 void Controller::__BeforeRaceRead(THREADID tid, Inst *inst, ADDRINT addr,
                                   UINT32 size) {
   ((Controller *)ctrl_)->HandleBeforeRaceRead(tid, inst, addr, size);
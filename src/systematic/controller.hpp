@@ -23,9 +23,12 @@
 #include "core/basictypes.h"
 #include "core/execution_control.hpp"
 #include "race/race.h"
+#include "sinst/sinst.h"
 #include "systematic/scheduler.h"
 #include "systematic/random.h"
+#include "systematic/pct.h"
 #include "systematic/chess.h"
+#include "systematic/replay.h"
 
 namespace systematic {
 
@@ -159,6 +162,9 @@ class Controller : public ExecutionControl, public ControllerInterface {
   };
 
   // overrided virtual functions
+  virtual Semaphore *CreateSemaphore(unsigned int value) {
+    return new FutexSemaphore(value, handoff_spin_);
+  }
   virtual void HandlePreSetup();
   virtual void HandlePostSetup();
   virtual void HandlePreInstrumentTrace(TRACE trace);
@@ -168,6 +174,7 @@ class Controller : public ExecutionControl, public ControllerInterface {
   virtual void HandleImageUnload(IMG img, Image *image);
   virtual void HandleThreadStart();
   virtual void HandleThreadExit();
+  virtual void HandleMain(THREADID tid, CONTEXT *ctxt);
   virtual void HandleSchedulerThread();
   virtual void HandleSchedulerThreadReclaim();
   virtual void HandleBeforeRaceRead(THREADID tid, Inst *inst,
@@ -197,6 +204,10 @@ class Controller : public ExecutionControl, public ControllerInterface {
   State *Execute(State *state, Action *action);
   Action *Schedule(thread_id_t self, address_t iaddr, Operation op, Inst *inst);
   void ScheduleOnExit(thread_id_t self);
+  bool ScheduleInline(thread_id_t self);
+  void StartExecution();
+  void ForkServer(THREADID tid, CONTEXT *ctxt);
+  void ForkServerReport();
 
   // helper functions
   void SetScheduler(Scheduler *scheduler);
@@ -209,6 +220,7 @@ class Controller : public ExecutionControl, public ControllerInterface {
   void SetAffinity();
   void SetSchedPolicy();
   void Yield();
+  bool OtherActive(thread_id_t self);
   JoinInfo *GetJoinInfo(thread_id_t thd_id);
   MutexInfo *GetMutexInfo(address_t iaddr);
   CondInfo *GetCondInfo(address_t iaddr);
@@ -223,17 +235,32 @@ class Controller : public ExecutionControl, public ControllerInterface {
   void FreeMutexInfo(Region *region);
   void FreeCondInfo(Region *region);
   Object::idx_t GetCreatorIdx(thread_id_t thd_id, Inst *inst);
+  bool SchedMemInst(INS ins, Inst *inst, INS *read_point);
+  bool SameReadAddr(INS ins1, INS ins2);
+  bool ClobberReadPoint(INS read_point, INS ins);
 
   // settings and flags
   Scheduler *scheduler_; // the scheduler that controls the execution
   RandomScheduler *random_scheduler_;
+  PctScheduler *pct_scheduler_;
   ChessScheduler *chess_scheduler_;
+  ReplayScheduler *replay_scheduler_;
   Program *program_; // the modeled program
   Execution *execution_; // the current execution of the modeled program
   race::RaceDB *race_db_;
+  sinst::SharedInstDB *sinst_db_;
+  int read_mostly_ratio_; // the min reads per read after write to coalesce
   bool sched_app_; // whether only care about ops in the application
   bool sched_race_; // whether schedule racy memory operations
+  bool sched_sinst_; // whether schedule shared memory operations
+  bool sched_mem_; // whether schedule any memory operation
   address_t unit_size_; // the granularity
+  bool fork_server_; // whether fork each execution from the main function
+  int fork_server_runs_; // the max number of forked executions
+  int handoff_spin_; // the spin iterations before parking on a hand-off
+  bool inline_schedule_; // whether pick the next action without the scheduler thread
+  bool os_fifo_; // whether run the program under the os FIFO policy
+  bool export_schedule_; // whether export the schedule of the execution
 
   // global analysis states
   PIN_THREAD_UID scheduler_thd_uid_; // the pin uid for the scheduler thread
@@ -259,9 +286,14 @@ class Controller : public ExecutionControl, public ControllerInterface {
   size_t tls_race_write_size_[PIN_MAX_THREADS];
   address_t tls_race_read2_addr_[PIN_MAX_THREADS];
 
+  // fork server related
+  AFUNPTR fork_funptr_; // the fork function in the application
+  int fork_server_pipe_; // used to report to the fork server
+
  private:
   static void __SchedulerThread(VOID *arg);
   static void __SchedulerThreadReclaim(INT32 code, VOID *v);
+  static void __ForkServerReport(INT32 code, VOID *v);
   static void __BeforeRaceRead(THREADID tid, Inst *inst, ADDRINT addr,
                                UINT32 size);
   static void __AfterRaceRead(THREADID tid, Inst *inst);
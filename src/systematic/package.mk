@@ -1,19 +1,21 @@
 # Rules for the systematic package
 
 protodefs += \
-  systematic/chess.proto \
   systematic/program.proto \
   systematic/search.proto
 
 srcs += \
   systematic/chess.cc \
-  systematic/chess.pb.cc \
   systematic/controller.cpp \
   systematic/controller_main.cpp \
   systematic/fair.cc \
+  systematic/pct.cc \
+  systematic/por_store.cc \
   systematic/program.cc \
   systematic/program.pb.cc \
   systematic/random.cc \
+  systematic/replay.cc \
+  systematic/schedule.cc \
   systematic/scheduler.cc \
   systematic/search.cc \
   systematic/search.pb.cc
@@ -23,28 +25,39 @@ pintools += \
 
 systematic_controller_objs := \
   systematic/chess.o \
-  systematic/chess.pb.o \
   systematic/controller.o \
   systematic/controller_main.o \
   systematic/fair.o \
+  systematic/pct.o \
+  systematic/por_store.o \
   systematic/program.o \
   systematic/program.pb.o \
   systematic/random.o \
+  systematic/replay.o \
+  systematic/schedule.o \
   systematic/scheduler.o \
   systematic/search.o \
   systematic/search.pb.o \
+  pct/history.o \
+  pct/history.pb.o \
   $(race_objs) \
+  $(sinst_objs) \
   $(core_objs)
 
 systematic_objs := \
   systematic/chess.o \
-  systematic/chess.pb.o \
   systematic/controller.o \
   systematic/fair.o \
+  systematic/pct.o \
+  systematic/por_store.o \
   systematic/program.o \
   systematic/program.pb.o \
   systematic/random.o \
+  systematic/replay.o \
+  systematic/schedule.o \
   systematic/scheduler.o \
   systematic/search.o \
-  systematic/search.pb.o
+  systematic/search.pb.o \
+  pct/history.o \
+  pct/history.pb.o
 
@@ -0,0 +1,172 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: systematic/pct.cc - The implementation of the PCT scheduler
+// which picks the enabled thread with the highest priority at each
+// schedule point and changes priorities at randomly chosen steps.
+
+#include "systematic/pct.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include "core/logging.h"
+
+namespace systematic {
+
+// order threads by their uids which are stable across runs
+static bool ThreadUidLess(Thread *t1, Thread *t2) {
+  return t1->uid() < t2->uid();
+}
+
+PctScheduler::PctScheduler(ControllerInterface *controller)
+    : Scheduler(controller),
+      seed_(0),
+      rand_state_(0),
+      depth_(1),
+      num_steps_(0),
+      curr_step_(0),
+      change_points_cursor_(0) {
+  // empty
+}
+
+PctScheduler::~PctScheduler() {
+  // empty
+}
+
+void PctScheduler::Register() {
+  knob()->RegisterBool("enable_pct_scheduler", "whether use the pct scheduler", "0");
+  knob()->RegisterInt("pct_depth", "the target bug depth of the pct scheduler", "3");
+  knob()->RegisterInt("pct_seed", "the random seed of the pct scheduler (0 means use the current time)", "0");
+  knob()->RegisterInt("pct_steps", "the estimated number of schedule points in a run (0 means use the history)", "0");
+  knob()->RegisterStr("pct_history", "the pct scheduler history file path", "pct_sched.histo");
+}
+
+bool PctScheduler::Enabled() {
+  return knob()->ValueBool("enable_pct_scheduler");
+}
+
+void PctScheduler::Setup() {
+  // seed the random number generator
+  seed_ = (unsigned int)knob()->ValueInt("pct_seed");
+  if (!seed_)
+    seed_ = (unsigned int)time(NULL);
+  rand_state_ = seed_;
+
+  // estimate the number of schedule points
+  history_.Load(knob()->ValueStr("pct_history"));
+  num_steps_ = (unsigned long)knob()->ValueInt("pct_steps");
+  if (!num_steps_ && !history_.Empty())
+    num_steps_ = history_.AvgInstCount();
+
+  // setup depth (no change point can be chosen without an estimation)
+  if (num_steps_)
+    depth_ = knob()->ValueInt("pct_depth");
+  else
+    depth_ = 1;
+  if (depth_ < 1)
+    depth_ = 1;
+
+  // randomize priority change points
+  for (int i = 1; i < depth_; i++)
+    change_points_.push_back(1 + Random(num_steps_));
+  std::sort(change_points_.begin(), change_points_.end());
+
+  // print the settings so that this run can be replayed
+  printf("[PCT] seed = %u, depth = %d, steps = %lu\n",
+         seed_, depth_, num_steps_);
+}
+
+void PctScheduler::ProgramStart() {
+  // empty
+}
+
+void PctScheduler::ProgramExit() {
+  // update the history
+  history_.Update(curr_step_, priorities_.size());
+  history_.Save(knob()->ValueStr("pct_history"));
+}
+
+void PctScheduler::Explore(State *init_state) {
+  // start with the initial state
+  State *state = init_state;
+  // run until no enabled thread
+  while (!state->IsTerminal()) {
+    // pick the enabled thread with the highest priority
+    Action *action = Pick(state);
+    // execute the action and move to next state
+    state = Execute(state, action);
+  }
+}
+
+unsigned long PctScheduler::Random(unsigned long max) {
+  // use rand_r so that the sequence only depends on the seed
+  unsigned long val = (unsigned long)rand_r(&rand_state_);
+  val = (val << 31) | (unsigned long)rand_r(&rand_state_);
+  return val % max;
+}
+
+void PctScheduler::AssignPriorities(State *state) {
+  // assign random initial priorities (all greater than the change
+  // priorities) to new threads in uid order
+  Thread::Vec new_threads;
+  Action::Map *enabled = state->enabled();
+  for (Action::Map::iterator it = enabled->begin(); it != enabled->end(); ++it){
+    if (priorities_.find(it->first) == priorities_.end())
+      new_threads.push_back(it->first);
+  }
+  std::sort(new_threads.begin(), new_threads.end(), ThreadUidLess);
+  for (Thread::Vec::iterator it = new_threads.begin();
+       it != new_threads.end(); ++it) {
+    priorities_[*it] = depth_ + (long)Random(RAND_MAX);
+  }
+}
+
+Action *PctScheduler::Pick(State *state) {
+  curr_step_++;
+  AssignPriorities(state);
+  Action::Map *enabled = state->enabled();
+  while (true) {
+    // find the enabled thread with the highest priority (ties are
+    // broken by uids)
+    Action *target = NULL;
+    long target_priority = 0;
+    for (Action::Map::iterator it = enabled->begin(); it != enabled->end();
+         ++it) {
+      long priority = priorities_[it->first];
+      if (!target || priority > target_priority ||
+          (priority == target_priority &&
+           it->first->uid() < target->thd()->uid())) {
+        target = it->second;
+        target_priority = priority;
+      }
+    }
+    DEBUG_ASSERT(target);
+
+    // change the priority of the target thread if a change point is
+    // reached, and pick again
+    if (change_points_cursor_ < change_points_.size() &&
+        change_points_[change_points_cursor_] <= curr_step_) {
+      priorities_[target->thd()] = depth_ - 1 - (long)change_points_cursor_;
+      change_points_cursor_++;
+      continue;
+    }
+    return target;
+  }
+}
+
+} // namespace systematic
+
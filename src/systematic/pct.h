@@ -0,0 +1,74 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: systematic/pct.h - The definition of the PCT scheduler which
+// picks the enabled thread with the highest priority at each schedule
+// point and changes priorities at randomly chosen steps. All random
+// choices are derived from a seed, so that a run can be replayed.
+
+#ifndef SYSTEMATIC_PCT_H_
+#define SYSTEMATIC_PCT_H_
+
+#include <map>
+#include <vector>
+
+#include "core/basictypes.h"
+#include "pct/history.h"
+#include "systematic/scheduler.h"
+
+namespace systematic {
+
+class PctScheduler : public Scheduler {
+ public:
+  explicit PctScheduler(ControllerInterface *controller);
+  ~PctScheduler();
+
+  // overrided virtual functions
+  void Register();
+  bool Enabled();
+  void Setup();
+  void ProgramStart();
+  void ProgramExit();
+  void Explore(State *init_state);
+  bool Inline() { return true; }
+  bool OsFifo() { return false; }
+  Action *Pick(State *state);
+
+ protected:
+  typedef std::map<Thread *, long> PriorityMap;
+
+  // helper functions
+  unsigned long Random(unsigned long max);
+  void AssignPriorities(State *state);
+
+  unsigned int seed_;
+  unsigned int rand_state_;
+  int depth_;
+  unsigned long num_steps_; // the estimated number of schedule points
+  unsigned long curr_step_;
+  std::vector<unsigned long> change_points_; // sorted
+  size_t change_points_cursor_;
+  PriorityMap priorities_;
+  pct::History history_;
+
+ private:
+  DISALLOW_COPY_CONSTRUCTORS(PctScheduler);
+};
+
+} // namespace systematic
+
+#endif
+
@@ -0,0 +1,202 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: systematic/por_store.cc - Implementation of the append-only
+// store of past executions and visited states used by partial order
+// reduction.
+
+#include "systematic/por_store.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "core/logging.h"
+
+namespace systematic {
+
+// the store is useless (and the search unsound) if its files cannot be
+// read or written, thus any failure is fatal even in release builds
+static void Abort(const std::string &msg) {
+  fprintf(stderr, "%s", msg.c_str());
+  abort();
+}
+
+PorStore::PorStore(const std::string &path)
+    : path_(path),
+      actions_(NULL),
+      execs_(NULL),
+      visited_(NULL),
+      num_actions_(0),
+      num_execs_(0),
+      num_visited_(0) {
+  actions_file_.fd = -1;
+  execs_file_.fd = -1;
+  visited_file_.fd = -1;
+}
+
+void PorStore::Open() {
+  actions_ = (const ActionRecord *)OpenFile(&actions_file_, "actions");
+  execs_ = (const ExecRecord *)OpenFile(&execs_file_, "execs");
+  visited_ = (const VisitedRecord *)OpenFile(&visited_file_, "visited");
+  num_actions_ = actions_file_.size / sizeof(ActionRecord);
+  num_execs_ = execs_file_.size / sizeof(ExecRecord);
+  num_visited_ = visited_file_.size / sizeof(VisitedRecord);
+
+  // discard the records of a partially appended run. since records
+  // are appended in order, only the tail can be invalid
+  while (num_execs_ > 0 &&
+         execs_[num_execs_ - 1].start + execs_[num_execs_ - 1].num_actions
+         > num_actions_) {
+    num_execs_--;
+  }
+  if (num_execs_ > 0)
+    num_actions_ = execs_[num_execs_ - 1].start
+                   + execs_[num_execs_ - 1].num_actions;
+  else
+    num_actions_ = 0;
+  while (num_visited_ > 0 &&
+         visited_[num_visited_ - 1].exec_id > num_execs_) {
+    num_visited_--;
+  }
+  if (ftruncate(actions_file_.fd, num_actions_ * sizeof(ActionRecord)) ||
+      ftruncate(execs_file_.fd, num_execs_ * sizeof(ExecRecord)) ||
+      ftruncate(visited_file_.fd, num_visited_ * sizeof(VisitedRecord)))
+    Abort("fail to truncate the por store files\n");
+}
+
+void PorStore::Close() {
+  CloseFile(&actions_file_);
+  CloseFile(&execs_file_);
+  CloseFile(&visited_file_);
+  actions_ = NULL;
+  execs_ = NULL;
+  visited_ = NULL;
+}
+
+bool PorStore::FindActions(int exec_id, size_t state_idx,
+                           const ActionRecord **begin,
+                           const ActionRecord **end) {
+  // exec ids start from 1
+  if (exec_id <= 0 || (size_t)exec_id > num_execs_)
+    return false;
+  const ExecRecord *exec = &execs_[exec_id - 1];
+  if (state_idx > exec->num_actions)
+    return false;
+  *begin = actions_ + exec->start;
+  *end = *begin + state_idx;
+  return true;
+}
+
+void PorStore::AppendExec(Execution *exec) {
+  DEBUG_ASSERT(actions_file_.fd >= 0 && execs_file_.fd >= 0);
+  std::vector<ActionRecord> records;
+  for (size_t idx = 0; ; idx++) {
+    State *state = exec->FindState(idx);
+    if (!state || !state->taken())
+      break;
+    records.push_back(ActionRecord());
+    Encode(state->taken(), &records.back());
+  }
+  ExecRecord exec_record;
+  exec_record.start = num_actions_;
+  exec_record.num_actions = records.size();
+  if (!records.empty())
+    Append(&actions_file_, &records[0], records.size() * sizeof(ActionRecord));
+  Append(&execs_file_, &exec_record, sizeof(ExecRecord));
+  num_actions_ += records.size();
+  num_execs_++;
+}
+
+void PorStore::AppendVisited(const VisitedRecord &record) {
+  DEBUG_ASSERT(visited_file_.fd >= 0);
+  Append(&visited_file_, &record, sizeof(VisitedRecord));
+}
+
+void PorStore::Encode(Action *action, ActionRecord *record) {
+  memset(record, 0, sizeof(ActionRecord));
+  record->tc = action->tc();
+  record->oc = action->oc();
+  record->thd_uid = action->thd()->uid();
+  record->op = (uint16)action->op();
+  if (action->obj()) {
+    record->obj_uid = action->obj()->uid();
+    record->flags |= ActionRecord::HAS_OBJ;
+  }
+  if (action->inst()) {
+    record->inst_id = action->inst()->id();
+    record->flags |= ActionRecord::HAS_INST;
+  }
+}
+
+bool PorStore::Equal(const ActionRecord &r1, const ActionRecord &r2) {
+  return r1.tc == r2.tc &&
+         r1.oc == r2.oc &&
+         r1.thd_uid == r2.thd_uid &&
+         r1.obj_uid == r2.obj_uid &&
+         r1.inst_id == r2.inst_id &&
+         r1.op == r2.op &&
+         r1.flags == r2.flags;
+}
+
+void *PorStore::OpenFile(MappedFile *file, const char *name) {
+  std::string file_path = path_ + '/' + name;
+  file->fd = open(file_path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (file->fd < 0)
+    Abort("fail to open " + file_path + "\n");
+  struct stat sb;
+  if (fstat(file->fd, &sb))
+    Abort("fail to stat " + file_path + "\n");
+  file->size = sb.st_size;
+  file->addr = NULL;
+  if (file->size > 0) {
+    file->addr = mmap(NULL, file->size, PROT_READ, MAP_SHARED, file->fd, 0);
+    if (file->addr == MAP_FAILED)
+      Abort("fail to map " + file_path + "\n");
+  }
+  return file->addr;
+}
+
+void PorStore::CloseFile(MappedFile *file) {
+  if (file->addr)
+    munmap(file->addr, file->size);
+  if (file->fd >= 0)
+    close(file->fd);
+  file->fd = -1;
+  file->addr = NULL;
+  file->size = 0;
+}
+
+void PorStore::Append(MappedFile *file, const void *buf, size_t size) {
+  const char *ptr = (const char *)buf;
+  while (size > 0) {
+    ssize_t res = write(file->fd, ptr, size);
+    if (res < 0 && errno == EINTR)
+      continue;
+    if (res <= 0)
+      Abort("fail to append to the por store\n");
+    ptr += res;
+    size -= res;
+  }
+}
+
+} // namespace systematic
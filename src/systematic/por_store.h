@@ -0,0 +1,116 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: systematic/por_store.h - Define the append-only store of past
+// executions and visited states used by partial order reduction.
+
+#ifndef SYSTEMATIC_POR_STORE_H_
+#define SYSTEMATIC_POR_STORE_H_
+
+#include <string>
+
+#include "core/basictypes.h"
+#include "systematic/program.h"
+
+namespace systematic {
+
+// the fixed-size record of an action taken in a past execution
+struct ActionRecord {
+  enum {
+    HAS_OBJ = 0x1,
+    HAS_INST = 0x2,
+  };
+
+  uint64 tc;
+  uint64 oc;
+  uint32 thd_uid;
+  uint32 obj_uid;
+  uint32 inst_id;
+  uint16 op;
+  uint16 flags;
+};
+
+// the fixed-size record of a past execution. the i-th action record
+// of the execution is the action taken at state i
+struct ExecRecord {
+  uint64 start;       // the index of the first action record
+  uint64 num_actions;
+};
+
+// the fixed-size record of a visited state
+struct VisitedRecord {
+  uint64 hash_lo;
+  uint64 hash_hi;
+  uint32 preemptions;
+  uint32 exec_id;
+  uint64 state_idx;
+};
+
+// The store keeps three append-only files in a directory: the action
+// records of all past executions, the execution records indexing
+// them, and the visited state records. The existing records are
+// mapped into memory when the store is opened, so that past
+// executions can be read in place. New records are appended in the
+// order actions, executions, visited states, thus a partially appended
+// run (e.g. the program crashes in the middle) is discarded on open.
+class PorStore {
+ public:
+  explicit PorStore(const std::string &path);
+  ~PorStore() {}
+
+  void Open();
+  void Close();
+  bool FindActions(int exec_id, size_t state_idx,
+                   const ActionRecord **begin, const ActionRecord **end);
+  void AppendExec(Execution *exec);
+  void AppendVisited(const VisitedRecord &record);
+
+  size_t num_execs() { return num_execs_; }
+  size_t num_visited() { return num_visited_; }
+  const VisitedRecord *visited(size_t i) { return &visited_[i]; }
+
+  static void Encode(Action *action, ActionRecord *record);
+  static bool Equal(const ActionRecord &r1, const ActionRecord &r2);
+
+ protected:
+  typedef struct {
+    int fd;
+    void *addr;
+    size_t size;
+  } MappedFile;
+
+  void *OpenFile(MappedFile *file, const char *name);
+  void CloseFile(MappedFile *file);
+  void Append(MappedFile *file, const void *buf, size_t size);
+
+  std::string path_;
+  MappedFile actions_file_;
+  MappedFile execs_file_;
+  MappedFile visited_file_;
+  const ActionRecord *actions_;
+  const ExecRecord *execs_;
+  const VisitedRecord *visited_;
+  size_t num_actions_;
+  size_t num_execs_;
+  size_t num_visited_;
+
+ private:
+  DISALLOW_COPY_CONSTRUCTORS(PorStore);
+};
+
+} // namespace systematic
+
+#endif
@@ -193,18 +193,26 @@ void Program::Load(const std::string &db_name, StaticInfo *sinfo) {
   if (in.is_open())
     program_proto.ParseFromIstream(&in);
   in.close();
-  // load thread info, we need two passes
+  // the threads and objects that are already known are kept (the
+  // pointers to them might be cached), thus loading the database
+  // again only adds the new ones. load thread info, we need two passes
+  Thread::Set new_thds;
   for (int i = 0; i < program_proto.thread_size(); i++) {
     ThreadProto *proto = program_proto.mutable_thread(i);
+    if (FindThread(proto->uid()))
+      continue;
     Thread *thd = new Thread;
     thd->uid_ = proto->uid();
     thd_uid_table_[thd->uid_] = thd;
+    new_thds.insert(thd);
     if (curr_thd_uid_ < thd->uid_)
       curr_thd_uid_ = thd->uid_;
   }
   for (int i = 0; i < program_proto.thread_size(); i++) {
     ThreadProto *proto = program_proto.mutable_thread(i);
     Thread *thd = thd_uid_table_[proto->uid()];
+    if (new_thds.find(thd) == new_thds.end())
+      continue;
     if (proto->has_creator_uid()) {
       thd->creator_ = FindThread(proto->creator_uid());
       DEBUG_ASSERT(thd->creator_);
@@ -215,6 +223,8 @@ void Program::Load(const std::string &db_name, StaticInfo *sinfo) {
   // load static object info
   for (int i = 0; i < program_proto.sobject_size(); i++) {
     SObjectProto *proto = program_proto.mutable_sobject(i);
+    if (FindObject(proto->uid()))
+      continue;
     SObject *sobj = new SObject;
     sobj->uid_ = proto->uid();
     sobj->image_ = sinfo->FindImage(proto->image_id());
@@ -228,6 +238,8 @@ void Program::Load(const std::string &db_name, StaticInfo *sinfo) {
   // load dynamic object info
   for (int i = 0; i < program_proto.dobject_size(); i++) {
     DObjectProto *proto = program_proto.mutable_dobject(i);
+    if (FindObject(proto->uid()))
+      continue;
     DObject *dobj = new DObject;
     dobj->uid_ = proto->uid();
     dobj->creator_ = FindThread(proto->creator_uid());
@@ -19,13 +19,23 @@
 
 #include "systematic/random.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <ctime>
 #include "core/logging.h"
 
 namespace systematic {
 
+// order actions by the uids of their threads which are stable across
+// runs (the thread pointers are not)
+static bool ActionThreadUidLess(Action *a1, Action *a2) {
+  return a1->thd()->uid() < a2->thd()->uid();
+}
+
 RandomScheduler::RandomScheduler(ControllerInterface *controller)
-    : Scheduler(controller) {
+    : Scheduler(controller),
+      seed_(0),
+      rand_state_(0) {
   // empty
 }
 
@@ -35,6 +45,7 @@ RandomScheduler::~RandomScheduler() {
 
 void RandomScheduler::Register() {
   knob()->RegisterBool("enable_random_scheduler", "whether use the random scheduler", "0");
+  knob()->RegisterInt("random_seed", "the random seed of the random scheduler (0 means use the current time)", "0");
 }
 
 bool RandomScheduler::Enabled() {
@@ -43,7 +54,13 @@ bool RandomScheduler::Enabled() {
 
 void RandomScheduler::Setup() {
   // seed the random number generator
-  srand((unsigned int)time(NULL));
+  seed_ = (unsigned int)knob()->ValueInt("random_seed");
+  if (!seed_)
+    seed_ = (unsigned int)time(NULL);
+  rand_state_ = seed_;
+
+  // print the seed so that this run can be replayed
+  printf("[RANDOM] seed = %u\n", seed_);
 }
 
 void RandomScheduler::ProgramStart() {
@@ -60,26 +77,34 @@ void RandomScheduler::Explore(State *init_state) {
   // run until no enabled thread
   while (!state->IsTerminal()) {
     // randomly pick the next thread to run
-    Action *action = PickNextRandom(state);
+    Action *action = Pick(state);
     // execute the action and move to next state
     state = Execute(state, action);
   }
 }
 
 bool RandomScheduler::RandomChoice(double true_rate) {
-  double val = rand() / (RAND_MAX + 1.0);
+  // use rand_r so that the sequence only depends on the seed
+  double val = rand_r(&rand_state_) / (RAND_MAX + 1.0);
   if (val < true_rate)
     return true;
   else
     return false;
 }
 
-Action *RandomScheduler::PickNextRandom(State *state) {
+Action *RandomScheduler::Pick(State *state) {
+  // visit the enabled actions in thread uid order
+  Action::Vec candidates;
   Action::Map *enabled = state->enabled();
+  for (Action::Map::iterator it = enabled->begin(); it != enabled->end(); ++it)
+    candidates.push_back(it->second);
+  std::sort(candidates.begin(), candidates.end(), ActionThreadUidLess);
+
   Action *target = NULL;
   int counter = 1;
-  for (Action::Map::iterator it = enabled->begin(); it != enabled->end(); ++it){
-    Action *current = it->second;
+  for (Action::Vec::iterator it = candidates.begin(); it != candidates.end();
+       ++it) {
+    Action *current = *it;
     // decide whether to pick the current one
     if (RandomChoice(1.0 / (double)counter)) {
       target = current;
@@ -37,11 +37,15 @@ class RandomScheduler : public Scheduler {
   void ProgramStart();
   void ProgramExit();
   void Explore(State *init_state);
+  bool Inline() { return true; }
+  Action *Pick(State *state);
 
  protected:
   // helper functions
   bool RandomChoice(double true_rate);
-  Action *PickNextRandom(State *state);
+
+  unsigned int seed_;
+  unsigned int rand_state_;
 
  private:
   DISALLOW_COPY_CONSTRUCTORS(RandomScheduler);
@@ -0,0 +1,132 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: systematic/replay.cc - The implementation of the replay
+// scheduler which forces an exported schedule.
+
+#include "systematic/replay.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "core/logging.h"
+
+namespace systematic {
+
+ReplayScheduler::ReplayScheduler(ControllerInterface *controller)
+    : Scheduler(controller),
+      curr_idx_(0),
+      diverged_(false),
+      diverge_idx_(0) {
+  // empty
+}
+
+ReplayScheduler::~ReplayScheduler() {
+  // empty
+}
+
+void ReplayScheduler::Register() {
+  knob()->RegisterBool("enable_replay_scheduler", "whether use the replay scheduler", "0");
+  knob()->RegisterStr("schedule_in", "the input schedule file path", "schedule.db");
+}
+
+bool ReplayScheduler::Enabled() {
+  return knob()->ValueBool("enable_replay_scheduler");
+}
+
+void ReplayScheduler::Setup() {
+  // replaying a schedule that is missing or of another format would
+  // silently run a different execution
+  std::string schedule_in = knob()->ValueStr("schedule_in");
+  if (!schedule_.Load(schedule_in)) {
+    fprintf(stderr, "[REPLAY] invalid schedule file %s\n",
+            schedule_in.c_str());
+    abort();
+  }
+}
+
+void ReplayScheduler::ProgramStart() {
+  // empty
+}
+
+void ReplayScheduler::ProgramExit() {
+  if (diverged_)
+    printf("[REPLAY] divergence at step %lu of %lu\n",
+           (unsigned long)diverge_idx_, (unsigned long)schedule_.size());
+  else if (curr_idx_ < schedule_.size())
+    printf("[REPLAY] stopped at step %lu of %lu\n",
+           (unsigned long)curr_idx_, (unsigned long)schedule_.size());
+  else
+    printf("[REPLAY] schedule replayed\n");
+}
+
+void ReplayScheduler::Explore(State *init_state) {
+  // start with the initial state
+  State *state = init_state;
+  // run until no enabled thread
+  while (!state->IsTerminal()) {
+    // pick the action in the schedule
+    Action *action = Pick(state);
+    // execute the action and move to next state
+    state = Execute(state, action);
+  }
+}
+
+Action *ReplayScheduler::Pick(State *state) {
+  Action *action = PickScheduled(state);
+  curr_idx_++;
+  return action;
+}
+
+Action *ReplayScheduler::PickScheduled(State *state) {
+  if (diverged_ || curr_idx_ >= schedule_.size())
+    return PickDefault(state);
+
+  // find the enabled action of the scheduled thread and make sure
+  // that it is the scheduled action
+  const ActionRecord &expected = schedule_.record(curr_idx_);
+  Action::Map *enabled = state->enabled();
+  for (Action::Map::iterator it = enabled->begin(); it != enabled->end(); ++it){
+    if (it->first->uid() != expected.thd_uid)
+      continue;
+    ActionRecord record;
+    PorStore::Encode(it->second, &record);
+    if (PorStore::Equal(record, expected))
+      return it->second;
+    break;
+  }
+
+  // the rest of the execution is not replayed
+  diverged_ = true;
+  diverge_idx_ = curr_idx_;
+  printf("[REPLAY] divergence happens\n");
+  return PickDefault(state);
+}
+
+Action *ReplayScheduler::PickDefault(State *state) {
+  // pick the enabled thread with the smallest uid
+  Action::Map *enabled = state->enabled();
+  Action *target = NULL;
+  for (Action::Map::iterator it = enabled->begin(); it != enabled->end(); ++it){
+    if (!target || it->first->uid() < target->thd()->uid())
+      target = it->second;
+  }
+  DEBUG_ASSERT(target);
+  return target;
+}
+
+} // namespace systematic
+
@@ -0,0 +1,61 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: systematic/replay.h - The definition of the replay scheduler
+// which forces an exported schedule.
+
+#ifndef SYSTEMATIC_REPLAY_H_
+#define SYSTEMATIC_REPLAY_H_
+
+#include "core/basictypes.h"
+#include "systematic/scheduler.h"
+#include "systematic/schedule.h"
+
+namespace systematic {
+
+class ReplayScheduler : public Scheduler {
+ public:
+  explicit ReplayScheduler(ControllerInterface *controller);
+  ~ReplayScheduler();
+
+  // overrided virtual functions
+  void Register();
+  bool Enabled();
+  void Setup();
+  void ProgramStart();
+  void ProgramExit();
+  void Explore(State *init_state);
+  bool Inline() { return true; }
+  Action *Pick(State *state);
+
+ protected:
+  // helper functions
+  Action *PickScheduled(State *state);
+  Action *PickDefault(State *state);
+
+  Schedule schedule_;
+  size_t curr_idx_;
+  bool diverged_;
+  size_t diverge_idx_;
+
+ private:
+  DISALLOW_COPY_CONSTRUCTORS(ReplayScheduler);
+};
+
+} // namespace systematic
+
+#endif
+
@@ -0,0 +1,77 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: systematic/schedule.cc - Implementation of the exported
+// schedule of an execution.
+
+#include "systematic/schedule.h"
+
+#include <fstream>
+
+namespace systematic {
+
+#define SCHEDULE_MAGIC 0x53504c4d // "MLPS" in little endian
+#define SCHEDULE_VERSION 1
+
+void Schedule::Update(Execution *exec) {
+  records_.clear();
+  for (size_t idx = 0; ; idx++) {
+    State *state = exec->FindState(idx);
+    if (!state || !state->taken())
+      break;
+    records_.push_back(ActionRecord());
+    PorStore::Encode(state->taken(), &records_.back());
+  }
+}
+
+bool Schedule::Load(const std::string &file_name) {
+  records_.clear();
+  std::fstream in(file_name.c_str(), std::ios::in | std::ios::binary);
+  ScheduleHeader header;
+  if (!in.read((char *)&header, sizeof(ScheduleHeader)))
+    return false;
+  if (header.magic != SCHEDULE_MAGIC ||
+      header.version != SCHEDULE_VERSION ||
+      header.record_size != sizeof(ActionRecord))
+    return false;
+  records_.resize(header.num_records);
+  if (header.num_records > 0 &&
+      !in.read((char *)&records_[0],
+               header.num_records * sizeof(ActionRecord))) {
+    records_.clear();
+    return false;
+  }
+  in.close();
+  return true;
+}
+
+void Schedule::Save(const std::string &file_name) {
+  std::fstream out(file_name.c_str(),
+                   std::ios::out | std::ios::trunc | std::ios::binary);
+  ScheduleHeader header;
+  header.magic = SCHEDULE_MAGIC;
+  header.version = SCHEDULE_VERSION;
+  header.record_size = sizeof(ActionRecord);
+  header.num_records = records_.size();
+  out.write((const char *)&header, sizeof(ScheduleHeader));
+  if (!records_.empty())
+    out.write((const char *)&records_[0],
+              records_.size() * sizeof(ActionRecord));
+  out.close();
+}
+
+} // namespace systematic
+
@@ -0,0 +1,66 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+// File: systematic/schedule.h - Define the exported schedule of an
+// execution which can be replayed by the replay scheduler.
+
+#ifndef SYSTEMATIC_SCHEDULE_H_
+#define SYSTEMATIC_SCHEDULE_H_
+
+#include <string>
+#include <vector>
+
+#include "core/basictypes.h"
+#include "systematic/program.h"
+#include "systematic/por_store.h"
+
+namespace systematic {
+
+// The header of a schedule file. A file with a different magic,
+// version or record size is rejected when loading.
+struct ScheduleHeader {
+  uint32 magic;
+  uint32 version;
+  uint32 record_size;
+  uint32 num_records;
+};
+
+// The schedule of an execution is the sequence of actions taken at
+// each state, stored as fixed-size action records (see por_store.h)
+// after a header. Threads and objects are identified by their uids,
+// thus a schedule is only valid with the program database of the
+// exporting run.
+class Schedule {
+ public:
+  Schedule() {}
+  ~Schedule() {}
+
+  size_t size() { return records_.size(); }
+  const ActionRecord &record(size_t idx) { return records_[idx]; }
+  void Update(Execution *exec);
+  bool Load(const std::string &file_name); // false if not valid
+  void Save(const std::string &file_name);
+
+ private:
+  std::vector<ActionRecord> records_;
+
+  DISALLOW_COPY_CONSTRUCTORS(Schedule);
+};
+
+} // namespace systematic
+
+#endif
+
@@ -30,7 +30,28 @@ void Scheduler::Main(State *init_state) {
   Explore(init_state);
 }
 
+Action *Scheduler::Step(State *state) {
+  // set counters for enabled actions
+  SetActionCounters(state);
+  if (state->IsTerminal())
+    return NULL;
+  // pick the next action, the controller executes it
+  Action *action = Pick(state);
+  DEBUG_ASSERT(action);
+  Take(state, action);
+  return action;
+}
+
 State *Scheduler::Execute(State *state, Action *action) {
+  Take(state, action);
+  // execute the action, and get the next state
+  State *next_state = controller_->Execute(state, action);
+  // set counters for enabled actions
+  SetActionCounters(next_state);
+  return next_state;
+}
+
+void Scheduler::Take(State *state, Action *action) {
   // update the stored counters
   if (action->obj()) {
     Action::idx_t &tc_idx = GetThreadCounter(action->thd());
@@ -40,11 +61,6 @@ State *Scheduler::Execute(State *state, Action *action) {
   }
   // update the taken field
   state->set_taken(action);
-  // execute the action, and get the next state
-  State *next_state = controller_->Execute(state, action);
-  // set counters for enabled actions
-  SetActionCounters(next_state);
-  return next_state;
 }
 
 void Scheduler::SetActionCounters(State *state) {
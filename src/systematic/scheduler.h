@@ -55,9 +55,28 @@ class Scheduler {
   virtual void ProgramStart() = 0;
   virtual void ProgramExit() = 0;
   virtual void Explore(State *init_state) = 0;
+  // called in a forked execution before the program starts, to pick
+  // up the states saved by the previous execution
+  virtual void Reload() {}
+  // return whether no more execution needs to be explored
+  virtual bool Done() { return false; }
+  // return whether the next action only depends on the current state
+  // (not on the explore loop). if so, the controller can pick the next
+  // action in the thread that reaches a scheduling point (see Step)
+  virtual bool Inline() { return false; }
+  // return whether the program is run under the os FIFO policy (which
+  // needs privileges). otherwise, the controller waits for the running
+  // threads to reach their scheduling points before the next state
+  virtual bool OsFifo() { return true; }
+  // pick the next action in a non-terminal state (see Inline)
+  virtual Action *Pick(State *state) { return NULL; }
 
   // the main entry of the scheduler
   void Main(State *init_state);
+  // take one step of the explore loop of an inline scheduler in the
+  // calling thread. return the action to take, or NULL if the state is
+  // terminal
+  Action *Step(State *state);
 
   Descriptor *desc() { return &desc_; }
   Knob *knob() { return controller_->GetKnob(); }
@@ -69,6 +88,7 @@ class Scheduler {
   State *Execute(State *state, Action *action); // should not be override
 
  private:
+  void Take(State *state, Action *action);
   void SetActionCounters(State *state);
   Action::idx_t &GetThreadCounter(Thread *thd);
   Action::idx_t &GetObjectCounter(Object *obj);
@@ -19,6 +19,11 @@
 
 #include "systematic/search.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
 #include <sstream>
 #include "core/logging.h"
 
@@ -79,6 +84,14 @@ std::string SearchNode::ToString() {
     Thread *thd = *it;
     ss << std::dec << thd->uid() << " ";
   }
+  ss << ")" << std::endl;
+  // explored set
+  ss << "   explored = ( ";
+  for (Thread::Set::iterator it = explored_.begin();
+       it != explored_.end(); ++it) {
+    Thread *thd = *it;
+    ss << std::dec << thd->uid() << " ";
+  }
   ss << ")";
   return ss.str();
 }
@@ -116,7 +129,10 @@ void SearchInfo::UpdateForNext() {
     if (!node->Finished())
       break;
     stack_.pop_back();
+    DeleteNode(node);
   }
+  if (stack_.size() < synced_size_)
+    synced_size_ = stack_.size();
   if (stack_.empty())
     done_ = true;
   num_runs_ += 1;
@@ -124,6 +140,13 @@ void SearchInfo::UpdateForNext() {
                        done_, (int)stack_.size(), num_runs_);
 }
 
+SearchNode *SearchInfo::FindNode(size_t idx) {
+  if (idx >= stack_.size())
+    return NULL;
+  else
+    return stack_[idx];
+}
+
 SearchNode *SearchInfo::Prev(SearchNode *node) {
   if (node->idx_ == 0)
     return NULL;
@@ -151,86 +174,254 @@ void SearchInfo::Load(const std::string &db_name,
   // load general info
   done_ = info_proto.done();
   num_runs_ = info_proto.num_runs();
-  // load search stack
+  // load search stack (replace the current one)
+  PopNodes(0);
+  cursor_ = 0;
   for (int i = 0; i < info_proto.node_size(); i++) {
-    SearchNodeProto *node_proto = info_proto.mutable_node(i);
     SearchNode *node = new SearchNode;
     node->info_ = this;
     node->idx_ = stack_.size();
-    // load sel
-    node->sel_ = program->FindThread(node_proto->sel());
-    DEBUG_ASSERT(node->sel_);
-    // load backtrack set
-    for (int j = 0; j < node_proto->backtrack_size(); j++) {
-      Thread *thd = program->FindThread(node_proto->backtrack(j));
-      DEBUG_ASSERT(thd);
-      node->backtrack_.insert(thd);
-    }
-    // load done set
-    for (int j = 0; j < node_proto->done_size(); j++) {
-      Thread *thd = program->FindThread(node_proto->done(j));
-      DEBUG_ASSERT(thd);
-      node->done_.insert(thd);
-    }
-    // load enabled set
-    for (int j = 0; j < node_proto->enabled_size(); j++) {
-      ActionInfoProto *action_info_proto = node_proto->mutable_enabled(j);
-      ActionInfo *action_info = new ActionInfo;
-      action_info->thd_ = program->FindThread(action_info_proto->thd_uid());
-      if (action_info_proto->has_obj_uid())
-        action_info->obj_ = program->FindObject(action_info_proto->obj_uid());
-      action_info->op_ = action_info_proto->op();
-      if (action_info_proto->has_inst_id())
-        action_info->inst_ = sinfo->FindInst(action_info_proto->inst_id());
-      node->enabled_[action_info->thd_] = action_info;
-    }
+    LoadNode(node, info_proto.mutable_node(i), sinfo, program);
     stack_.push_back(node);
   }
+  // apply the deltas saved after the snapshot
+  LoadLog(db_name + ".log", sinfo, program);
+  MarkSynced(db_name);
 }
 
 void SearchInfo::Save(const std::string &db_name,
                       StaticInfo *sinfo,
                       Program *program) {
+  // the log can only be appended if the db matches the nodes that
+  // are not changed, otherwise write a new snapshot
+  std::string log_name = db_name + ".log";
+  struct stat db_sb;
+  struct stat log_sb;
+  if (db_name != synced_db_name_ || stat(db_name.c_str(), &db_sb)) {
+    SaveSnapshot(db_name);
+  } else if (!stat(log_name.c_str(), &log_sb) &&
+             log_sb.st_size > db_sb.st_size) {
+    // compact the log when it is larger than the snapshot
+    SaveSnapshot(db_name);
+  } else {
+    AppendLog(log_name);
+  }
+  MarkSynced(db_name);
+}
+
+void SearchInfo::LoadNode(SearchNode *node,
+                          SearchNodeProto *node_proto,
+                          StaticInfo *sinfo,
+                          Program *program) {
+  // load sel
+  node->sel_ = program->FindThread(node_proto->sel());
+  DEBUG_ASSERT(node->sel_);
+  // load backtrack set
+  node->backtrack_.clear();
+  for (int j = 0; j < node_proto->backtrack_size(); j++) {
+    Thread *thd = program->FindThread(node_proto->backtrack(j));
+    DEBUG_ASSERT(thd);
+    node->backtrack_.insert(thd);
+  }
+  // load done set
+  node->done_.clear();
+  for (int j = 0; j < node_proto->done_size(); j++) {
+    Thread *thd = program->FindThread(node_proto->done(j));
+    DEBUG_ASSERT(thd);
+    node->done_.insert(thd);
+  }
+  // load explored set
+  node->explored_.clear();
+  for (int j = 0; j < node_proto->explored_size(); j++) {
+    Thread *thd = program->FindThread(node_proto->explored(j));
+    DEBUG_ASSERT(thd);
+    node->explored_.insert(thd);
+  }
+  // load enabled set (only saved when the node is created)
+  for (int j = 0; j < node_proto->enabled_size(); j++) {
+    ActionInfoProto *action_info_proto = node_proto->mutable_enabled(j);
+    ActionInfo *action_info = new ActionInfo;
+    action_info->thd_ = program->FindThread(action_info_proto->thd_uid());
+    if (action_info_proto->has_obj_uid())
+      action_info->obj_ = program->FindObject(action_info_proto->obj_uid());
+    action_info->op_ = action_info_proto->op();
+    if (action_info_proto->has_inst_id())
+      action_info->inst_ = sinfo->FindInst(action_info_proto->inst_id());
+    ActionInfo::Map::iterator it = node->enabled_.find(action_info->thd_);
+    if (it != node->enabled_.end())
+      delete it->second;
+    node->enabled_[action_info->thd_] = action_info;
+  }
+}
+
+void SearchInfo::SaveNode(SearchNode *node,
+                          SearchNodeProto *node_proto,
+                          bool save_enabled) {
+  // save sel
+  node_proto->set_sel(node->sel_->uid());
+  // save backtrack
+  for (Thread::Set::iterator bit = node->backtrack_.begin();
+       bit != node->backtrack_.end(); ++bit) {
+    Thread *thd = *bit;
+    node_proto->add_backtrack(thd->uid());
+  }
+  // save done
+  for (Thread::Set::iterator dit = node->done_.begin();
+       dit != node->done_.end(); ++dit) {
+    Thread *thd = *dit;
+    node_proto->add_done(thd->uid());
+  }
+  // save explored
+  for (Thread::Set::iterator xit = node->explored_.begin();
+       xit != node->explored_.end(); ++xit) {
+    Thread *thd = *xit;
+    node_proto->add_explored(thd->uid());
+  }
+  if (!save_enabled)
+    return;
+  // save enabled
+  for (ActionInfo::Map::iterator eit = node->enabled_.begin();
+       eit != node->enabled_.end(); ++eit) {
+    ActionInfo *action_info = eit->second;
+    ActionInfoProto *action_info_proto = node_proto->add_enabled();
+    action_info_proto->set_thd_uid(action_info->thd_->uid());
+    if (action_info->obj_)
+      action_info_proto->set_obj_uid(action_info->obj_->uid());
+    action_info_proto->set_op(action_info->op_);
+    if (action_info->inst_)
+      action_info_proto->set_inst_id(action_info->inst_->id());
+  }
+}
+
+void SearchInfo::LoadLog(const std::string &log_name,
+                         StaticInfo *sinfo,
+                         Program *program) {
+  std::fstream in(log_name.c_str(), std::ios::in | std::ios::binary);
+  if (!in.is_open())
+    return;
+  // each delta is prefixed with its size. stop at the first delta
+  // that is incomplete or does not apply, and cut it off (and all
+  // the deltas after it) so that new deltas can be appended after
+  // the valid ones
+  std::streamoff valid_size = 0;
+  std::string buf;
+  while (true) {
+    uint32 size = 0;
+    if (!in.read((char *)&size, sizeof(size)))
+      break;
+    buf.resize(size);
+    if (size > 0 && !in.read(&buf[0], size))
+      break;
+    SearchDeltaProto delta_proto;
+    if (!delta_proto.ParseFromString(buf))
+      break;
+    // skip the deltas that are already in the snapshot (the program
+    // may be killed after compaction before the log is removed)
+    if ((int)delta_proto.num_runs() <= num_runs_) {
+      valid_size += sizeof(size) + size;
+      continue;
+    }
+    if (delta_proto.base_size() > stack_.size())
+      break;
+    valid_size += sizeof(size) + size;
+    // pop the nodes that are not kept
+    PopNodes(delta_proto.base_size());
+    // apply the changed nodes and push the new nodes
+    for (int i = 0; i < delta_proto.node_size(); i++) {
+      size_t idx = delta_proto.node_idx(i);
+      DEBUG_ASSERT(idx <= stack_.size());
+      if (idx == stack_.size()) {
+        SearchNode *node = new SearchNode;
+        node->info_ = this;
+        node->idx_ = stack_.size();
+        stack_.push_back(node);
+      }
+      LoadNode(stack_[idx], delta_proto.mutable_node(i), sinfo, program);
+    }
+    done_ = delta_proto.done();
+    num_runs_ = delta_proto.num_runs();
+  }
+  in.close();
+  int res = truncate(log_name.c_str(), valid_size);
+  assert(!res);
+}
+
+void SearchInfo::AppendLog(const std::string &log_name) {
+  SearchDeltaProto delta_proto;
+  delta_proto.set_done(done_);
+  delta_proto.set_num_runs(num_runs_);
+  delta_proto.set_base_size(synced_size_);
+  // the nodes below synced_size_ are saved already, only save the
+  // changed sets. the nodes above are new
+  for (size_t idx = 0; idx < stack_.size(); idx++) {
+    SearchNode *node = stack_[idx];
+    if (idx < synced_size_ && !node->dirty_)
+      continue;
+    delta_proto.add_node_idx(idx);
+    SaveNode(node, delta_proto.add_node(), idx >= synced_size_);
+  }
+  std::string buf;
+  delta_proto.SerializeToString(&buf);
+  uint32 size = buf.size();
+  buf.insert(0, (const char *)&size, sizeof(size));
+  // the delta must reach the disk before the run is reported, or a
+  // crash may lose a run that the caller has already moved past
+  int fd = open(log_name.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  SANITY_ASSERT(fd >= 0);
+  const char *ptr = buf.data();
+  size_t remain = buf.size();
+  while (remain > 0) {
+    ssize_t res = write(fd, ptr, remain);
+    if (res < 0 && errno == EINTR)
+      continue;
+    SANITY_ASSERT(res > 0);
+    ptr += res;
+    remain -= res;
+  }
+  SANITY_ASSERT(!fsync(fd));
+  close(fd);
+}
+
+void SearchInfo::SaveSnapshot(const std::string &db_name) {
   SearchInfoProto info_proto;
   // save general info
   info_proto.set_done(done_);
   info_proto.set_num_runs(num_runs_);
   // save search stack
   for (SearchNode::Vec::iterator it = stack_.begin(); it != stack_.end(); ++it){
-    SearchNode *node = *it;
-    SearchNodeProto *node_proto = info_proto.add_node();
-    // save sel
-    node_proto->set_sel(node->sel_->uid());
-    // save backtrack
-    for (Thread::Set::iterator bit = node->backtrack_.begin();
-         bit != node->backtrack_.end(); ++bit) {
-      Thread *thd = *bit;
-      node_proto->add_backtrack(thd->uid());
-    }
-    // save done
-    for (Thread::Set::iterator dit = node->done_.begin();
-         dit != node->done_.end(); ++dit) {
-      Thread *thd = *dit;
-      node_proto->add_done(thd->uid());
-    }
-    // save enabled
-    for (ActionInfo::Map::iterator eit = node->enabled_.begin();
-         eit != node->enabled_.end(); ++eit) {
-      ActionInfo *action_info = eit->second;
-      ActionInfoProto *action_info_proto = node_proto->add_enabled();
-      action_info_proto->set_thd_uid(action_info->thd_->uid());
-      if (action_info->obj_)
-        action_info_proto->set_obj_uid(action_info->obj_->uid());
-      action_info_proto->set_op(action_info->op_);
-      if (action_info->inst_)
-        action_info_proto->set_inst_id(action_info->inst_->id());
-    }
+    SaveNode(*it, info_proto.add_node(), true);
   }
-  // save to file
-  std::fstream out(db_name.c_str(),
+  // save to a temporary file and rename it so that the snapshot is
+  // either the old one or the new one. the log is removed afterwards
+  std::string tmp_name = db_name + ".tmp";
+  std::fstream out(tmp_name.c_str(),
                    std::ios::out | std::ios::trunc | std::ios::binary);
   info_proto.SerializeToOstream(&out);
   out.close();
+  int res = rename(tmp_name.c_str(), db_name.c_str());
+  assert(!res);
+  unlink((db_name + ".log").c_str());
+}
+
+void SearchInfo::PopNodes(size_t size) {
+  while (stack_.size() > size) {
+    DeleteNode(stack_.back());
+    stack_.pop_back();
+  }
+}
+
+void SearchInfo::DeleteNode(SearchNode *node) {
+  for (ActionInfo::Map::iterator it = node->enabled_.begin();
+       it != node->enabled_.end(); ++it)
+    delete it->second;
+  delete node;
+}
+
+void SearchInfo::MarkSynced(const std::string &db_name) {
+  synced_db_name_ = db_name;
+  synced_size_ = stack_.size();
+  for (SearchNode::Vec::iterator it = stack_.begin(); it != stack_.end(); ++it)
+    (*it)->dirty_ = false;
 }
 
 bool SearchInfo::CheckDivergence(SearchNode *node, State *state) {
@@ -71,6 +71,7 @@ class SearchNode {
   bool IsDone(Thread *thd);
   void AddDone(Thread *thd);
   void AddBacktrack(Thread *thd);
+  void AddExplored(Thread *thd);
   SearchNode *Prev();
   SearchNode *Next();
   bool Finished();
@@ -78,10 +79,11 @@ class SearchNode {
 
   Thread *sel() { return sel_; }
   size_t idx() { return idx_; }
-  void set_sel(Thread *thd) { sel_ = thd; }
+  Thread::Set *explored() { return &explored_; }
+  void set_sel(Thread *thd);
 
  protected:
-  SearchNode() : info_(NULL), idx_(0) {}
+  SearchNode() : info_(NULL), idx_(0), sel_(NULL), dirty_(false) {}
   ~SearchNode() {}
 
   SearchInfo *info_;
@@ -89,7 +91,9 @@ class SearchNode {
   Thread *sel_;
   Thread::Set backtrack_;
   Thread::Set done_;
+  Thread::Set explored_; // the threads selected (done but not pruned)
   ActionInfo::Map enabled_; // used for divergence check
+  bool dirty_; // whether changed since the last save
 
  private:
   friend class SearchInfo;
@@ -97,15 +101,21 @@ class SearchNode {
   DISALLOW_COPY_CONSTRUCTORS(SearchNode);
 };
 
-// define the search info (dfs search)
+// define the search info (dfs search). the search info is saved as a
+// snapshot (db_name) followed by a log of deltas (db_name.log). each
+// save appends the nodes changed or pushed since the previous save to
+// the log, and the log is compacted into a new snapshot when it grows
+// larger than the snapshot. a partially written delta (e.g. the run is
+// killed during saving) is discarded when loading
 class SearchInfo {
  public:
-  SearchInfo() : done_(false), num_runs_(0), cursor_(0) {}
+  SearchInfo() : done_(false), num_runs_(0), cursor_(0), synced_size_(0) {}
   ~SearchInfo() {}
 
   bool Done() { return done_; }
   size_t StackSize() { return stack_.size(); }
   SearchNode *GetNextNode(State *state); // create a new node if needed
+  SearchNode *FindNode(size_t idx);
   SearchNode *Prev(SearchNode *node);
   SearchNode *Next(SearchNode *node);
   void UpdateForNext();
@@ -115,11 +125,24 @@ class SearchInfo {
  protected:
   // helper functions
   bool CheckDivergence(SearchNode *node, State *state);
+  void LoadNode(SearchNode *node, SearchNodeProto *node_proto,
+                StaticInfo *sinfo, Program *program);
+  void SaveNode(SearchNode *node, SearchNodeProto *node_proto,
+                bool save_enabled);
+  void LoadLog(const std::string &log_name, StaticInfo *sinfo,
+               Program *program);
+  void AppendLog(const std::string &log_name);
+  void SaveSnapshot(const std::string &db_name);
+  void MarkSynced(const std::string &db_name);
+  void PopNodes(size_t size); // pop and delete the nodes above size
+  void DeleteNode(SearchNode *node);
 
   bool done_;
   int num_runs_;
   SearchNode::Vec stack_;
   size_t cursor_;
+  std::string synced_db_name_; // the db that matches the nodes below
+  size_t synced_size_; // the number of nodes not popped since synced
 
  private:
   DISALLOW_COPY_CONSTRUCTORS(SearchInfo);
@@ -135,11 +158,24 @@ inline bool SearchNode::IsDone(Thread *thd) {
 }
 
 inline void SearchNode::AddDone(Thread *thd) {
-  done_.insert(thd);
+  if (done_.insert(thd).second)
+    dirty_ = true;
 }
 
 inline void SearchNode::AddBacktrack(Thread *thd) {
-  backtrack_.insert(thd);
+  if (backtrack_.insert(thd).second)
+    dirty_ = true;
+}
+
+inline void SearchNode::AddExplored(Thread *thd) {
+  if (explored_.insert(thd).second)
+    dirty_ = true;
+}
+
+inline void SearchNode::set_sel(Thread *thd) {
+  if (sel_ != thd)
+    dirty_ = true;
+  sel_ = thd;
 }
 
 inline SearchNode *SearchNode::Prev() {
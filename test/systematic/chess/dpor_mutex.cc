@@ -0,0 +1,73 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+
+#define NUM_THREADS 2
+
+// the order in which the threads enter the critical section, the
+// "bug" is the order in which thread 1 enters first
+int order = 0;
+
+pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t mutex0 = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t mutex1 = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t mutex2 = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t mutex3 = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t mutex4 = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t mutex5 = PTHREAD_MUTEX_INITIALIZER;
+
+void *thread0(void *arg) {
+  int res;
+  res = pthread_mutex_lock(&mutex);
+  order = order * 10 + 1;
+  res = pthread_mutex_unlock(&mutex);
+  res = pthread_mutex_lock(&mutex0);
+  res = pthread_mutex_unlock(&mutex0);
+  res = pthread_mutex_lock(&mutex1);
+  res = pthread_mutex_unlock(&mutex1);
+  res = pthread_mutex_lock(&mutex2);
+  res = pthread_mutex_unlock(&mutex2);
+  return NULL;
+}
+
+void *thread1(void *arg) {
+  int res;
+  res = pthread_mutex_lock(&mutex);
+  order = order * 10 + 2;
+  res = pthread_mutex_unlock(&mutex);
+  res = pthread_mutex_lock(&mutex3);
+  res = pthread_mutex_unlock(&mutex3);
+  res = pthread_mutex_lock(&mutex4);
+  res = pthread_mutex_unlock(&mutex4);
+  res = pthread_mutex_lock(&mutex5);
+  res = pthread_mutex_unlock(&mutex5);
+  return NULL;
+}
+
+int main(int argc, char *argv[]) {
+  pthread_t tids[NUM_THREADS];
+  pthread_create(&tids[0], NULL, thread0, NULL);
+  pthread_create(&tids[1], NULL, thread1, NULL);
+  pthread_join(tids[0], NULL);
+  pthread_join(tids[1], NULL);
+  printf("order %d\n", order);
+  return 0;
+}
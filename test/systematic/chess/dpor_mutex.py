@@ -0,0 +1,90 @@
+"""Copyright 2011 The University of Michigan
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+Authors - Jie Yu (jieyu@umich.edu)
+"""
+
+import os
+import copy
+from maple.core import config
+from maple.core import logging
+from maple.core import pintool
+from maple.core import static_info
+from maple.systematic import program
+from maple.systematic import search
+from maple.systematic import testing as systematic_testing
+from maple.regression import common
+from maple.regression import systematic as regression_systematic
+
+def source_name():
+    return __name__ + common.cxx_ext()
+
+def setup_controller(controller):
+    controller.debug = True
+    controller.knobs['por'] = False
+    controller.knobs['dpor'] = True
+    controller.knobs['fair'] = False
+    controller.knobs['pb_limit'] = 1
+
+def setup_testcase(testcase):
+    testcase.mode = 'finish'
+
+def num_runs(controller):
+    sinfo = static_info.StaticInfo()
+    sinfo.load(controller.knobs['sinfo_out'])
+    prog = program.Program(sinfo)
+    prog.load(controller.knobs['program_out'])
+    search_info = search.SearchInfo(sinfo, prog)
+    search_info.load(controller.knobs['search_out'])
+    if not search_info.done():
+        return None
+    return search_info.num_runs()
+
+def bug_found(output_path):
+    # the bug is the order in which thread 1 enters the critical
+    # section first, each execution prints the order
+    f = open(output_path)
+    found = 'order 21\n' in f.readlines()
+    f.close()
+    return found
+
+def verify(controller, testcase):
+    output_path = testcase.test.sio()[1]
+    dpor_runs = num_runs(controller)
+    if dpor_runs == None or not bug_found(output_path):
+        return False
+    os.remove(output_path)
+    # run the same search without dpor, it must find the bug as well,
+    # with more executions
+    baseline = copy.deepcopy(controller)
+    baseline.knobs['dpor'] = False
+    for name in ['sinfo', 'program', 'search']:
+        db_path = 'baseline_%s.db' % name
+        baseline.knobs['%s_in' % name] = db_path
+        baseline.knobs['%s_out' % name] = db_path
+    baseline.knobs['por_info_path'] = 'baseline-por-info'
+    pin = pintool.Pin(config.pin_home())
+    test = copy.deepcopy(testcase.test)
+    test.set_prefix(regression_systematic.get_prefix(pin, baseline))
+    baseline_testcase = systematic_testing.ChessTestCase(test, 'finish', 1,
+                                                         baseline)
+    logging.message_off()
+    baseline_testcase.run()
+    logging.message_on()
+    baseline_runs = num_runs(baseline)
+    if baseline_runs == None or not bug_found(output_path):
+        return False
+    if dpor_runs >= baseline_runs:
+        return False
+    return True
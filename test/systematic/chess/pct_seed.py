@@ -0,0 +1,73 @@
+"""Copyright 2011 The University of Michigan
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+Authors - Jie Yu (jieyu@umich.edu)
+"""
+
+import os
+import copy
+from maple.core import config
+from maple.core import logging
+from maple.core import pintool
+from maple.systematic import testing as systematic_testing
+from maple.regression import common
+from maple.regression import systematic as regression_systematic
+
+def source_name():
+    return __name__ + common.cxx_ext()
+
+def setup_controller(controller):
+    controller.debug = True
+    controller.knobs['enable_chess_scheduler'] = False
+    controller.knobs['enable_pct_scheduler'] = True
+    controller.knobs['pct_seed'] = 2011
+    controller.knobs['pct_steps'] = 40
+    controller.knobs['export_schedule'] = True
+
+def setup_testcase(testcase):
+    testcase.mode = 'runout'
+    testcase.threshold = 1
+
+def read_file(path):
+    if not os.path.exists(path):
+        return None
+    f = open(path, 'rb')
+    content = f.read()
+    f.close()
+    return content
+
+def verify(controller, testcase):
+    output_path = testcase.test.sio()[1]
+    schedule_path = controller.knobs['schedule_out']
+    output = read_file(output_path)
+    schedule = read_file(schedule_path)
+    if not output or not schedule:
+        return False
+    os.remove(output_path)
+    os.remove(schedule_path)
+    # run again with the same seed, the schedule and the output must
+    # be the same (the os scheduler must not matter)
+    pin = pintool.Pin(config.pin_home())
+    test = copy.deepcopy(testcase.test)
+    test.set_prefix(regression_systematic.get_prefix(pin, controller))
+    again_testcase = systematic_testing.ChessTestCase(test, 'runout', 1,
+                                                      controller)
+    logging.message_off()
+    again_testcase.run()
+    logging.message_on()
+    if read_file(schedule_path) != schedule:
+        return False
+    if read_file(output_path) != output:
+        return False
+    return True
@@ -43,8 +43,11 @@ def verify(controller, testcase):
     search_info.load(controller.knobs['search_out'])
     if search_info.num_runs() != 19:
         return False
-    por_files = os.listdir(controller.knobs['por_info_path'])
-    if len(por_files) != 2:
+    # one exec record (two 64-bit words) is appended per run
+    execs_path = os.path.join(controller.knobs['por_info_path'], 'execs')
+    if not os.path.exists(execs_path):
+        return False
+    if os.path.getsize(execs_path) / 16 != search_info.num_runs():
         return False
     return True
 
@@ -0,0 +1,52 @@
+// Copyright 2011 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Jie Yu (jieyu@umich.edu)
+
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+
+#define NUM_THREADS 2
+#define NUM_ITERS 3
+
+// the order in which the threads enter the critical section, which
+// only depends on the schedule (thus must be the same when replayed)
+char order[NUM_THREADS * NUM_ITERS + 1];
+int num_entries = 0;
+
+pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void *thread(void *arg) {
+  long id = (long)arg;
+  for (int i = 0; i < NUM_ITERS; i++) {
+    pthread_mutex_lock(&mutex);
+    order[num_entries++] = '0' + id;
+    pthread_mutex_unlock(&mutex);
+  }
+  return NULL;
+}
+
+int main(int argc, char *argv[]) {
+  pthread_t tids[NUM_THREADS];
+  for (long i = 0; i < NUM_THREADS; i++)
+    pthread_create(&tids[i], NULL, thread, (void *)i);
+  for (int i = 0; i < NUM_THREADS; i++)
+    pthread_join(tids[i], NULL);
+  order[num_entries] = '\0';
+  printf("order %s\n", order);
+  return 0;
+}
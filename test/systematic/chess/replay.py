@@ -0,0 +1,89 @@
+"""Copyright 2011 The University of Michigan
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+Authors - Jie Yu (jieyu@umich.edu)
+"""
+
+import os
+import copy
+from maple.core import config
+from maple.core import logging
+from maple.core import pintool
+from maple.systematic import testing as systematic_testing
+from maple.regression import common
+from maple.regression import systematic as regression_systematic
+
+def source_name():
+    return __name__ + common.cxx_ext()
+
+def setup_controller(controller):
+    controller.debug = True
+    controller.knobs['enable_chess_scheduler'] = False
+    controller.knobs['enable_random_scheduler'] = True
+    controller.knobs['random_seed'] = 2011
+    controller.knobs['export_schedule'] = True
+
+def setup_testcase(testcase):
+    testcase.mode = 'runout'
+    testcase.threshold = 1
+
+def read_file(path):
+    if not os.path.exists(path):
+        return None
+    f = open(path, 'rb')
+    content = f.read()
+    f.close()
+    return content
+
+def find_line(output, prefix):
+    for line in output.splitlines():
+        if line.startswith(prefix):
+            return line
+    return None
+
+def verify(controller, testcase):
+    output_path = testcase.test.sio()[1]
+    output = read_file(output_path)
+    schedule = read_file(controller.knobs['schedule_out'])
+    if not output or not schedule:
+        return False
+    order = find_line(output, 'order ')
+    if not order:
+        return False
+    os.remove(output_path)
+    # replay the recorded schedule, the execution must follow it to
+    # the end and export the same schedule
+    replay = copy.deepcopy(controller)
+    replay.knobs['enable_random_scheduler'] = False
+    replay.knobs['enable_replay_scheduler'] = True
+    replay.knobs['schedule_in'] = controller.knobs['schedule_out']
+    replay.knobs['schedule_out'] = 'replayed_schedule.db'
+    pin = pintool.Pin(config.pin_home())
+    test = copy.deepcopy(testcase.test)
+    test.set_prefix(regression_systematic.get_prefix(pin, replay))
+    replay_testcase = systematic_testing.ChessTestCase(test, 'runout', 1,
+                                                       replay)
+    logging.message_off()
+    replay_testcase.run()
+    logging.message_on()
+    replay_output = read_file(output_path)
+    if not replay_output:
+        return False
+    if not find_line(replay_output, '[REPLAY] schedule replayed'):
+        return False
+    if find_line(replay_output, 'order ') != order:
+        return False
+    if read_file(replay.knobs['schedule_out']) != schedule:
+        return False
+    return True